@@ -0,0 +1,178 @@
+// micro-benchmarks of the core Group and Aggregate operations, on synthetic events that need no input files
+// compile:
+// filename=benchmark_group; g++ $(root-config --cflags --evelibs) -std=c++17 -O3 -Wall -Wextra -Wpedantic -Werror -Wno-float-equal -Wno-sign-compare -I ../plugins/ -I ../src/ -o ${filename} ${filename}.cc
+// run e.g. as ./benchmark_group --events 100000 --json benchmark_group.json --context "$(git rev-parse --short HEAD)"
+// and compare the json files of two commits to see what a change to src/Group.cc or src/Aggregate.cc buys
+
+// core framework headers
+// Collection is not benchmarked directly, as it needs a file to read from; SyntheticGroup stands in for it
+#include "Aggregate.h"
+
+#include "misc/synthetic_group.h"
+#include "misc/combinatorics.h"
+#include "misc/benchmark.h"
+
+// command line parsing
+#include "tclap/CmdLine.h"
+
+#include <cstdlib>
+#include <new>
+
+// the allocation counting of the benchmark harness, see plugins/misc/benchmark.h
+// none of these are inlined, as gcc would otherwise see a malloc paired with a delete or a new with a free, and complain
+[[gnu::noinline]] void* operator new(std::size_t size)
+{
+  benchmark_allocation.fetch_add(1LL, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void *ptr) noexcept
+{
+  std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void *ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+int main(int argc, char** argv) {
+  using namespace Framework;
+
+  TCLAP::CmdLine cmdline("micro-benchmarks of the core group operations", ' ', "1.0");
+  TCLAP::ValueArg<int> arg_event("", "events", "number of events each case runs over", false, 20000, "int", cmdline);
+  TCLAP::ValueArg<int> arg_repeat("", "repeat", "number of timed runs per case", false, 5, "int", cmdline);
+  TCLAP::ValueArg<std::string> arg_json("", "json", "file to write the results into as json, none if empty", false, "", "string", cmdline);
+  TCLAP::ValueArg<std::string> arg_context("", "context", "free-form string stored with the json results, e.g. the commit hash", false, "", "string", cmdline);
+  cmdline.parse(argc, argv);
+
+  // the groups mimic the nanoAOD GenPart and Muon branches, in their multiplicities and in the attributes they hold
+  // the attribute values are only roughly realistic, which matters little as long as the selections below keep a similar fraction
+  SyntheticGroup<boolean, int, float> gen_particle("gen_particle", 10, 0, nanoaod_multiplicity::gen_particle);
+  gen_particle.add_attribute<float>("pt", [] (SyntheticRandom &rng) { return static_cast<float>(rng.exponential(15.)); });
+  gen_particle.add_attribute<float>("eta", [] (SyntheticRandom &rng) { return static_cast<float>(rng.normal(0., 3.)); });
+  gen_particle.add_attribute<float>("phi", [] (SyntheticRandom &rng) { return static_cast<float>(rng.uniform(-M_PI, M_PI)); });
+  gen_particle.add_attribute<float>("mass", [] (SyntheticRandom &rng) { return static_cast<float>(rng.exponential(1.)); });
+  gen_particle.add_attribute<int>("pdg", [] (SyntheticRandom &rng) {
+      constexpr std::array<int, 8> pdgs = {21, 1, 2, 5, 6, 11, 13, 22};
+      return pdgs[rng.integer(0, 7)] * ((rng.uniform() < 0.5) ? -1 : 1);
+    });
+  gen_particle.add_attribute<int>("flag", [] (SyntheticRandom &rng) { return static_cast<int>(rng.next() & 32767ULL); });
+
+  // the same events with a few transforms on top, so that their cost shows up as the difference to plain populate
+  SyntheticGroup<boolean, int, float> gen_particle_transform("gen_particle_transform", 13, 0, nanoaod_multiplicity::gen_particle);
+  for (const auto &attr : {"pt", "eta", "phi", "mass"})
+    gen_particle_transform.add_attribute<float>(attr, [] (SyntheticRandom &rng) { return static_cast<float>(rng.exponential(15.)); });
+  gen_particle_transform.add_attribute<int>("pdg", [] (SyntheticRandom &rng) { return rng.integer(-25, 25); });
+  gen_particle_transform.add_attribute<int>("flag", [] (SyntheticRandom &rng) { return static_cast<int>(rng.next() & 32767ULL); });
+  gen_particle_transform.transform_attribute("final_top", [] (int pdg, int flag) -> boolean { return std::abs(pdg) == 6 and flag & 8192; },
+                                             "pdg", "flag");
+  gen_particle_transform.transform_attribute("px", [] (float pt, float phi) { return pt * std::cos(phi); }, "pt", "phi");
+  gen_particle_transform.transform_attribute("energy", [] (float pt, float eta, float mass) {
+      return std::sqrt((pt * pt * std::cosh(eta) * std::cosh(eta)) + (mass * mass));
+    }, "pt", "eta", "mass");
+
+  SyntheticGroup<boolean, int, float> muon("muon", 6, 0, nanoaod_multiplicity::muon, 1ULL);
+  muon.add_attribute<float>("pt", [] (SyntheticRandom &rng) { return static_cast<float>(3. + rng.exponential(25.)); });
+  muon.add_attribute<float>("eta", [] (SyntheticRandom &rng) { return static_cast<float>(rng.uniform(-2.4, 2.4)); });
+  muon.add_attribute<float>("phi", [] (SyntheticRandom &rng) { return static_cast<float>(rng.uniform(-M_PI, M_PI)); });
+  muon.add_attribute<float>("mass", [] (SyntheticRandom &) { return 0.1057f; });
+  muon.add_attribute<int>("charge", [] (SyntheticRandom &rng) { return (rng.uniform() < 0.5) ? -1 : 1; });
+  muon.add_attribute<boolean>("tight", [] (SyntheticRandom &rng) { return boolean(rng.uniform() < 0.8); });
+
+  // dimuon aggregates, identical save for the lazy evaluation of their attributes
+  auto make_dimuon = [&muon] (const std::string &name, bool lazy) {
+    auto dimuon = std::make_unique<Aggregate<2, boolean, int, float>>(name, 4, 16, muon, muon);
+    dimuon->set_indexer(combination_indexer<2>());
+    dimuon->set_lazy(lazy);
+
+    dimuon->add_attribute("mass", [] (float pt1, float eta1, float phi1, float m1, float pt2, float eta2, float phi2, float m2) {
+        const float e1 = std::sqrt((pt1 * pt1 * std::cosh(eta1) * std::cosh(eta1)) + (m1 * m1));
+        const float e2 = std::sqrt((pt2 * pt2 * std::cosh(eta2) * std::cosh(eta2)) + (m2 * m2));
+        const float px = (pt1 * std::cos(phi1)) + (pt2 * std::cos(phi2)), py = (pt1 * std::sin(phi1)) + (pt2 * std::sin(phi2));
+        const float pz = (pt1 * std::sinh(eta1)) + (pt2 * std::sinh(eta2));
+        return std::sqrt(std::max(((e1 + e2) * (e1 + e2)) - (px * px) - (py * py) - (pz * pz), 0.f));
+      }, "muon::pt", "muon::eta", "muon::phi", "muon::mass", "muon::pt", "muon::eta", "muon::phi", "muon::mass");
+    dimuon->add_attribute("charge", [] (int q1, int q2) { return q1 * q2; }, "muon::charge", "muon::charge");
+    dimuon->add_attribute("dphi", [] (float phi1, float phi2) { return std::remainder(phi1 - phi2, 2.f * static_cast<float>(M_PI)); },
+                          "muon::phi", "muon::phi");
+    dimuon->transform_attribute("mass_os", [] (float mass, int charge) { return (charge < 0) ? mass : -1.f; }, "mass", "charge");
+
+    return dimuon;
+  };
+  auto dimuon = make_dimuon("dimuon", false);
+  auto dimuon_lazy = make_dimuon("dimuon_lazy", true);
+
+  Benchmark bench(arg_event.getValue(), arg_repeat.getValue());
+
+  // the group operations, each against the populate they need to be preceded by
+  bench.run("group_populate", [&] (long long entry) { gen_particle.populate(entry); });
+
+  bench.run("group_populate_transform", [&] (long long entry) { gen_particle_transform.populate(entry); }, "group_populate");
+
+  bench.run("group_filter", [&] (long long entry) {
+      gen_particle.populate(entry);
+      benchmark_keep(gen_particle.filter_greater("pt", 10.f));
+    }, "group_populate");
+
+  bench.run("group_filter_multi", [&] (long long entry) {
+      gen_particle.populate(entry);
+      benchmark_keep(gen_particle.filter([] (int pdg, int flag, float pt) { return std::abs(pdg) < 6 and flag & 8192 and pt > 10.f; },
+                                         "pdg", "flag", "pt"));
+    }, "group_populate");
+
+  bench.run("group_count", [&] (long long entry) {
+      gen_particle.populate(entry);
+      benchmark_keep(gen_particle.count_in("eta", -2.4f, 2.4f));
+    }, "group_populate");
+
+  bench.run("group_sort", [&] (long long entry) {
+      gen_particle.populate(entry);
+      benchmark_keep(gen_particle.sort_descending("pt"));
+    }, "group_populate");
+
+  bench.run("group_update_indices", [&] (long long entry) {
+      gen_particle.populate(entry);
+      gen_particle.update_indices(gen_particle.filter_greater("pt", 10.f));
+    }, "group_filter");
+
+  bench.run("group_reorder", [&] (long long entry) {
+      gen_particle.populate(entry);
+      gen_particle.update_indices(gen_particle.filter_greater("pt", 10.f));
+      gen_particle.reorder();
+    }, "group_update_indices");
+
+  // the aggregate operations, against the populate of the muons they are made of
+  bench.run("muon_populate", [&] (long long entry) { muon.populate(entry); });
+
+  bench.run("aggregate_populate", [&] (long long entry) {
+      muon.populate(entry);
+      dimuon->populate(entry);
+    }, "muon_populate");
+
+  bench.run("aggregate_populate_lazy_unused", [&] (long long entry) {
+      muon.populate(entry);
+      dimuon_lazy->populate(entry);
+      benchmark_keep(dimuon_lazy->n_elements());
+    }, "muon_populate");
+
+  bench.run("aggregate_populate_lazy_used", [&] (long long entry) {
+      muon.populate(entry);
+      dimuon_lazy->populate(entry);
+      benchmark_keep(dimuon_lazy->get<float>("mass_os"));
+    }, "muon_populate");
+
+  bench.run("aggregate_filter", [&] (long long entry) {
+      muon.populate(entry);
+      dimuon->populate(entry);
+      benchmark_keep(dimuon->filter_in("mass_os", 70.f, 110.f));
+    }, "aggregate_populate");
+
+  bench.print();
+  if (arg_json.getValue() != "")
+    bench.write_json(arg_json.getValue(), arg_context.getValue());
+
+  return 0;
+}
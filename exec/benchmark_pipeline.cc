@@ -0,0 +1,379 @@
+// end-to-end throughput benchmark: Dataset -> Collection -> Aggregate -> Histogram -> Tree, across thread counts
+// compile:
+// filename=benchmark_pipeline; g++ $(root-config --cflags --evelibs) -std=c++17 -O3 -Wall -Wextra -Wpedantic -Werror -Wno-float-equal -Wno-sign-compare -I ../plugins/ -I ../src/ -o ${filename} ${filename}.cc
+// run e.g. on the output of exec/make_nanoaod_like.cc as
+// ./benchmark_pipeline --threads 1 --threads 2 --threads 4 --json benchmark_pipeline.json nanoaod_like_*.root
+// the pipeline is that of exec/example_gen_ttbar.cc, trimmed of what does not change the amount of work done
+// for every thread count, as many replicas of it are made and run through the Scheduler over the same files
+// reported per thread count are the events/s, the MB/s read off the files, the CPU and wall times, and the peak RSS
+// the peak RSS is reset before each run where the kernel allows it, otherwise it is the high-water mark of the whole process so far
+
+// core framework headers
+#include "Dataset.h"
+#include "Collection.h"
+#include "Aggregate.h"
+#include "Histogram.h"
+#include "Cutflow.h"
+#include "Scheduler.h"
+#include "../src/Tree.h"
+
+// additional headers that aid in defining analysis-dependent functions
+#include "misc/four_vector.h"
+#include "misc/overlap_removal.h"
+#include "misc/combinatorics.h"
+#include "misc/gen_history.h"
+#include "misc/ttbar_dilepton_solver.h"
+#include "misc/function_util.h"
+
+// command line parsing
+#include "tclap/CmdLine.h"
+
+#include <fstream>
+#include <sys/resource.h>
+
+float invariant_mass(float pt1, float eta1, float phi1, float mass1,
+                     float pt2, float eta2, float phi2, float mass2)
+{
+  const auto p1 = FourVector<double>::pt_eta_phi_m(pt1, eta1, phi1, mass1);
+  const auto p2 = FourVector<double>::pt_eta_phi_m(pt2, eta2, phi2, mass2);
+
+  return (p1 + p2).M();
+}
+
+
+
+// one replica of the pipeline, i.e. a dataset with its own collections, aggregates and outputs
+// held by pointer, as the functions below capture references to the members
+struct Pipeline {
+  Pipeline(const std::vector<std::string> &files, const std::string &output, bool solve, bool io);
+
+  Framework::Dataset<TChain> dat;
+
+  Framework::Collection<uint, unsigned long long, float> metadata;
+  Framework::Collection<boolean, int, float> gen_particle, gen_jet, gen_lepton, muon;
+  Framework::Collection<float> gen_met;
+
+  std::unique_ptr<GenHistory<Framework::Collection<boolean, int, float>>> history;
+  OverlapRemoval<> cleaning;
+  TTbarDileptonSolver<float> solver;
+
+  Framework::Aggregate<2, boolean, int, float> gen_ttbar, gen_dilepton;
+  Framework::Aggregate<4, boolean, int, float> reco_ttbar;
+
+  Framework::Histogram hist;
+  Framework::Cutflow cutflow;
+  std::unique_ptr<Framework::Tree> tree;
+};
+
+
+
+Pipeline::Pipeline(const std::vector<std::string> &files, const std::string &output, bool solve, bool io) :
+dat("pipeline", "Events"),
+metadata("metadata", 5),
+gen_particle("gen_particle", "nGenPart", 9, 256),
+gen_jet("gen_jet", "nGenJet", 6, 32),
+gen_lepton("gen_lepton", "nGenDressedLepton", 6, 8),
+muon("muon", "nMuon", 16, 8),
+gen_met("gen_met", 2),
+solver(20),
+gen_ttbar("gen_ttbar", 2, 1, gen_particle, gen_particle),
+gen_dilepton("gen_dilepton", 1, 4, gen_lepton, gen_lepton),
+reco_ttbar("reco_ttbar", 18, 4, gen_lepton, gen_lepton, gen_jet, gen_jet),
+cutflow("cutflow")
+{
+  using namespace Framework;
+
+  for (const auto &file : files)
+    dat.add_file(file);
+
+  if (io)
+    dat.enable_io_stats();
+
+  metadata.add_attribute("run", "run", 1U);
+  metadata.add_attribute("lumi", "luminosityBlock", 1U);
+  metadata.add_attribute("event", "event", 1ULL);
+  metadata.add_attribute("weight", "genWeight", 1.f);
+  metadata.add_attribute("lhe_orixwgtup", "LHEWeight_originalXWGTUP", 1.f);
+
+  gen_particle.add_attribute("mass", "GenPart_mass", 1.f);
+  gen_particle.add_attribute("pt", "GenPart_pt", 1.f);
+  gen_particle.add_attribute("eta", "GenPart_eta", 1.f);
+  gen_particle.add_attribute("phi", "GenPart_phi", 1.f);
+  gen_particle.add_attribute("pdg", "GenPart_pdgId", 1);
+  gen_particle.add_attribute("status", "GenPart_status", 1);
+  gen_particle.add_attribute("flag", "GenPart_statusFlags", 1);
+  gen_particle.add_attribute("mother", "GenPart_genPartIdxMother", 1);
+
+  // the generator history and the dileptonic ttbar tagging, as in the example
+  // the history checks the attributes it reads at construction, so it can only be made once they are added
+  history = std::make_unique<GenHistory<Collection<boolean, int, float>>>(gen_particle, "mother", "pdg");
+  const int tag_top = history->add_tag([&pdgs = gen_particle.get<int>("pdg"), &flags = gen_particle.get<int>("flag")] (int idx) {
+      return std::abs(pdgs[idx]) == 6 and flags[idx] & 8192;
+    });
+
+  gen_particle.transform_attribute("dileptonic_ttbar",
+                                   [this, tag_top, &pdgs = gen_particle.get<int>("pdg"), &flags = gen_particle.get<int>("flag")]
+                                   (int pdg, int flag, int idx) -> int {
+                                     if (pdg == 6 and flag & 8192)
+                                       return 1;
+                                     if (pdg == -6 and flag & 8192)
+                                       return 6;
+
+                                     if (idx < 0)
+                                       return 0;
+
+                                     if (std::abs(pdg) == 24 and flag & 8192) {
+                                       const int origin = (pdgs[idx] == pdg) ? history->origin(idx) : idx;
+                                       if (origin > -1 and std::abs(pdgs[origin]) == 6 and flags[origin] & 8192)
+                                         return (pdg > 0) ? 2 : 7;
+
+                                       return 0;
+                                     }
+
+                                     if (std::abs(pdg) == 5 and std::abs(pdgs[idx]) == 6 and flags[idx] & 8192)
+                                       return (pdg > 0) ? 3 : 8;
+
+                                     if (std::abs(pdg) > 10 and std::abs(pdg) < 15) {
+                                       if (std::abs(pdgs[idx]) == 24 and flags[idx] & 8192 and history->descends_from(history->mother(idx), tag_top)) {
+                                         if (pdg % 2)
+                                           return (pdg > 0) ? 9 : 4;
+                                         else
+                                           return (pdg > 0) ? 5 : 10;
+                                       }
+                                     }
+
+                                     return 0;
+                                   }, "pdg", "flag", "mother");
+
+  gen_jet.add_attribute("mass", "GenJet_mass", 1.f);
+  gen_jet.add_attribute("pt", "GenJet_pt", 1.f);
+  gen_jet.add_attribute("eta", "GenJet_eta", 1.f);
+  gen_jet.add_attribute("phi", "GenJet_phi", 1.f);
+  gen_jet.add_attribute("flavour", "GenJet_partonFlavour", 1);
+
+  gen_lepton.add_attribute("mass", "GenDressedLepton_mass", 1.f);
+  gen_lepton.add_attribute("pt", "GenDressedLepton_pt", 1.f);
+  gen_lepton.add_attribute("eta", "GenDressedLepton_eta", 1.f);
+  gen_lepton.add_attribute("phi", "GenDressedLepton_phi", 1.f);
+  gen_lepton.add_attribute("pdg", "GenDressedLepton_pdgId", 1);
+  gen_lepton.transform_attribute("charge", [] (int pdg) -> int { return (pdg > 0) ? -1 : 1; }, "pdg");
+
+  gen_met.add_attribute("pt", "GenMET_pt", 1.f);
+  gen_met.add_attribute("phi", "GenMET_phi", 1.f);
+
+  // all of the muon branches are read, as a typical analysis does, though only a few of them are used
+  muon.add_attribute("pt", "Muon_pt", 1.f);
+  muon.add_attribute("eta", "Muon_eta", 1.f);
+  muon.add_attribute("phi", "Muon_phi", 1.f);
+  muon.add_attribute("mass", "Muon_mass", 1.f);
+  muon.add_attribute("charge", "Muon_charge", 1);
+  muon.add_attribute("dxy", "Muon_dxy", 1.f);
+  muon.add_attribute("dxy_error", "Muon_dxyErr", 1.f);
+  muon.add_attribute("dz", "Muon_dz", 1.f);
+  muon.add_attribute("dz_error", "Muon_dzErr", 1.f);
+  muon.add_attribute("iso03", "Muon_pfRelIso03_all", 1.f);
+  muon.add_attribute("iso04", "Muon_pfRelIso04_all", 1.f);
+  muon.add_attribute("gen_index", "Muon_genPartIdx", 1);
+  muon.add_attribute("loose", "Muon_looseId", boolean(true));
+  muon.add_attribute("medium", "Muon_mediumId", boolean(true));
+  muon.add_attribute("tight", "Muon_tightId", boolean(true));
+
+  dat.associate(metadata, gen_particle, gen_jet, gen_lepton, muon, gen_met);
+
+  cleaning.add_step(OverlapRemoval<>::Policy::remove_target, 0.4f, gen_jet, gen_lepton);
+
+  gen_ttbar.set_indexer([] (const auto &g1, const auto &g2) -> std::vector<std::array<int, 2>> {
+                          auto top = g1.filter_equal("dileptonic_ttbar", 1);
+                          auto antitop = g2.filter_equal("dileptonic_ttbar", 6);
+                          if (top.size() != 1 or antitop.size() != 1)
+                            return {};
+
+                          return {{top[0], antitop[0]}};
+                        });
+  gen_ttbar.add_attribute("ttbar_mass", invariant_mass,
+                          "gen_particle::pt", "gen_particle::eta", "gen_particle::phi", "gen_particle::mass",
+                          "gen_particle::pt", "gen_particle::eta", "gen_particle::phi", "gen_particle::mass");
+
+  gen_dilepton.set_indexer(combination_indexer<2>([&charge = gen_lepton.get<int>("charge")] (int slot, const std::array<int, 2> &idx) {
+                             return slot == 0 or charge[idx[0]] != charge[idx[1]];
+                           }));
+  gen_dilepton.add_attribute("mass", invariant_mass,
+                             "gen_lepton::pt", "gen_lepton::eta", "gen_lepton::phi", "gen_lepton::mass",
+                             "gen_lepton::pt", "gen_lepton::eta", "gen_lepton::phi", "gen_lepton::mass");
+
+  // the solver dominates everything else when it runs, so it is only run when asked
+  if (solve) {
+    reco_ttbar.set_indexer([this] (const auto &g1, const auto &, const auto &g3, const auto &) -> std::vector<std::array<int, 4>> {
+                             auto bottom = g3.filter([] (int flavour) { return std::abs(flavour) == 5; }, "flavour");
+                             return solver.solve(g1, g1.ref_to_indices(), g3, bottom, gen_met);
+                           });
+  }
+  else
+    reco_ttbar.set_indexer([] (const auto &, const auto &, const auto &, const auto &) -> std::vector<std::array<int, 4>> { return {}; });
+  solver.add_attributes(reco_ttbar);
+
+  hist.set_weighter([&weight = metadata.get<float>("weight")] () { return weight[0]; });
+  hist.make_histogram<TH1F>(filler_first_of(gen_ttbar, "ttbar_mass"), "ttbar_mass", "", 120, 300.f, 1500.f);
+  hist.make_histogram<TH1F>(filler_all_of(gen_dilepton, "mass"), "dilepton_mass", "", 100, 0.f, 500.f);
+  hist.make_histogram<TH1F>(filler_all_of(gen_jet, "pt"), "jet_pt", "", 100, 0.f, 500.f);
+  hist.make_histogram<TH1F>(filler_all_of(muon, "pt"), "muon_pt", "", 100, 0.f, 500.f);
+  hist.make_histogram<TH1F>(filler_first_of(reco_ttbar, "top_pt"), "reco_top_pt", "", 100, 0.f, 500.f);
+
+  const int step_all = cutflow.add_step("all");
+  const int step_ttbar = cutflow.add_step("dileptonic_ttbar");
+
+  if (output != "") {
+    tree = std::make_unique<Tree>(output, "tree");
+    tree->make_single_branches(gen_ttbar, "ttbar_mass");
+    tree->make_array_branches(gen_lepton, "pt", "eta", "phi", "pdg");
+  }
+
+  dat.set_analyzer([this, step_all, step_ttbar, &weight = metadata.get<float>("weight")] (long long entry) {
+      metadata.populate(entry);
+      gen_particle.populate(entry);
+      gen_jet.populate(entry);
+      gen_lepton.populate(entry);
+      muon.populate(entry);
+      gen_met.populate(entry);
+
+      gen_lepton.update_indices( gen_lepton.filter([] (float pt, float eta) { return pt > 20.f and std::abs(eta) < 2.4f; }, "pt", "eta") );
+      gen_jet.update_indices( gen_jet.filter([] (float pt, float eta) { return pt > 30.f and std::abs(eta) < 2.4f; }, "pt", "eta") );
+      muon.update_indices( muon.filter([] (float pt, boolean tight, float iso) { return pt > 20.f and tight and iso < 0.15f; }, "pt", "tight", "iso04") );
+      cleaning.run();
+
+      gen_ttbar.populate(entry);
+      gen_dilepton.populate(entry);
+      reco_ttbar.populate(entry);
+
+      cutflow.count(step_all, weight[0]);
+      hist.fill();
+
+      if (!gen_ttbar.n_elements())
+        return;
+      cutflow.count(step_ttbar, weight[0]);
+
+      if (tree)
+        tree->fill();
+    });
+}
+
+
+
+// process-wide resource usage
+struct Usage {
+  double cpu;
+  long long bytes_read;
+};
+
+Usage usage()
+{
+  rusage use;
+  getrusage(RUSAGE_SELF, &use);
+  const double cpu = use.ru_utime.tv_sec + (1e-6 * use.ru_utime.tv_usec) + use.ru_stime.tv_sec + (1e-6 * use.ru_stime.tv_usec);
+  return {cpu, TFile::GetFileBytesRead()};
+}
+
+
+
+// peak RSS in MB, from /proc if possible as it can be reset, from getrusage otherwise
+double peak_rss()
+{
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.rfind("VmHWM:", 0) == 0)
+      return std::stod(line.substr(6)) / 1024.;
+  }
+
+  rusage use;
+  getrusage(RUSAGE_SELF, &use);
+  return use.ru_maxrss / 1024.;
+}
+
+
+
+int main(int argc, char** argv) {
+  using namespace Framework;
+
+  TCLAP::CmdLine cmdline("end-to-end throughput benchmark of the framework", ' ', "1.0");
+  TCLAP::MultiArg<int> arg_thread("", "threads", "thread count to benchmark, may be given several times; defaults to 1", false, "int", cmdline);
+  TCLAP::ValueArg<std::string> arg_json("", "json", "file to write the results into as json, none if empty", false, "", "string", cmdline);
+  TCLAP::ValueArg<std::string> arg_context("", "context", "free-form string stored with the json results, e.g. the commit hash", false, "", "string", cmdline);
+  TCLAP::ValueArg<std::string> arg_output("", "output", "prefix of the output tree files, no trees are written if empty", false, "", "string", cmdline);
+  TCLAP::SwitchArg arg_solve("", "solve", "run the dileptonic ttbar solver too", cmdline, false);
+  TCLAP::SwitchArg arg_io("", "io", "print the I/O statistics of the first replica, with the per-branch read costs", cmdline, false);
+  TCLAP::UnlabeledMultiArg<std::string> arg_file("files", "the input files e.g. from make_nanoaod_like", true, "string", cmdline);
+  cmdline.parse(argc, argv);
+
+  auto v_thread = arg_thread.getValue();
+  if (v_thread.empty())
+    v_thread.emplace_back(1);
+
+  struct Result {
+    int nthread;
+    long long events;
+    double wall, cpu, megabyte, rss;
+  };
+  std::vector<Result> v_result;
+
+  for (auto nthread : v_thread) {
+    if (nthread < 1)
+      throw std::invalid_argument( "ERROR: benchmark_pipeline: thread counts must be positive!!" );
+
+    // one replica per thread, so that every thread has a dataset to run
+    std::vector<std::unique_ptr<Pipeline>> v_pipeline;
+    Scheduler scheduler(nthread);
+    for (int iT = 0; iT < nthread; ++iT) {
+      const std::string output = (arg_output.getValue() == "") ? "" :
+        arg_output.getValue() + "_" + std::to_string(nthread) + "_" + std::to_string(iT) + ".root";
+      v_pipeline.emplace_back(std::make_unique<Pipeline>(arg_file.getValue(), output, arg_solve.getValue(), arg_io.getValue() and iT == 0));
+      scheduler.add(v_pipeline.back()->dat, "pipeline");
+    }
+
+    const auto [first, last] = v_pipeline.front()->dat.entry_range();
+
+    // 5 resets the peak RSS to the current RSS, see proc(5)
+    std::ofstream("/proc/self/clear_refs") << "5";
+
+    const auto use_start = usage();
+    const auto start = std::chrono::steady_clock::now();
+    scheduler.run();
+    const std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    const auto use_end = usage();
+
+    v_result.push_back({nthread, last - first, wall.count(), use_end.cpu - use_start.cpu, (use_end.bytes_read - use_start.bytes_read) / 1e6, peak_rss()});
+    scheduler.print();
+    if (auto io = v_pipeline.front()->dat.io_stats(); io != nullptr)
+      io->print();
+
+    for (auto &pipeline : v_pipeline) {
+      if (pipeline->tree)
+        pipeline->tree->save();
+    }
+  }
+
+  std::cout << "\n" << std::setw(8) << "threads" << std::setw(12) << "events" << std::setw(12) << "wall (s)" << std::setw(12) << "cpu (s)"
+            << std::setw(10) << "cpu/wall" << std::setw(14) << "events/s" << std::setw(10) << "MB/s" << std::setw(14) << "peak RSS (MB)" << "\n";
+  std::cout << std::fixed << std::setprecision(2);
+  for (const auto &res : v_result) {
+    std::cout << std::setw(8) << res.nthread << std::setw(12) << res.events << std::setw(12) << res.wall << std::setw(12) << res.cpu
+              << std::setw(10) << res.cpu / res.wall << std::setw(14) << res.events / res.wall << std::setw(10) << res.megabyte / res.wall
+              << std::setw(14) << res.rss << "\n";
+  }
+  std::cout << std::defaultfloat << std::flush;
+
+  if (arg_json.getValue() != "") {
+    std::ofstream json(arg_json.getValue());
+    json << "{\n  \"context\": \"" << arg_context.getValue() << "\",\n  \"solve\": " << (arg_solve.getValue() ? "true" : "false") << ",\n  \"results\": [";
+    for (int iR = 0; iR < v_result.size(); ++iR) {
+      const auto &res = v_result[iR];
+      json << ((iR == 0) ? "\n" : ",\n")
+           << "    {\"threads\": " << res.nthread << ", \"events\": " << res.events << ", \"wall_s\": " << res.wall << ", \"cpu_s\": " << res.cpu
+           << ", \"events_per_s\": " << res.events / res.wall << ", \"megabyte_read\": " << res.megabyte << ", \"megabyte_per_s\": " << res.megabyte / res.wall
+           << ", \"peak_rss_megabyte\": " << res.rss << "}";
+    }
+    json << "\n  ]\n}\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,94 @@
+// example execution macro showing the batch mode, on the generator-level jets and leptons of the CMS nanoAOD format
+// it assumes familiarity with exec/example_gen_ttbar.cc, and comments only on what is different in the batch mode
+// compile:
+// filename=example_batch; g++ $(root-config --cflags --evelibs) -std=c++17 -O3 -Wall -Wextra -Wpedantic -Werror -Wno-float-equal -Wno-sign-compare -I ../plugins/ -I ../src/ -o ${filename} ${filename}.cc
+
+// core framework headers
+#include "Dataset.h"
+#include "Collection.h"
+#include "Batch.h"
+#include "Histogram.h"
+
+// command line parsing
+#include "tclap/CmdLine.h"
+
+int main(int argc, char** argv) {
+  using namespace Framework;
+
+  TCLAP::CmdLine cmdline("generator-level jets and leptons in batch mode", ' ', "1.0");
+  TCLAP::ValueArg<int> arg_batch("", "batch", "number of events per batch", false, 4096, "int", cmdline);
+  cmdline.parse(argc, argv);
+
+  Dataset<TChain> dat("mc", "Events");
+  dat.add_file("/pnfs/desy.de/cms/tier2/store/mc/RunIIAutumn18NanoAODv7/TTTo2L2Nu_TuneCP5_13TeV-powheg-pythia8/NANOAODSIM/Nano02Apr2020_102X_upgrade2018_realistic_v21-v1/60000/022107FA-F567-1B44-B139-A18ADC996FCF.root");
+
+  // the collections are set up as usual
+  Collection<int, float> gen_jet("gen_jet", "nGenJet", 5, 32);
+  gen_jet.add_attribute("pt", "GenJet_pt", 1.f);
+  gen_jet.add_attribute("eta", "GenJet_eta", 1.f);
+  gen_jet.add_attribute("flavor", "GenJet_partonFlavour", 1);
+
+  Collection<int, float> gen_lepton("gen_lepton", "nGenDressedLepton", 4, 8);
+  gen_lepton.add_attribute("pt", "GenDressedLepton_pt", 1.f);
+  gen_lepton.add_attribute("eta", "GenDressedLepton_eta", 1.f);
+  gen_lepton.add_attribute("pdg", "GenDressedLepton_pdgId", 1);
+
+  // transforms could be added to the collections too, but those run on every entry as it is read
+  // in the batch mode it is cheaper to leave them to the batches, see below
+  dat.associate(gen_jet, gen_lepton);
+
+  // a batch holds the elements of a group over many events, as jagged arrays
+  // i.e. every attribute is one flat array of all the elements of all the events in the batch
+  // together with the offsets of where each event begins in them
+  // args are the group, the attributes to be batched (all of them if empty), and estimates of the events and elements per event
+  Batch b_jet(gen_jet, {}, arg_batch.getValue(), 16);
+  Batch b_lepton(gen_lepton, {"pt", "eta", "pdg"}, arg_batch.getValue(), 3);
+
+  // transforms on a batch are evaluated once the batch is complete, in one loop over all of its elements
+  // rather than once per event, which is where the batch mode gets its throughput from when the collections are small
+  b_jet.transform_attribute("abs_eta", [] (float eta) -> float { return std::abs(eta); }, "eta");
+  b_lepton.transform_attribute("is_muon", [] (int pdg) -> int { return std::abs(pdg) == 13; }, "pdg");
+
+  // histograms are made as usual, but their fillers fill the whole batch
+  // Batch::fill goes over every element, with optionally a weight per event
+  Histogram hist;
+  hist.make_histogram<TH1F>([&b_jet] (TH1F *h, double) { b_jet.fill(h, "pt"); }, "jet_pt", "", 100, 0.f, 500.f);
+  hist.make_histogram<TH1F>([&b_lepton] (TH1F *h, double) { b_lepton.fill(h, "pt"); }, "lepton_pt", "", 100, 0.f, 500.f);
+
+  // event-level quantities are arrays over the events of the batch, as here the number of selected jets in every event
+  // they are filled with an array of events instead of elements; the histogram below is filled by FillN in one call
+  std::vector<double> v_njet, v_weight;
+  hist.make_histogram<TH1I>([&v_njet, &v_weight] (TH1I *h, double) { h->FillN(v_njet.size(), v_njet.data(), v_weight.data()); },
+                            "n_jet", "", 15, 0, 15);
+
+  // the analyzer of the batch mode is called once per batch, with the batches as arguments in the order they are given
+  // first arg is the number of events per batch
+  // every entry populates the group of each batch, which is then appended to the batch, so an aggregate is to be given after the groups it is made of
+  dat.set_batch_analyzer(arg_batch.getValue(), [&hist, &v_njet, &v_weight] (auto &jet, const auto &lepton) {
+      // filters go over all the elements of the batch, returning the indices of the passing ones into the flat arrays
+      // update_indices then keeps only those, and the offsets follow, so that the jet_pt histogram is of the selected jets
+      jet.update_indices(jet.filter([] (float pt, float abs_eta) { return pt > 30.f and abs_eta < 2.4f; }, "pt", "abs_eta"));
+
+      // count gives the number of passing elements per event, tally the same for a set of indices e.g. from a filter
+      // note that the events are never dropped from a batch, only flagged, so that all the batches share the same events
+      const auto v_nlep = lepton.count([] (float pt, float eta) { return pt > 20.f and std::abs(eta) < 2.4f; }, "pt", "eta");
+      const auto v_count = jet.counts();
+
+      v_njet.clear();
+      v_weight.clear();
+      for (int iV = 0; iV < v_count.size(); ++iV) {
+        if (v_nlep[iV] < 2)
+          continue;
+
+        v_njet.emplace_back(v_count[iV]);
+        v_weight.emplace_back(1.);
+      }
+
+      hist.fill();
+    }, b_jet, b_lepton);
+
+  dat.analyze();
+  hist.save_as("hist_batch.root");
+
+  return 0;
+}
@@ -7,19 +7,29 @@
 #include "Collection.h"
 #include "Aggregate.h"
 #include "Histogram.h"
+#include "Cutflow.h"
 #include "../src/Tree.h"
 
 // additional headers that aid in defining analysis-dependent functions
-#include "TLorentzVector.h"
+#include "misc/four_vector.h"
+#include "misc/kinematics_cache.h"
+#include "misc/delta_r_matching.h"
+#include "misc/overlap_removal.h"
+#include "misc/combinatorics.h"
+#include "misc/gen_history.h"
+#include "misc/ttbar_dilepton_solver.h"
+#include "misc/spin_correlation.h"
 #include "misc/function_util.h"
 
+// command line parsing
+#include "tclap/CmdLine.h"
+
 // declare in advance a few functions we will need in the analysis
 float invariant_mass(float pt1, float eta1, float phi1, float mass1,
                      float pt2, float eta2, float phi2, float mass2)
 {
-  TLorentzVector p1, p2;
-  p1.SetPtEtaPhiM(pt1, eta1, phi1, mass1);
-  p2.SetPtEtaPhiM(pt2, eta2, phi2, mass2);
+  const auto p1 = FourVector<double>::pt_eta_phi_m(pt1, eta1, phi1, mass1);
+  const auto p2 = FourVector<double>::pt_eta_phi_m(pt2, eta2, phi2, mass2);
 
   return (p1 + p2).M();
 }
@@ -32,10 +42,23 @@ float pt_vector_sum(float pt1, float phi1, float pt2, float phi2)
   return std::sqrt(((px1 + px2) * (px1 + px2)) + ((py1 + py2) * (py1 + py2)));
 }
 
-int main() {
+int main(int argc, char** argv) {
   // the core part of the framework are all within this namespace
   using namespace Framework;
 
+  // a large dataset is best split across many jobs, each analyzing one shard of it
+  // e.g. ./example_gen_ttbar --shard 3/10 runs the fourth out of ten shards
+  // the outputs of all jobs can then be combined with exec/merge_output
+  TCLAP::CmdLine cmdline("generator-level ttbar analysis", ' ', "1.0");
+  TCLAP::ValueArg<std::string> arg_shard("", "shard", "analyze only the i-th out of n shards of the dataset, given as i/n", false, "", "string", cmdline);
+  TCLAP::ValueArg<std::string> arg_snapshot("", "snapshot", "file to periodically save the outputs into while running, none if empty", false, "", "string", cmdline);
+  TCLAP::SwitchArg arg_resume("", "resume", "resume from the snapshot file, if there is one", cmdline, false);
+  TCLAP::ValueArg<std::string> arg_cache("", "cache", "read the branches off a local column cache at this path, made on first use", false, "", "string", cmdline);
+  cmdline.parse(argc, argv);
+
+  // the job-dependent suffix keeps the outputs of different jobs apart
+  const std::string suffix = (arg_shard.getValue() == "") ? "" : "_" + arg_shard.getValue().substr(0, arg_shard.getValue().find('/'));
+
   // first and foremost, we specify the input files we will be looking at
   // this is done by constructing a dataset object
   // in this example we will analyze flat trees, so we specify that our dataset is of type TChain
@@ -123,36 +146,37 @@ int main() {
   // the usage of which requires us to view the attribute arrays in their entirety
   // however the collection deals with its elements one by one, and similarly the functions take as arguments only the current attributes
   // so it may not be obvious how this can be achieved given these restrictions
-  // this example shows how, exploiting the lambda captures to create an impure function
+  // one way is to exploit the lambda captures to create an impure function, that walks up the mother chain of each particle
+  // but this repeats the same walk for every particle and in every transform that needs it
+  // instead we use the generator history helper, which digests the mother indices once per event
+  // and answers questions like 'what is the mother', 'what is the first copy' or 'does this descend from a top' in constant time
+  // the arguments are the collection, and the names of its mother index and pdg id attributes
+  GenHistory history(gen_particle, "mother", "pdg");
+
+  // tags are particle properties whose presence along the ancestry the history keeps track of
+  // here the final copy top quarks, which are what the decay products below are traced back to
+  // the tag function takes the particle index, and the key returned is what is used in the queries
+  const int tag_top = history.add_tag([&pdgs = gen_particle.get<int>("pdg"), &flags = gen_particle.get<int>("flag")] (int idx) {
+      return std::abs(pdgs[idx]) == 6 and flags[idx] & 8192;
+    });
+
   gen_particle.transform_attribute("final_w_top_daughter", 
-                                   // we capture references to the full array of mother indices and the final top tag
-                                   // ordering matters; we can capture final_top only after defining it
-                                   [&idxs = gen_particle.get<int>("mother"), &tops = gen_particle.get<boolean>("final_top")] 
-                                   (int pdg, int flag, int idx) -> boolean {
+                                   // we capture the history by reference, and the tag key by value
+                                   [&history, tag_top] (int pdg, int flag, int idx) -> boolean {
                                      // first the finality check similar to the top case
-                                     if (std::abs(pdg) == 24 and flag & 8192) {
-                                       // the particle history log may contain radiation
-                                       // which is written as the mother particle having the same pdg id as the particle itself
-                                       // as such it is not sufficient to check the immediate mother of the particle
-                                       // mother index == -1 is nanoAOD for mother is not saved in the array 
-                                       while (idx > -1) {
-                                         // we are done if the mother is a top
-                                         if (tops[idx])
-                                           return true;
-
-                                         // otherwise we update the mother index to mother of mother and recheck
-                                         idx = idxs[idx];
-                                       }
-                                     }
-                                     return false;
+                                     // then whether the mother is, or descends from, a final top
+                                     // the particle history log may contain radiation
+                                     // which is written as the mother particle having the same pdg id as the particle itself
+                                     // as such it is not sufficient to check the immediate mother of the particle
+                                     // mother index == -1 is nanoAOD for mother is not saved in the array, for which descends_from is false
+                                     return std::abs(pdg) == 24 and flag & 8192 and history.descends_from(idx, tag_top);
                                    }, "pdg", "flag", "mother");
 
   // of course, the transformation can be as complex as desired
   // in this case we tag the entire set of particles of interest in a dileptonic ttbar decay tt -> WbWb -> lvblvb
   // restricting leptons to only electron or muon as is commonly done in experimental analyses
   gen_particle.transform_attribute("dileptonic_ttbar", 
-                                   [&pdgs = gen_particle.get<int>("pdg"), &idxs = gen_particle.get<int>("mother"), 
-                                    &flags = gen_particle.get<int>("flag")] 
+                                   [&history, tag_top, &pdgs = gen_particle.get<int>("pdg"), &flags = gen_particle.get<int>("flag")] 
                                    (int pdg, int flag, int idx) -> int {
                                      // integer flag for particles which are part of a generator-level dileptonic ttbar system
                                      // 1 top
@@ -172,60 +196,36 @@ int main() {
                                      if (pdg == -6 and flag & 8192)
                                        return 6;
 
+                                     // everything else has to have a mother
+                                     if (idx < 0)
+                                       return 0;
+
                                      // W boson block
+                                     // the W has to come straight from the top, up to radiation i.e. copies of itself
+                                     // so we skip over the copies of the W with origin(), and check that what is left is a final top
                                      if (std::abs(pdg) == 24 and flag & 8192) {
-                                       while (idx > -1) {
-                                         if (std::abs(pdgs[idx]) == 6 and flags[idx] & 8192) {
-                                           if (pdg > 0)
-                                             return 2;
-                                           else
-                                             return 7;
-                                         }
-
-                                         // mother pdg is not top, but also not the same as self
-                                         // probably the result of some other decay instead of radiation
-                                         if (pdgs[idx] != pdg)
-                                           return 0;
-
-                                         // otherwise we update the mother index to mother of mother and recheck
-                                         idx = idxs[idx];
-                                       }
+                                       const int origin = (pdgs[idx] == pdg) ? history.origin(idx) : idx;
+                                       if (origin > -1 and std::abs(pdgs[origin]) == 6 and flags[origin] & 8192)
+                                         return (pdg > 0) ? 2 : 7;
+
+                                       return 0;
                                      }
 
                                      // bottom quark block
                                      // parton level so simply check that immediate mother is a final copy top
                                      if (std::abs(pdg) == 5) {
-                                       if (std::abs(pdgs[idx]) == 6 and flags[idx] & 8192) {
-                                         if (pdg > 0)
-                                           return 3;
-                                         else
-                                           return 8;
-                                       }
+                                       if (std::abs(pdgs[idx]) == 6 and flags[idx] & 8192)
+                                         return (pdg > 0) ? 3 : 8;
                                      }
 
                                      // leptonic W daughter block
+                                     // the immediate mother is a final W, which descends from a final top
                                      if (std::abs(pdg) > 10 and std::abs(pdg) < 15) {
-                                       if (std::abs(pdgs[idx]) == 24 and flags[idx] & 8192) {
-                                         idx = idxs[idx];
-
-                                         while (idx > -1) {
-                                           if (std::abs(pdgs[idx]) == 6 and flags[idx] & 8192) {
-                                             if (pdg % 2) {
-                                               if (pdg > 0)
-                                                 return 9;
-                                               else 
-                                                 return 4;
-                                             }
-                                             else {
-                                               if (pdg > 0)
-                                                 return 5;
-                                               else 
-                                                 return 10;
-                                             }
-                                           }
-
-                                           idx = idxs[idx];
-                                         }
+                                       if (std::abs(pdgs[idx]) == 24 and flags[idx] & 8192 and history.descends_from(history.mother(idx), tag_top)) {
+                                         if (pdg % 2)
+                                           return (pdg > 0) ? 9 : 4;
+                                         else
+                                           return (pdg > 0) ? 5 : 10;
                                        }
                                      }
 
@@ -233,11 +233,51 @@ int main() {
                                      return 0;
                                    }, "pdg", "flag", "mother");
 
+  // the generator-level jets, which we will match to the bottom quarks later on
+  Collection<boolean, int, float> gen_jet("gen_jet", "nGenJet", 5, 32);
+  gen_jet.add_attribute("mass", "GenJet_mass", 1.f);
+  gen_jet.add_attribute("pt", "GenJet_pt", 1.f);
+  gen_jet.add_attribute("eta", "GenJet_eta", 1.f);
+  gen_jet.add_attribute("phi", "GenJet_phi", 1.f);
+  gen_jet.add_attribute("flavour", "GenJet_partonFlavour", 1);
+
+  // and the dressed leptons, which the jets are cleaned against
+  Collection<boolean, int, float> gen_lepton("gen_lepton", "nGenDressedLepton", 5, 8);
+  gen_lepton.add_attribute("mass", "GenDressedLepton_mass", 1.f);
+  gen_lepton.add_attribute("pt", "GenDressedLepton_pt", 1.f);
+  gen_lepton.add_attribute("eta", "GenDressedLepton_eta", 1.f);
+  gen_lepton.add_attribute("phi", "GenDressedLepton_phi", 1.f);
+  gen_lepton.add_attribute("pdg", "GenDressedLepton_pdgId", 1);
+  gen_lepton.transform_attribute("charge", [] (int pdg) -> int { return (pdg > 0) ? -1 : 1; }, "pdg");
+
+  // and the generator-level missing transverse momentum, which is made of the neutrinos
+  Collection<float> gen_met("gen_met", 2);
+  gen_met.add_attribute("pt", "GenMET_pt", 1.f);
+  gen_met.add_attribute("phi", "GenMET_phi", 1.f);
+
+  // to tune the init hints given above, the memory held by each group can be accounted for
+  // it is given to the dataset before associating, so that the collections are registered then
+  // the report is printed at the end of analyze: capacity against the most elements seen, reallocations, and the RSS over each file read
+  Memory memory;
+  dat.set_memory(memory);
+
+  // alternatively the hints can be made moot: with the prescan, associate reads the maximum of every counter off all the files
+  // (in parallel, one thread per file up to the argument) and sizes each collection once for the whole dataset
+  // so that nothing is reallocated, nor any branch rebound, when moving from file to file during the analysis
+  dat.enable_prescan(4);
+
+  // when the same branches of the same files are analyzed over and over e.g. while tuning a selection
+  // they can be read off a local columnar cache instead, e.g. ./example_gen_ttbar --cache /tmp/gen_ttbar.cache
+  // the first run writes the branches of the collections below into it, and later runs read them straight off the memory-mapped file
+  // it is remade whenever the files or the branches change, and a second argument of true makes it LZ4-compressed
+  if (arg_cache.getValue() != "")
+    dat.enable_cache(arg_cache.getValue());
+
   // having specified all the branches we are interested in, we associate the collections with the dataset
   // this is done by the call below, where the arguments are simply all the collections we are considering
   // this call is equivalent to SetBranchAddress(...) etc steps in a more traditional flat tree analyses
   // be sure to include all the collections in the call, as step-wise association is currently not supported
-  dat.associate(metadata, gen_particle);
+  dat.associate(metadata, gen_particle, gen_jet, gen_lepton, gen_met);
 
   // now we move to the case of attributes that are well-defined only for some selection of elements from the collections
   // for example, the invariant mass of the system of final top quark pair is relevant only for gen_particle with attribute dileptonic_ttbar == 1 or 6
@@ -311,7 +351,7 @@ int main() {
   // rather than something one might actually be interested in doing in an actual analysis
   // so now let us consider a more typical example of a dileptonic ttbar system
   // where we are interested in six particles: tops, charged leptons and bottoms
-  Aggregate gen_tt_ll_bb("gen_tt_ll_bb", 15, 1, gen_particle, gen_particle, gen_particle, gen_particle, gen_particle, gen_particle);
+  Aggregate gen_tt_ll_bb("gen_tt_ll_bb", 18, 1, gen_particle, gen_particle, gen_particle, gen_particle, gen_particle, gen_particle);
 
   // set the indices similarly as above
   gen_tt_ll_bb.set_indexer([] (const auto &g1, const auto &g2, const auto &g3, const auto &g4, const auto &g5, const auto &g6)
@@ -443,6 +483,92 @@ int main() {
                              "gen_particle::pt", "gen_particle::eta", "gen_particle::phi", "gen_particle::mass",
                              "gen_particle::pt", "gen_particle::eta", "gen_particle::phi", "gen_particle::mass");
 
+  // each of the masses above sums up its own pair of four-vectors, redoing the same trigonometry for the same particles
+  // when many such attributes are made out of the same few particles, it is cheaper to let them share the work
+  // this is what the kinematics cache is for: it computes the four-vector of each particle at most once per event
+  // and remembers the sums it has been asked for, until the group is populated again
+  // the cache is told which groups it is to serve, and it refers to them by the key returned here
+  KinematicsCache<decltype(gen_particle)> kinematics;
+  const int kgen = kinematics.add_group(gen_particle);
+
+  // the cache needs the indices of the particles rather than their attributes
+  // which are what add_indexed_attribute gives: the array of indices in the order of the groups given to the aggregate constructor
+  gen_tt_ll_bb.add_indexed_attribute("llbarbbbar_mass", [&kinematics, kgen] (const std::array<int, 6> &idx) -> float
+                                     { return kinematics.mass(kgen, {idx[2], idx[3], idx[4], idx[5]}); });
+
+  // the ttbar system summed here is reused by the ttbar_pt and ttbar_rapidity below
+  gen_tt_ll_bb.add_indexed_attribute("ttbar_energy", [&kinematics, kgen] (const std::array<int, 6> &idx) -> float
+                                     { return kinematics.system(kgen, {idx[0], idx[1]}).E(); });
+  gen_tt_ll_bb.add_indexed_attribute("ttbar_pt", [&kinematics, kgen] (const std::array<int, 6> &idx) -> float
+                                     { return kinematics.pt(kgen, {idx[0], idx[1]}); });
+  gen_tt_ll_bb.add_indexed_attribute("ttbar_rapidity", [&kinematics, kgen] (const std::array<int, 6> &idx) -> float
+                                     { return kinematics.rapidity(kgen, {idx[0], idx[1]}); });
+
+  // jets that overlap with leptons are usually not wanted, as they are often the leptons themselves
+  // the overlap removal takes care of this: each step removes the elements of one group that lie within some dR of another
+  // here the jets within 0.4 of any lepton are removed from gen_jet; more steps are run in the order they are added
+  // only the currently selected elements take part, and the removal updates the indices of gen_jet as update_indices would
+  // to remove the reference elements instead, use Policy::remove_reference
+  OverlapRemoval cleaning;
+  cleaning.add_step(OverlapRemoval<>::Policy::remove_target, 0.4f, gen_jet, gen_lepton);
+
+  // a common task is to match the elements of one group to those of another by their distance in the eta-phi plane
+  // e.g. here the bottom quarks to the (lepton-cleaned) generator-level jets they end up in
+  // DeltaRMatching does this one-to-one for all elements at once, returning the matched index pairs
+  // which is precisely what an aggregate indexer returns, so the matches become an aggregate of their own
+  // the arguments are the maximum dR, and whether the pairs are taken greedily closest first or such that the sum of dR is minimal
+  Aggregate gen_bottom_jet("gen_bottom_jet", 3, 2, gen_particle, gen_jet);
+  gen_bottom_jet.set_indexer([matcher = DeltaRMatching<float>(0.4f, DeltaRMatching<float>::Strategy::greedy)] (const auto &g1, const auto &g2)
+                             -> std::vector<std::array<int, 2>> {
+                               // only the bottom quarks take part in the matching, but all jets are considered
+                               auto bottom = g1.filter([] (int tag) { return tag == 3 or tag == 8; }, "dileptonic_ttbar");
+                               return matcher.match(g1, bottom, g2, g2.ref_to_indices());
+                             });
+
+  // the matched pairs are then used as any other aggregate
+  // note the phi difference wrapped into [-pi, pi] in computing the dR
+  gen_bottom_jet.add_attribute("dR", [] (float eta1, float phi1, float eta2, float phi2) { 
+      return std::hypot(eta1 - eta2, std::remainder(phi1 - phi2, 2.f * constants::pi<float>)); 
+    }, "gen_particle::eta", "gen_particle::phi", "gen_jet::eta", "gen_jet::phi");
+  gen_bottom_jet.add_attribute("response", [] (float pt1, float pt2) { return pt2 / pt1; }, "gen_particle::pt", "gen_jet::pt");
+
+  // many aggregates are simply all the pairs, triplets etc of the selected elements of some groups
+  // rather than writing out the loops, such indexers can be made by combination_indexer or permutation_indexer
+  // which take care not to pair an element with itself, nor to give the same pair twice when a group is given more than once
+  // the optional predicate is asked about each partial candidate, so that a failing first slot skips every candidate starting with it
+  // its arguments are the slot just filled and the indices of the candidate up to that slot, here requiring the leptons to be of opposite charge
+  // these indexers also fill the index list of the aggregate in place, instead of returning a new one every event
+  Aggregate gen_dilepton("gen_dilepton", 1, 4, gen_lepton, gen_lepton);
+  gen_dilepton.set_indexer(combination_indexer<2>([&charge = gen_lepton.get<int>("charge")] (int slot, const std::array<int, 2> &idx) {
+                             return slot == 0 or charge[idx[0]] != charge[idx[1]];
+                           }));
+  gen_dilepton.add_attribute("mass", invariant_mass, 
+                             "gen_lepton::pt", "gen_lepton::eta", "gen_lepton::phi", "gen_lepton::mass", 
+                             "gen_lepton::pt", "gen_lepton::eta", "gen_lepton::phi", "gen_lepton::mass");
+
+  // at the detector level the top quarks are not seen, and have to be reconstructed from their decay products
+  // in the dileptonic channel the two neutrinos escape, and only the sum of their transverse momenta is measured
+  // the solver recovers them from the W and top mass constraints, for every pairing of the leptons and b jets in the event
+  // here it is run on the generator-level objects, as a stand-in for their reconstructed counterparts
+  // the argument is the number of times each pairing is solved, with the jet energies and masses smeared each time
+  // the pairings having a solution are returned best first, as an indexer for an aggregate of (lepton, lepton, jet, jet)
+  TTbarDileptonSolver<float> solver(100);
+  Aggregate reco_ttbar("reco_ttbar", 18, 4, gen_lepton, gen_lepton, gen_jet, gen_jet);
+  reco_ttbar.set_indexer([&solver, &gen_met] (const auto &g1, const auto &, const auto &g3, const auto &)
+                         -> std::vector<std::array<int, 4>> {
+                           // only the jets originating from a bottom quark are considered
+                           auto bottom = g3.filter([] (int flavour) { return std::abs(flavour) == 5; }, "flavour");
+                           return solver.solve(g1, g1.ref_to_indices(), g3, bottom, gen_met);
+                         });
+
+  // the reconstructed top, antitop, lepton and antilepton kinematics, plus the solution weight, as attributes
+  solver.add_attributes(reco_ttbar);
+
+  // which are everything that is needed to compute the spin correlation observables
+  reco_ttbar.transform_attribute("cHel", cHel<float>,
+                                 "top_pt", "top_eta", "top_phi", "top_mass", "antitop_pt", "antitop_eta", "antitop_phi", "antitop_mass",
+                                 "lepton_pt", "lepton_eta", "lepton_phi", "lepton_mass", "antilepton_pt", "antilepton_eta", "antilepton_phi", "antilepton_mass");
+
   // let's histogram the attributes we defined above
   // this is done through the histogram class, which handles a group of histograms sharing the same weights and to be filled at the same time
   // in this example we will have two instances, before and after some acceptance cuts
@@ -493,6 +619,16 @@ int main() {
   hist_no_cut.make_histogram<TH1F>(filler_first_of(gen_tt_ll_bb, "lbbar_mass"), "lbbar_mass_no_cut", "", 100, 0.f, 200.f);
   hist_no_cut.make_histogram<TH1F>(filler_first_of(gen_tt_ll_bb, "lbarb_mass"), "lbarb_mass_no_cut", "", 100, 0.f, 200.f);
 
+  // filler_all_of fills every element, here each matched bottom-jet pair
+  hist_no_cut.make_histogram<TH1F>(filler_all_of(gen_bottom_jet, "dR"), "bottom_jet_dR_no_cut", "", 40, 0.f, 0.4f);
+  hist_no_cut.make_histogram<TH1F>(filler_all_of(gen_bottom_jet, "response"), "bottom_jet_response_no_cut", "", 100, 0.f, 2.f);
+
+  hist_no_cut.make_histogram<TH1F>(filler_all_of(gen_dilepton, "mass"), "dilepton_mass_no_cut", "", 100, 0.f, 500.f);
+
+  // the first element of reco_ttbar is the best pairing
+  hist_no_cut.make_histogram<TH1F>(filler_first_of(reco_ttbar, "top_pt"), "reco_top_pt_no_cut", "", 100, 0.f, 500.f);
+  hist_no_cut.make_histogram<TH1F>(filler_first_of(reco_ttbar, "cHel"), "reco_cHel_no_cut", "", 20, -1.f, 1.f);
+
   // let's define another histogram instance but now with acceptance cuts
   // we can, but don't need to, define the cuts in the filling function themselves
   // so the histogram instance is defined identically as above except the histogram names
@@ -519,11 +655,25 @@ int main() {
   hist_cut.make_histogram<TH1F>(filler_first_of(gen_tt_ll_bb, "lbbar_mass"), "lbbar_mass_cut", "", 100, 0.f, 200.f);
   hist_cut.make_histogram<TH1F>(filler_first_of(gen_tt_ll_bb, "lbarb_mass"), "lbarb_mass_cut", "", 100, 0.f, 200.f);
 
+  // it is often useful to know how many events, and how much weight, survive each step of the selection
+  // for this we have the cutflow class, whose steps are declared in advance
+  // add_step returns an index which is then used to count the events passing that step
+  Cutflow cutflow("cutflow");
+  const int step_all = cutflow.add_step("all");
+  const int step_tt_ll_bb = cutflow.add_step("dileptonic_ttbar");
+  const int step_acceptance = cutflow.add_step("acceptance");
+
+  // registering the cutflow with the dataset prints its table at the end of the analysis
+  dat.add_cutflow(cutflow);
+
   // if the unbinned values are needed we can save them as flat trees
   // just like the histogram object we start by instantiating the object
   // args are the file and tree names we want to save out
   // optionally also the compression setting
-  Tree tree_gen("gen_smtt_kinematic_cut.root", "tree");
+  // the file is recreated here, so a resumed job writes into another one, leaving the entries saved before the snapshot intact
+  // resumed_filename gives the first of gen_smtt_kinematic_cut_resumed.root, ..._resumed_2.root etc that does not exist yet
+  const std::string tree_file = "gen_smtt_kinematic_cut" + suffix + ".root";
+  Tree tree_gen((arg_resume.getValue()) ? Snapshot::resumed_filename(tree_file) : tree_file, "tree");
 
   // two types of branches are supported - single and array
   // by calling the respective methods as shown below
@@ -547,16 +697,31 @@ int main() {
   // that captures the references to all the collections, aggregates and histograms we defined above
   // the only argument to this function is the entry number
   // one way to think about this function is that it contains the instructions on how to analyze a single event
-  auto f_analyze = [&metadata, &gen_particle, &gen_ttbar, &gen_tt_ll_bb, &hist_no_cut, &hist_cut, &tree_gen] (long long entry) {
+  auto f_analyze = [&metadata, &gen_particle, &gen_jet, &gen_lepton, &gen_met, &cleaning, &gen_ttbar, &gen_tt_ll_bb, &gen_bottom_jet, &gen_dilepton, &reco_ttbar, &hist_no_cut, &hist_cut, &tree_gen, 
+                    &cutflow, step_all, step_tt_ll_bb, step_acceptance, &weight = metadata.get<float>("weight")] (long long entry) {
     // first we start by populating the collections
     // this is essentially equivalent of the tree->GetEntry(entry)
     // with the (compulsory) freedom of timing the call separately for each group
     metadata.populate(entry);
     gen_particle.populate(entry);
+    gen_jet.populate(entry);
+    gen_lepton.populate(entry);
+    gen_met.populate(entry);
+
+    // select the leptons and jets within the acceptance, and clean the jets against the leptons
+    gen_lepton.update_indices( gen_lepton.filter([] (float pt, float eta) { return pt > 20.f and std::abs(eta) < 2.4f; }, "pt", "eta") );
+    gen_jet.update_indices( gen_jet.filter([] (float pt, float eta) { return pt > 30.f and std::abs(eta) < 2.4f; }, "pt", "eta") );
+    cleaning.run();
 
     // since the collections serve as input to the aggregates, they need to be populated first
     gen_ttbar.populate(entry);
     gen_tt_ll_bb.populate(entry);
+    gen_bottom_jet.populate(entry);
+    gen_dilepton.populate(entry);
+    reco_ttbar.populate(entry);
+
+    // count the event into the cutflow, with the same weight as is used for the histograms
+    cutflow.count(step_all, weight[0]);
 
     // we make an oversimplification here, considering only the events where gen_tt_ll_bb contain an element
     // this is because in the above, we have grouped the gen_ttbar and gen_tt_ll_bb histograms together
@@ -565,6 +730,7 @@ int main() {
     // when this aggregate is empty e.g. when we have taus in the event
     if (!gen_tt_ll_bb.n_elements())
       return;
+    cutflow.count(step_tt_ll_bb, weight[0]);
 
     // fill the no (acceptance) cut histograms
     hist_no_cut.fill();
@@ -593,6 +759,7 @@ int main() {
     // if all four objects pass the cut, then gen_particle will have 4 elements left
     // fill also our tree at this point
     if (gen_particle.n_elements() == 4) {
+      cutflow.count(step_acceptance, weight[0]);
       hist_cut.fill();
       tree_gen.fill();
     }
@@ -617,14 +784,43 @@ int main() {
   // tell the dataset instance about our event analyzer function
   dat.set_analyzer(f_analyze);
 
+  // restrict the dataset to the requested shard, if any
+  // the shards are aligned to the cluster boundaries of the files, so no two jobs read the same baskets
+  if (arg_shard.getValue() != "")
+    dat.shard(arg_shard.getValue());
+
+  // for long jobs it is worth saving the outputs periodically while the analysis runs, e.g. ./example_gen_ttbar --snapshot snapshot_gen_ttbar.root
+  // here a snapshot is taken every million events or every 10 minutes, whichever comes first
+  // should the job be killed, running it again with --resume added picks up after the last snapshot
+  // the cutflow registered with the dataset above is included by itself, while the histograms and trees are added here
+  std::unique_ptr<Snapshot> snapshot;
+  if (arg_snapshot.getValue() != "") {
+    snapshot = std::make_unique<Snapshot>(arg_snapshot.getValue(), 1000000LL, 600.);
+    snapshot->add_histogram(hist_no_cut);
+    snapshot->add_histogram(hist_cut);
+    snapshot->add_tree(tree_gen);
+    dat.set_snapshot(*snapshot);
+  }
+
+  // batch jobs can also report how far along they are, with the events/s, MB/s read and the ETA
+  // here every minute to stderr, and into a json file that a monitoring script can poll
+  Progress progress(60., "status_gen_ttbar" + suffix + ".json");
+  dat.set_progress(progress);
+
+  // the aggregates are not associated to the dataset, so they are registered with the memory accounting directly
+  memory.add_group(gen_ttbar, gen_dilepton, reco_ttbar);
+
   // and run it!
   // for analyzing only a subset, provide as argument the desired number of events
-  dat.analyze();
+  // the third argument resumes from the snapshot, if one is set
+  dat.analyze(-1LL, -1LL, arg_resume.getValue());
 
   // when all is said and done, we collect the output
   // which we can plot, or perform statistical tests etc
-  hist_no_cut.save_as("hist_no_cut.root");
-  hist_cut.save_as("hist_cut.root");
+  hist_no_cut.save_as("hist_no_cut" + suffix + ".root");
+  hist_cut.save_as("hist_cut" + suffix + ".root");
+  // the cutflow histograms are by default added to an existing file
+  cutflow.save_as("hist_cut" + suffix + ".root");
   tree_gen.save();
 
   return 0;
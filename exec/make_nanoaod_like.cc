@@ -0,0 +1,375 @@
+// writes flat ROOT files with nanoAOD-shaped branches, for benchmarking the framework without access to the real samples
+// compile:
+// filename=make_nanoaod_like; g++ $(root-config --cflags --evelibs) -std=c++17 -O3 -Wall -Wextra -Wpedantic -Werror -Wno-float-equal -Wno-sign-compare -I ../plugins/ -I ../src/ -o ${filename} ${filename}.cc
+// run e.g. as ./make_nanoaod_like --output nanoaod_like --files 4 --events 100000 --compression 505
+// which writes nanoaod_like_0.root ... nanoaod_like_3.root, to be read by exec/benchmark_pipeline.cc
+// each event is a dileptonic-ish ttbar event, with the top decay chain written the way nanoAOD does, i.e. with first and last copies
+// plus a soup of other generator particles, generator jets and dressed leptons, the generator MET and reconstructed muons
+// the kinematics are only roughly realistic, but the branch names, types and multiplicities are as in the real thing
+// the content is a function of the seed and the event number alone, so that the files are the same on every machine and every run
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TLorentzVector.h"
+
+#include "misc/synthetic_group.h"
+
+// command line parsing
+#include "tclap/CmdLine.h"
+
+#include <numeric>
+
+// the per-event buffers the branches are written from
+struct Event {
+  static constexpr int max_gen = 512, max_jet = 64, max_lepton = 16, max_muon = 32;
+
+  uint run, lumi;
+  unsigned long long event;
+  float weight, lhe_weight;
+
+  uint n_gen;
+  float gen_pt[max_gen], gen_eta[max_gen], gen_phi[max_gen], gen_mass[max_gen];
+  int gen_pdg[max_gen], gen_status[max_gen], gen_flag[max_gen], gen_mother[max_gen];
+
+  uint n_jet;
+  float jet_pt[max_jet], jet_eta[max_jet], jet_phi[max_jet], jet_mass[max_jet];
+  int jet_flavour[max_jet];
+
+  uint n_lepton;
+  float lepton_pt[max_lepton], lepton_eta[max_lepton], lepton_phi[max_lepton], lepton_mass[max_lepton];
+  int lepton_pdg[max_lepton];
+
+  float met_pt, met_phi;
+
+  uint n_muon;
+  float muon_pt[max_muon], muon_eta[max_muon], muon_phi[max_muon], muon_mass[max_muon];
+  float muon_dxy[max_muon], muon_dxy_error[max_muon], muon_dz[max_muon], muon_dz_error[max_muon];
+  float muon_iso03[max_muon], muon_iso04[max_muon];
+  int muon_charge[max_muon], muon_gen_index[max_muon];
+  bool muon_loose[max_muon], muon_medium[max_muon], muon_tight[max_muon];
+};
+
+
+
+// nanoAOD GenPart_statusFlags bits
+constexpr int is_prompt = 1, is_hard_process = 128, from_hard_process = 256, is_first_copy = 4096, is_last_copy = 8192;
+
+constexpr double mass_top = 172.5, width_top = 1.4, mass_w = 80.4, width_w = 2.1, mass_b = 4.8;
+
+// a relativistic breit-wigner, truncated at 5 widths
+double breit_wigner(SyntheticRandom &rng, double mass, double width)
+{
+  double value = 0.;
+  do {
+    value = mass + (0.5 * width * std::tan(M_PI * (rng.uniform() - 0.5)));
+  } while (std::abs(value - mass) > 5. * width);
+
+  return value;
+}
+
+
+
+// isotropic two-body decay in the rest frame of the parent, boosted to the lab
+std::pair<TLorentzVector, TLorentzVector> decay(SyntheticRandom &rng, const TLorentzVector &parent, double m1, double m2)
+{
+  const double m = parent.M();
+  const double p = std::sqrt(std::max((m * m - (m1 + m2) * (m1 + m2)) * (m * m - (m1 - m2) * (m1 - m2)), 0.)) / (2. * m);
+  const double cos_theta = rng.uniform(-1., 1.), sin_theta = std::sqrt(1. - (cos_theta * cos_theta)), phi = rng.uniform(-M_PI, M_PI);
+
+  TLorentzVector d1, d2;
+  d1.SetXYZM(p * sin_theta * std::cos(phi), p * sin_theta * std::sin(phi), p * cos_theta, m1);
+  d2.SetXYZM(-d1.Px(), -d1.Py(), -d1.Pz(), m2);
+
+  d1.Boost(parent.BoostVector());
+  d2.Boost(parent.BoostVector());
+  return {d1, d2};
+}
+
+
+
+void generate(SyntheticRandom &rng, Event &evt)
+{
+  evt.n_gen = 0;
+  auto add_gen = [&evt] (int pdg, int status, int flag, int mother, const TLorentzVector &p4) -> int {
+    if (evt.n_gen == Event::max_gen)
+      return -1;
+
+    const int idx = evt.n_gen++;
+    evt.gen_pdg[idx] = pdg;
+    evt.gen_status[idx] = status;
+    evt.gen_flag[idx] = flag;
+    evt.gen_mother[idx] = mother;
+
+    // as in nanoAOD, particles along the beam get a large but finite eta
+    evt.gen_pt[idx] = p4.Pt();
+    evt.gen_eta[idx] = (p4.Pt() > 1e-3) ? p4.Eta() : std::copysign(20000., p4.Pz());
+    evt.gen_phi[idx] = (p4.Pt() > 1e-3) ? p4.Phi() : 0.;
+    evt.gen_mass[idx] = std::max(p4.M(), 0.);
+    return idx;
+  };
+
+  // the incoming gluons
+  const double x1 = rng.uniform(0.02, 0.2), x2 = rng.uniform(0.02, 0.2);
+  const int beam1 = add_gen(21, 21, is_hard_process | from_hard_process | is_first_copy | is_last_copy, -1, TLorentzVector(0., 0., 6500. * x1, 6500. * x1));
+  add_gen(21, 21, is_hard_process | from_hard_process | is_first_copy | is_last_copy, -1, TLorentzVector(0., 0., -6500. * x2, 6500. * x2));
+
+  // the ttbar system, with a transverse kick from initial state radiation
+  TLorentzVector ttbar;
+  const double mtt = std::max(2. * mass_top + 5., 2. * mass_top + rng.exponential(120.));
+  const double pt_tt = rng.exponential(40.), phi_tt = rng.uniform(-M_PI, M_PI);
+  ttbar.SetPtEtaPhiM(pt_tt, rng.normal(0., 1.2), phi_tt, mtt);
+  auto [top, antitop] = decay(rng, ttbar, breit_wigner(rng, mass_top, width_top), breit_wigner(rng, mass_top, width_top));
+
+  std::array<int, 2> last_w = {-1, -1};
+  std::array<TLorentzVector, 2> w_p4;
+  std::vector<std::pair<int, TLorentzVector>> quarks;
+  for (int iT = 0; iT < 2; ++iT) {
+    const int sign = (iT == 0) ? 1 : -1;
+    const auto &t_p4 = (iT == 0) ? top : antitop;
+
+    // the top, its last copy after radiating, and its decay into a W and a bottom
+    const int first = add_gen(6 * sign, 22, is_prompt | is_hard_process | from_hard_process | is_first_copy, beam1, t_p4);
+    const int last = add_gen(6 * sign, 62, is_prompt | from_hard_process | is_last_copy, first, t_p4);
+
+    auto [w, b] = decay(rng, t_p4, breit_wigner(rng, mass_w, width_w), mass_b);
+    const int first_w = add_gen(24 * sign, 22, is_prompt | is_hard_process | from_hard_process | is_first_copy, last, w);
+    const int bottom = add_gen(5 * sign, 23, is_prompt | is_hard_process | from_hard_process | is_first_copy | is_last_copy, last, b);
+    last_w[iT] = add_gen(24 * sign, 52, is_prompt | from_hard_process | is_last_copy, first_w, w);
+    w_p4[iT] = w;
+    quarks.emplace_back(bottom, b);
+  }
+
+  // the W decays: e, mu and tau with a ninth each, hadrons otherwise
+  double met_x = 0., met_y = 0.;
+  std::vector<int> leptons;
+  for (int iW = 0; iW < 2; ++iW) {
+    const int sign = (iW == 0) ? 1 : -1;
+    const int mode = rng.integer(0, 8);
+
+    if (mode < 3) {
+      const int flavour = 11 + (2 * mode);
+      const double mass_l = (mode == 0) ? 0.000511 : (mode == 1) ? 0.1057 : 1.777;
+      auto [l, nu] = decay(rng, w_p4[iW], mass_l, 0.);
+
+      const int flag = is_prompt | is_hard_process | from_hard_process | is_first_copy | is_last_copy;
+      leptons.emplace_back(add_gen(-flavour * sign, (mode < 2) ? 1 : 2, flag, last_w[iW], l));
+      add_gen((flavour + 1) * sign, 1, flag, last_w[iW], nu);
+      met_x += nu.Px();
+      met_y += nu.Py();
+    }
+    else {
+      const int up = (mode < 6) ? 2 : 4;
+      auto [q1, q2] = decay(rng, w_p4[iW], 0.3, 0.3);
+      const int flag = is_prompt | is_hard_process | from_hard_process | is_first_copy | is_last_copy;
+      quarks.emplace_back(add_gen(up * sign, 23, flag, last_w[iW], q1), q1);
+      quarks.emplace_back(add_gen(-(up - 1) * sign, 23, flag, last_w[iW], q2), q2);
+    }
+  }
+
+  // everything else: radiation, hadrons and their decay products, with mothers among the particles before them
+  constexpr std::array<int, 10> soup = {21, 21, 1, -1, 2, -2, 22, 111, 211, -211};
+  const int n_soup = std::min(rng.poisson(nanoaod_multiplicity::gen_particle.mean), nanoaod_multiplicity::gen_particle.max) - int(evt.n_gen);
+  for (int iS = 0; iS < n_soup; ++iS) {
+    TLorentzVector p4;
+    const int pdg = soup[rng.integer(0, soup.size() - 1)];
+    p4.SetPtEtaPhiM(0.5 + rng.exponential(6.), rng.normal(0., 3.), rng.uniform(-M_PI, M_PI), (std::abs(pdg) > 100) ? 0.14 : 0.);
+    const int mother = (rng.uniform() < 0.1) ? -1 : rng.integer(0, evt.n_gen - 1);
+    add_gen(pdg, (rng.uniform() < 0.5) ? 1 : 71, static_cast<int>(rng.next() & 0x0c7eULL), mother, p4);
+  }
+
+  // generator jets: the quarks, smeared, plus some from the radiation, ordered by pt as in nanoAOD
+  std::vector<std::pair<TLorentzVector, int>> jets;
+  for (const auto &[idx, p4] : quarks) {
+    TLorentzVector jet;
+    jet.SetPtEtaPhiM(p4.Pt() * std::max(rng.normal(0.95, 0.1), 0.1), p4.Eta() + rng.normal(0., 0.03), p4.Phi() + rng.normal(0., 0.03),
+                     std::max(rng.normal(8., 3.), 0.5));
+    if (jet.Pt() > 10.)
+      jets.emplace_back(jet, evt.gen_pdg[idx]);
+  }
+  const int n_radiation = rng.poisson(6.);
+  for (int iJ = 0; iJ < n_radiation; ++iJ) {
+    TLorentzVector jet;
+    jet.SetPtEtaPhiM(10. + rng.exponential(20.), rng.normal(0., 2.), rng.uniform(-M_PI, M_PI), std::max(rng.normal(5., 2.), 0.5));
+    jets.emplace_back(jet, (rng.uniform() < 0.6) ? 21 : 0);
+  }
+  std::sort(std::begin(jets), std::end(jets), [] (const auto &j1, const auto &j2) { return j1.first.Pt() > j2.first.Pt(); });
+
+  evt.n_jet = std::min(int(jets.size()), Event::max_jet);
+  for (int iJ = 0; iJ < evt.n_jet; ++iJ) {
+    evt.jet_pt[iJ] = jets[iJ].first.Pt();
+    evt.jet_eta[iJ] = jets[iJ].first.Eta();
+    evt.jet_phi[iJ] = jets[iJ].first.Phi();
+    evt.jet_mass[iJ] = jets[iJ].first.M();
+    evt.jet_flavour[iJ] = jets[iJ].second;
+  }
+
+  // dressed leptons: the electrons and muons from the W decays
+  evt.n_lepton = 0;
+  for (auto idx : leptons) {
+    if (std::abs(evt.gen_pdg[idx]) == 15 or evt.n_lepton == Event::max_lepton)
+      continue;
+
+    const int iL = evt.n_lepton++;
+    evt.lepton_pt[iL] = evt.gen_pt[idx] * std::max(rng.normal(1.01, 0.01), 0.5);
+    evt.lepton_eta[iL] = evt.gen_eta[idx];
+    evt.lepton_phi[iL] = evt.gen_phi[idx];
+    evt.lepton_mass[iL] = evt.gen_mass[idx];
+    evt.lepton_pdg[iL] = evt.gen_pdg[idx];
+  }
+
+  met_x += rng.normal(0., 5.);
+  met_y += rng.normal(0., 5.);
+  evt.met_pt = std::hypot(met_x, met_y);
+  evt.met_phi = std::atan2(met_y, met_x);
+
+  // reconstructed muons: the prompt ones with some inefficiency, plus a few fakes
+  evt.n_muon = 0;
+  auto add_muon = [&rng, &evt] (float pt, float eta, float phi, int charge, int gen_index) {
+    if (evt.n_muon == Event::max_muon)
+      return;
+
+    const int iM = evt.n_muon++;
+    evt.muon_pt[iM] = pt;
+    evt.muon_eta[iM] = eta;
+    evt.muon_phi[iM] = phi;
+    evt.muon_mass[iM] = 0.1057f;
+    evt.muon_charge[iM] = charge;
+    evt.muon_gen_index[iM] = gen_index;
+
+    const bool prompt = gen_index > -1;
+    evt.muon_dxy[iM] = rng.normal(0., prompt ? 0.002 : 0.05);
+    evt.muon_dxy_error[iM] = 0.001 + rng.exponential(0.002);
+    evt.muon_dz[iM] = rng.normal(0., prompt ? 0.005 : 0.1);
+    evt.muon_dz_error[iM] = 0.002 + rng.exponential(0.004);
+    evt.muon_iso03[iM] = rng.exponential(prompt ? 0.03 : 0.5);
+    evt.muon_iso04[iM] = evt.muon_iso03[iM] * rng.uniform(1., 1.5);
+    evt.muon_loose[iM] = prompt or rng.uniform() < 0.7;
+    evt.muon_medium[iM] = evt.muon_loose[iM] and (prompt or rng.uniform() < 0.4);
+    evt.muon_tight[iM] = evt.muon_medium[iM] and (prompt or rng.uniform() < 0.3);
+  };
+
+  for (auto idx : leptons) {
+    if (std::abs(evt.gen_pdg[idx]) == 13 and std::abs(evt.gen_eta[idx]) < 2.4f and rng.uniform() < 0.95)
+      add_muon(evt.gen_pt[idx] * rng.normal(1., 0.02), evt.gen_eta[idx], evt.gen_phi[idx], (evt.gen_pdg[idx] > 0) ? -1 : 1, idx);
+  }
+
+  const int n_fake = rng.poisson(0.4);
+  for (int iF = 0; iF < n_fake; ++iF)
+    add_muon(3. + rng.exponential(5.), rng.uniform(-2.4, 2.4), rng.uniform(-M_PI, M_PI), (rng.uniform() < 0.5) ? -1 : 1, -1);
+
+  // nanoAOD orders the muons by pt too, the gen indices are carried along
+  std::vector<int> order(evt.n_muon);
+  std::iota(std::begin(order), std::end(order), 0);
+  std::sort(std::begin(order), std::end(order), [&evt] (int m1, int m2) { return evt.muon_pt[m1] > evt.muon_pt[m2]; });
+
+  auto permute = [&order] (auto *arr) {
+    std::array<std::remove_pointer_t<decltype(arr)>, Event::max_muon> copy;
+    for (int iM = 0; iM < order.size(); ++iM)
+      copy[iM] = arr[order[iM]];
+    std::copy(std::begin(copy), std::begin(copy) + order.size(), arr);
+  };
+  permute(evt.muon_pt); permute(evt.muon_eta); permute(evt.muon_phi); permute(evt.muon_mass);
+  permute(evt.muon_dxy); permute(evt.muon_dxy_error); permute(evt.muon_dz); permute(evt.muon_dz_error);
+  permute(evt.muon_iso03); permute(evt.muon_iso04); permute(evt.muon_charge); permute(evt.muon_gen_index);
+  permute(evt.muon_loose); permute(evt.muon_medium); permute(evt.muon_tight);
+
+  // powheg-like weights, with a small fraction of negative ones
+  evt.weight = (rng.uniform() < 0.004) ? -72.3f : 72.3f;
+  evt.lhe_weight = std::abs(evt.weight);
+}
+
+
+
+int main(int argc, char** argv) {
+  TCLAP::CmdLine cmdline("writes flat ROOT files with nanoAOD-shaped branches", ' ', "1.0");
+  TCLAP::ValueArg<std::string> arg_output("", "output", "prefix of the output files, which are named prefix_i.root", false, "nanoaod_like", "string", cmdline);
+  TCLAP::ValueArg<int> arg_file("", "files", "number of files to write", false, 1, "int", cmdline);
+  TCLAP::ValueArg<int> arg_event("", "events", "number of events per file", false, 10000, "int", cmdline);
+  TCLAP::ValueArg<int> arg_compression("", "compression", "ROOT compression setting i.e. 100 * algorithm + level, e.g. 404 for LZ4 or 505 for ZSTD",
+                                       false, 505, "int", cmdline);
+  TCLAP::ValueArg<int> arg_cluster("", "cluster", "number of entries per TTree cluster, 0 for the ROOT default", false, 0, "int", cmdline);
+  TCLAP::ValueArg<int> arg_seed("", "seed", "seed of the generation, the same seed giving the same files", false, 0, "int", cmdline);
+  cmdline.parse(argc, argv);
+
+  if (arg_file.getValue() < 1 or arg_event.getValue() < 1)
+    throw std::invalid_argument( "ERROR: make_nanoaod_like: the number of files and events per file must be positive!!" );
+
+  auto evt = std::make_unique<Event>();
+  evt->run = 1U;
+
+  for (int iF = 0; iF < arg_file.getValue(); ++iF) {
+    const std::string filename = arg_output.getValue() + "_" + std::to_string(iF) + ".root";
+    auto file = std::unique_ptr<TFile>(TFile::Open(filename.c_str(), "recreate", "", arg_compression.getValue()));
+    if (file == nullptr or file->IsZombie())
+      throw std::runtime_error( "ERROR: make_nanoaod_like: unable to open " + filename + " for writing!!" );
+
+    auto tree = new TTree("Events", "Events");
+    if (arg_cluster.getValue() > 0)
+      tree->SetAutoFlush(arg_cluster.getValue());
+
+    tree->Branch("run", &evt->run, "run/i");
+    tree->Branch("luminosityBlock", &evt->lumi, "luminosityBlock/i");
+    tree->Branch("event", &evt->event, "event/l");
+    tree->Branch("genWeight", &evt->weight, "genWeight/F");
+    tree->Branch("LHEWeight_originalXWGTUP", &evt->lhe_weight, "LHEWeight_originalXWGTUP/F");
+
+    tree->Branch("nGenPart", &evt->n_gen, "nGenPart/i");
+    tree->Branch("GenPart_pt", evt->gen_pt, "GenPart_pt[nGenPart]/F");
+    tree->Branch("GenPart_eta", evt->gen_eta, "GenPart_eta[nGenPart]/F");
+    tree->Branch("GenPart_phi", evt->gen_phi, "GenPart_phi[nGenPart]/F");
+    tree->Branch("GenPart_mass", evt->gen_mass, "GenPart_mass[nGenPart]/F");
+    tree->Branch("GenPart_pdgId", evt->gen_pdg, "GenPart_pdgId[nGenPart]/I");
+    tree->Branch("GenPart_status", evt->gen_status, "GenPart_status[nGenPart]/I");
+    tree->Branch("GenPart_statusFlags", evt->gen_flag, "GenPart_statusFlags[nGenPart]/I");
+    tree->Branch("GenPart_genPartIdxMother", evt->gen_mother, "GenPart_genPartIdxMother[nGenPart]/I");
+
+    tree->Branch("nGenJet", &evt->n_jet, "nGenJet/i");
+    tree->Branch("GenJet_pt", evt->jet_pt, "GenJet_pt[nGenJet]/F");
+    tree->Branch("GenJet_eta", evt->jet_eta, "GenJet_eta[nGenJet]/F");
+    tree->Branch("GenJet_phi", evt->jet_phi, "GenJet_phi[nGenJet]/F");
+    tree->Branch("GenJet_mass", evt->jet_mass, "GenJet_mass[nGenJet]/F");
+    tree->Branch("GenJet_partonFlavour", evt->jet_flavour, "GenJet_partonFlavour[nGenJet]/I");
+
+    tree->Branch("nGenDressedLepton", &evt->n_lepton, "nGenDressedLepton/i");
+    tree->Branch("GenDressedLepton_pt", evt->lepton_pt, "GenDressedLepton_pt[nGenDressedLepton]/F");
+    tree->Branch("GenDressedLepton_eta", evt->lepton_eta, "GenDressedLepton_eta[nGenDressedLepton]/F");
+    tree->Branch("GenDressedLepton_phi", evt->lepton_phi, "GenDressedLepton_phi[nGenDressedLepton]/F");
+    tree->Branch("GenDressedLepton_mass", evt->lepton_mass, "GenDressedLepton_mass[nGenDressedLepton]/F");
+    tree->Branch("GenDressedLepton_pdgId", evt->lepton_pdg, "GenDressedLepton_pdgId[nGenDressedLepton]/I");
+
+    tree->Branch("GenMET_pt", &evt->met_pt, "GenMET_pt/F");
+    tree->Branch("GenMET_phi", &evt->met_phi, "GenMET_phi/F");
+
+    tree->Branch("nMuon", &evt->n_muon, "nMuon/i");
+    tree->Branch("Muon_pt", evt->muon_pt, "Muon_pt[nMuon]/F");
+    tree->Branch("Muon_eta", evt->muon_eta, "Muon_eta[nMuon]/F");
+    tree->Branch("Muon_phi", evt->muon_phi, "Muon_phi[nMuon]/F");
+    tree->Branch("Muon_mass", evt->muon_mass, "Muon_mass[nMuon]/F");
+    tree->Branch("Muon_charge", evt->muon_charge, "Muon_charge[nMuon]/I");
+    tree->Branch("Muon_dxy", evt->muon_dxy, "Muon_dxy[nMuon]/F");
+    tree->Branch("Muon_dxyErr", evt->muon_dxy_error, "Muon_dxyErr[nMuon]/F");
+    tree->Branch("Muon_dz", evt->muon_dz, "Muon_dz[nMuon]/F");
+    tree->Branch("Muon_dzErr", evt->muon_dz_error, "Muon_dzErr[nMuon]/F");
+    tree->Branch("Muon_pfRelIso03_all", evt->muon_iso03, "Muon_pfRelIso03_all[nMuon]/F");
+    tree->Branch("Muon_pfRelIso04_all", evt->muon_iso04, "Muon_pfRelIso04_all[nMuon]/F");
+    tree->Branch("Muon_genPartIdx", evt->muon_gen_index, "Muon_genPartIdx[nMuon]/I");
+    tree->Branch("Muon_looseId", evt->muon_loose, "Muon_looseId[nMuon]/O");
+    tree->Branch("Muon_mediumId", evt->muon_medium, "Muon_mediumId[nMuon]/O");
+    tree->Branch("Muon_tightId", evt->muon_tight, "Muon_tightId[nMuon]/O");
+
+    for (int iE = 0; iE < arg_event.getValue(); ++iE) {
+      // numbered across the files, so that no two events anywhere share the same content
+      evt->event = (static_cast<unsigned long long>(iF) * arg_event.getValue()) + iE + 1ULL;
+      evt->lumi = 1U + static_cast<uint>(evt->event / 1000ULL);
+
+      SyntheticRandom rng(SyntheticRandom::mix(arg_seed.getValue(), evt->event));
+      generate(rng, *evt);
+      tree->Fill();
+    }
+
+    file->Write();
+    std::cout << "Written " << tree->GetEntries() << " events into " << filename << " (" << file->GetSize() / 1048576. << " MB)" << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,120 @@
+// merging of the histogram and tree outputs of a sample that is split across many jobs
+// a parallel replacement for hadd, built on the Histogram and merge_trees of the framework
+// compile:
+// filename=merge_output; g++ $(root-config --cflags --evelibs) -std=c++17 -O3 -Wall -Wextra -Wpedantic -Werror -Wno-float-equal -Wno-sign-compare -I ../plugins/ -I ../src/ -o ${filename} ${filename}.cc
+// usage:
+// ./merge_output --output hist_ttbar.root --threads 8 --weight xsec=831.76 --weight lumi=59.7 --scale-by xsec --scale-by lumi hist_*.root
+// ./merge_output --output tree_ttbar.root --tree tree tree_*.root
+
+#include <fstream>
+#include <thread>
+
+#include "Dataset.h"
+#include "Histogram.h"
+#include "Cutflow.h"
+#include "Tree.h"
+
+#include "TROOT.h"
+
+#include "tclap/CmdLine.h"
+
+int main(int argc, char** argv) {
+  using namespace Framework;
+
+  TCLAP::CmdLine cmdline("merge the histogram or tree outputs of jobs running over the same sample", ' ', "1.0");
+  TCLAP::ValueArg<std::string> arg_output("o", "output", "output file", true, "", "string", cmdline);
+  TCLAP::ValueArg<std::string> arg_list("l", "list", "text file listing the inputs, one per line, in addition to the ones given as arguments",
+                                        false, "", "string", cmdline);
+  TCLAP::ValueArg<std::string> arg_tree("", "tree", "merge the trees of this name instead of the histograms", false, "", "string", cmdline);
+  TCLAP::ValueArg<int> arg_compression("", "compression", "compression setting of the merged tree, default is to take that of the inputs",
+                                       false, -1, "int", cmdline);
+  TCLAP::ValueArg<int> arg_thread("t", "threads", "number of threads to merge the histograms with", false, 1, "int", cmdline);
+  TCLAP::MultiArg<std::string> arg_weight("w", "weight", "weight of the dataset as name=value, as in Dataset::add_weight", false, "string", cmdline);
+  TCLAP::MultiArg<std::string> arg_scale("s", "scale-by", "name of the dataset weight to scale the histograms by, save the raw cutflow counts; "
+                                         "can be repeated, in which case the product is taken", false, "string", cmdline);
+  TCLAP::UnlabeledMultiArg<std::string> arg_input("inputs", "input files", false, "string", cmdline);
+  cmdline.parse(argc, argv);
+
+  std::vector<std::string> v_input = arg_input.getValue();
+  if (arg_list.getValue() != "") {
+    std::ifstream list(arg_list.getValue());
+    for (std::string line; std::getline(list, line); ) {
+      if (line != "")
+        v_input.emplace_back(line);
+    }
+  }
+
+  if (v_input.empty()) {
+    std::cerr << "No input files are given, nothing to do." << std::endl;
+    return 1;
+  }
+
+  // trees are merged serially, by copying the compressed baskets whenever possible
+  if (arg_tree.getValue() != "") {
+    auto nentry = merge_trees(v_input, arg_output.getValue(), arg_tree.getValue(), arg_compression.getValue());
+    std::cout << "Merged " << nentry << " entries of tree " << arg_tree.getValue() << " from " << v_input.size() << " files into " <<
+      arg_output.getValue() << std::endl;
+    return 0;
+  }
+
+  // the dataset is used only as the holder of the weights
+  Dataset<TChain> dat("merge", "");
+  for (const auto &weight : arg_weight.getValue()) {
+    const auto iEq = weight.find('=');
+    if (iEq == std::string::npos or !dat.add_weight(weight.substr(0, iEq), std::stod(weight.substr(iEq + 1)))) {
+      std::cerr << "Weight " << weight << " is either malformed or duplicated. Aborting!!" << std::endl;
+      return 1;
+    }
+  }
+
+  // an unknown name would otherwise scale everything by 0, as get_weight returns 0 for it
+  double scale = 1.;
+  for (const auto &weight : arg_scale.getValue()) {
+    if (!dat.has_weight(weight))
+      throw std::invalid_argument( "ERROR: merge_output: the weight " + weight + " to scale by is not defined!!" );
+
+    scale *= dat.get_weight(weight);
+  }
+
+  // first stage: each thread adds up every nthread-th input
+  const int nthread = std::max(1, std::min(arg_thread.getValue(), int(v_input.size())));
+  ROOT::EnableThreadSafety();
+
+  std::vector<std::unique_ptr<Histogram>> v_hist;
+  for (int iT = 0; iT < nthread; ++iT)
+    v_hist.emplace_back(std::make_unique<Histogram>());
+
+  std::vector<std::thread> v_thread;
+  for (int iT = 0; iT < nthread; ++iT) {
+    v_thread.emplace_back([iT, nthread, &v_input, &hist = *v_hist[iT]] () {
+        for (int iF = iT; iF < v_input.size(); iF += nthread)
+          hist.add_from(v_input[iF]);
+      });
+  }
+  for (auto &thread : v_thread)
+    thread.join();
+
+  // second stage: pairwise tree reduction of the partial sums
+  for (int stride = 1; stride < nthread; stride *= 2) {
+    v_thread.clear();
+    for (int iT = 0; iT + stride < nthread; iT += 2 * stride)
+      v_thread.emplace_back([&hist1 = *v_hist[iT], &hist2 = *v_hist[iT + stride]] () { hist1.add(hist2); });
+
+    for (auto &thread : v_thread)
+      thread.join();
+  }
+
+  // the weights are applied once at the end, rather than once per input
+  // except to the raw cutflow counts, which are numbers of events whatever the weights
+  Histogram merged;
+  merged.add(*v_hist[0]);
+  for (const auto &hist : merged.histograms()) {
+    if (scale != 1. and !Cutflow::is_raw(*hist.first))
+      hist.first->Scale(scale);
+  }
+  merged.save_as(arg_output.getValue());
+  std::cout << "Merged " << merged.histograms().size() << " histograms from " << v_input.size() << " files into " <<
+    arg_output.getValue() << ", scaled by " << scale << std::endl;
+
+  return 0;
+}
@@ -15,7 +15,7 @@
 #include "../src/Tree.h"
 
 // additional headers that aid in defining analysis-dependent functions
-#include "TLorentzVector.h"
+#include "misc/four_vector.h"
 #include "misc/function_util.h"
 // #include "misc/numeric_vector.h"
 
@@ -24,9 +24,8 @@
 float invariant_mass(float pt1, float eta1, float phi1, float mass1,
                      float pt2, float eta2, float phi2, float mass2)
 {
-  TLorentzVector p1, p2;
-  p1.SetPtEtaPhiM(pt1, eta1, phi1, mass1);
-  p2.SetPtEtaPhiM(pt2, eta2, phi2, mass2);
+  const auto p1 = FourVector<double>::pt_eta_phi_m(pt1, eta1, phi1, mass1);
+  const auto p2 = FourVector<double>::pt_eta_phi_m(pt2, eta2, phi2, mass2);
 
   return (p1 + p2).M();
 }
@@ -404,6 +403,13 @@ int main(int argc, char** argv) {
                           return {{top[0], antitop[0], lepton[0], antilepton[0], bottom[0], antibottom[0]}};
                        });
 
+  // by default the attributes of an aggregate are all computed within populate, whether or not they are used afterwards
+  // here most events are rejected based only on the number of elements in gen_tt_ll_bb (see the analyzer function below)
+  // so we ask for the attributes to be computed lazily instead, i.e. the first time each of them is accessed after populate
+  // filling a tree reorders the underlying groups, but the attributes still pending are computed before that happens
+  gen_ttbar.set_lazy();
+  gen_tt_ll_bb.set_lazy();
+
   // for transferring the attributes of some daughter particles
   auto return_third = [] (float , float , float f3) {return f3;};
   auto return_fourth = [] (float , float , float , float f4) {return f4;};
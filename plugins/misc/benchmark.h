@@ -0,0 +1,181 @@
+#ifndef FWK_BENCHMARK_H
+#define FWK_BENCHMARK_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: a minimal harness for per-event micro-benchmarks, reporting time and heap allocations per event
+// note: each case is a function of the entry number, run over the same entries a number of times, with the median and minimum over the runs reported
+// note: allocations are counted only if the macro replaces the global operator new to increment benchmark_allocation, see exec/benchmark_group.cc
+// note: it can only be done there since the replacement must be unique in a program; without it the allocation counts read 0
+// note: a case may name another as its baseline, in which case the difference between the two is reported too
+// note: e.g. a filter case that has to populate its group first, against the case that only populates it
+// note: results can be written as json, for comparison between commits
+
+#include <string>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+/// number of heap allocations so far, see the notes above
+inline std::atomic<long long> benchmark_allocation{0LL};
+
+/// keep the compiler from optimizing away a computation whose result is otherwise unused
+template <typename T>
+inline void benchmark_keep(const T &t)
+{
+  asm volatile("" : : "g"(&t) : "memory");
+}
+
+
+
+class Benchmark {
+public:
+  /// the outcome of one case
+  struct Result {
+    std::string name, baseline;
+    long long n_event;
+    double ns_per_event, ns_per_event_min, ns_over_baseline, allocation_per_event;
+  };
+
+  /// constructor
+  /// the cases run over the entries [0, n_event_), n_repeat_ times each after one untimed warm-up run
+  Benchmark(long long n_event_, int n_repeat_ = 5);
+
+  /// run a case
+  /// signature: the function takes the entry number, its return value if any is ignored
+  /// baseline is the name of an earlier case, or empty for none
+  template <typename Function>
+  const Result& run(const std::string &name, Function function, const std::string &baseline = "");
+
+  /// the results so far
+  const std::vector<Result>& results() const;
+
+  /// print the results as a table
+  void print(std::ostream &out = std::cout) const;
+
+  /// write the results as json
+  /// the context is a free-form string stored along, e.g. the commit or the machine the benchmark is run on
+  void write_json(const std::string &file, const std::string &context = "") const;
+
+protected:
+  long long n_event;
+  int n_repeat;
+
+  std::vector<Result> v_result;
+};
+
+
+
+inline Benchmark::Benchmark(long long n_event_, int n_repeat_) :
+n_event(n_event_),
+n_repeat(n_repeat_)
+{
+  if (n_event < 1 or n_repeat < 1)
+    throw std::invalid_argument( "ERROR: Benchmark: the number of events and repetitions must both be positive!!" );
+}
+
+
+
+template <typename Function>
+const Benchmark::Result& Benchmark::run(const std::string &name, Function function, const std::string &baseline)
+{
+  auto iB = std::find_if(std::begin(v_result), std::end(v_result), [&baseline] (const Result &res) {return res.name == baseline;});
+  if (baseline != "" and iB == std::end(v_result))
+    throw std::invalid_argument( "ERROR: Benchmark::run: baseline " + baseline + " of case " + name + " has not been run!!" );
+
+  // the warm-up also lets the buffers grow to their final capacities, which is then not counted against the case
+  for (long long iE = 0; iE < n_event; ++iE)
+    function(iE);
+
+  std::vector<double> v_time(n_repeat);
+  const long long alloc_start = benchmark_allocation.load(std::memory_order_relaxed);
+  for (int iR = 0; iR < n_repeat; ++iR) {
+    const auto start = std::chrono::steady_clock::now();
+    for (long long iE = 0; iE < n_event; ++iE)
+      function(iE);
+    const auto end = std::chrono::steady_clock::now();
+
+    v_time[iR] = std::chrono::duration<double, std::nano>(end - start).count() / n_event;
+  }
+  const long long alloc_end = benchmark_allocation.load(std::memory_order_relaxed);
+
+  std::sort(std::begin(v_time), std::end(v_time));
+  const double median = (n_repeat % 2) ? v_time[n_repeat / 2] : 0.5 * (v_time[(n_repeat / 2) - 1] + v_time[n_repeat / 2]);
+
+  v_result.push_back({name, baseline, n_event, median, v_time.front(), 0., static_cast<double>(alloc_end - alloc_start) / (n_event * n_repeat)});
+  if (baseline != "") {
+    // the lookup is redone, as the push may have invalidated the iterator
+    auto &base = *std::find_if(std::begin(v_result), std::end(v_result), [&baseline] (const Result &res) {return res.name == baseline;});
+    v_result.back().ns_over_baseline = median - base.ns_per_event;
+  }
+
+  return v_result.back();
+}
+
+
+
+inline const std::vector<Benchmark::Result>& Benchmark::results() const
+{
+  return v_result;
+}
+
+
+
+inline void Benchmark::print(std::ostream &out) const
+{
+  std::size_t width = 4;
+  for (const auto &res : v_result)
+    width = std::max(width, res.name.size());
+
+  out << std::left << std::setw(width + 2) << "case" << std::right
+      << std::setw(14) << "ns/event" << std::setw(14) << "min ns/event" << std::setw(16) << "over baseline" << std::setw(14) << "allocs/event" << "\n";
+
+  out << std::fixed << std::setprecision(1);
+  for (const auto &res : v_result) {
+    out << std::left << std::setw(width + 2) << res.name << std::right
+        << std::setw(14) << res.ns_per_event << std::setw(14) << res.ns_per_event_min;
+
+    if (res.baseline != "")
+      out << std::setw(16) << res.ns_over_baseline;
+    else
+      out << std::setw(16) << "-";
+
+    out << std::setw(14) << std::setprecision(3) << res.allocation_per_event << std::setprecision(1) << "\n";
+  }
+  out << std::defaultfloat << std::setprecision(6);
+}
+
+
+
+inline void Benchmark::write_json(const std::string &file, const std::string &context) const
+{
+  std::ofstream out(file);
+  if (!out)
+    throw std::runtime_error( "ERROR: Benchmark::write_json: unable to open " + file + " for writing!!" );
+
+  // names are under the control of the macro, so only quotes and backslashes are escaped
+  auto quote = [] (const std::string &str) {
+    std::string quoted = "\"";
+    for (auto c : str)
+      quoted += (c == '"' or c == '\\') ? std::string("\\") + c : std::string(1, c);
+    return quoted + "\"";
+  };
+
+  out << "{\n  \"context\": " << quote(context) << ",\n  \"n_repeat\": " << n_repeat << ",\n  \"results\": [";
+  for (int iR = 0; iR < v_result.size(); ++iR) {
+    const auto &res = v_result[iR];
+    out << ((iR == 0) ? "\n" : ",\n")
+        << "    {\"name\": " << quote(res.name) << ", \"baseline\": " << quote(res.baseline) << ", \"n_event\": " << res.n_event
+        << ", \"ns_per_event\": " << res.ns_per_event << ", \"ns_per_event_min\": " << res.ns_per_event_min
+        << ", \"ns_over_baseline\": " << res.ns_over_baseline << ", \"allocation_per_event\": " << res.allocation_per_event << "}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef FWK_COMBINATORICS_H
+#define FWK_COMBINATORICS_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: generators of the combinations and permutations of elements across N groups, as Aggregate indexers
+// note: each slot of the index array takes one selected element i.e. in ref_to_indices() of its group, in its selection order
+// note: a group given to several slots contributes distinct elements to them, and with combinations each set of them only once
+// note: i.e. a dilepton aggregate of (lepton, lepton) gets each pair once, in the selection order, rather than twice and with the diagonal
+// note: the candidates are built a slot at a time, and a prune predicate is asked about each partial one
+// note: so that whole branches of the combinatorics are skipped as soon as e.g. the first two slots fail a charge requirement
+// note: the indexers returned here write into the index buffer of the aggregate, which is reused from one event to the next
+
+#include <array>
+#include <vector>
+#include <cstddef>
+
+/// the default prune predicate, that keeps everything
+struct KeepAll {
+  template <std::size_t N>
+  constexpr bool operator()(int, const std::array<int, N> &) const { return true; }
+};
+
+
+
+/// append to out all index arrays made of one element from each list
+/// same[s] is the earlier slot whose list is the same as that of slot s, -1 if none
+/// ordered true gives permutations i.e. every ordering of the elements of slots sharing a list
+/// ordered false gives combinations, where slots sharing a list take increasing positions within it
+/// signature of prune: takes the depth d and the index array with slots 0..d filled, returns false to skip all candidates starting so
+template <std::size_t N, typename Prune = KeepAll>
+void combine_indices(std::vector<std::array<int, N>> &out, bool ordered, const std::array<const std::vector<int> *, N> &lists,
+                     const std::array<int, N> &same, Prune prune = Prune())
+{
+  for (const auto list : lists) {
+    if (list->empty())
+      return;
+  }
+
+  std::array<int, N> candidate, position;
+  position.fill(-1);
+
+  // position[d] is the position within lists[d] currently taken by slot d, advanced depth first
+  int depth = 0;
+  while (depth > -1) {
+    const auto &list = *lists[depth];
+    int next = position[depth] + 1;
+    if (position[depth] == -1 and !ordered and same[depth] != -1)
+      next = position[same[depth]] + 1;
+
+    // skip the positions already taken by earlier slots of the same list
+    auto taken = [&position, &same, depth] (int pos) {
+      for (int slot = same[depth]; slot != -1; slot = same[slot]) {
+        if (position[slot] == pos)
+          return true;
+      }
+      return false;
+    };
+    while (next < list.size() and ordered and taken(next))
+      ++next;
+
+    if (next >= list.size()) {
+      position[depth] = -1;
+      --depth;
+      continue;
+    }
+
+    position[depth] = next;
+    candidate[depth] = list[next];
+    if (!prune(depth, candidate))
+      continue;
+
+    if (depth == N - 1)
+      out.emplace_back(candidate);
+    else
+      ++depth;
+  }
+}
+
+
+
+/// helper to the indexers below, running combine_indices over the selected elements of the groups
+template <std::size_t N, typename Prune, typename ...Groups>
+void combine_groups(std::vector<std::array<int, N>> &out, bool ordered, Prune &prune, const Groups &...groups)
+{
+  static_assert(sizeof...(groups) == N, "ERROR: combine_groups: the number of groups must match the size of the index array!!");
+
+  const std::array<const void *, N> address = {static_cast<const void *>(&groups)...};
+  std::array<int, N> same;
+  for (int iS = 0; iS < N; ++iS) {
+    same[iS] = -1;
+    for (int iP = iS - 1; iP > -1; --iP) {
+      if (address[iP] == address[iS]) {
+        same[iS] = iP;
+        break;
+      }
+    }
+  }
+
+  combine_indices(out, ordered, {&groups.ref_to_indices()...}, same, prune);
+}
+
+
+
+/// an indexer giving the combinations of the selected elements of the aggregate's groups, see the notes above
+/// signature of prune: as in combine_indices
+template <std::size_t N, typename Prune = KeepAll>
+auto combination_indexer(Prune prune = Prune())
+{
+  return [prune] (std::vector<std::array<int, N>> &out, const auto &...groups) mutable -> void {
+    combine_groups(out, false, prune, groups...);
+  };
+}
+
+
+
+/// as above, but giving the permutations
+/// i.e. for slots with distinct roles filled from the same group, such as top and antitop both out of the generator particles
+template <std::size_t N, typename Prune = KeepAll>
+auto permutation_indexer(Prune prune = Prune())
+{
+  return [prune] (std::vector<std::array<int, N>> &out, const auto &...groups) mutable -> void {
+    combine_groups(out, true, prune, groups...);
+  };
+}
+
+#endif
@@ -0,0 +1,404 @@
+#ifndef FWK_DELTA_R_MATCHING_H
+#define FWK_DELTA_R_MATCHING_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: one-to-one matching of the elements of two groups by their distance in the eta-phi plane
+// note: the distances are computed a row at a time by a branchless kernel, so that the all-pairs loop is vectorized at -O3
+// note: for large second groups the elements are first binned in an eta-phi grid of cell size >= dr_max
+// note: so that each element of the first group is compared only against the 3x3 cells around it
+// note: the matches are returned as the index pairs expected of an Aggregate indexer, see exec/example_gen_ttbar.cc
+// note: greedy takes the closest remaining pair first; optimal maximizes the number of matches, then minimizes the sum of dR
+// note: optimal is O(n^3) in the number of elements having any candidate within dr_max, so keep it to modest group sizes
+
+#include <array>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+#include <limits>
+#include <stdexcept>
+#include <cmath>
+
+#include "misc/constants.h"
+
+/// squared eta-phi distances of one point (eta, phi) to each of the n points (eta2[i], phi2[i])
+/// the phi difference is wrapped into [-pi, pi] with a truncation-based rounding, which vectorizes where std::remainder does not
+/// out must not overlap with the inputs
+template <typename Number>
+void batch_delta_r2(int n, Number eta, Number phi, const Number *eta2, const Number *phi2, Number *__restrict__ out)
+{
+  constexpr Number two_pi = Number(2.) * Framework::constants::pi<Number>;
+  constexpr Number inv_two_pi = Number(1.) / two_pi;
+
+  for (int iE = 0; iE < n; ++iE) {
+    const Number deta = eta - eta2[iE];
+    const Number dphi = phi - phi2[iE];
+    const Number turns = dphi * inv_two_pi;
+    const Number wrapped = dphi - (two_pi * static_cast<Number>(static_cast<int>(turns + std::copysign(Number(0.5), turns))));
+    out[iE] = (deta * deta) + (wrapped * wrapped);
+  }
+}
+
+
+
+template <typename Number = float>
+class DeltaRMatching {
+public:
+  enum class Strategy {greedy, optimal};
+
+  /// constructor
+  /// dr_max_ is the (exclusive) maximum distance for two elements to be matched
+  /// eta_ and phi_ are the names of the attributes used, common to both groups
+  /// grid_ is the minimum number of elements in the second group for the grid binning to be used
+  DeltaRMatching(Number dr_max_, Strategy strategy_ = Strategy::greedy, const std::string &eta_ = "eta", const std::string &phi_ = "phi", int grid_ = 64);
+
+  /// match the selected elements of the two groups i.e. those in their ref_to_indices()
+  /// returns the {first group, second group} element index pairs, ordered as the first group indices
+  /// can be given as is to Aggregate::set_indexer
+  template <typename Group1, typename Group2>
+  std::vector<std::array<int, 2>> operator()(const Group1 &group1, const Group2 &group2) const;
+
+  /// as above, but matching only the elements with the given indices e.g. the output of filter
+  template <typename Group1, typename Group2>
+  std::vector<std::array<int, 2>> match(const Group1 &group1, const std::vector<int> &idx1, const Group2 &group2, const std::vector<int> &idx2) const;
+
+protected:
+  /// a pair within dr_max, referring to positions within idx1 and idx2
+  struct Candidate {
+    Number dr2;
+    int first, second;
+  };
+
+  /// per-thread working space, so that matching allocates nothing once warmed up
+  struct Scratch {
+    std::vector<Number> v_eta1, v_phi1, v_eta2, v_phi2, v_dr2;
+    std::vector<Number> v_cell_eta, v_cell_phi;
+    std::vector<int> v_cell, v_start, v_fill, v_order;
+    std::vector<Candidate> v_candidate;
+    std::vector<int> v_used1, v_used2;
+    std::vector<double> v_cost, v_u, v_v, v_minv;
+    std::vector<int> v_row, v_col, v_p, v_way;
+    std::vector<char> v_visit;
+  };
+
+  static Scratch& scratch();
+
+  /// fill v_candidate by comparing every pair
+  void candidates_all(Scratch &work) const;
+
+  /// fill v_candidate by comparing only the pairs in neighbouring grid cells
+  void candidates_grid(Scratch &work) const;
+
+  /// resolve the candidates into one-to-one matches, as pairs of positions
+  void assign_greedy(Scratch &work, std::vector<std::array<int, 2>> &matches) const;
+
+  void assign_optimal(Scratch &work, std::vector<std::array<int, 2>> &matches) const;
+
+  /// matching parameters
+  Number dr_max;
+
+  Strategy strategy;
+
+  std::string eta_name, phi_name;
+
+  int grid;
+};
+
+
+
+template <typename Number>
+DeltaRMatching<Number>::DeltaRMatching(Number dr_max_, Strategy strategy_, const std::string &eta_, const std::string &phi_, int grid_) :
+dr_max(dr_max_),
+strategy(strategy_),
+eta_name(eta_),
+phi_name(phi_),
+grid(grid_)
+{
+  if (!(dr_max > Number(0.)))
+    throw std::invalid_argument( "ERROR: DeltaRMatching: dr_max must be positive!!" );
+}
+
+
+
+template <typename Number>
+template <typename Group1, typename Group2>
+std::vector<std::array<int, 2>> DeltaRMatching<Number>::operator()(const Group1 &group1, const Group2 &group2) const
+{
+  return match(group1, group1.ref_to_indices(), group2, group2.ref_to_indices());
+}
+
+
+
+template <typename Number>
+template <typename Group1, typename Group2>
+std::vector<std::array<int, 2>> DeltaRMatching<Number>::match(const Group1 &group1, const std::vector<int> &idx1,
+                                                                 const Group2 &group2, const std::vector<int> &idx2) const
+{
+  std::vector<std::array<int, 2>> matches;
+  if (idx1.empty() or idx2.empty())
+    return matches;
+
+  auto &work = scratch();
+  auto gather = [] (const auto &group, const std::vector<int> &idx, const std::string &name, std::vector<Number> &column) {
+    const auto &attr = group.template get<Number>(name);
+    column.resize(idx.size());
+    for (int iE = 0; iE < idx.size(); ++iE)
+      column[iE] = attr[idx[iE]];
+  };
+
+  gather(group1, idx1, eta_name, work.v_eta1);
+  gather(group1, idx1, phi_name, work.v_phi1);
+  gather(group2, idx2, eta_name, work.v_eta2);
+  gather(group2, idx2, phi_name, work.v_phi2);
+
+  work.v_candidate.clear();
+  if (idx2.size() >= grid)
+    candidates_grid(work);
+  else
+    candidates_all(work);
+
+  if (strategy == Strategy::optimal)
+    assign_optimal(work, matches);
+  else
+    assign_greedy(work, matches);
+
+  std::sort(std::begin(matches), std::end(matches));
+  for (auto &pair : matches)
+    pair = {idx1[pair[0]], idx2[pair[1]]};
+
+  return matches;
+}
+
+
+
+template <typename Number>
+typename DeltaRMatching<Number>::Scratch& DeltaRMatching<Number>::scratch()
+{
+  thread_local Scratch work;
+  return work;
+}
+
+
+
+template <typename Number>
+void DeltaRMatching<Number>::candidates_all(Scratch &work) const
+{
+  const int n1 = work.v_eta1.size(), n2 = work.v_eta2.size();
+  const Number dr2_max = dr_max * dr_max;
+  work.v_dr2.resize(n2);
+
+  for (int iE = 0; iE < n1; ++iE) {
+    batch_delta_r2(n2, work.v_eta1[iE], work.v_phi1[iE], work.v_eta2.data(), work.v_phi2.data(), work.v_dr2.data());
+
+    for (int iF = 0; iF < n2; ++iF) {
+      if (work.v_dr2[iF] < dr2_max)
+        work.v_candidate.push_back({work.v_dr2[iF], iE, iF});
+    }
+  }
+}
+
+
+
+template <typename Number>
+void DeltaRMatching<Number>::candidates_grid(Scratch &work) const
+{
+  constexpr Number pi = Framework::constants::pi<Number>;
+  const int n1 = work.v_eta1.size(), n2 = work.v_eta2.size();
+  const Number dr2_max = dr_max * dr_max;
+
+  // cells are at least dr_max wide in both directions, so anything within dr_max is in the 3x3 cells around
+  // the eta range is capped to a sane number of cells in case of far outliers
+  const auto [eta_min, eta_max] = std::minmax_element(std::begin(work.v_eta2), std::end(work.v_eta2));
+  const Number eta_low = *eta_min;
+  const Number eta_cell = std::max(dr_max, (*eta_max - eta_low) / Number(1023.));
+  const int n_eta = static_cast<int>((*eta_max - eta_low) / eta_cell) + 1;
+  const int n_phi = std::max(1, static_cast<int>(Number(2.) * pi / dr_max));
+  const Number phi_cell = Number(2.) * pi / n_phi;
+
+  auto eta_bin = [eta_low, eta_cell] (Number eta) { return static_cast<int>(std::floor((eta - eta_low) / eta_cell)); };
+  auto phi_bin = [pi, phi_cell, n_phi] (Number phi) {
+    const Number wrapped = std::remainder(phi, Number(2.) * pi) + pi;
+    return std::clamp(static_cast<int>(wrapped / phi_cell), 0, n_phi - 1);
+  };
+
+  // counting sort of the second group into the cells, so that each cell is a contiguous slice the row kernel can run over
+  work.v_start.assign((n_eta * n_phi) + 1, 0);
+  work.v_cell.resize(n2);
+  for (int iF = 0; iF < n2; ++iF) {
+    work.v_cell[iF] = (eta_bin(work.v_eta2[iF]) * n_phi) + phi_bin(work.v_phi2[iF]);
+    ++work.v_start[work.v_cell[iF] + 1];
+  }
+  std::partial_sum(std::begin(work.v_start), std::end(work.v_start), std::begin(work.v_start));
+
+  work.v_cell_eta.resize(n2);
+  work.v_cell_phi.resize(n2);
+  work.v_order.resize(n2);
+  work.v_fill.assign(std::begin(work.v_start), std::end(work.v_start));
+  for (int iF = 0; iF < n2; ++iF) {
+    const int slot = work.v_fill[work.v_cell[iF]]++;
+    work.v_cell_eta[slot] = work.v_eta2[iF];
+    work.v_cell_phi[slot] = work.v_phi2[iF];
+    work.v_order[slot] = iF;
+  }
+
+  work.v_dr2.resize(n2);
+  for (int iE = 0; iE < n1; ++iE) {
+    const int ieta = eta_bin(work.v_eta1[iE]), iphi = phi_bin(work.v_phi1[iE]);
+    const int dphi_min = (n_phi < 3) ? -iphi : -1, dphi_max = (n_phi < 3) ? n_phi - 1 - iphi : 1;
+
+    for (int iC = std::max(0, ieta - 1); iC <= std::min(n_eta - 1, ieta + 1); ++iC) {
+      for (int iD = dphi_min; iD <= dphi_max; ++iD) {
+        const int cell = (iC * n_phi) + ((iphi + iD + n_phi) % n_phi);
+        const int begin = work.v_start[cell], n = work.v_start[cell + 1] - begin;
+        if (n == 0)
+          continue;
+
+        batch_delta_r2(n, work.v_eta1[iE], work.v_phi1[iE], work.v_cell_eta.data() + begin, work.v_cell_phi.data() + begin, work.v_dr2.data());
+        for (int iF = 0; iF < n; ++iF) {
+          if (work.v_dr2[iF] < dr2_max)
+            work.v_candidate.push_back({work.v_dr2[iF], iE, work.v_order[begin + iF]});
+        }
+      }
+    }
+  }
+}
+
+
+
+template <typename Number>
+void DeltaRMatching<Number>::assign_greedy(Scratch &work, std::vector<std::array<int, 2>> &matches) const
+{
+  std::sort(std::begin(work.v_candidate), std::end(work.v_candidate), [] (const Candidate &c1, const Candidate &c2) {
+      return std::tie(c1.dr2, c1.first, c1.second) < std::tie(c2.dr2, c2.first, c2.second);
+    });
+
+  work.v_used1.assign(work.v_eta1.size(), 0);
+  work.v_used2.assign(work.v_eta2.size(), 0);
+  for (const auto &candidate : work.v_candidate) {
+    if (work.v_used1[candidate.first] or work.v_used2[candidate.second])
+      continue;
+
+    work.v_used1[candidate.first] = 1;
+    work.v_used2[candidate.second] = 1;
+    matches.push_back({candidate.first, candidate.second});
+  }
+}
+
+
+
+template <typename Number>
+void DeltaRMatching<Number>::assign_optimal(Scratch &work, std::vector<std::array<int, 2>> &matches) const
+{
+  if (work.v_candidate.empty())
+    return;
+
+  // only the elements having any candidate take part, renumbered from 1 as the solver below expects
+  // the solver needs no more rows than columns, so the groups are swapped if needed
+  auto compress = [] (std::vector<int> &v_map, int n, const std::vector<Candidate> &v_candidate, auto member) {
+    v_map.assign(n, 0);
+    for (const auto &candidate : v_candidate)
+      v_map[candidate.*member] = 1;
+
+    int count = 0;
+    for (auto &map : v_map)
+      map = map ? ++count : 0;
+    return count;
+  };
+
+  const int n1 = compress(work.v_used1, work.v_eta1.size(), work.v_candidate, &Candidate::first);
+  const int n2 = compress(work.v_used2, work.v_eta2.size(), work.v_candidate, &Candidate::second);
+  const bool swap = n1 > n2;
+  const int nrow = swap ? n2 : n1, ncol = swap ? n1 : n2;
+
+  // pairs beyond dr_max cost more than all allowed pairs together, so that the number of matches comes first
+  const double forbidden = (double(nrow) + 1.) * (double(dr_max) + 1.);
+  work.v_cost.assign(nrow * ncol, forbidden);
+  for (const auto &candidate : work.v_candidate) {
+    const int row = (swap ? work.v_used2[candidate.second] : work.v_used1[candidate.first]) - 1;
+    const int col = (swap ? work.v_used1[candidate.first] : work.v_used2[candidate.second]) - 1;
+    work.v_cost[(row * ncol) + col] = std::sqrt(double(candidate.dr2));
+  }
+
+  // hungarian algorithm with potentials, see e.g. e-maxx.ru/algo/assignment_hungary
+  constexpr double inf = std::numeric_limits<double>::max();
+  auto &u = work.v_u, &v = work.v_v, &minv = work.v_minv;
+  auto &p = work.v_p, &way = work.v_way;
+  auto &visit = work.v_visit;
+  u.assign(nrow + 1, 0.);
+  v.assign(ncol + 1, 0.);
+  p.assign(ncol + 1, 0);
+  way.assign(ncol + 1, 0);
+
+  for (int iR = 1; iR <= nrow; ++iR) {
+    p[0] = iR;
+    int col0 = 0;
+    minv.assign(ncol + 1, inf);
+    visit.assign(ncol + 1, 0);
+
+    do {
+      visit[col0] = 1;
+      const int row0 = p[col0];
+      double delta = inf;
+      int col1 = 0;
+
+      for (int iC = 1; iC <= ncol; ++iC) {
+        if (visit[iC])
+          continue;
+
+        const double current = work.v_cost[((row0 - 1) * ncol) + iC - 1] - u[row0] - v[iC];
+        if (current < minv[iC]) {
+          minv[iC] = current;
+          way[iC] = col0;
+        }
+
+        if (minv[iC] < delta) {
+          delta = minv[iC];
+          col1 = iC;
+        }
+      }
+
+      for (int iC = 0; iC <= ncol; ++iC) {
+        if (visit[iC]) {
+          u[p[iC]] += delta;
+          v[iC] -= delta;
+        }
+        else
+          minv[iC] -= delta;
+      }
+
+      col0 = col1;
+    } while (p[col0] != 0);
+
+    do {
+      const int col1 = way[col0];
+      p[col0] = p[col1];
+      col0 = col1;
+    } while (col0 != 0);
+  }
+
+  // translate back to positions, dropping the forced forbidden assignments
+  work.v_row.assign(n1 + 1, 0);
+  work.v_col.assign(n2 + 1, 0);
+  for (int iE = 0; iE < work.v_used1.size(); ++iE) {
+    if (work.v_used1[iE])
+      work.v_row[work.v_used1[iE]] = iE;
+  }
+  for (int iF = 0; iF < work.v_used2.size(); ++iF) {
+    if (work.v_used2[iF])
+      work.v_col[work.v_used2[iF]] = iF;
+  }
+
+  for (int iC = 1; iC <= ncol; ++iC) {
+    if (p[iC] == 0 or work.v_cost[((p[iC] - 1) * ncol) + iC - 1] >= forbidden)
+      continue;
+
+    if (swap)
+      matches.push_back({work.v_row[iC], work.v_col[p[iC]]});
+    else
+      matches.push_back({work.v_row[p[iC]], work.v_col[iC]});
+  }
+}
+
+#endif
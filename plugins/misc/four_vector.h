@@ -0,0 +1,291 @@
+#ifndef FWK_FOUR_VECTOR_H
+#define FWK_FOUR_VECTOR_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: a lightweight four-vector value type, and batch kernels over columns of four-vector components
+// note: FourVector is a plain aggregate of px, py, pz and E with no virtual functions, so it lives happily in registers and arrays
+// note: its getters follow TLorentzVector naming, so that it serves as a drop-in replacement where only the kinematics are needed
+// note: as TLorentzVector is in double, sums of several vectors whose mass is wanted are best done in FourVector<double>
+// note: the batch kernels take structure-of-arrays columns and are written to be auto-vectorized at -O3, as is spin_correlation.h
+// note: i.e. without branches or library calls in the inner loops, which is why they use the approximate trigonometric and exponential
+// note: functions below instead of the std:: ones; these are accurate to ~1e-7 relative, enough for float inputs
+// note: the system kernels sum the bodies in double for the same reason as above, which halves the vector width but not the accuracy
+// note: std::sqrt is vectorized only when the compiler is allowed to skip setting errno, so add -fno-math-errno to the compilation
+// note: without it such kernels are still correct, just scalar
+
+#include <array>
+#include <algorithm>
+#include <vector>
+#include <utility>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+template <typename Number = float>
+struct FourVector {
+  static_assert(std::is_floating_point_v<Number>, "ERROR: FourVector: only floating point types are supported!!");
+
+  Number px = 0., py = 0., pz = 0., e = 0.;
+
+  /// constructors
+  constexpr FourVector() = default;
+
+  constexpr FourVector(Number px_, Number py_, Number pz_, Number e_) : px(px_), py(py_), pz(pz_), e(e_) {}
+
+  /// named constructors from the usual collider coordinates
+  static FourVector pt_eta_phi_m(Number pt, Number eta, Number phi, Number mass)
+  {
+    const Number pz_ = pt * std::sinh(eta);
+    return FourVector(pt * std::cos(phi), pt * std::sin(phi), pz_, std::sqrt((pt * pt) + (pz_ * pz_) + (mass * mass)));
+  }
+
+  static FourVector pt_eta_phi_e(Number pt, Number eta, Number phi, Number energy)
+  {
+    return FourVector(pt * std::cos(phi), pt * std::sin(phi), pt * std::sinh(eta), energy);
+  }
+
+  /// TLorentzVector-like setters
+  void SetPtEtaPhiM(Number pt, Number eta, Number phi, Number mass) { *this = pt_eta_phi_m(pt, eta, phi, mass); }
+
+  void SetPtEtaPhiE(Number pt, Number eta, Number phi, Number energy) { *this = pt_eta_phi_e(pt, eta, phi, energy); }
+
+  constexpr void SetPxPyPzE(Number px_, Number py_, Number pz_, Number e_) { px = px_; py = py_; pz = pz_; e = e_; }
+
+  /// arithmetic
+  constexpr FourVector& operator+=(const FourVector &other) { px += other.px; py += other.py; pz += other.pz; e += other.e; return *this; }
+
+  constexpr FourVector& operator-=(const FourVector &other) { px -= other.px; py -= other.py; pz -= other.pz; e -= other.e; return *this; }
+
+  constexpr FourVector& operator*=(Number scale) { px *= scale; py *= scale; pz *= scale; e *= scale; return *this; }
+
+  friend constexpr FourVector operator+(FourVector p1, const FourVector &p2) { return p1 += p2; }
+
+  friend constexpr FourVector operator-(FourVector p1, const FourVector &p2) { return p1 -= p2; }
+
+  friend constexpr FourVector operator*(FourVector p, Number scale) { return p *= scale; }
+
+  friend constexpr FourVector operator*(Number scale, FourVector p) { return p *= scale; }
+
+  friend constexpr bool operator==(const FourVector &p1, const FourVector &p2)
+  {
+    return p1.px == p2.px and p1.py == p2.py and p1.pz == p2.pz and p1.e == p2.e;
+  }
+
+  friend constexpr bool operator!=(const FourVector &p1, const FourVector &p2) { return !(p1 == p2); }
+
+  /// Minkowski product, with the (+, -, -, -) metric
+  constexpr Number Dot(const FourVector &other) const { return (e * other.e) - (px * other.px) - (py * other.py) - (pz * other.pz); }
+
+  /// getters
+  constexpr Number Px() const { return px; }
+
+  constexpr Number Py() const { return py; }
+
+  constexpr Number Pz() const { return pz; }
+
+  constexpr Number E() const { return e; }
+
+  constexpr Number Perp2() const { return (px * px) + (py * py); }
+
+  constexpr Number P2() const { return Perp2() + (pz * pz); }
+
+  constexpr Number M2() const { return (e * e) - P2(); }
+
+  Number Pt() const { return std::sqrt(Perp2()); }
+
+  Number P() const { return std::sqrt(P2()); }
+
+  /// as TLorentzVector, negative for spacelike vectors
+  Number M() const
+  {
+    const Number m2 = M2();
+    return (m2 < 0.) ? -std::sqrt(-m2) : std::sqrt(m2);
+  }
+
+  Number Phi() const { return (px == 0. and py == 0.) ? 0. : std::atan2(py, px); }
+
+  Number Eta() const
+  {
+    const Number pt = Pt();
+    if (pt == 0.)
+      return (pz == 0.) ? 0. : std::copysign(Number(1e10), pz);
+
+    return std::asinh(pz / pt);
+  }
+
+  Number Rapidity() const { return Number(0.5) * std::log((e + pz) / (e - pz)); }
+
+  /// the velocity of the vector, as a boost to be passed to Boost()
+  constexpr std::array<Number, 3> BoostVector() const { return {px / e, py / e, pz / e}; }
+
+  /// Lorentz boost with velocity (bx, by, bz), with the same convention as TLorentzVector::Boost
+  void Boost(Number bx, Number by, Number bz)
+  {
+    const Number b2 = (bx * bx) + (by * by) + (bz * bz);
+    if (b2 <= 0.)
+      return;
+
+    const Number gamma = Number(1.) / std::sqrt(Number(1.) - b2);
+    const Number bp = (bx * px) + (by * py) + (bz * pz);
+    const Number gamma2 = (gamma - Number(1.)) / b2;
+
+    px += (gamma2 * bp * bx) + (gamma * bx * e);
+    py += (gamma2 * bp * by) + (gamma * by * e);
+    pz += (gamma2 * bp * bz) + (gamma * bz * e);
+    e = gamma * (e + bp);
+  }
+
+  void Boost(const std::array<Number, 3> &beta) { Boost(beta[0], beta[1], beta[2]); }
+};
+
+
+
+/// branch-free approximations of sin and cos, computed together as they share the range reduction
+/// the argument is reduced to [-pi/4, pi/4] around the nearest multiple of pi/2, where Taylor series of degree 9 and 10 are used
+template <typename Number>
+inline void approximate_sincos(Number x, Number &sin, Number &cos)
+{
+  // pi/2 split into a part exactly representable in float, and the remainder
+  constexpr Number two_over_pi = 0.636619772367581343, pi_over_2_hi = 1.5707963705062866, pi_over_2_lo = -4.37113900018624283e-8;
+
+  // rounding by truncation, as floor and friends are not vectorized under the default floating point environment
+  const int iq = static_cast<int>((x * two_over_pi) + std::copysign(Number(0.5), x));
+  const Number q = iq;
+  const Number r = (x - (q * pi_over_2_hi)) - (q * pi_over_2_lo);
+  const Number r2 = r * r;
+
+  const Number sr = r * (Number(1.) + r2 * (Number(-1. / 6.) + r2 * (Number(1. / 120.) + r2 * (Number(-1. / 5040.) + r2 * Number(1. / 362880.)))));
+  const Number cr = Number(1.) + r2 * (Number(-0.5) + r2 * (Number(1. / 24.) + r2 * (Number(-1. / 720.) + r2 * (Number(1. / 40320.) + r2 * Number(-1. / 3628800.)))));
+
+  // the quadrant decides which of the two goes where, and with which sign
+  // written as arithmetic rather than selections, which the vectorizer does not always manage to if-convert
+  const int quadrant = iq & 3;
+  const Number swap = quadrant & 1;
+  const Number sign_sin = 1 - (quadrant & 2), sign_cos = 1 - ((quadrant + 1) & 2);
+  sin = sign_sin * ((swap * cr) + ((Number(1.) - swap) * sr));
+  cos = sign_cos * ((swap * sr) + ((Number(1.) - swap) * cr));
+}
+
+
+
+/// branch-free approximation of exp, valid for |x| < 87 in float and |x| < 708 in double i.e. well beyond any pseudorapidity
+/// x is split into k ln2 + r with |r| <= ln2 / 2, with exp(r) from a Taylor series of degree 8 and 2^k built directly from its bits
+/// beyond the valid range the result tends towards 0 or the overflow, without being accurate
+template <typename Number>
+inline Number approximate_exp(Number x)
+{
+  using Integer = std::conditional_t<std::is_same_v<Number, float>, std::int32_t, std::int64_t>;
+  constexpr int mantissa = std::numeric_limits<Number>::digits - 1;
+  constexpr Integer bias = std::numeric_limits<Number>::max_exponent - 1;
+  constexpr Number log2e = 1.44269504088896341, ln2_hi = 0.693145751953125, ln2_lo = 1.42860682030941723e-6;
+
+  // the exponent is clamped as an integer, as the vectorizer handles integer selections better than floating point ones
+  const Integer k = std::clamp(static_cast<Integer>((x * log2e) + std::copysign(Number(0.5), x)), Integer(1 - bias), bias);
+
+  const Number kf = k;
+  const Number r = (x - (kf * ln2_hi)) - (kf * ln2_lo);
+  const Number er = Number(1.) + r * (Number(1.) + r * (Number(0.5) + r * (Number(1. / 6.) + r * (Number(1. / 24.) + r * (Number(1. / 120.) +
+                    r * (Number(1. / 720.) + r * (Number(1. / 5040.) + r * Number(1. / 40320.))))))));
+
+  const Integer bits = (k + bias) << mantissa;
+  Number scale;
+  std::memcpy(&scale, &bits, sizeof(Number));
+
+  return er * scale;
+}
+
+
+
+/// the cartesian components of a pt, eta, phi, mass vector, built from the approximations above
+template <typename Number>
+inline void approximate_cartesian(Number pt, Number eta, Number phi, Number mass, Number &px, Number &py, Number &pz, Number &e)
+{
+  Number sin, cos;
+  approximate_sincos(phi, sin, cos);
+
+  const Number exp_eta = approximate_exp(eta);
+  pz = pt * Number(0.5) * (exp_eta - (Number(1.) / exp_eta));
+  px = pt * cos;
+  py = pt * sin;
+  e = std::sqrt((pt * pt) + (pz * pz) + (mass * mass));
+}
+
+
+
+/// batch conversion of pt, eta, phi, mass columns of length n into px, py, pz, E columns
+/// the output columns must not overlap with each other nor with the inputs
+template <typename Number>
+void batch_cartesian(std::size_t n, const Number *pt, const Number *eta, const Number *phi, const Number *mass,
+                     Number *__restrict__ px, Number *__restrict__ py, Number *__restrict__ pz, Number *__restrict__ e)
+{
+  for (std::size_t iN = 0; iN < n; ++iN)
+    approximate_cartesian(pt[iN], eta[iN], phi[iN], mass[iN], px[iN], py[iN], pz[iN], e[iN]);
+}
+
+
+
+/// helper for batch_system_kinematics, doing the actual loop over the systems
+/// the bodies are unrolled at compile time, as the vectorizer does not see through a loop over the column pointers
+/// and the outputs are restrict parameters, as otherwise the vectorizer gives up checking them against every input column
+/// the components and their sums are in double, and only the outputs are narrowed, as in multivector_system of numeric_vector.h
+template <std::size_t ...K, typename Number>
+void batch_system_kinematics_impl(std::index_sequence<K...>, std::size_t n,
+                                  const std::array<const Number *, sizeof...(K)> &pt, const std::array<const Number *, sizeof...(K)> &eta,
+                                  const std::array<const Number *, sizeof...(K)> &phi, const std::array<const Number *, sizeof...(K)> &mass,
+                                  Number *__restrict__ out_mass, Number *__restrict__ out_pt, Number *__restrict__ out_rapidity)
+{
+  for (std::size_t iN = 0; iN < n; ++iN) {
+    std::array<double, sizeof...(K)> px, py, pz, e;
+    (approximate_cartesian(double(std::get<K>(pt)[iN]), double(std::get<K>(eta)[iN]), double(std::get<K>(phi)[iN]), double(std::get<K>(mass)[iN]),
+                           std::get<K>(px), std::get<K>(py), std::get<K>(pz), std::get<K>(e)), ...);
+
+    const double sx = (std::get<K>(px) + ...), sy = (std::get<K>(py) + ...), sz = (std::get<K>(pz) + ...), se = (std::get<K>(e) + ...);
+    const double m2 = (se * se) - (sx * sx) - (sy * sy) - (sz * sz);
+
+    out_mass[iN] = static_cast<Number>(std::copysign(std::sqrt(std::abs(m2)), m2));
+    out_pt[iN] = static_cast<Number>(std::sqrt((sx * sx) + (sy * sy)));
+    out_rapidity[iN] = static_cast<Number>((se + sz) / (se - sz));
+  }
+
+  // the logarithm is done separately, as it is a library call that would otherwise keep the loop above scalar
+  for (std::size_t iN = 0; iN < n; ++iN)
+    out_rapidity[iN] = Number(0.5) * std::log(out_rapidity[iN]);
+}
+
+
+
+/// batch kinematics of N-body systems
+/// body k of system i has the components pt[k][i], eta[k][i], phi[k][i] and mass[k][i], for i < n
+/// the mass, pt and rapidity of each system are written into the respective output columns of length n
+/// any of the outputs can be nullptr, in which case it goes into a thread-local scratch instead, so the loop itself stays branch-free
+/// Number is then to be given explicitly, as it is not deduced from a nullptr
+/// the output columns must not overlap with each other nor with the inputs
+template <std::size_t N, typename Number = float>
+void batch_system_kinematics(std::size_t n,
+                             const std::array<const Number *, N> &pt, const std::array<const Number *, N> &eta,
+                             const std::array<const Number *, N> &phi, const std::array<const Number *, N> &mass,
+                             Number *out_mass, Number *out_pt, Number *out_rapidity)
+{
+  static_assert(N > 0, "ERROR: batch_system_kinematics: a system needs at least one body!!");
+
+  thread_local std::vector<Number> v_scratch;
+  const std::size_t nscratch = n * ((out_mass == nullptr) + (out_pt == nullptr) + (out_rapidity == nullptr));
+  if (v_scratch.size() < nscratch)
+    v_scratch.resize(nscratch);
+
+  Number *scratch = v_scratch.data();
+  if (out_mass == nullptr)
+    out_mass = std::exchange(scratch, scratch + n);
+  if (out_pt == nullptr)
+    out_pt = std::exchange(scratch, scratch + n);
+  if (out_rapidity == nullptr)
+    out_rapidity = std::exchange(scratch, scratch + n);
+
+  batch_system_kinematics_impl(std::make_index_sequence<N>{}, n, pt, eta, phi, mass, out_mass, out_pt, out_rapidity);
+}
+
+#endif
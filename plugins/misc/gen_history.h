@@ -0,0 +1,308 @@
+#ifndef FWK_GEN_HISTORY_H
+#define FWK_GEN_HISTORY_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: navigation of the generator history i.e. the mother-daughter relations within a group, e.g. nanoAOD GenPart
+// note: the history is built once per event from the mother index attribute, the first time it is queried after the group is populated
+// note: so that the queries below cost O(1) each, instead of walking up the mother chain for every particle and in every transform
+// note: daughters are stored as one flat array with per-particle offsets, and the ancestry as an euler tour
+// note: i.e. a particle is a descendant of another iff its pre-order position falls within the range spanned by the other
+// note: tags are predicates on the particles, evaluated once per build, whose presence among the ancestors is kept as bits
+// note: the particles are referred to by their element index, the same as in the mother index attribute
+// note: a mother index that is negative, out of range or part of a loop is taken to mean the particle has no mother
+
+#include <array>
+#include <vector>
+#include <string>
+#include <functional>
+#include <cstdint>
+#include <stdexcept>
+
+template <typename Group>
+class GenHistory {
+public:
+  /// constructor
+  /// mother_ and pdg_ are the names of the mother index and pdg id attributes of the group, both of type int
+  GenHistory(const Group &group_, const std::string &mother_ = "mother", const std::string &pdg_ = "pdg");
+
+  /// register a tag, at most 64 of them
+  /// signature: the predicate takes the element index and returns whether the particle carries the tag
+  /// returns the tag key to be used in the queries below
+  template <typename Predicate>
+  int add_tag(Predicate predicate);
+
+  /// mother of the particle, -1 if none
+  int mother(int index);
+
+  /// daughters of the particle, as a begin and end pointer pair, in index order
+  std::pair<const int *, const int *> daughters(int index);
+
+  /// first and last copies of the particle i.e. following the mothers or daughters of the same pdg id
+  /// a particle with no such mother is its own first copy, and with no such daughter its own last copy
+  int first_copy(int index);
+
+  int last_copy(int index);
+
+  /// the particle that produced this one, skipping over the copies of itself i.e. the mother of its first copy
+  int origin(int index);
+
+  /// whether the particle is a (strict) descendant of the ancestor
+  bool is_descendant(int index, int ancestor);
+
+  /// whether the particle itself or any of its ancestors carries the tag
+  /// returns false for index -1, so that it can be given a mother index as is
+  bool descends_from(int index, int tag);
+
+  /// the particle itself if it carries the tag, otherwise its nearest ancestor that does, -1 if none
+  int nearest(int index, int tag);
+
+protected:
+  /// rebuild the history if the group has been populated since the last build
+  void update();
+
+  /// build the history from the current group data
+  void build();
+
+  /// the group and its attribute names
+  const Group &group;
+
+  std::string mother_name, pdg_name;
+
+  /// group generation at the last build, plus one so that zero means never built
+  unsigned long long stamp;
+
+  /// the registered tags
+  std::vector<std::function<bool(int)>> v_tag;
+
+  /// number of particles, and their sanitized mothers
+  int n;
+
+  std::vector<int> v_mother;
+
+  /// daughters in compressed sparse row form: those of particle i are v_daughter[v_offset[i], v_offset[i + 1])
+  std::vector<int> v_offset, v_daughter;
+
+  /// euler tour: particle i occupies the pre-order positions [v_enter[i], v_exit[i])
+  std::vector<int> v_enter, v_exit, v_preorder;
+
+  /// copy resolution
+  std::vector<int> v_first, v_last;
+
+  /// tags carried by the particle itself, and by it or any of its ancestors
+  std::vector<std::uint64_t> v_tagged, v_lineage;
+
+  /// nearest tagged particle along the lineage, per tag: v_nearest[(tag * n) + i]
+  std::vector<int> v_nearest;
+
+  /// traversal stack of particle and next daughter position
+  std::vector<std::array<int, 2>> v_stack;
+};
+
+
+
+template <typename Group>
+GenHistory<Group>::GenHistory(const Group &group_, const std::string &mother_, const std::string &pdg_) :
+group(group_),
+mother_name(mother_),
+pdg_name(pdg_),
+stamp(0ULL),
+n(0)
+{
+  if (group.inquire(mother_name) == -1 or group.inquire(pdg_name) == -1)
+    throw std::invalid_argument( "ERROR: GenHistory: group " + group.name + " does not have the attributes " + mother_name + " and " + pdg_name + "!!" );
+}
+
+
+
+template <typename Group>
+template <typename Predicate>
+int GenHistory<Group>::add_tag(Predicate predicate)
+{
+  if (v_tag.size() == 64)
+    throw std::runtime_error( "ERROR: GenHistory::add_tag: at most 64 tags are supported!!" );
+
+  v_tag.emplace_back(predicate);
+  stamp = 0ULL;
+  return v_tag.size() - 1;
+}
+
+
+
+template <typename Group>
+int GenHistory<Group>::mother(int index)
+{
+  update();
+  return (index > -1) ? v_mother[index] : -1;
+}
+
+
+
+template <typename Group>
+std::pair<const int *, const int *> GenHistory<Group>::daughters(int index)
+{
+  update();
+  return {v_daughter.data() + v_offset[index], v_daughter.data() + v_offset[index + 1]};
+}
+
+
+
+template <typename Group>
+int GenHistory<Group>::first_copy(int index)
+{
+  update();
+  return v_first[index];
+}
+
+
+
+template <typename Group>
+int GenHistory<Group>::last_copy(int index)
+{
+  update();
+  return v_last[index];
+}
+
+
+
+template <typename Group>
+int GenHistory<Group>::origin(int index)
+{
+  update();
+  return v_mother[v_first[index]];
+}
+
+
+
+template <typename Group>
+bool GenHistory<Group>::is_descendant(int index, int ancestor)
+{
+  update();
+  return v_enter[ancestor] < v_enter[index] and v_enter[index] < v_exit[ancestor];
+}
+
+
+
+template <typename Group>
+bool GenHistory<Group>::descends_from(int index, int tag)
+{
+  update();
+  return index > -1 and (v_lineage[index] >> tag) & 1ULL;
+}
+
+
+
+template <typename Group>
+int GenHistory<Group>::nearest(int index, int tag)
+{
+  update();
+  return (index > -1) ? v_nearest[(tag * n) + index] : -1;
+}
+
+
+
+template <typename Group>
+void GenHistory<Group>::update()
+{
+  if (stamp != group.generation() + 1ULL) {
+    build();
+    stamp = group.generation() + 1ULL;
+  }
+}
+
+
+
+template <typename Group>
+void GenHistory<Group>::build()
+{
+  n = group.n_populated_elements();
+  const auto &mothers = group.template get<int>(mother_name);
+  const auto &pdgs = group.template get<int>(pdg_name);
+
+  v_mother.resize(n);
+  v_offset.assign(n + 1, 0);
+  for (int iP = 0; iP < n; ++iP) {
+    v_mother[iP] = (mothers[iP] > -1 and mothers[iP] < n and mothers[iP] != iP) ? mothers[iP] : -1;
+    if (v_mother[iP] > -1)
+      ++v_offset[v_mother[iP] + 1];
+  }
+
+  for (int iP = 0; iP < n; ++iP)
+    v_offset[iP + 1] += v_offset[iP];
+
+  // filling in index order keeps the daughters of each particle sorted
+  v_daughter.resize(v_offset[n]);
+  v_exit.assign(std::begin(v_offset), std::end(v_offset) - 1);
+  for (int iP = 0; iP < n; ++iP) {
+    if (v_mother[iP] > -1)
+      v_daughter[v_exit[v_mother[iP]]++] = iP;
+  }
+
+  const int ntag = v_tag.size();
+  v_tagged.assign(n, 0ULL);
+  for (int iT = 0; iT < ntag; ++iT) {
+    for (int iP = 0; iP < n; ++iP)
+      v_tagged[iP] |= static_cast<std::uint64_t>(v_tag[iT](iP)) << iT;
+  }
+
+  v_enter.assign(n, -1);
+  v_exit.assign(n, -1);
+  v_first.resize(n);
+  v_lineage.resize(n);
+  v_nearest.resize(ntag * n);
+  v_preorder.clear();
+
+  auto enter = [this, &pdgs, ntag] (int particle, int parent) {
+    v_enter[particle] = v_preorder.size();
+    v_preorder.emplace_back(particle);
+
+    v_first[particle] = (parent > -1 and pdgs[parent] == pdgs[particle]) ? v_first[parent] : particle;
+    v_lineage[particle] = v_tagged[particle] | ((parent > -1) ? v_lineage[parent] : 0ULL);
+    for (int iT = 0; iT < ntag; ++iT) {
+      const int inherited = (parent > -1) ? v_nearest[(iT * n) + parent] : -1;
+      v_nearest[(iT * n) + particle] = ((v_tagged[particle] >> iT) & 1ULL) ? particle : inherited;
+    }
+
+    v_stack.push_back({particle, v_offset[particle]});
+  };
+
+  // the roots are visited first, so that particles are reached from their real mothers
+  // whatever is left after is part of a loop, which is broken by making its first particle a root
+  for (int pass = 0; pass < 2; ++pass) {
+    for (int iP = 0; iP < n; ++iP) {
+      if (v_enter[iP] != -1 or (pass == 0 and v_mother[iP] != -1))
+        continue;
+
+      v_mother[iP] = -1;
+      enter(iP, -1);
+      while (!v_stack.empty()) {
+        auto &[particle, next] = v_stack.back();
+        if (next == v_offset[particle + 1]) {
+          v_exit[particle] = v_preorder.size();
+          v_stack.pop_back();
+          continue;
+        }
+
+        const int daughter = v_daughter[next++];
+        if (v_enter[daughter] == -1)
+          enter(daughter, particle);
+      }
+    }
+  }
+
+  // last copies are resolved from the bottom up, i.e. in reverse pre-order
+  v_last.resize(n);
+  for (auto iP = std::rbegin(v_preorder); iP != std::rend(v_preorder); ++iP) {
+    const int particle = *iP;
+    v_last[particle] = particle;
+    for (int iD = v_offset[particle]; iD < v_offset[particle + 1]; ++iD) {
+      const int daughter = v_daughter[iD];
+      if (v_mother[daughter] == particle and pdgs[daughter] == pdgs[particle]) {
+        v_last[particle] = v_last[daughter];
+        break;
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,282 @@
+#ifndef FWK_KINEMATICS_CACHE_H
+#define FWK_KINEMATICS_CACHE_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: per-event cache of the four-vectors of group elements, and of their sums
+// note: each element's four-vector is computed at most once per event, keyed by (group, element index)
+// note: and the sums over a subset of elements are kept too, so that e.g. ttbar_mass and ttbar_pt share one summation
+// note: the cached values are tied to Group::generation(), so they go stale by themselves whenever a group is populated
+// note: the four-vectors and their sums are in double, as TLorentzVector was, since M2 = E2 - p2 cancels badly in float for boosted systems
+// note: storage is per thread, so that one cache can be shared by analyzers running on different threads
+// note: the groups are fixed once the cache is first used, so that the threads can read them without locking
+// note: meant mainly for Aggregate::add_indexed_attribute, see exec/example_gen_ttbar.cc
+
+#include <string>
+#include <vector>
+#include <array>
+#include <variant>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <initializer_list>
+
+#include "misc/four_vector.h"
+
+template <typename Group, typename Number = float>
+class KinematicsCache {
+public:
+  /// constructor
+  /// the names of the attributes holding the pt, eta, phi and mass of the elements, common to all groups
+  KinematicsCache(const std::string &pt_ = "pt", const std::string &eta_ = "eta", const std::string &phi_ = "phi", const std::string &mass_ = "mass");
+
+  /// register a group with the cache
+  /// returns the key by which the group is referred to in p4() and system()
+  /// throws if the group does not have the attributes of the expected type, or if the cache has already been used
+  int add_group(const Group &group);
+
+  /// four-vector of a single element of a registered group
+  /// index is the element index, as in the indices returned by filter etc
+  FourVector<double> p4(int group, int index);
+
+  /// four-vector of the system of several elements of one group
+  FourVector<double> system(int group, std::initializer_list<int> indices);
+
+  /// four-vector of the system of elements of several groups, each given as {group, index}
+  FourVector<double> system(std::initializer_list<std::pair<int, int>> elements);
+
+  /// the usual derived quantities, narrowed to Number only at the end
+  Number mass(int group, std::initializer_list<int> indices) { return static_cast<Number>(system(group, indices).M()); }
+
+  Number pt(int group, std::initializer_list<int> indices) { return static_cast<Number>(system(group, indices).Pt()); }
+
+  Number rapidity(int group, std::initializer_list<int> indices) { return static_cast<Number>(system(group, indices).Rapidity()); }
+
+protected:
+  /// at most this many elements per system are cached; larger systems are summed on every call
+  static constexpr int max_body = 8;
+
+  /// the cached four-vectors of one group
+  /// an element is valid if its stamp equals the generation of the group + 1, so that stale entries need not be cleared
+  struct Elements {
+    std::vector<FourVector<double>> v_p4;
+    std::vector<unsigned long long> v_stamp;
+  };
+
+  /// a cached system: the number of elements, the sorted packed (group, index) keys, and the sum
+  struct System {
+    int n;
+    std::array<unsigned long long, max_body> key;
+    FourVector<double> p4;
+  };
+
+  /// everything cached by one thread
+  /// v_generation is the generation of each group as of when the systems were last forgotten for its sake
+  struct Storage {
+    std::vector<Elements> v_element;
+    std::vector<System> v_system;
+    std::vector<unsigned long long> v_generation;
+  };
+
+  /// get the storage belonging to the calling thread, registering it if needed
+  Storage& storage();
+
+  /// four-vector of an element, within a given storage
+  const FourVector<double>& element(Storage &store, int group, int index);
+
+  /// four-vector of a system of n elements, within a given storage
+  FourVector<double> system_impl(Storage &store, const std::pair<int, int> *elements, int n);
+
+  /// the attribute names
+  std::string pt_name, eta_name, phi_name, mass_name;
+
+  /// unique id of the instance, indexing the thread-local storage cache
+  const unsigned long long id;
+
+  /// registered groups, with the indices of their pt, eta, phi and mass attributes
+  std::vector<std::pair<const Group *, std::array<int, 4>>> v_group;
+
+  /// per-thread storage
+  std::vector<std::pair<std::thread::id, std::unique_ptr<Storage>>> v_slot;
+
+  /// whether any thread has used the cache, after which the groups are fixed
+  bool used;
+
+  /// guard for storage registration and the groups
+  std::mutex mutex;
+};
+
+
+
+template <typename Group, typename Number>
+KinematicsCache<Group, Number>::KinematicsCache(const std::string &pt_, const std::string &eta_, const std::string &phi_, const std::string &mass_) :
+pt_name(pt_),
+eta_name(eta_),
+phi_name(phi_),
+mass_name(mass_),
+id([] () { static std::atomic<unsigned long long> n_instance = 0ULL; return n_instance++; }()),
+used(false)
+{}
+
+
+
+template <typename Group, typename Number>
+int KinematicsCache<Group, Number>::add_group(const Group &group)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (used)
+    throw std::logic_error( "ERROR: KinematicsCache::add_group: group " + group.name + " can not be added once the cache is in use!!" );
+
+  for (int iG = 0; iG < v_group.size(); ++iG) {
+    if (v_group[iG].first == &group)
+      return iG;
+  }
+
+  const std::array<int, 4> attrs = {group.inquire(pt_name), group.inquire(eta_name), group.inquire(phi_name), group.inquire(mass_name)};
+  for (auto attr : attrs) {
+    if (attr == -1 or !std::holds_alternative<std::vector<Number>>(group.data()[attr]))
+      throw std::invalid_argument( "ERROR: KinematicsCache::add_group: group " + group.name + " does not have all of the attributes " +
+                                   pt_name + ", " + eta_name + ", " + phi_name + ", " + mass_name + " of the expected type!!" );
+  }
+
+  v_group.emplace_back(&group, attrs);
+  return v_group.size() - 1;
+}
+
+
+
+template <typename Group, typename Number>
+FourVector<double> KinematicsCache<Group, Number>::p4(int group, int index)
+{
+  return element(storage(), group, index);
+}
+
+
+
+template <typename Group, typename Number>
+FourVector<double> KinematicsCache<Group, Number>::system(int group, std::initializer_list<int> indices)
+{
+  auto &store = storage();
+  if (indices.size() > max_body) {
+    FourVector<double> sum;
+    for (auto index : indices)
+      sum += element(store, group, index);
+    return sum;
+  }
+
+  std::array<std::pair<int, int>, max_body> elements;
+  int iE = 0;
+  for (auto index : indices)
+    elements[iE++] = {group, index};
+
+  return system_impl(store, elements.data(), iE);
+}
+
+
+
+template <typename Group, typename Number>
+FourVector<double> KinematicsCache<Group, Number>::system(std::initializer_list<std::pair<int, int>> elements)
+{
+  return system_impl(storage(), elements.begin(), elements.size());
+}
+
+
+
+template <typename Group, typename Number>
+typename KinematicsCache<Group, Number>::Storage& KinematicsCache<Group, Number>::storage()
+{
+  // every thread caches its storage of every cache by the instance id, so that the lookup is a single index
+  // whichever number of caches a thread uses; the ids are never reused, so entries of caches since destroyed are never read
+  thread_local std::vector<Storage *> v_cache;
+  if (id < v_cache.size() and v_cache[id] != nullptr)
+    return *v_cache[id];
+
+  std::lock_guard<std::mutex> lock(mutex);
+  used = true;
+
+  const auto thread = std::this_thread::get_id();
+  auto iS = std::find_if(std::begin(v_slot), std::end(v_slot), [&thread] (const auto &slot) {return slot.first == thread;});
+  if (iS == std::end(v_slot)) {
+    v_slot.emplace_back(thread, std::make_unique<Storage>());
+    iS = std::prev(std::end(v_slot));
+    iS->second->v_element.resize(v_group.size());
+    iS->second->v_generation.assign(v_group.size(), 0ULL);
+  }
+
+  if (id >= v_cache.size())
+    v_cache.resize(id + 1, nullptr);
+
+  v_cache[id] = iS->second.get();
+  return *v_cache[id];
+}
+
+
+
+template <typename Group, typename Number>
+const FourVector<double>& KinematicsCache<Group, Number>::element(Storage &store, int group, int index)
+{
+  const auto &[grp, attrs] = v_group[group];
+  auto &elements = store.v_element[group];
+  const auto stamp = grp->generation() + 1ULL;
+
+  if (index >= elements.v_p4.size()) {
+    elements.v_p4.resize(index + 1);
+    elements.v_stamp.resize(index + 1, 0ULL);
+  }
+
+  if (elements.v_stamp[index] != stamp) {
+    const auto &data = grp->data();
+    elements.v_p4[index] = FourVector<double>::pt_eta_phi_m(std::get<std::vector<Number>>(data[attrs[0]])[index],
+                                                            std::get<std::vector<Number>>(data[attrs[1]])[index],
+                                                            std::get<std::vector<Number>>(data[attrs[2]])[index],
+                                                            std::get<std::vector<Number>>(data[attrs[3]])[index]);
+    elements.v_stamp[index] = stamp;
+  }
+
+  return elements.v_p4[index];
+}
+
+
+
+template <typename Group, typename Number>
+FourVector<double> KinematicsCache<Group, Number>::system_impl(Storage &store, const std::pair<int, int> *elements, int n)
+{
+  if (n > max_body) {
+    FourVector<double> sum;
+    for (int iE = 0; iE < n; ++iE)
+      sum += element(store, elements[iE].first, elements[iE].second);
+    return sum;
+  }
+
+  // systems are forgotten as soon as any of the groups asked about moves on
+  // only those groups need checking, as a cached system matches only if it is made of elements of the same groups
+  for (int iE = 0; iE < n; ++iE) {
+    const auto generation = v_group[elements[iE].first].first->generation();
+    if (store.v_generation[elements[iE].first] != generation) {
+      store.v_system.clear();
+      store.v_generation[elements[iE].first] = generation;
+    }
+  }
+
+  // the elements are keyed irrespective of their order, as the sum does not depend on it
+  System current{n, {}, {}};
+  for (int iE = 0; iE < n; ++iE)
+    current.key[iE] = (static_cast<unsigned long long>(elements[iE].first) << 32) | static_cast<unsigned int>(elements[iE].second);
+  std::sort(std::begin(current.key), std::begin(current.key) + n);
+
+  for (const auto &sys : store.v_system) {
+    if (sys.n == n and std::equal(std::begin(sys.key), std::begin(sys.key) + n, std::begin(current.key)))
+      return sys.p4;
+  }
+
+  for (int iE = 0; iE < n; ++iE)
+    current.p4 += element(store, elements[iE].first, elements[iE].second);
+
+  store.v_system.emplace_back(current);
+  return current.p4;
+}
+
+#endif
@@ -7,7 +7,10 @@
 
 #include <numeric>
 #include <cmath>
-#include "TLorentzVector.h"
+#include <array>
+#include <tuple>
+#include "misc/constants.h"
+#include "misc/four_vector.h"
 
 /// poor man's std::hypot (tested with g++/clang++, fine for double: 1e-158 < i < 1e10)
 template <typename Number = float>
@@ -26,11 +29,12 @@ Number absolute_difference(Number num1, Number num2)
 
 
 
-/// actually abs(dphi)
+/// actually abs(dphi), wrapped into [0, pi]
+/// for many pairs at once see batch_delta_r2 in delta_r_matching.h
 template <typename Number = float>
 Number dphi(Number phi1, Number phi2) 
 {
-  return std::acos( std::cos(phi1 - phi2) );
+  return std::abs( std::remainder(phi1 - phi2, Number(2.) * Framework::constants::pi<Number>) );
 }
 
 
@@ -43,19 +47,21 @@ Number dR(Number eta1, Number phi1, Number eta2, Number phi2)
 
 
 
-/// helper for multivector_system_impl, doing the actual daughter assignment
+/// helper for multivector_system_impl, doing the actual daughter assignment and summation
+/// the sum is done in double whatever the input type, as TLorentzVector did, since M2 = E2 - p2 cancels badly in float for boosted systems
 template <size_t ...N, typename Number>
-void assign_vector(std::array<TLorentzVector, sizeof...(N)> &p4, std::array<Number, 4 * sizeof...(N)> &arg, std::index_sequence<N...>)
+FourVector<double> sum_vector(const std::array<Number, 4 * sizeof...(N)> &arg, std::index_sequence<N...>)
 {
-  (std::get<N>(p4).SetPtEtaPhiM(std::get<4 * N>(arg), std::get<(4 * N) + 1>(arg), std::get<(4 * N) + 2>(arg), std::get<(4 * N) + 3>(arg)), ...);
+  return (FourVector<double>::pt_eta_phi_m(std::get<4 * N>(arg), std::get<(4 * N) + 1>(arg), std::get<(4 * N) + 2>(arg), std::get<(4 * N) + 3>(arg)) + ...);
 }
 
 
 
-/// provide a reference to sum of N 4-momenta
-/// with arg checking to minimize the reassignment i.e. reuse the p4 as much as possible
+/// provide a reference to sum of N 4-momenta, in double precision
+/// with arg checking to minimize the recomputation i.e. reuse the p4 as much as possible
+/// the cache is thread-local, so that analyzers running on several threads do not clobber each other
 template <size_t ...N, typename ...Numbers>
-const TLorentzVector& multivector_system_impl(std::index_sequence<N...>, Numbers ...numbers)
+const auto& multivector_system_impl(std::index_sequence<N...>, Numbers ...numbers)
 {
   static_assert(sizeof...(N) > 0 and sizeof...(numbers) == sizeof...(N) and sizeof...(N) % 4 == 0, 
                 "ERROR: multivector_system: arguments are interpreted as pt, eta, phi and mass of "
@@ -64,19 +70,16 @@ const TLorentzVector& multivector_system_impl(std::index_sequence<N...>, Numbers
 
   using Number = typename std::tuple_element<0, std::tuple<Numbers...>>::type;
 
-  static TLorentzVector psum;
-  static std::array<Number, sizeof...(N)> arg;
-  if (((std::get<N>(arg) == numbers) and ...))
+  thread_local FourVector<double> psum;
+  thread_local std::array<Number, sizeof...(N)> arg;
+  thread_local bool filled = false;
+  if (filled and ((std::get<N>(arg) == numbers) and ...))
     return psum;
 
   ((std::get<N>(arg) = numbers), ...);
+  filled = true;
 
-  static std::array<TLorentzVector, sizeof...(N) / 4> p4s;
-  assign_vector(p4s, arg, std::make_index_sequence<sizeof...(N) / 4>{});
-  psum = p4s[0];
-  for (int ip4 = 1; ip4 < sizeof...(N) / 4; ++ip4)
-    psum += p4s[ip4];
-
+  psum = sum_vector(arg, std::make_index_sequence<sizeof...(N) / 4>{});
   return psum;
 }
 
@@ -84,8 +87,9 @@ const TLorentzVector& multivector_system_impl(std::index_sequence<N...>, Numbers
 
 /// whenever such a p4 sum is desired, without having to deal with details
 /// for use mainly in the Aggregate attributes that require index masking
+/// when several attributes are made from the same elements, KinematicsCache in kinematics_cache.h shares the work between them
 template <typename ...Numbers>
-const TLorentzVector& multivector_system(Numbers ...numbers)
+const auto& multivector_system(Numbers ...numbers)
 {
   return multivector_system_impl(std::make_index_sequence<sizeof...(numbers)>{}, numbers...);
 }
@@ -97,7 +101,7 @@ template <typename Number, typename ...Numbers>
 Number invariant_mass_impl(Number number, Numbers ...numbers) 
 { 
   const auto &p4 = multivector_system(number, numbers...);
-  return p4.M();
+  return static_cast<Number>(p4.M());
 }
 
 
@@ -125,7 +129,7 @@ template <typename Number, typename ...Numbers>
 Number system_pt_impl(Number number, Numbers ...numbers) 
 { 
   const auto &p4 = multivector_system(number, numbers...);
-  return p4.Pt();
+  return static_cast<Number>(p4.Pt());
 }
 
 
@@ -151,7 +155,7 @@ template <typename Number, typename ...Numbers>
 Number system_rapidity_impl(Number number, Numbers ...numbers) 
 { 
   const auto &p4 = multivector_system(number, numbers...);
-  return p4.Rapidity();
+  return static_cast<Number>(p4.Rapidity());
 }
 
 
@@ -170,4 +174,69 @@ auto system_rapidity() -> decltype(system_rapidity_helper<Number>(std::make_inde
   return system_rapidity_helper<Number>(std::make_index_sequence<4 * N>{});
 }
 
+
+
+/// helper for batch_system_impl, splitting the 4N columns into the per-component arrays of batch_system_kinematics
+template <typename Number, size_t ...K>
+void batch_system_split(std::index_sequence<K...>, std::size_t n, const std::array<const Number *, 4 * sizeof...(K)> &column,
+                        Number *out_mass, Number *out_pt, Number *out_rapidity)
+{
+  batch_system_kinematics<sizeof...(K), Number>(n, {std::get<4 * K>(column)...}, {std::get<(4 * K) + 1>(column)...},
+                                                {std::get<(4 * K) + 2>(column)...}, {std::get<(4 * K) + 3>(column)...},
+                                                out_mass, out_pt, out_rapidity);
+}
+
+
+
+/// implementation of the kernels, with the output selected by which of them is not nullptr
+template <int Output, typename Number, typename ...Numbers>
+void batch_system_impl(std::size_t n, Number *out, const Numbers *...columns)
+{
+  static_assert(sizeof...(columns) > 0 and sizeof...(columns) % 4 == 0,
+                "ERROR: batch_system: columns are interpreted as pt, eta, phi and mass of "
+                "the vectors comprising the system. As such, the number of columns must be 4N!!");
+
+  batch_system_split<Number>(std::make_index_sequence<sizeof...(columns) / 4>{}, n, {columns...},
+                             (Output == 0) ? out : nullptr, (Output == 1) ? out : nullptr, (Output == 2) ? out : nullptr);
+}
+
+
+
+/// helper that returns a function pointer to batch_system_impl
+template <int Output, typename Number, size_t ...N>
+auto batch_system_helper(std::index_sequence<N...>) -> void(*)(std::size_t, Number *, typename std::tuple_element<N, std::array<const Number *, sizeof...(N)>>::type...)
+{
+  return batch_system_impl<Output, Number, typename std::tuple_element<N, std::array<Number, sizeof...(N)>>::type...>;
+}
+
+
+
+/// a function returning a kernel that calculates the invariant masses of n systems consisting of N 4-momenta each
+/// i.e. the column version of invariant_mass, to be given to e.g. Batch::kernel_attribute instead of the element-wise one
+/// signature: void(std::size_t n, Number *out, const Number *pt1, const Number *eta1, const Number *phi1, const Number *mass1, pt2, ...)
+/// the work is done by batch_system_kinematics in four_vector.h, which is written to be vectorized
+template <size_t N = 2, typename Number = float>
+auto batch_invariant_mass() -> decltype(batch_system_helper<0, Number>(std::make_index_sequence<4 * N>{}))
+{
+  return batch_system_helper<0, Number>(std::make_index_sequence<4 * N>{});
+}
+
+
+
+/// as batch_invariant_mass, for the transverse momentum
+template <size_t N = 2, typename Number = float>
+auto batch_system_pt() -> decltype(batch_system_helper<1, Number>(std::make_index_sequence<4 * N>{}))
+{
+  return batch_system_helper<1, Number>(std::make_index_sequence<4 * N>{});
+}
+
+
+
+/// as batch_invariant_mass, for the rapidity
+template <size_t N = 2, typename Number = float>
+auto batch_system_rapidity() -> decltype(batch_system_helper<2, Number>(std::make_index_sequence<4 * N>{}))
+{
+  return batch_system_helper<2, Number>(std::make_index_sequence<4 * N>{});
+}
+
 #endif
@@ -0,0 +1,191 @@
+#ifndef FWK_OVERLAP_REMOVAL_H
+#define FWK_OVERLAP_REMOVAL_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: overlap removal i.e. cleaning the elements of a group against those of other groups, by their distance in the eta-phi plane
+// note: the elements being cleaned against are gathered into eta-sorted columns, so that each element being cleaned
+// note: is compared only to the slice within dr in eta, by the same vectorized kernel as in DeltaRMatching
+// note: only the selected elements take part, on both sides, and the removal is done by updating the indices of the cleaned group
+// note: all working space is kept per thread and reused, so that nothing is allocated per event once warmed up
+
+#include <functional>
+
+#include "misc/delta_r_matching.h"
+
+template <typename Number = float>
+class OverlapRemoval {
+public:
+  enum class Policy {remove_target, remove_reference};
+
+  /// constructor
+  /// eta_ and phi_ are the names of the attributes used, common to all groups
+  OverlapRemoval(const std::string &eta_ = "eta", const std::string &phi_ = "phi");
+
+  /// add a cleaning step
+  /// with remove_target, selected target elements within dr of any selected reference element are removed from the target
+  /// with remove_reference it is the other way around: each reference loses its elements within dr of any selected target element
+  /// steps run in the order they are added, each seeing the groups as cleaned by the steps before it
+  /// i.e. the order of the steps sets the priority between the groups
+  /// the target can not be among the references, as it would then be cleaned against itself
+  template <typename Target, typename ...References>
+  void add_step(Policy policy, Number dr, Target &target, References &...references);
+
+  /// run all the steps, updating the indices of the groups in place
+  /// to be called once per event, after the groups are populated and their elements selected
+  void run() const;
+
+protected:
+  /// per-thread working space
+  struct Scratch {
+    std::vector<Number> v_eta, v_phi, v_dr2;
+    std::vector<int> v_order;
+    std::vector<Number> v_sort_eta, v_sort_phi;
+    std::vector<int> v_keep;
+  };
+
+  static Scratch& scratch();
+
+  /// gather the selected elements of the groups into the eta-sorted columns of the working space
+  template <typename ...Groups>
+  void collect(Scratch &work, const Groups &...groups) const;
+
+  /// remove from the group its selected elements within dr of any of the gathered elements
+  template <typename Group>
+  void clean(Scratch &work, Group &group, Number dr) const;
+
+  /// the attribute names
+  std::string eta_name, phi_name;
+
+  /// the cleaning steps, in order
+  std::vector<std::function<void()>> v_step;
+};
+
+
+
+template <typename Number>
+OverlapRemoval<Number>::OverlapRemoval(const std::string &eta_, const std::string &phi_) :
+eta_name(eta_),
+phi_name(phi_)
+{}
+
+
+
+template <typename Number>
+template <typename Target, typename ...References>
+void OverlapRemoval<Number>::add_step(Policy policy, Number dr, Target &target, References &...references)
+{
+  static_assert(sizeof...(references) > 0, "ERROR: OverlapRemoval::add_step: at least one reference group must be provided!!");
+
+  if (!(dr > Number(0.)))
+    throw std::invalid_argument( "ERROR: OverlapRemoval::add_step: dr must be positive!!" );
+
+  auto check = [this] (const auto &group) {
+    if (group.inquire(eta_name) == -1 or group.inquire(phi_name) == -1)
+      throw std::invalid_argument( "ERROR: OverlapRemoval::add_step: group " + group.name + " does not have the attributes " +
+                                   eta_name + " and " + phi_name + "!!" );
+  };
+  check(target);
+  (check(references), ...);
+
+  // a group cleaned against itself would lose every selected element, as each is at zero distance of itself
+  if (((static_cast<const void *>(&target) == static_cast<const void *>(&references)) or ...))
+    throw std::invalid_argument( "ERROR: OverlapRemoval::add_step: group " + target.name + " can not be both the target and a reference!!" );
+
+  if (policy == Policy::remove_target) {
+    v_step.emplace_back([this, dr, &target, &references...] () {
+        auto &work = scratch();
+        collect(work, references...);
+        clean(work, target, dr);
+      });
+  }
+  else {
+    v_step.emplace_back([this, dr, &target, &references...] () {
+        auto &work = scratch();
+        collect(work, target);
+        (clean(work, references, dr), ...);
+      });
+  }
+}
+
+
+
+template <typename Number>
+void OverlapRemoval<Number>::run() const
+{
+  for (const auto &step : v_step)
+    step();
+}
+
+
+
+template <typename Number>
+typename OverlapRemoval<Number>::Scratch& OverlapRemoval<Number>::scratch()
+{
+  thread_local Scratch work;
+  return work;
+}
+
+
+
+template <typename Number>
+template <typename ...Groups>
+void OverlapRemoval<Number>::collect(Scratch &work, const Groups &...groups) const
+{
+  work.v_eta.clear();
+  work.v_phi.clear();
+
+  auto gather = [this, &work] (const auto &group) {
+    const auto &eta = group.template get<Number>(eta_name);
+    const auto &phi = group.template get<Number>(phi_name);
+    for (auto index : group.ref_to_indices()) {
+      work.v_eta.emplace_back(eta[index]);
+      work.v_phi.emplace_back(phi[index]);
+    }
+  };
+  (gather(groups), ...);
+
+  const int n = work.v_eta.size();
+  work.v_order.resize(n);
+  std::iota(std::begin(work.v_order), std::end(work.v_order), 0);
+  std::sort(std::begin(work.v_order), std::end(work.v_order), [&eta = work.v_eta] (int i1, int i2) { return eta[i1] < eta[i2]; });
+
+  work.v_sort_eta.resize(n);
+  work.v_sort_phi.resize(n);
+  for (int iE = 0; iE < n; ++iE) {
+    work.v_sort_eta[iE] = work.v_eta[work.v_order[iE]];
+    work.v_sort_phi[iE] = work.v_phi[work.v_order[iE]];
+  }
+}
+
+
+
+template <typename Number>
+template <typename Group>
+void OverlapRemoval<Number>::clean(Scratch &work, Group &group, Number dr) const
+{
+  if (work.v_sort_eta.empty() or group.ref_to_indices().empty())
+    return;
+
+  const auto &eta = group.template get<Number>(eta_name);
+  const auto &phi = group.template get<Number>(phi_name);
+  const Number dr2 = dr * dr;
+  work.v_dr2.resize(work.v_sort_eta.size());
+  work.v_keep.clear();
+
+  for (auto index : group.ref_to_indices()) {
+    // anything outside of the eta window can not be within dr
+    const auto begin = std::lower_bound(std::begin(work.v_sort_eta), std::end(work.v_sort_eta), eta[index] - dr);
+    const auto end = std::upper_bound(begin, std::end(work.v_sort_eta), eta[index] + dr);
+    const int first = std::distance(std::begin(work.v_sort_eta), begin), n = std::distance(begin, end);
+
+    batch_delta_r2(n, eta[index], phi[index], work.v_sort_eta.data() + first, work.v_sort_phi.data() + first, work.v_dr2.data());
+    if (std::none_of(std::begin(work.v_dr2), std::begin(work.v_dr2) + n, [dr2] (Number d2) { return d2 < dr2; }))
+      work.v_keep.emplace_back(index);
+  }
+
+  if (work.v_keep.size() != group.ref_to_indices().size())
+    group.update_indices(work.v_keep);
+}
+
+#endif
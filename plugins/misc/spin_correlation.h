@@ -4,166 +4,437 @@
 // -*- C++ -*-
 // author: afiq anuar
 // short: for computing ttbar spin correlation variables except dphi
+// note: batch_spin_correlation computes the observables of many events at once, from structure-of-arrays columns
+// note: the event loop is branch-free and auto-vectorized at -O3, given -fno-math-errno as noted in four_vector.h
+// note: compute_spin_correlation and the per-observable functions are the single event interface, built on top of the batch one
+// note: the frames are built in double even for float inputs, as the boosts into the top rest frames lose precision with the boost
+// note: in float that is up to ~2e-4 on the projections and ~5e-4 on phi0 and phi1, near the beam or where acos is steep
+// note: in double the observables agree with the exact formulae to ~1e-7, the accuracy of the approximate functions, at half the vector width
+
+#include <array>
+#include <vector>
+#include <string>
+#include <utility>
 
 #include "misc/function_util.h"
 #include "misc/constants.h"
+#include "misc/four_vector.h"
+
+/// the observables computed by compute_spin_correlation and batch_spin_correlation, in the order of the former
+enum class SpinObservable : int {
+  cLab,
+  kdx, kdy, kdz,
+  rdx, rdy, rdz,
+  ndx, ndy, ndz,
+  b1k, b2k,
+  b1j, b2j,
+  b1r, b2r,
+  b1q, b2q,
+  b1n, b2n,
+  b1x, b2x,
+  b1y, b2y,
+  b1z, b2z,
+  bPkk, bMkk,
+  bPjj, bMjj,
+  bPrr, bMrr,
+  bPqq, bMqq,
+  bPnn, bMnn,
+  bPxx, bMxx,
+  bPyy, bMyy,
+  bPzz, bMzz,
+  ckk, crr, cnn,
+  crk, ckr,
+  cnr, crn,
+  cnk, ckn,
+  cPrk, cMrk,
+  cPnr, cMnr,
+  cPnk, cMnk,
+  cxx, cyy, czz,
+  cyx, cxy,
+  czy, cyz,
+  czx, cxz,
+  cPyx, cMyx,
+  cPzy, cMzy,
+  cPzx, cMzx,
+  cHel,
+  cHan, cSca, cTra,
+  crkP, cnrP, cnkP,
+  crkM, cnrM, cnkM,
+  cXxx, cYyy, cZzz,
+  cyxP, czyP, czxP,
+  cyxM, czyM, czxM,
+  kNorm, rNorm, nNorm,
+  phi0, phi1
+};
+
+constexpr int n_spin_observable = static_cast<int>(SpinObservable::phi1) + 1;
+
+/// names of the observables, as keyed in compute_spin_correlation
+constexpr std::array<const char *, n_spin_observable> spin_observable_name = {
+  "cLab",
+  "kdx", "kdy", "kdz",
+  "rdx", "rdy", "rdz",
+  "ndx", "ndy", "ndz",
+  "b1k", "b2k",
+  "b1j", "b2j",
+  "b1r", "b2r",
+  "b1q", "b2q",
+  "b1n", "b2n",
+  "b1x", "b2x",
+  "b1y", "b2y",
+  "b1z", "b2z",
+  "bPkk", "bMkk",
+  "bPjj", "bMjj",
+  "bPrr", "bMrr",
+  "bPqq", "bMqq",
+  "bPnn", "bMnn",
+  "bPxx", "bMxx",
+  "bPyy", "bMyy",
+  "bPzz", "bMzz",
+  "ckk", "crr", "cnn",
+  "crk", "ckr",
+  "cnr", "crn",
+  "cnk", "ckn",
+  "cPrk", "cMrk",
+  "cPnr", "cMnr",
+  "cPnk", "cMnk",
+  "cxx", "cyy", "czz",
+  "cyx", "cxy",
+  "czy", "cyz",
+  "czx", "cxz",
+  "cPyx", "cMyx",
+  "cPzy", "cMzy",
+  "cPzx", "cMzx",
+  "cHel",
+  "cHan", "cSca", "cTra",
+  "crkP", "cnrP", "cnkP",
+  "crkM", "cnrM", "cnkM",
+  "cXxx", "cYyy", "cZzz",
+  "cyxP", "czyP", "czxP",
+  "cyxM", "czyM", "czxM",
+  "kNorm", "rNorm", "nNorm",
+  "phi0", "phi1"
+};
+
+
+
+/// branch-free approximation of acos, Abramowitz and Stegun 4.4.46, accurate to 2e-8 absolute
+/// the argument is clamped to [-1, 1] first, so that rounding just outside of it does not give a NaN
+template <typename Number>
+inline Number approximate_acos(Number x)
+{
+  constexpr Number half_pi = 1.57079632679489662;
+  x = std::min(std::max(x, Number(-1.)), Number(1.));
+  const Number ax = std::abs(x);
+  const Number r = std::sqrt(Number(1.) - ax) * (Number(1.5707963050) + ax * (Number(-0.2145988016) + ax * (Number(0.0889789874) + ax * (Number(-0.0501743046) +
+                   ax * (Number(0.0308918810) + ax * (Number(-0.0170881256) + ax * (Number(0.0066700901) + ax * Number(-0.0012624911))))))));
+
+  // acos(-x) = pi - acos(x), written as arithmetic rather than as a selection
+  return half_pi - std::copysign(half_pi - r, x);
+}
+
+
+
+/// everything the observables are built from, for one event
+/// k, r and n are the helicity basis axes; b1 and b2 are the projections of the antilepton and lepton directions in their parent top rest frames
+/// onto the axes k, j, r, q, n, x, y and z, in this order, with b2 carrying the conventional minus sign
+template <typename Number>
+struct SpinFrame {
+  Number cLab, cHel, phi0;
+  std::array<Number, 3> k, r, n, ll;
+  std::array<Number, 8> b1, b2;
+};
+
+
+
+/// build the frame of one event, given the top, antitop, lepton and antilepton pt, eta, phi, mass
+/// the helicity basis is as in Bernreuther et al 1508.05271, and phi0 as in 1702.06063
+/// written without branches or library calls other than sqrt, so that it vectorizes when inlined into a loop over events
+template <typename Number>
+inline SpinFrame<Number> spin_frame(Number pTop_pt, Number pTop_eta, Number pTop_phi, Number pTop_m,
+                                    Number aTop_pt, Number aTop_eta, Number aTop_phi, Number aTop_m,
+                                    Number pLep_pt, Number pLep_eta, Number pLep_phi, Number pLep_m,
+                                    Number aLep_pt, Number aLep_eta, Number aLep_phi, Number aLep_m)
+{
+  using Vector = std::array<Number, 3>;
+  auto dot = [] (const Vector &v1, const Vector &v2) { return (v1[0] * v2[0]) + (v1[1] * v2[1]) + (v1[2] * v2[2]); };
+  auto unit = [&dot] (const Vector &v) { const Number inorm = Number(1.) / std::sqrt(dot(v, v)); return Vector{v[0] * inorm, v[1] * inorm, v[2] * inorm}; };
+  auto cross = [] (const Vector &v1, const Vector &v2) {
+    return Vector{(v1[1] * v2[2]) - (v1[2] * v2[1]), (v1[2] * v2[0]) - (v1[0] * v2[2]), (v1[0] * v2[1]) - (v1[1] * v2[0])};
+  };
+
+  // boost p4 by -p4 of the frame, with the same convention as TLorentzVector::Boost
+  // (gamma - 1) / b^2 is written as gamma^2 / (gamma + 1), which needs no special case for b = 0
+  auto boost = [] (FourVector<Number> &p4, const FourVector<Number> &frame) {
+    const Number bx = -frame.px / frame.e, by = -frame.py / frame.e, bz = -frame.pz / frame.e;
+    const Number gamma = Number(1.) / std::sqrt(Number(1.) - (bx * bx) - (by * by) - (bz * bz));
+    const Number bp = (bx * p4.px) + (by * p4.py) + (bz * p4.pz);
+    const Number gamma2 = (gamma * gamma) / (gamma + Number(1.));
+
+    p4.px += (gamma2 * bp * bx) + (gamma * bx * p4.e);
+    p4.py += (gamma2 * bp * by) + (gamma * by * p4.e);
+    p4.pz += (gamma2 * bp * bz) + (gamma * bz * p4.e);
+    p4.e = gamma * (p4.e + bp);
+  };
+
+  FourVector<Number> pTop, aTop, pLep, aLep;
+  approximate_cartesian(pTop_pt, pTop_eta, pTop_phi, pTop_m, pTop.px, pTop.py, pTop.pz, pTop.e);
+  approximate_cartesian(aTop_pt, aTop_eta, aTop_phi, aTop_m, aTop.px, aTop.py, aTop.pz, aTop.e);
+  approximate_cartesian(pLep_pt, pLep_eta, pLep_phi, pLep_m, pLep.px, pLep.py, pLep.pz, pLep.e);
+  approximate_cartesian(aLep_pt, aLep_eta, aLep_phi, aLep_m, aLep.px, aLep.py, aLep.pz, aLep.e);
+
+  SpinFrame<Number> frame;
+  frame.cLab = dot(unit({aLep.px, aLep.py, aLep.pz}), unit({pLep.px, pLep.py, pLep.pz}));
+
+  // the top with the larger absolute rapidity, compared as |pz| / E to skip the logarithms
+  const Number sD = std::copysign(Number(1.), (std::abs(pTop.pz) * aTop.e) - (std::abs(aTop.pz) * pTop.e));
+
+  // leptons are boosted into the ttbar rest frame, then into the rest frame of their parent top
+  const FourVector<Number> pTT = pTop + aTop;
+  boost(pTop, pTT);
+  boost(aTop, pTT);
+  boost(aLep, pTT);
+  boost(aLep, pTop);
+  boost(pLep, pTT);
+  boost(pLep, aTop);
+
+  const Vector a = unit({aLep.px, aLep.py, aLep.pz}), l = unit({pLep.px, pLep.py, pLep.pz});
+  frame.k = unit({pTop.px, pTop.py, pTop.pz});
+
+  // the angle of the top to the +z beam, and the sign needed to account for Bose symmetry
+  // r and n are unit vectors by construction, as |z - ck| = |z x k| = s, which is computed from kx and ky for precision near the beam
+  const Number c = frame.k[2], s = std::sqrt((frame.k[0] * frame.k[0]) + (frame.k[1] * frame.k[1]));
+  const Number sY_s = std::copysign(Number(1.), c) / s;
+  frame.r = {-sY_s * c * frame.k[0], -sY_s * c * frame.k[1], sY_s * (Number(1.) - (c * frame.k[2]))};
+  frame.n = {-sY_s * frame.k[1], sY_s * frame.k[0], Number(0.)};
+
+  const std::array<Vector, 8> axes = {frame.k, Vector{sD * frame.k[0], sD * frame.k[1], sD * frame.k[2]},
+                                      frame.r, Vector{sD * frame.r[0], sD * frame.r[1], sD * frame.r[2]},
+                                      frame.n, Vector{1., 0., 0.}, Vector{0., 1., 0.}, Vector{0., 0., 1.}};
+  for (int iA = 0; iA < 8; ++iA) {
+    frame.b1[iA] = dot(a, axes[iA]);
+    frame.b2[iA] = -dot(l, axes[iA]);
+  }
 
-template <typename Number = float>
-const std::vector<std::pair<std::string, Number>>& 
-compute_spin_correlation(Number pTop_pt, Number pTop_eta, Number pTop_phi, Number pTop_m,
-                         Number aTop_pt, Number aTop_eta, Number aTop_phi, Number aTop_m,
-                         Number pLep_pt, Number pLep_eta, Number pLep_phi, Number pLep_m,
-                         Number aLep_pt, Number aLep_eta, Number aLep_phi, Number aLep_m)
-{
-  using namespace Framework;
-  static std::vector<std::pair<std::string, Number>> m_spin_corr;
-  static int initialize = 0;
-  if (initialize == 0) {
-    m_spin_corr.reserve(96); // exact size
-    m_spin_corr.emplace_back("cLab", -9999.);
-
-    m_spin_corr.emplace_back("kdx", -9999.);
-    m_spin_corr.emplace_back("kdy", -9999.);
-    m_spin_corr.emplace_back("kdz", -9999.);
-
-    m_spin_corr.emplace_back("rdx", -9999.);
-    m_spin_corr.emplace_back("rdy", -9999.);
-    m_spin_corr.emplace_back("rdz", -9999.);
-
-    m_spin_corr.emplace_back("ndx", -9999.);
-    m_spin_corr.emplace_back("ndy", -9999.);
-    m_spin_corr.emplace_back("ndz", -9999.);
-
-    m_spin_corr.emplace_back("b1k", -9999.);
-    m_spin_corr.emplace_back("b2k", -9999.);
-
-    m_spin_corr.emplace_back("b1j", -9999.);
-    m_spin_corr.emplace_back("b2j", -9999.);
-
-    m_spin_corr.emplace_back("b1r", -9999.);
-    m_spin_corr.emplace_back("b2r", -9999.);
-
-    m_spin_corr.emplace_back("b1q", -9999.);
-    m_spin_corr.emplace_back("b2q", -9999.);
-
-    m_spin_corr.emplace_back("b1n", -9999.);
-    m_spin_corr.emplace_back("b2n", -9999.);
-
-    m_spin_corr.emplace_back("b1x", -9999.);
-    m_spin_corr.emplace_back("b2x", -9999.);
-
-    m_spin_corr.emplace_back("b1y", -9999.);
-    m_spin_corr.emplace_back("b2y", -9999.);
-
-    m_spin_corr.emplace_back("b1z", -9999.);
-    m_spin_corr.emplace_back("b2z", -9999.);
-
-    m_spin_corr.emplace_back("bPkk", -9999.);
-    m_spin_corr.emplace_back("bMkk", -9999.);
-
-    m_spin_corr.emplace_back("bPjj", -9999.);
-    m_spin_corr.emplace_back("bMjj", -9999.);
+  frame.cHel = dot(a, l);
+  frame.ll = cross(a, l);
 
-    m_spin_corr.emplace_back("bPrr", -9999.);
-    m_spin_corr.emplace_back("bMrr", -9999.);
+  // the directions transverse to k, b2 being -l.k
+  const Number b1k = frame.b1[0], b2k = frame.b2[0];
+  const Vector t_aLep = unit({a[0] - (b1k * frame.k[0]), a[1] - (b1k * frame.k[1]), a[2] - (b1k * frame.k[2])});
+  const Vector t_pLep = unit({l[0] + (b2k * frame.k[0]), l[1] + (b2k * frame.k[1]), l[2] + (b2k * frame.k[2])});
+  frame.phi0 = approximate_acos(dot(t_aLep, t_pLep));
 
-    m_spin_corr.emplace_back("bPqq", -9999.);
-    m_spin_corr.emplace_back("bMqq", -9999.);
+  return frame;
+}
 
-    m_spin_corr.emplace_back("bPnn", -9999.);
-    m_spin_corr.emplace_back("bMnn", -9999.);
 
-    m_spin_corr.emplace_back("bPxx", -9999.);
-    m_spin_corr.emplace_back("bMxx", -9999.);
 
-    m_spin_corr.emplace_back("bPyy", -9999.);
-    m_spin_corr.emplace_back("bMyy", -9999.);
+/// the value of one observable, given the frame
+template <SpinObservable O, typename Number>
+inline Number spin_observable(const SpinFrame<Number> &f)
+{
+  using S = SpinObservable;
+  enum {k, j, r, q, n, x, y, z};
+  constexpr int index = static_cast<int>(O);
 
-    m_spin_corr.emplace_back("bPzz", -9999.);
-    m_spin_corr.emplace_back("bMzz", -9999.);
+  if constexpr (O == S::cLab)
+    return f.cLab;
+  else if constexpr (index >= static_cast<int>(S::kdx) and index <= static_cast<int>(S::kdz))
+    return f.k[index - static_cast<int>(S::kdx)];
+  else if constexpr (index >= static_cast<int>(S::rdx) and index <= static_cast<int>(S::rdz))
+    return f.r[index - static_cast<int>(S::rdx)];
+  else if constexpr (index >= static_cast<int>(S::ndx) and index <= static_cast<int>(S::ndz))
+    return f.n[index - static_cast<int>(S::ndx)];
 
-    m_spin_corr.emplace_back("ckk", -9999.);
-    m_spin_corr.emplace_back("crr", -9999.);
-    m_spin_corr.emplace_back("cnn", -9999.);
+  // b1k, b2k, b1j... alternate between the two leptons along k, j, r, q, n, x, y, z
+  else if constexpr (index >= static_cast<int>(S::b1k) and index <= static_cast<int>(S::b2z)) {
+    constexpr int axis = (index - static_cast<int>(S::b1k)) / 2;
+    if constexpr ((index - static_cast<int>(S::b1k)) % 2 == 0)
+      return f.b1[axis];
+    else
+      return f.b2[axis];
+  }
 
-    m_spin_corr.emplace_back("crk", -9999.);
-    m_spin_corr.emplace_back("ckr", -9999.);
+  // and the sums and differences bPkk, bMkk... in the same way
+  else if constexpr (index >= static_cast<int>(S::bPkk) and index <= static_cast<int>(S::bMzz)) {
+    constexpr int axis = (index - static_cast<int>(S::bPkk)) / 2;
+    if constexpr ((index - static_cast<int>(S::bPkk)) % 2 == 0)
+      return f.b1[axis] + f.b2[axis];
+    else
+      return f.b1[axis] - f.b2[axis];
+  }
 
-    m_spin_corr.emplace_back("cnr", -9999.);
-    m_spin_corr.emplace_back("crn", -9999.);
+  // Cab = -9<cab>
+  else if constexpr (O == S::ckk) return f.b1[k] * f.b2[k];
+  else if constexpr (O == S::crr) return f.b1[r] * f.b2[r];
+  else if constexpr (O == S::cnn) return f.b1[n] * f.b2[n];
+  else if constexpr (O == S::crk) return f.b1[r] * f.b2[k];
+  else if constexpr (O == S::ckr) return f.b1[k] * f.b2[r];
+  else if constexpr (O == S::cnr) return f.b1[n] * f.b2[r];
+  else if constexpr (O == S::crn) return f.b1[r] * f.b2[n];
+  else if constexpr (O == S::cnk) return f.b1[n] * f.b2[k];
+  else if constexpr (O == S::ckn) return f.b1[k] * f.b2[n];
+
+  else if constexpr (O == S::cPrk) return spin_observable<S::crk>(f) + spin_observable<S::ckr>(f);
+  else if constexpr (O == S::cMrk) return spin_observable<S::crk>(f) - spin_observable<S::ckr>(f);
+  else if constexpr (O == S::cPnr) return spin_observable<S::cnr>(f) + spin_observable<S::crn>(f);
+  else if constexpr (O == S::cMnr) return spin_observable<S::cnr>(f) - spin_observable<S::crn>(f);
+  else if constexpr (O == S::cPnk) return spin_observable<S::cnk>(f) + spin_observable<S::ckn>(f);
+  else if constexpr (O == S::cMnk) return spin_observable<S::cnk>(f) - spin_observable<S::ckn>(f);
+
+  else if constexpr (O == S::cxx) return f.b1[x] * f.b2[x];
+  else if constexpr (O == S::cyy) return f.b1[y] * f.b2[y];
+  else if constexpr (O == S::czz) return f.b1[z] * f.b2[z];
+  else if constexpr (O == S::cyx) return f.b1[y] * f.b2[x];
+  else if constexpr (O == S::cxy) return f.b1[x] * f.b2[y];
+  else if constexpr (O == S::czy) return f.b1[z] * f.b2[y];
+  else if constexpr (O == S::cyz) return f.b1[y] * f.b2[z];
+  else if constexpr (O == S::czx) return f.b1[z] * f.b2[x];
+  else if constexpr (O == S::cxz) return f.b1[x] * f.b2[z];
+
+  else if constexpr (O == S::cPyx) return spin_observable<S::cyx>(f) + spin_observable<S::cxy>(f);
+  else if constexpr (O == S::cMyx) return spin_observable<S::cyx>(f) - spin_observable<S::cxy>(f);
+  else if constexpr (O == S::cPzy) return spin_observable<S::czy>(f) + spin_observable<S::cyz>(f);
+  else if constexpr (O == S::cMzy) return spin_observable<S::czy>(f) - spin_observable<S::cyz>(f);
+  else if constexpr (O == S::cPzx) return spin_observable<S::czx>(f) + spin_observable<S::cxz>(f);
+  else if constexpr (O == S::cMzx) return spin_observable<S::czx>(f) - spin_observable<S::cxz>(f);
 
-    m_spin_corr.emplace_back("cnk", -9999.);
-    m_spin_corr.emplace_back("ckn", -9999.);
+  // opening angle between the spin vectors
+  else if constexpr (O == S::cHel) return f.cHel;
 
-    m_spin_corr.emplace_back("cPrk", -9999.);
-    m_spin_corr.emplace_back("cMrk", -9999.);
+  // cHel with one spin vector flipped about a given axis
+  // useful to measure Cii = 1.5(Di - D), where Di is the coeff for these flipped cHel
+  else if constexpr (O == S::cHan) return spin_observable<S::ckk>(f) - spin_observable<S::crr>(f) - spin_observable<S::cnn>(f);
+  else if constexpr (O == S::cSca) return -spin_observable<S::ckk>(f) + spin_observable<S::crr>(f) - spin_observable<S::cnn>(f);
+  else if constexpr (O == S::cTra) return -spin_observable<S::ckk>(f) - spin_observable<S::crr>(f) + spin_observable<S::cnn>(f);
+
+  // cHel with one of the spin vectors having two of its components swapped, or also sign flipped
+  // useful to measure Cij + Cji = -3Dij - Ckk for axes i, j and k, and Cij - Cji
+  else if constexpr (O == S::crkP) return -spin_observable<S::crk>(f) - spin_observable<S::ckr>(f) - spin_observable<S::cnn>(f);
+  else if constexpr (O == S::cnrP) return -spin_observable<S::ckk>(f) - spin_observable<S::cnr>(f) - spin_observable<S::crn>(f);
+  else if constexpr (O == S::cnkP) return -spin_observable<S::cnk>(f) - spin_observable<S::crr>(f) - spin_observable<S::ckn>(f);
+  else if constexpr (O == S::crkM) return -spin_observable<S::crk>(f) + spin_observable<S::ckr>(f) - spin_observable<S::cnn>(f);
+  else if constexpr (O == S::cnrM) return -spin_observable<S::ckk>(f) - spin_observable<S::cnr>(f) + spin_observable<S::crn>(f);
+  else if constexpr (O == S::cnkM) return -spin_observable<S::cnk>(f) - spin_observable<S::crr>(f) + spin_observable<S::ckn>(f);
+
+  // the same in the xyz system
+  else if constexpr (O == S::cXxx) return spin_observable<S::cxx>(f) - spin_observable<S::cyy>(f) - spin_observable<S::czz>(f);
+  else if constexpr (O == S::cYyy) return -spin_observable<S::cxx>(f) + spin_observable<S::cyy>(f) - spin_observable<S::czz>(f);
+  else if constexpr (O == S::cZzz) return -spin_observable<S::cxx>(f) - spin_observable<S::cyy>(f) + spin_observable<S::czz>(f);
+  else if constexpr (O == S::cyxP) return -spin_observable<S::cyx>(f) - spin_observable<S::cxy>(f) - spin_observable<S::czz>(f);
+  else if constexpr (O == S::czyP) return -spin_observable<S::cxx>(f) - spin_observable<S::czy>(f) - spin_observable<S::cyz>(f);
+  else if constexpr (O == S::czxP) return -spin_observable<S::czx>(f) - spin_observable<S::cyy>(f) - spin_observable<S::cxz>(f);
+  else if constexpr (O == S::cyxM) return -spin_observable<S::cyx>(f) + spin_observable<S::cxy>(f) - spin_observable<S::czz>(f);
+  else if constexpr (O == S::czyM) return -spin_observable<S::cxx>(f) - spin_observable<S::czy>(f) + spin_observable<S::cyz>(f);
+  else if constexpr (O == S::czxM) return -spin_observable<S::czx>(f) - spin_observable<S::cyy>(f) + spin_observable<S::cxz>(f);
 
-    m_spin_corr.emplace_back("cPnr", -9999.);
-    m_spin_corr.emplace_back("cMnr", -9999.);
+  // these are the O_CP1 and O_CP2 as in page 18 (why not O_CP3 with n base too)
+  else if constexpr (O == S::kNorm) return (f.ll[0] * f.k[0]) + (f.ll[1] * f.k[1]) + (f.ll[2] * f.k[2]);
+  else if constexpr (O == S::rNorm) return (f.ll[0] * f.r[0]) + (f.ll[1] * f.r[1]) + (f.ll[2] * f.r[2]);
+  else if constexpr (O == S::nNorm) return (f.ll[0] * f.n[0]) + (f.ll[1] * f.n[1]) + (f.ll[2] * f.n[2]);
+
+  // angles as in 1702.06063; phi0 = phi* and phi1 = phi*_CP, sensitive to CP mixtures (shows up as a phase in the distributions)
+  // phi1 is 2 pi - phi0 when kNorm < 0, written as arithmetic rather than as a selection
+  else if constexpr (O == S::phi0) return f.phi0;
+  else {
+    constexpr Number pi = Framework::constants::pi<Number>;
+    return pi + ((f.phi0 - pi) * std::copysign(Number(1.), spin_observable<S::kNorm>(f)));
+  }
+}
 
-    m_spin_corr.emplace_back("cPnk", -9999.);
-    m_spin_corr.emplace_back("cMnk", -9999.);
 
-    m_spin_corr.emplace_back("cxx", -9999.);
-    m_spin_corr.emplace_back("cyy", -9999.);
-    m_spin_corr.emplace_back("czz", -9999.);
 
-    m_spin_corr.emplace_back("cyx", -9999.);
-    m_spin_corr.emplace_back("cxy", -9999.);
+/// output of batch_spin_correlation: one column per observable, of which only the requested ones are filled
+template <typename Number = float>
+struct SpinCorrelationColumns {
+  std::array<std::vector<Number>, n_spin_observable> v_column;
 
-    m_spin_corr.emplace_back("czy", -9999.);
-    m_spin_corr.emplace_back("cyz", -9999.);
+  std::vector<Number>& operator[](SpinObservable observable) { return v_column[static_cast<int>(observable)]; }
 
-    m_spin_corr.emplace_back("czx", -9999.);
-    m_spin_corr.emplace_back("cxz", -9999.);
+  const std::vector<Number>& operator[](SpinObservable observable) const { return v_column[static_cast<int>(observable)]; }
+};
 
-    m_spin_corr.emplace_back("cPyx", -9999.);
-    m_spin_corr.emplace_back("cMyx", -9999.);
 
-    m_spin_corr.emplace_back("cPzy", -9999.);
-    m_spin_corr.emplace_back("cMzy", -9999.);
 
-    m_spin_corr.emplace_back("cPzx", -9999.);
-    m_spin_corr.emplace_back("cMzx", -9999.);
+/// helper for batch_spin_correlation, doing the actual loop over the events
+/// one output parameter per observable, so that they can all be restrict
+/// the frame is built in double whatever the input type, and only the observables are narrowed, see the notes at the top
+template <SpinObservable O, typename Number>
+using spin_column_t = Number;
 
-    m_spin_corr.emplace_back("cHel", -9999.);
+template <SpinObservable ...Obs, typename Number>
+void batch_spin_correlation_impl(std::size_t n, 
+                                 const std::array<const Number *, 4> &top, const std::array<const Number *, 4> &antitop,
+                                 const std::array<const Number *, 4> &lepton, const std::array<const Number *, 4> &antilepton,
+                                 spin_column_t<Obs, Number> *__restrict__ ...out)
+{
+  for (std::size_t iN = 0; iN < n; ++iN) {
+    auto at = [iN] (const Number *column) { return static_cast<double>(column[iN]); };
+    const auto frame = spin_frame(at(top[0]), at(top[1]), at(top[2]), at(top[3]),
+                                  at(antitop[0]), at(antitop[1]), at(antitop[2]), at(antitop[3]),
+                                  at(lepton[0]), at(lepton[1]), at(lepton[2]), at(lepton[3]),
+                                  at(antilepton[0]), at(antilepton[1]), at(antilepton[2]), at(antilepton[3]));
+    ((out[iN] = static_cast<Number>(spin_observable<Obs>(frame))), ...);
+  }
+}
 
-    m_spin_corr.emplace_back("cHan", -9999.);
-    m_spin_corr.emplace_back("cSca", -9999.);
-    m_spin_corr.emplace_back("cTra", -9999.);
 
-    m_spin_corr.emplace_back("crkP", -9999.);
-    m_spin_corr.emplace_back("cnrP", -9999.);
-    m_spin_corr.emplace_back("cnkP", -9999.);
 
-    m_spin_corr.emplace_back("crkM", -9999.);
-    m_spin_corr.emplace_back("cnrM", -9999.);
-    m_spin_corr.emplace_back("cnkM", -9999.);
+template <typename Number, int ...I>
+void batch_spin_correlation_all(std::integer_sequence<int, I...>, std::size_t n,
+                                const std::array<const Number *, 4> &top, const std::array<const Number *, 4> &antitop,
+                                const std::array<const Number *, 4> &lepton, const std::array<const Number *, 4> &antilepton,
+                                SpinCorrelationColumns<Number> &out)
+{
+  (out.v_column[I].resize(n), ...);
+  batch_spin_correlation_impl<static_cast<SpinObservable>(I)...>(n, top, antitop, lepton, antilepton, out.v_column[I].data()...);
+}
 
-    m_spin_corr.emplace_back("cXxx", -9999.);
-    m_spin_corr.emplace_back("cYyy", -9999.);
-    m_spin_corr.emplace_back("cZzz", -9999.);
 
-    m_spin_corr.emplace_back("cyxP", -9999.);
-    m_spin_corr.emplace_back("czyP", -9999.);
-    m_spin_corr.emplace_back("czxP", -9999.);
 
-    m_spin_corr.emplace_back("cyxM", -9999.);
-    m_spin_corr.emplace_back("czyM", -9999.);
-    m_spin_corr.emplace_back("czxM", -9999.);
+/// batch spin correlation observables of n events
+/// each of top, antitop, lepton and antilepton are the pt, eta, phi and mass columns, of length n
+/// the observables to compute are given as template arguments, e.g. batch_spin_correlation<SpinObservable::ckk, SpinObservable::phi0>(...)
+/// and all of them if none is given; as the set is known at compile time, whatever the requested ones do not need is never computed
+/// the requested columns of out are resized to n and overwritten, the others are left as they are
+template <SpinObservable ...Obs, typename Number>
+void batch_spin_correlation(std::size_t n,
+                            const std::array<const Number *, 4> &top, const std::array<const Number *, 4> &antitop,
+                            const std::array<const Number *, 4> &lepton, const std::array<const Number *, 4> &antilepton,
+                            SpinCorrelationColumns<Number> &out)
+{
+  if constexpr (sizeof...(Obs) == 0)
+    batch_spin_correlation_all(std::make_integer_sequence<int, n_spin_observable>{}, n, top, antitop, lepton, antilepton, out);
+  else {
+    (out[Obs].resize(n), ...);
+    batch_spin_correlation_impl<Obs...>(n, top, antitop, lepton, antilepton, out[Obs].data()...);
+  }
+}
 
-    m_spin_corr.emplace_back("kNorm", -9999.);
-    m_spin_corr.emplace_back("rNorm", -9999.);
-    m_spin_corr.emplace_back("nNorm", -9999.);
 
-    m_spin_corr.emplace_back("phi0", -9999.);
-    m_spin_corr.emplace_back("phi1", -9999.);
 
-    ++initialize;
+/// all the observables of a single event, keyed by name
+/// kept for the per-observable functions below; for many events, or only a few of the observables, use batch_spin_correlation instead
+/// the result is cached per thread, and recomputed only when the arguments change
+template <typename Number = float>
+const std::vector<std::pair<std::string, Number>>& 
+compute_spin_correlation(Number pTop_pt, Number pTop_eta, Number pTop_phi, Number pTop_m,
+                         Number aTop_pt, Number aTop_eta, Number aTop_phi, Number aTop_m,
+                         Number pLep_pt, Number pLep_eta, Number pLep_phi, Number pLep_m,
+                         Number aLep_pt, Number aLep_eta, Number aLep_phi, Number aLep_m)
+{
+  thread_local std::vector<std::pair<std::string, Number>> m_spin_corr;
+  if (m_spin_corr.empty()) {
+    m_spin_corr.reserve(n_spin_observable);
+    for (const auto name : spin_observable_name)
+      m_spin_corr.emplace_back(name, -9999.);
   }
 
-  static std::array<Number, 16> arg;
-  if (arg[0]  == pTop_pt and arg[1]  == pTop_eta and arg[2]  == pTop_phi and arg[3]  == pTop_m and 
+  thread_local std::array<Number, 16> arg;
+  thread_local bool filled = false;
+  if (filled and
+      arg[0]  == pTop_pt and arg[1]  == pTop_eta and arg[2]  == pTop_phi and arg[3]  == pTop_m and 
       arg[4]  == aTop_pt and arg[5]  == aTop_eta and arg[6]  == aTop_phi and arg[7]  == aTop_m and 
       arg[8]  == pLep_pt and arg[9]  == pLep_eta and arg[10] == pLep_phi and arg[11] == pLep_m and 
       arg[12] == aLep_pt and arg[13] == aLep_eta and arg[14] == aLep_phi and arg[15] == aLep_m)
@@ -173,352 +444,15 @@ compute_spin_correlation(Number pTop_pt, Number pTop_eta, Number pTop_phi, Numbe
   arg[4]  = aTop_pt; arg[5]  = aTop_eta; arg[6]  = aTop_phi; arg[7]  = aTop_m;
   arg[8]  = pLep_pt; arg[9]  = pLep_eta; arg[10] = pLep_phi; arg[11] = pLep_m;
   arg[12] = aLep_pt; arg[13] = aLep_eta; arg[14] = aLep_phi; arg[15] = aLep_m;
+  filled = true;
 
-  static TLorentzVector p4_pTop, p4_aTop, p4_pLep, p4_aLep;
-  p4_pTop.SetPtEtaPhiM(arg[0],  arg[1],  arg[2],  arg[3]);
-  p4_aTop.SetPtEtaPhiM(arg[4],  arg[5],  arg[6],  arg[7]);
-  p4_pLep.SetPtEtaPhiM(arg[8],  arg[9],  arg[10], arg[11]);
-  p4_aLep.SetPtEtaPhiM(arg[12], arg[13], arg[14], arg[15]);
-
-  // computes spin correlation variables
-  static const int icLab = index_with_key(m_spin_corr, "cLab");
-  m_spin_corr[icLab].second = p4_aLep.Vect().Unit().Dot( p4_pLep.Vect().Unit() );
-
-  // the various spin corr vars with boosting: Bernreuther 1508.05271
-  // xyz coordinate system
-  static const TVector3 xBase(1., 0., 0.);
-  static const TVector3 yBase(0., 1., 0.);
-  static const TVector3 zBase(0., 0., 1.);
-
-  const TLorentzVector p4_TT( p4_pTop + p4_aTop );
-
-  // should be const-ized, but Boost() doesn't work with copy ctors...
-  TLorentzVector b4_pTop( p4_pTop );
-  b4_pTop.Boost( -1. * p4_TT.BoostVector() );
-
-  TLorentzVector b4_aTop( p4_aTop );
-  b4_aTop.Boost( -1. * p4_TT.BoostVector() );
-
-  TLorentzVector b4_aLep( p4_aLep );
-  b4_aLep.Boost( -1. * p4_TT.BoostVector() );
-  b4_aLep.Boost( -1. * b4_pTop.BoostVector() );
-
-  TLorentzVector b4_pLep( p4_pLep );
-  b4_pLep.Boost( -1. * p4_TT.BoostVector() );
-  b4_pLep.Boost( -1. * b4_aTop.BoostVector() );
-
-  // calculating the top-beam angle for pTop only (defining pP as the +z beam proton)
-  const Number c_pTP = b4_pTop.Vect().Unit().Dot(zBase);
-  const Number s_pTP = std::sqrt(1. - (c_pTP * c_pTP));
-
-  // the signs needed to account for Bose symmetry
-  const Number sY = (c_pTP >= 0.) ? 1. : -1.;
-  const Number sD = ( std::abs(p4_pTop.Rapidity()) >= std::abs(p4_aTop.Rapidity()) ) ? 1. : -1.;
-
-  // define the base vectors a
-  // j and q base are the k* and r* respectively
-  // b is always -a
-  const TVector3 kBase = b4_pTop.Vect().Unit();
-  const TVector3 jBase = sD * kBase;
-  const TVector3 rBase = ( (sY / s_pTP) * (zBase - (c_pTP * kBase)) ).Unit();
-  const TVector3 qBase = sD * rBase;
-  const TVector3 nBase = ( (sY / s_pTP) * zBase.Cross(kBase) ).Unit();
-
-  // for resolution studies
-  // naming eg ndx for n dot x -> x component of the n axis
-  static const int ikdx = index_with_key(m_spin_corr, "kdx");
-  static const int ikdy = index_with_key(m_spin_corr, "kdy");
-  static const int ikdz = index_with_key(m_spin_corr, "kdz");
-
-  static const int irdx = index_with_key(m_spin_corr, "rdx");
-  static const int irdy = index_with_key(m_spin_corr, "rdy");
-  static const int irdz = index_with_key(m_spin_corr, "rdz");
-
-  static const int indx = index_with_key(m_spin_corr, "ndx");
-  static const int indy = index_with_key(m_spin_corr, "ndy");
-  static const int indz = index_with_key(m_spin_corr, "ndz");
-
-  m_spin_corr[ikdx].second = kBase.x();
-  m_spin_corr[ikdy].second = kBase.y();
-  m_spin_corr[ikdz].second = kBase.z();
-
-  m_spin_corr[irdx].second = rBase.x();
-  m_spin_corr[irdy].second = rBase.y();
-  m_spin_corr[irdz].second = rBase.z();
-
-  m_spin_corr[indx].second = nBase.x();
-  m_spin_corr[indy].second = nBase.y();
-  m_spin_corr[indz].second = nBase.z();
-
-  // find the polarization angles along bases
-  static const int ib1k = index_with_key(m_spin_corr, "b1k");
-  static const int ib2k = index_with_key(m_spin_corr, "b2k");
-
-  static const int ib1j = index_with_key(m_spin_corr, "b1j");
-  static const int ib2j = index_with_key(m_spin_corr, "b2j");
-
-  static const int ib1r = index_with_key(m_spin_corr, "b1r");
-  static const int ib2r = index_with_key(m_spin_corr, "b2r");
-
-  static const int ib1q = index_with_key(m_spin_corr, "b1q");
-  static const int ib2q = index_with_key(m_spin_corr, "b2q");
-
-  static const int ib1n = index_with_key(m_spin_corr, "b1n");
-  static const int ib2n = index_with_key(m_spin_corr, "b2n");
-
-  static const int ib1x = index_with_key(m_spin_corr, "b1x");
-  static const int ib2x = index_with_key(m_spin_corr, "b2x");
-
-  static const int ib1y = index_with_key(m_spin_corr, "b1y");
-  static const int ib2y = index_with_key(m_spin_corr, "b2y");
-
-  static const int ib1z = index_with_key(m_spin_corr, "b1z");
-  static const int ib2z = index_with_key(m_spin_corr, "b2z");
-
-  m_spin_corr[ib1k].second = b4_aLep.Vect().Unit().Dot( kBase );
-  m_spin_corr[ib2k].second = b4_pLep.Vect().Unit().Dot( -1. * kBase );
-
-  m_spin_corr[ib1j].second = b4_aLep.Vect().Unit().Dot( jBase );
-  m_spin_corr[ib2j].second = b4_pLep.Vect().Unit().Dot( -1. * jBase );
-
-  m_spin_corr[ib1r].second = b4_aLep.Vect().Unit().Dot( rBase );
-  m_spin_corr[ib2r].second = b4_pLep.Vect().Unit().Dot( -1. * rBase );
-
-  m_spin_corr[ib1q].second = b4_aLep.Vect().Unit().Dot( qBase );
-  m_spin_corr[ib2q].second = b4_pLep.Vect().Unit().Dot( -1. * qBase );
-
-  m_spin_corr[ib1n].second = b4_aLep.Vect().Unit().Dot( nBase );
-  m_spin_corr[ib2n].second = b4_pLep.Vect().Unit().Dot( -1. * nBase );
-
-  m_spin_corr[ib1x].second = b4_aLep.Vect().Unit().Dot( xBase );
-  m_spin_corr[ib2x].second = b4_pLep.Vect().Unit().Dot( -1. * xBase );
-
-  m_spin_corr[ib1y].second = b4_aLep.Vect().Unit().Dot( yBase );
-  m_spin_corr[ib2y].second = b4_pLep.Vect().Unit().Dot( -1. * yBase );
-
-  m_spin_corr[ib1z].second = b4_aLep.Vect().Unit().Dot( zBase );
-  m_spin_corr[ib2z].second = b4_pLep.Vect().Unit().Dot( -1. * zBase );
-
-  // sums and differences of the polarization angles
-  static const int ibPkk = index_with_key(m_spin_corr, "bPkk");
-  static const int ibMkk = index_with_key(m_spin_corr, "bMkk");
-
-  static const int ibPjj = index_with_key(m_spin_corr, "bPjj");
-  static const int ibMjj = index_with_key(m_spin_corr, "bMjj");
-
-  static const int ibPrr = index_with_key(m_spin_corr, "bPrr");
-  static const int ibMrr = index_with_key(m_spin_corr, "bMrr");
-
-  static const int ibPqq = index_with_key(m_spin_corr, "bPqq");
-  static const int ibMqq = index_with_key(m_spin_corr, "bMqq");
-
-  static const int ibPnn = index_with_key(m_spin_corr, "bPnn");
-  static const int ibMnn = index_with_key(m_spin_corr, "bMnn");
-
-  static const int ibPxx = index_with_key(m_spin_corr, "bPxx");
-  static const int ibMxx = index_with_key(m_spin_corr, "bMxx");
-
-  static const int ibPyy = index_with_key(m_spin_corr, "bPyy");
-  static const int ibMyy = index_with_key(m_spin_corr, "bMyy");
-
-  static const int ibPzz = index_with_key(m_spin_corr, "bPzz");
-  static const int ibMzz = index_with_key(m_spin_corr, "bMzz");
-
-  m_spin_corr[ibPkk].second = m_spin_corr[ib1k].second + m_spin_corr[ib2k].second;
-  m_spin_corr[ibMkk].second = m_spin_corr[ib1k].second - m_spin_corr[ib2k].second;
-
-  m_spin_corr[ibPjj].second = m_spin_corr[ib1j].second + m_spin_corr[ib2j].second;
-  m_spin_corr[ibMjj].second = m_spin_corr[ib1j].second - m_spin_corr[ib2j].second;
-
-  m_spin_corr[ibPrr].second = m_spin_corr[ib1r].second + m_spin_corr[ib2r].second;
-  m_spin_corr[ibMrr].second = m_spin_corr[ib1r].second - m_spin_corr[ib2r].second;
-
-  m_spin_corr[ibPqq].second = m_spin_corr[ib1q].second + m_spin_corr[ib2q].second;
-  m_spin_corr[ibMqq].second = m_spin_corr[ib1q].second - m_spin_corr[ib2q].second;
-
-  m_spin_corr[ibPnn].second = m_spin_corr[ib1n].second + m_spin_corr[ib2n].second;
-  m_spin_corr[ibMnn].second = m_spin_corr[ib1n].second - m_spin_corr[ib2n].second;
-
-  m_spin_corr[ibPxx].second = m_spin_corr[ib1x].second + m_spin_corr[ib2x].second;
-  m_spin_corr[ibMxx].second = m_spin_corr[ib1x].second - m_spin_corr[ib2x].second;
-
-  m_spin_corr[ibPyy].second = m_spin_corr[ib1y].second + m_spin_corr[ib2y].second;
-  m_spin_corr[ibMyy].second = m_spin_corr[ib1y].second - m_spin_corr[ib2y].second;
-
-  m_spin_corr[ibPzz].second = m_spin_corr[ib1z].second + m_spin_corr[ib2z].second;
-  m_spin_corr[ibMzz].second = m_spin_corr[ib1z].second - m_spin_corr[ib2z].second;
-
-  // Cab = -9<cab>
-  static const int ickk = index_with_key(m_spin_corr, "ckk");
-  static const int icrr = index_with_key(m_spin_corr, "crr");
-  static const int icnn = index_with_key(m_spin_corr, "cnn");
-
-  static const int icrk = index_with_key(m_spin_corr, "crk");
-  static const int ickr = index_with_key(m_spin_corr, "ckr");
-
-  static const int icnr = index_with_key(m_spin_corr, "cnr");
-  static const int icrn = index_with_key(m_spin_corr, "crn");
-
-  static const int icnk = index_with_key(m_spin_corr, "cnk");
-  static const int ickn = index_with_key(m_spin_corr, "ckn");
-
-  static const int icxx = index_with_key(m_spin_corr, "cxx");
-  static const int icyy = index_with_key(m_spin_corr, "cyy");
-  static const int iczz = index_with_key(m_spin_corr, "czz");
-
-  static const int icyx = index_with_key(m_spin_corr, "cyx");
-  static const int icxy = index_with_key(m_spin_corr, "cxy");
-
-  static const int iczy = index_with_key(m_spin_corr, "czy");
-  static const int icyz = index_with_key(m_spin_corr, "cyz");
-
-  static const int iczx = index_with_key(m_spin_corr, "czx");
-  static const int icxz = index_with_key(m_spin_corr, "cxz");
-
-  m_spin_corr[ickk].second = m_spin_corr[ib1k].second * m_spin_corr[ib2k].second;
-  m_spin_corr[icrr].second = m_spin_corr[ib1r].second * m_spin_corr[ib2r].second;
-  m_spin_corr[icnn].second = m_spin_corr[ib1n].second * m_spin_corr[ib2n].second;
-
-  m_spin_corr[icrk].second = m_spin_corr[ib1r].second * m_spin_corr[ib2k].second;
-  m_spin_corr[ickr].second = m_spin_corr[ib1k].second * m_spin_corr[ib2r].second;
-
-  m_spin_corr[icnr].second = m_spin_corr[ib1n].second * m_spin_corr[ib2r].second;
-  m_spin_corr[icrn].second = m_spin_corr[ib1r].second * m_spin_corr[ib2n].second;
-
-  m_spin_corr[icnk].second = m_spin_corr[ib1n].second * m_spin_corr[ib2k].second;
-  m_spin_corr[ickn].second = m_spin_corr[ib1k].second * m_spin_corr[ib2n].second;
-
-  m_spin_corr[icxx].second = m_spin_corr[ib1x].second * m_spin_corr[ib2x].second;
-  m_spin_corr[icyy].second = m_spin_corr[ib1y].second * m_spin_corr[ib2y].second;
-  m_spin_corr[iczz].second = m_spin_corr[ib1z].second * m_spin_corr[ib2z].second;
-
-  m_spin_corr[icyx].second = m_spin_corr[ib1y].second * m_spin_corr[ib2x].second;
-  m_spin_corr[icxy].second = m_spin_corr[ib1x].second * m_spin_corr[ib2y].second;
-
-  m_spin_corr[iczy].second = m_spin_corr[ib1z].second * m_spin_corr[ib2y].second;
-  m_spin_corr[icyz].second = m_spin_corr[ib1y].second * m_spin_corr[ib2z].second;
-
-  m_spin_corr[iczx].second = m_spin_corr[ib1z].second * m_spin_corr[ib2x].second;
-  m_spin_corr[icxz].second = m_spin_corr[ib1x].second * m_spin_corr[ib2z].second;
-
-  // sums and differences of cij
-  static const int icPrk = index_with_key(m_spin_corr, "cPrk");
-  static const int icMrk = index_with_key(m_spin_corr, "cMrk");
-
-  static const int icPnr = index_with_key(m_spin_corr, "cPnr");
-  static const int icMnr = index_with_key(m_spin_corr, "cMnr");
-
-  static const int icPnk = index_with_key(m_spin_corr, "cPnk");
-  static const int icMnk = index_with_key(m_spin_corr, "cMnk");
-
-  static const int icPyx = index_with_key(m_spin_corr, "cPyx");
-  static const int icMyx = index_with_key(m_spin_corr, "cMyx");
-
-  static const int icPzy = index_with_key(m_spin_corr, "cPzy");
-  static const int icMzy = index_with_key(m_spin_corr, "cMzy");
-
-  static const int icPzx = index_with_key(m_spin_corr, "cPzx");
-  static const int icMzx = index_with_key(m_spin_corr, "cMzx");
-
-  m_spin_corr[icPrk].second = m_spin_corr[icrk].second + m_spin_corr[ickr].second;
-  m_spin_corr[icMrk].second = m_spin_corr[icrk].second - m_spin_corr[ickr].second;
-
-  m_spin_corr[icPnr].second = m_spin_corr[icnr].second + m_spin_corr[icrn].second;
-  m_spin_corr[icMnr].second = m_spin_corr[icnr].second - m_spin_corr[icrn].second;
-
-  m_spin_corr[icPnk].second = m_spin_corr[icnk].second + m_spin_corr[ickn].second;
-  m_spin_corr[icMnk].second = m_spin_corr[icnk].second - m_spin_corr[ickn].second;
-
-  m_spin_corr[icPyx].second = m_spin_corr[icyx].second + m_spin_corr[icxy].second;
-  m_spin_corr[icMyx].second = m_spin_corr[icyx].second - m_spin_corr[icxy].second;
-
-  m_spin_corr[icPzy].second = m_spin_corr[iczy].second + m_spin_corr[icyz].second;
-  m_spin_corr[icMzy].second = m_spin_corr[iczy].second - m_spin_corr[icyz].second;
-
-  m_spin_corr[icPzx].second = m_spin_corr[iczx].second + m_spin_corr[icxz].second;
-  m_spin_corr[icMzx].second = m_spin_corr[iczx].second - m_spin_corr[icxz].second;
-
-  // opening angle between the spin vectors
-  static const int icHel = index_with_key(m_spin_corr, "cHel");
-  m_spin_corr[icHel].second = b4_aLep.Vect().Unit().Dot( b4_pLep.Vect().Unit() );
-
-  // cHel with one spin vector flipped about a given axis
-  // useful to measure Cii = 1.5(Di - D)
-  // where Di is the coeff for these flipped cHel
-  static const int icHan = index_with_key(m_spin_corr, "cHan");
-  static const int icSca = index_with_key(m_spin_corr, "cSca");
-  static const int icTra = index_with_key(m_spin_corr, "cTra");
-
-  m_spin_corr[icHan].second = 0. + m_spin_corr[ickk].second - m_spin_corr[icrr].second - m_spin_corr[icnn].second;
-  m_spin_corr[icSca].second = 0. - m_spin_corr[ickk].second + m_spin_corr[icrr].second - m_spin_corr[icnn].second;
-  m_spin_corr[icTra].second = 0. - m_spin_corr[ickk].second - m_spin_corr[icrr].second + m_spin_corr[icnn].second;
-
-  // cHel with one of the spin vectors having two of its components swapped
-  // in other words, flipped about the bisector of the i and j axes
-  // useful to measure Cij + Cji = -3Dij - Ckk for axes i, j and k
-  static const int icrkP = index_with_key(m_spin_corr, "crkP");
-  static const int icnrP = index_with_key(m_spin_corr, "cnrP");
-  static const int icnkP = index_with_key(m_spin_corr, "cnkP");
-
-  m_spin_corr[icnrP].second = 0. - m_spin_corr[ickk].second - m_spin_corr[icnr].second - m_spin_corr[icrn].second;
-  m_spin_corr[icnkP].second = 0. - m_spin_corr[icnk].second - m_spin_corr[icrr].second - m_spin_corr[ickn].second;
-  m_spin_corr[icrkP].second = 0. - m_spin_corr[icrk].second - m_spin_corr[ickr].second - m_spin_corr[icnn].second;
-
-  // the above naturally lends itself to a measurement of Cij - Cji
-  // with swapping and also sign flipping
-  static const int icrkM = index_with_key(m_spin_corr, "crkM");
-  static const int icnrM = index_with_key(m_spin_corr, "cnrM");
-  static const int icnkM = index_with_key(m_spin_corr, "cnkM");
-
-  m_spin_corr[icnrM].second = 0. - m_spin_corr[ickk].second - m_spin_corr[icnr].second + m_spin_corr[icrn].second;
-  m_spin_corr[icnkM].second = 0. - m_spin_corr[icnk].second - m_spin_corr[icrr].second + m_spin_corr[ickn].second;
-  m_spin_corr[icrkM].second = 0. - m_spin_corr[icrk].second + m_spin_corr[ickr].second - m_spin_corr[icnn].second;
-
-  // the flipped cHel in the xyz system
-  static const int icXxx = index_with_key(m_spin_corr, "cXxx");
-  static const int icYyy = index_with_key(m_spin_corr, "cYyy");
-  static const int icZzz = index_with_key(m_spin_corr, "cZzz");
-
-  m_spin_corr[icXxx].second = 0. + m_spin_corr[icxx].second - m_spin_corr[icyy].second - m_spin_corr[iczz].second;
-  m_spin_corr[icYyy].second = 0. - m_spin_corr[icxx].second + m_spin_corr[icyy].second - m_spin_corr[iczz].second;
-  m_spin_corr[icZzz].second = 0. - m_spin_corr[icxx].second - m_spin_corr[icyy].second + m_spin_corr[iczz].second;
-
-  static const int icyxP = index_with_key(m_spin_corr, "cyxP");
-  static const int iczyP = index_with_key(m_spin_corr, "czyP");
-  static const int iczxP = index_with_key(m_spin_corr, "czxP");
-
-  m_spin_corr[iczyP].second = 0. - m_spin_corr[icxx].second - m_spin_corr[iczy].second - m_spin_corr[icyz].second;
-  m_spin_corr[iczxP].second = 0. - m_spin_corr[iczx].second - m_spin_corr[icyy].second - m_spin_corr[icxz].second;
-  m_spin_corr[icyxP].second = 0. - m_spin_corr[icyx].second - m_spin_corr[icxy].second - m_spin_corr[iczz].second;
-
-  static const int icyxM = index_with_key(m_spin_corr, "cyxM");
-  static const int iczyM = index_with_key(m_spin_corr, "czyM");
-  static const int iczxM = index_with_key(m_spin_corr, "czxM");
-
-  m_spin_corr[iczyM].second = 0. - m_spin_corr[icxx].second - m_spin_corr[iczy].second + m_spin_corr[icyz].second;
-  m_spin_corr[iczxM].second = 0. - m_spin_corr[iczx].second - m_spin_corr[icyy].second + m_spin_corr[icxz].second;
-  m_spin_corr[icyxM].second = 0. - m_spin_corr[icyx].second + m_spin_corr[icxy].second - m_spin_corr[iczz].second;
-
-  // these are the O_CP1 and O_CP2 as in page 18 (why not O_CP3 with n base too)
-  static const int ikNorm = index_with_key(m_spin_corr, "kNorm");
-  static const int irNorm = index_with_key(m_spin_corr, "rNorm");
-  static const int inNorm = index_with_key(m_spin_corr, "nNorm");
-
-  const TVector3 llNorm = b4_aLep.Vect().Unit().Cross( b4_pLep.Vect().Unit() );
-  m_spin_corr[ikNorm].second =  llNorm.Dot( kBase );
-  m_spin_corr[irNorm].second =  llNorm.Dot( rBase );
-  m_spin_corr[inNorm].second =  llNorm.Dot( nBase );
-
-  // angles as in 1702.06063; phi0 = phi* and phi1 = phi*_CP
-  // sensitive to CP mixtures (shows up as a phase in the distributions)
-  static const int iphi0 = index_with_key(m_spin_corr, "phi0");
-  static const int iphi1 = index_with_key(m_spin_corr, "phi1");
-
-  const TVector3 t3_aLep = ( b4_aLep.Vect().Unit() - (m_spin_corr[ib1k].second * kBase) ).Unit();
-  const TVector3 t3_pLep = ( b4_pLep.Vect().Unit() - (-1. * m_spin_corr[ib2k].second * kBase) ).Unit();
+  // a batch of one
+  thread_local SpinCorrelationColumns<Number> columns;
+  batch_spin_correlation(1, {&arg[0], &arg[1], &arg[2], &arg[3]}, {&arg[4], &arg[5], &arg[6], &arg[7]}, 
+                         {&arg[8], &arg[9], &arg[10], &arg[11]}, {&arg[12], &arg[13], &arg[14], &arg[15]}, columns);
 
-  m_spin_corr[iphi0].second = std::acos(t3_aLep.Dot(t3_pLep));
-  m_spin_corr[iphi1].second = (m_spin_corr[ikNorm].second < 0.) ? (2. * constants::pi<Number>) - m_spin_corr[iphi0].second : m_spin_corr[iphi0].second;
+  for (int iO = 0; iO < n_spin_observable; ++iO)
+    m_spin_corr[iO].second = columns.v_column[iO][0];
 
   return m_spin_corr;
 }
@@ -0,0 +1,215 @@
+#ifndef FWK_SYNTHETIC_GROUP_H
+#define FWK_SYNTHETIC_GROUP_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: a group whose elements are generated rather than read off a file, for benchmarking and testing without any input
+// note: it plays the role of a Collection: attributes added here are filled by populate, and transforms run after them
+// note: the number of elements per event follows a poisson distribution of a given mean, truncated at a given maximum
+// note: the generation is seeded by the entry number, so that an entry gives the same elements however often and on whichever thread it is populated
+// note: default multiplicities mimicking a nanoAOD ttbar sample are provided in nanoaod_multiplicity
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cmath>
+#include <stdexcept>
+
+#include "Group.h"
+
+/// a small and fast random number generator (splitmix64), with the few distributions needed here
+class SyntheticRandom {
+public:
+  explicit SyntheticRandom(std::uint64_t seed_ = 0ULL) : state(seed_) {}
+
+  std::uint64_t next()
+  {
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  /// uniform in [0, 1)
+  double uniform() { return (next() >> 11) * 0x1.0p-53; }
+
+  double uniform(double min, double max) { return min + ((max - min) * uniform()); }
+
+  /// uniform integer in [min, max]
+  int integer(int min, int max) { return min + static_cast<int>(uniform() * (max - min + 1)); }
+
+  double normal(double mean, double sigma)
+  {
+    const double u1 = 1. - uniform(), u2 = uniform();
+    return mean + (sigma * std::sqrt(-2. * std::log(u1)) * std::cos(6.283185307179586 * u2));
+  }
+
+  double exponential(double mean) { return -mean * std::log(1. - uniform()); }
+
+  /// poisson by inversion, walking up from the mode so that the cost stays O(sqrt(mean))
+  int poisson(double mean)
+  {
+    if (mean <= 0.)
+      return 0;
+
+    const int mode = static_cast<int>(mean);
+    const double p_mode = std::exp((mode * std::log(mean)) - mean - std::lgamma(mode + 1.));
+
+    double u = uniform(), p_up = p_mode, p_down = p_mode;
+    int up = mode, down = mode;
+    u -= p_mode;
+    while (u > 0.) {
+      if (down > 0) {
+        p_down *= down / mean;
+        --down;
+        u -= p_down;
+        if (u <= 0.)
+          return down;
+      }
+
+      ++up;
+      p_up *= mean / up;
+      u -= p_up;
+      if (u <= 0. or (p_up < 1e-300 and down == 0))
+        return up;
+    }
+
+    return mode;
+  }
+
+  /// a seed that mixes a base seed with e.g. an entry number
+  static std::uint64_t mix(std::uint64_t seed, std::uint64_t key)
+  {
+    SyntheticRandom rng(seed ^ (key * 0xd1b54a32d192ed03ULL));
+    return rng.next();
+  }
+
+protected:
+  std::uint64_t state;
+};
+
+
+
+/// mean and maximum number of elements per event of a few nanoAOD groups, roughly as in a ttbar sample
+struct SyntheticMultiplicity {
+  double mean;
+  int max;
+};
+
+namespace nanoaod_multiplicity {
+  constexpr SyntheticMultiplicity gen_particle = {80., 300};
+  constexpr SyntheticMultiplicity gen_jet = {10., 60};
+  constexpr SyntheticMultiplicity jet = {9., 60};
+  constexpr SyntheticMultiplicity muon = {1.5, 20};
+  constexpr SyntheticMultiplicity electron = {1.2, 20};
+}
+
+
+
+template <typename ...Ts>
+class SyntheticGroup : public Framework::Group<Ts...> {
+public:
+  /// constructor
+  /// reserve_ and init as in Collection, multiplicity as described in the notes
+  /// a multiplicity with max 1 and mean >= 1 gives exactly one element per event, as in a non-array collection
+  SyntheticGroup(const std::string &name_, int reserve_, int init, SyntheticMultiplicity multiplicity_, std::uint64_t seed_ = 0ULL);
+
+  /// add a generated attribute
+  /// signature: the generator takes a SyntheticRandom & and returns a T
+  /// all attributes of an element are generated one after another, in the order they are added
+  template <typename T, typename Generator>
+  bool add_attribute(const std::string &attr, Generator generator);
+
+  /// populate the group with the elements of the given entry
+  void populate(long long entry) override;
+
+protected:
+  /// see constructor
+  SyntheticMultiplicity multiplicity;
+
+  std::uint64_t seed;
+
+  /// per generated attribute, the function writing the value of an element
+  std::vector<std::function<void(SyntheticRandom &, int)>> v_generator;
+};
+
+
+
+template <typename ...Ts>
+SyntheticGroup<Ts...>::SyntheticGroup(const std::string &name_, int reserve_, int init, SyntheticMultiplicity multiplicity_, std::uint64_t seed_) :
+Framework::Group<Ts...>::Group(name_, 0),
+multiplicity(multiplicity_),
+seed(seed_)
+{
+  if (multiplicity.max < 1 or multiplicity.mean < 0.)
+    throw std::invalid_argument( "ERROR: SyntheticGroup: multiplicity must have a non-negative mean and a positive maximum!!" );
+
+  this->reserve(reserve_);
+  v_generator.reserve(reserve_);
+  this->initialize((init > 0) ? init : multiplicity.max);
+}
+
+
+
+template <typename ...Ts>
+template <typename T, typename Generator>
+bool SyntheticGroup<Ts...>::add_attribute(const std::string &attr, Generator generator)
+{
+  static_assert(contained_in<T, Ts...>, "ERROR: SyntheticGroup::add_attribute: the attribute type is not among the types expected by the Group!!");
+
+  if (this->has_attribute(attr))
+    return false;
+
+  auto f_generate = [generator, this, iattr = this->v_data.size()] (SyntheticRandom &rng, int element) mutable -> void {
+    std::get<std::vector<T>>(this->v_data[iattr])[element] = generator(rng);
+  };
+
+  v_generator.emplace_back(f_generate);
+  this->v_attr.emplace_back(attr, std::function<void()>());
+  this->v_data.emplace_back(std::vector<T>());
+  std::visit([init = this->v_index.capacity()] (auto &vec) {vec.reserve(init);}, this->v_data.back());
+
+  return true;
+}
+
+
+
+template <typename ...Ts>
+void SyntheticGroup<Ts...>::populate(long long entry)
+{
+  FWK_PROFILE_SCOPE(collection_populate, this->name.c_str());
+  ++this->n_populate;
+
+  SyntheticRandom rng(SyntheticRandom::mix(seed, entry));
+  this->counter = std::min(rng.poisson(multiplicity.mean), multiplicity.max);
+  if (multiplicity.max == 1 and multiplicity.mean >= 1.)
+    this->counter = 1;
+  this->selected = this->counter;
+  this->peak = std::max(this->peak, this->counter);
+
+  if (this->counter > this->v_index.capacity())
+    this->initialize(this->counter);
+
+  this->v_index.clear();
+  for (int iD = 0; iD < this->counter; ++iD)
+    this->v_index.emplace_back(iD);
+
+  // sized rather than only reserved, so that every attribute holds exactly the populated elements
+  for (auto &dat : this->v_data)
+    std::visit([n = this->counter] (auto &vec) {vec.resize(n);}, dat);
+
+  for (int iD = 0; iD < this->counter; ++iD) {
+    for (auto &generate : v_generator)
+      generate(rng, iD);
+  }
+
+  // functional transformations can only run after everything else is populated, as in Collection
+  FWK_PROFILE_SCOPE(transform, this->name.c_str());
+  for (int iD = 0; iD < this->v_data.size(); ++iD) {
+    if (this->v_attr[iD].second)
+      this->v_attr[iD].second();
+  }
+}
+
+#endif
@@ -0,0 +1,675 @@
+#ifndef FWK_TTBAR_DILEPTON_SOLVER_H
+#define FWK_TTBAR_DILEPTON_SOLVER_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: analytic reconstruction of the dileptonic ttbar system from the two leptons, two b jets and the missing transverse momentum
+// note: with the W and top masses fixed, each neutrino momentum is confined to a conic in the plane of its transverse momentum
+// note: and the two conics are tied together by the missing transverse momentum, so the solutions are the roots of a quartic
+// note: as in L. Sonnenschein, Phys. Rev. D 73 (2006) 054015, hep-ph/0510100
+// note: every lepton-jet pairing is solved many times over, with the jet energies and the W and top masses smeared by their resolution and widths
+// note: of the up to four solutions of each sample the one of smallest ttbar mass is taken, and the neutrino momenta are averaged over the samples
+// note: weighted by an optional function of the two lepton-jet invariant masses
+// note: all samples of all pairings of an event are solved together, with the quartic coefficients and roots kept as flat columns
+// note: so that building the quartics and finding their roots, which is where the time goes, vectorizes at -O3 -mavx2 (or -march=native)
+// note: everything is computed in double precision in units of the top mass, whatever the Number type of the groups
+// note: the solved pairings are returned as the indices expected of an Aggregate indexer, see exec/example_gen_ttbar.cc
+
+#include <array>
+#include <vector>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <cmath>
+
+#include "misc/constants.h"
+#include "misc/four_vector.h"
+
+/// energy and longitudinal momentum of a neutrino as linear functions of its transverse momentum
+/// given the charged lepton and b jet (px, py, pz, e) it comes with, and the squared masses of the W and top they come from
+/// returns {e0, ex, ey, z0, zx, zy} such that e = e0 + ex px + ey py and pz = z0 + zx px + zy py
+inline std::array<double, 6> neutrino_linear_form(double lx, double ly, double lz, double le, double bx, double by, double bz, double be,
+                                                  double mw2, double mt2)
+{
+  // the W mass constraint reads le e - lz pz = lx px + ly py + aw
+  // the top mass constraint, less the above, reads be e - bz pz = bx px + by py + at
+  const double ml2 = (le * le) - (lx * lx) - (ly * ly) - (lz * lz);
+  const double sx = lx + bx, sy = ly + by, sz = lz + bz, se = le + be;
+  const double mlb2 = (se * se) - (sx * sx) - (sy * sy) - (sz * sz);
+  const double aw = 0.5 * (mw2 - ml2), at = 0.5 * (mt2 - mlb2 - mw2 + ml2);
+
+  const double inv = 1. / ((be * lz) - (le * bz));
+  return {((lz * at) - (bz * aw)) * inv, ((lz * bx) - (bz * lx)) * inv, ((lz * by) - (bz * ly)) * inv,
+          ((le * at) - (be * aw)) * inv, ((le * bx) - (be * lx)) * inv, ((le * by) - (be * ly)) * inv};
+}
+
+
+
+/// the conic a x^2 + b xy + c y^2 + d x + e y + f = 0 that is the massless condition e^2 = px^2 + py^2 + pz^2 on a linear form as above
+/// returns {a, b, c, d, e, f}
+inline std::array<double, 6> neutrino_conic(const std::array<double, 6> &form)
+{
+  const auto &[e0, ex, ey, z0, zx, zy] = form;
+  return {(ex * ex) - (zx * zx) - 1., 2. * ((ex * ey) - (zx * zy)), (ey * ey) - (zy * zy) - 1.,
+          2. * ((e0 * ex) - (z0 * zx)), 2. * ((e0 * ey) - (z0 * zy)), (e0 * e0) - (z0 * z0)};
+}
+
+
+
+/// the same conic in terms of (mx - x, my - y) i.e. the transverse momentum of the other neutrino
+inline std::array<double, 6> reflect_conic(const std::array<double, 6> &conic, double mx, double my)
+{
+  const auto &[a, b, c, d, e, f] = conic;
+  return {a, b, c, -(2. * a * mx) - (b * my) - d, -(b * mx) - (2. * c * my) - e,
+          (a * mx * mx) + (b * mx * my) + (c * my * my) + (d * mx) + (e * my) + f};
+}
+
+
+
+/// the quadratic P(x) and linear Q(x) coefficients {p2, p1, p0, q1, q0} of the elimination of y from two conics
+/// the common roots satisfy P(x)^2 = Q(x) R(x), and then y = -P(x) / Q(x)
+inline std::array<double, 5> conic_elimination(const std::array<double, 6> &c1, const std::array<double, 6> &c2)
+{
+  return {(c1[2] * c2[0]) - (c2[2] * c1[0]), (c1[2] * c2[3]) - (c2[2] * c1[3]), (c1[2] * c2[5]) - (c2[2] * c1[5]),
+          (c1[2] * c2[1]) - (c2[2] * c1[1]), (c1[2] * c2[4]) - (c2[2] * c1[4])};
+}
+
+
+
+/// the monic quartic in x {k0, k1, k2, k3} whose real roots are the x of the common points of two conics
+/// i.e. the resultant of the two conics, taken as quadratics in y
+inline std::array<double, 4> conic_resultant(const std::array<double, 6> &c1, const std::array<double, 6> &c2)
+{
+  const auto [p2, p1, p0, q1, q0] = conic_elimination(c1, c2);
+  const double r3 = (c1[1] * c2[0]) - (c2[1] * c1[0]);
+  const double r2 = (c1[1] * c2[3]) + (c1[4] * c2[0]) - (c2[1] * c1[3]) - (c2[4] * c1[0]);
+  const double r1 = (c1[1] * c2[5]) + (c1[4] * c2[3]) - (c2[1] * c1[5]) - (c2[4] * c1[3]);
+  const double r0 = (c1[4] * c2[5]) - (c2[4] * c1[5]);
+
+  const double inv = 1. / ((p2 * p2) - (q1 * r3));
+  return {((p0 * p0) - (q0 * r0)) * inv, ((2. * p1 * p0) - (q1 * r0) - (q0 * r1)) * inv,
+          ((p1 * p1) + (2. * p2 * p0) - (q1 * r1) - (q0 * r2)) * inv, ((2. * p2 * p1) - (q1 * r2) - (q0 * r3)) * inv};
+}
+
+
+
+/// all four complex roots of the n monic quartics x^4 + c3 x^3 + c2 x^2 + c1 x + c0
+/// by a fixed number of Durand-Kerner iterations, which being branchless vectorize across the quartics (given AVX)
+/// the roots are written as re[(4 * i) + k] and im[(4 * i) + k] for k = 0..3, in no particular order
+/// quartics with non-finite coefficients give non-finite roots
+template <int Iteration = 32>
+void batch_quartic_roots(int n, const double *c0, const double *c1, const double *c2, const double *c3,
+                         double *__restrict__ re, double *__restrict__ im)
+{
+  // the usual starting points (0.4 + 0.9i)^k, scaled up to the size of the roots
+  constexpr std::array<double, 4> seed_re = {1., 0.4, -0.65, -0.908};
+  constexpr std::array<double, 4> seed_im = {0., 0.9, 0.72, -0.297};
+
+  for (int iQ = 0; iQ < n; ++iQ) {
+    const double scale = 1. + std::max(std::max(std::abs(c0[iQ]), std::abs(c1[iQ])), std::max(std::abs(c2[iQ]), std::abs(c3[iQ])));
+    const double radius = std::sqrt(std::sqrt(scale));
+    for (int iR = 0; iR < 4; ++iR) {
+      re[(4 * iQ) + iR] = radius * seed_re[iR];
+      im[(4 * iQ) + iR] = radius * seed_im[iR];
+    }
+  }
+
+  // one correction of the estimate z, given the other three
+  // the quartic at z, by horner, divided by the product of the distances of z to the others
+  // imaginary parts heading to zero are set to zero, as otherwise they go through the (slow) subnormals first
+  auto correct = [] (double &zr, double &zi, double ar, double ai, double br, double bi, double cr, double ci,
+                     double k0, double k1, double k2, double k3) {
+    double pr = zr + k3, pi = zi;
+    double tr = (pr * zr) - (pi * zi) + k2, ti = (pr * zi) + (pi * zr);
+    pr = (tr * zr) - (ti * zi) + k1;
+    pi = (tr * zi) + (ti * zr);
+    tr = (pr * zr) - (pi * zi) + k0;
+    ti = (pr * zi) + (pi * zr);
+
+    const double er = zr - ar, ei = zi - ai, fr = zr - br, fi = zi - bi, gr = zr - cr, gi = zi - ci;
+    const double hr = (er * fr) - (ei * fi), hi = (er * fi) + (ei * fr);
+    const double dr = (hr * gr) - (hi * gi), di = (hr * gi) + (hi * gr);
+
+    const double inv = 1. / ((dr * dr) + (di * di));
+    zr -= ((tr * dr) + (ti * di)) * inv;
+    zi -= ((ti * dr) - (tr * di)) * inv;
+    zi = std::copysign(std::max(std::abs(zi) - 1e-60, 0.), zi);
+  };
+
+  for (int iI = 0; iI < Iteration; ++iI) {
+    for (int iQ = 0; iQ < n; ++iQ) {
+      double zr0 = re[4 * iQ], zr1 = re[(4 * iQ) + 1], zr2 = re[(4 * iQ) + 2], zr3 = re[(4 * iQ) + 3];
+      double zi0 = im[4 * iQ], zi1 = im[(4 * iQ) + 1], zi2 = im[(4 * iQ) + 2], zi3 = im[(4 * iQ) + 3];
+      correct(zr0, zi0, zr1, zi1, zr2, zi2, zr3, zi3, c0[iQ], c1[iQ], c2[iQ], c3[iQ]);
+      correct(zr1, zi1, zr0, zi0, zr2, zi2, zr3, zi3, c0[iQ], c1[iQ], c2[iQ], c3[iQ]);
+      correct(zr2, zi2, zr0, zi0, zr1, zi1, zr3, zi3, c0[iQ], c1[iQ], c2[iQ], c3[iQ]);
+      correct(zr3, zi3, zr0, zi0, zr1, zi1, zr2, zi2, c0[iQ], c1[iQ], c2[iQ], c3[iQ]);
+      re[4 * iQ] = zr0;
+      re[(4 * iQ) + 1] = zr1;
+      re[(4 * iQ) + 2] = zr2;
+      re[(4 * iQ) + 3] = zr3;
+      im[4 * iQ] = zi0;
+      im[(4 * iQ) + 1] = zi1;
+      im[(4 * iQ) + 2] = zi2;
+      im[(4 * iQ) + 3] = zi3;
+    }
+  }
+}
+
+
+
+template <typename Number = float>
+class TTbarDileptonSolver {
+public:
+  /// a solved pairing, with the element indices in the order {lepton, antilepton, bottom, antibottom}
+  /// the weight is the summed weight of the samples having a solution, divided by the number of samples
+  struct Solution {
+    std::array<int, 4> index;
+    Number weight;
+    FourVector<Number> top, antitop, neutrino, antineutrino, lepton, antilepton;
+  };
+
+  /// constructor
+  /// n_sample_ is the number of smeared samples per pairing; with 0 each pairing is solved once with the nominal inputs and masses
+  /// seed_ sets the smearing, which otherwise depends only on the inputs of each pairing i.e. not on the event order or threading
+  /// p4_ and charge_ are the names of the pt, eta, phi, mass and charge attributes of the leptons, the first four also of the jets
+  /// met_ are the names of the pt and phi attributes of the missing transverse momentum
+  TTbarDileptonSolver(int n_sample_ = 100, unsigned long long seed_ = 0ULL,
+                      const std::array<std::string, 4> &p4_ = {"pt", "eta", "phi", "mass"}, const std::string &charge_ = "charge",
+                      const std::array<std::string, 2> &met_ = {"pt", "phi"});
+
+  /// the masses and widths, in GeV, the widths setting the (truncated) breit-wigner the masses are sampled from
+  void set_masses(Number top_mass_, Number top_width_, Number w_mass_, Number w_width_);
+
+  /// the relative jet energy resolution by which the b jets are smeared, the missing transverse momentum following suit
+  void set_jet_resolution(Number resolution_);
+
+  /// the weight of each sample
+  /// signature: takes the invariant masses of the lepton-bottom and antilepton-antibottom systems in GeV, returns the weight
+  /// e.g. the product of their expected distributions; without a weighter all samples having a solution count equally
+  template <typename Weighter>
+  void set_weighter(Weighter weighter_);
+
+  /// solve all pairings of the selected elements i.e. those in their ref_to_indices()
+  /// with one negatively and one positively charged lepton, and two different jets
+  /// returns the index arrays {lepton, antilepton, bottom, antibottom} of the pairings having a solution, by decreasing weight
+  /// can be given as is to Aggregate::set_indexer for an aggregate of the groups (lepton, lepton, jet, jet)
+  template <typename Lepton, typename Jet, typename Met>
+  std::vector<std::array<int, 4>> operator()(const Lepton &lepton, const Jet &jet, const Met &met);
+
+  /// as above, but considering only the elements with the given indices e.g. the output of filter
+  template <typename Lepton, typename Jet, typename Met>
+  std::vector<std::array<int, 4>> solve(const Lepton &lepton, const std::vector<int> &idx_lepton, const Jet &jet, const std::vector<int> &idx_jet,
+                                        const Met &met);
+
+  /// the solutions of the last call, in the order they were returned
+  const std::vector<Solution>& solutions() const;
+
+  /// the solution of a given pairing, as found in the last call
+  /// the search starts after the solution found last, so that going over the pairings in the order they were returned
+  /// as the attributes of add_attributes do, finds each of them at once; not to be called concurrently with itself or solve()
+  const Solution& solution(const std::array<int, 4> &index) const;
+
+  /// add to the aggregate of the solved pairings the attributes expected by spin_correlation.h
+  /// i.e. the pt, eta, phi and mass of the top, antitop, lepton and antilepton, named as e.g. top_pt, antilepton_mass
+  /// plus the solution weight as solver_weight
+  template <typename Aggregate>
+  void add_attributes(Aggregate &aggregate) const;
+
+protected:
+  /// the layout of a problem i.e. a pairing and a sample: the (px, py, pz, e) of the four objects, the missing transverse momentum
+  /// and the squared top, antitop, W+ and W- masses, all in units of the top mass
+  enum Input : int {in_antilepton = 0, in_bottom = 4, in_lepton = 8, in_antibottom = 12, in_met = 16, in_mass = 18, n_input = 22};
+
+  /// neutrino_linear_form of a problem, given the columns of its lepton, b jet, W and top masses
+  template <typename Column>
+  static std::array<double, 6> linear_form(Column input, int lepton, int bottom, int w, int top);
+
+  /// the pt, eta, phi and mass attributes of a group
+  using Columns = std::array<const std::vector<Number> *, 4>;
+
+  template <typename Group>
+  Columns columns(const Group &group) const;
+
+  /// the (px, py, pz, e) of an element, in GeV
+  static std::array<double, 4> cartesian(const Columns &column, int index);
+
+  /// fill the problems of a pairing, smearing all but the nominal one
+  void sample(const std::array<std::array<double, 4>, 4> &object, double metx, double mety, std::uint64_t state);
+
+  /// choose among the roots of each problem and average over the samples of each pairing
+  void resolve(int n_pairing);
+
+  /// configuration
+  int n_sample;
+
+  unsigned long long seed;
+
+  std::array<std::string, 4> p4_name;
+
+  std::string charge_name;
+
+  std::array<std::string, 2> met_name;
+
+  double top_mass, top_width, w_mass, w_width, resolution;
+
+  std::function<double(double, double)> weighter;
+
+  /// the problems as columns, the monic quartic coefficients and their roots
+  std::array<std::vector<double>, n_input> v_input;
+
+  std::array<std::vector<double>, 4> v_coefficient;
+
+  std::vector<double> v_re, v_im;
+
+  /// the pairings being solved, and the solutions found
+  std::vector<std::array<int, 4>> v_pairing;
+
+  std::vector<std::array<std::array<double, 4>, 4>> v_object;
+
+  std::vector<Solution> v_solution;
+
+  /// where solution() starts its search
+  mutable std::size_t hint;
+
+  /// the lepton, jet and met groups last found to have all the attributes needed, so that they are checked again only when they change
+  std::array<const void *, 3> v_checked;
+};
+
+
+
+template <typename Number>
+TTbarDileptonSolver<Number>::TTbarDileptonSolver(int n_sample_, unsigned long long seed_,
+                                                 const std::array<std::string, 4> &p4_, const std::string &charge_,
+                                                 const std::array<std::string, 2> &met_) :
+n_sample(n_sample_),
+seed(seed_),
+p4_name(p4_),
+charge_name(charge_),
+met_name(met_),
+top_mass(Framework::constants::m_top<double>),
+top_width(1.42),
+w_mass(Framework::constants::m_w<double>),
+w_width(2.085),
+resolution(0.1),
+hint(0),
+v_checked({nullptr, nullptr, nullptr})
+{
+  if (n_sample < 0)
+    throw std::invalid_argument( "ERROR: TTbarDileptonSolver: the number of samples can not be negative!!" );
+}
+
+
+
+template <typename Number>
+void TTbarDileptonSolver<Number>::set_masses(Number top_mass_, Number top_width_, Number w_mass_, Number w_width_)
+{
+  if (!(top_mass_ > w_mass_ and w_mass_ > Number(0.)) or top_width_ < Number(0.) or w_width_ < Number(0.))
+    throw std::invalid_argument( "ERROR: TTbarDileptonSolver::set_masses: the masses must be positive with the top heavier than the W, "
+                                 "and the widths non-negative!!" );
+
+  top_mass = top_mass_;
+  top_width = top_width_;
+  w_mass = w_mass_;
+  w_width = w_width_;
+}
+
+
+
+template <typename Number>
+void TTbarDileptonSolver<Number>::set_jet_resolution(Number resolution_)
+{
+  if (resolution_ < Number(0.))
+    throw std::invalid_argument( "ERROR: TTbarDileptonSolver::set_jet_resolution: the resolution can not be negative!!" );
+
+  resolution = resolution_;
+}
+
+
+
+template <typename Number>
+template <typename Weighter>
+void TTbarDileptonSolver<Number>::set_weighter(Weighter weighter_)
+{
+  weighter = [weighter_] (double mlb, double mlbbar) { return static_cast<double>(weighter_(static_cast<Number>(mlb), static_cast<Number>(mlbbar))); };
+}
+
+
+
+template <typename Number>
+template <typename Lepton, typename Jet, typename Met>
+std::vector<std::array<int, 4>> TTbarDileptonSolver<Number>::operator()(const Lepton &lepton, const Jet &jet, const Met &met)
+{
+  return solve(lepton, lepton.ref_to_indices(), jet, jet.ref_to_indices(), met);
+}
+
+
+
+template <typename Number>
+template <typename Lepton, typename Jet, typename Met>
+std::vector<std::array<int, 4>> TTbarDileptonSolver<Number>::solve(const Lepton &lepton, const std::vector<int> &idx_lepton,
+                                                                   const Jet &jet, const std::vector<int> &idx_jet, const Met &met)
+{
+  auto check = [this] (int slot, const auto &group, const auto &...names) {
+    if (v_checked[slot] == static_cast<const void *>(&group))
+      return;
+
+    if (((group.inquire(names) == -1) or ...))
+      throw std::invalid_argument( "ERROR: TTbarDileptonSolver::solve: group " + group.name + " does not have all of the attributes " +
+                                   ((names + " ") + ...) + "!!" );
+    v_checked[slot] = &group;
+  };
+  check(0, lepton, p4_name[0], p4_name[1], p4_name[2], p4_name[3], charge_name);
+  check(1, jet, p4_name[0], p4_name[1], p4_name[2], p4_name[3]);
+  check(2, met, met_name[0], met_name[1]);
+
+  v_pairing.clear();
+  v_object.clear();
+  v_solution.clear();
+  hint = 0;
+  for (auto &column : v_input)
+    column.clear();
+
+  // the attributes are looked up once per call rather than once per pairing
+  const auto &charge = lepton.template get<int>(charge_name);
+  const auto column_lepton = columns(lepton), column_jet = columns(jet);
+  const double metx = met.template get<Number>(met_name[0])[0] * std::cos(met.template get<Number>(met_name[1])[0]);
+  const double mety = met.template get<Number>(met_name[0])[0] * std::sin(met.template get<Number>(met_name[1])[0]);
+
+  for (auto il : idx_lepton) {
+    for (auto ia : idx_lepton) {
+      if (charge[il] >= 0 or charge[ia] <= 0)
+        continue;
+
+      for (auto ib : idx_jet) {
+        for (auto iB : idx_jet) {
+          if (ib == iB)
+            continue;
+
+          v_pairing.push_back({il, ia, ib, iB});
+          v_object.push_back({cartesian(column_lepton, ia), cartesian(column_jet, ib), cartesian(column_lepton, il), cartesian(column_jet, iB)});
+
+          // the smearing of each pairing is seeded from its inputs, so that it does not depend on what else is in the event
+          std::uint64_t state = seed;
+          for (const auto &object : v_object.back()) {
+            std::uint64_t bits;
+            std::memcpy(&bits, &object[3], sizeof(bits));
+            state = (state ^ bits) * 0x9e3779b97f4a7c15ULL;
+          }
+          sample(v_object.back(), metx, mety, state);
+        }
+      }
+    }
+  }
+
+  const int n = v_input[0].size();
+  for (auto &coefficient : v_coefficient)
+    coefficient.resize(n);
+
+  // the quartics, one per problem
+  {
+    const double *column[n_input];
+    for (int iI = 0; iI < n_input; ++iI)
+      column[iI] = v_input[iI].data();
+
+    double *__restrict__ k0 = v_coefficient[0].data();
+    double *__restrict__ k1 = v_coefficient[1].data();
+    double *__restrict__ k2 = v_coefficient[2].data();
+    double *__restrict__ k3 = v_coefficient[3].data();
+    for (int iP = 0; iP < n; ++iP) {
+      auto input = [&column, iP] (int index) { return column[index][iP]; };
+      const auto c1 = neutrino_conic(linear_form(input, in_antilepton, in_bottom, in_mass + 2, in_mass));
+      const auto c2 = reflect_conic(neutrino_conic(linear_form(input, in_lepton, in_antibottom, in_mass + 3, in_mass + 1)), input(in_met), input(in_met + 1));
+      const auto k = conic_resultant(c1, c2);
+      k0[iP] = k[0];
+      k1[iP] = k[1];
+      k2[iP] = k[2];
+      k3[iP] = k[3];
+    }
+  }
+
+  v_re.resize(4 * n);
+  v_im.resize(4 * n);
+  batch_quartic_roots(n, v_coefficient[0].data(), v_coefficient[1].data(), v_coefficient[2].data(), v_coefficient[3].data(), v_re.data(), v_im.data());
+
+  resolve(v_pairing.size());
+
+  std::stable_sort(std::begin(v_solution), std::end(v_solution), [] (const Solution &s1, const Solution &s2) { return s1.weight > s2.weight; });
+  std::vector<std::array<int, 4>> indices;
+  indices.reserve(v_solution.size());
+  for (const auto &solution : v_solution)
+    indices.emplace_back(solution.index);
+
+  return indices;
+}
+
+
+
+template <typename Number>
+const std::vector<typename TTbarDileptonSolver<Number>::Solution>& TTbarDileptonSolver<Number>::solutions() const
+{
+  return v_solution;
+}
+
+
+
+template <typename Number>
+const typename TTbarDileptonSolver<Number>::Solution& TTbarDileptonSolver<Number>::solution(const std::array<int, 4> &index) const
+{
+  const std::size_t n = v_solution.size();
+  for (std::size_t iS = 0; iS < n; ++iS) {
+    const std::size_t position = (hint + iS) % n;
+    if (v_solution[position].index == index) {
+      hint = position + 1;
+      return v_solution[position];
+    }
+  }
+
+  throw std::invalid_argument( "ERROR: TTbarDileptonSolver::solution: the requested pairing has no solution in the current event!!" );
+}
+
+
+
+template <typename Number>
+template <typename Aggregate>
+void TTbarDileptonSolver<Number>::add_attributes(Aggregate &aggregate) const
+{
+  using Member = FourVector<Number> Solution::*;
+  const std::array<std::pair<std::string, Member>, 4> objects = {{{"top", &Solution::top}, {"antitop", &Solution::antitop},
+                                                                  {"lepton", &Solution::lepton}, {"antilepton", &Solution::antilepton}}};
+
+  for (const auto &[name, member] : objects) {
+    aggregate.add_indexed_attribute(name + "_pt", [this, member = member] (const std::array<int, 4> &idx) -> Number { return (solution(idx).*member).Pt(); });
+    aggregate.add_indexed_attribute(name + "_eta", [this, member = member] (const std::array<int, 4> &idx) -> Number { return (solution(idx).*member).Eta(); });
+    aggregate.add_indexed_attribute(name + "_phi", [this, member = member] (const std::array<int, 4> &idx) -> Number { return (solution(idx).*member).Phi(); });
+    aggregate.add_indexed_attribute(name + "_mass", [this, member = member] (const std::array<int, 4> &idx) -> Number { return (solution(idx).*member).M(); });
+  }
+
+  aggregate.add_indexed_attribute("solver_weight", [this] (const std::array<int, 4> &idx) -> Number { return solution(idx).weight; });
+}
+
+
+
+template <typename Number>
+template <typename Column>
+std::array<double, 6> TTbarDileptonSolver<Number>::linear_form(Column input, int lepton, int bottom, int w, int top)
+{
+  return neutrino_linear_form(input(lepton), input(lepton + 1), input(lepton + 2), input(lepton + 3),
+                              input(bottom), input(bottom + 1), input(bottom + 2), input(bottom + 3), input(w), input(top));
+}
+
+
+
+template <typename Number>
+template <typename Group>
+typename TTbarDileptonSolver<Number>::Columns TTbarDileptonSolver<Number>::columns(const Group &group) const
+{
+  return {&group.template get<Number>(p4_name[0]), &group.template get<Number>(p4_name[1]),
+          &group.template get<Number>(p4_name[2]), &group.template get<Number>(p4_name[3])};
+}
+
+
+
+template <typename Number>
+std::array<double, 4> TTbarDileptonSolver<Number>::cartesian(const Columns &column, int index)
+{
+  const double pt = (*column[0])[index], eta = (*column[1])[index], phi = (*column[2])[index], mass = (*column[3])[index];
+  const double px = pt * std::cos(phi), py = pt * std::sin(phi), pz = pt * std::sinh(eta);
+
+  return {px, py, pz, std::sqrt((px * px) + (py * py) + (pz * pz) + (mass * mass))};
+}
+
+
+
+template <typename Number>
+void TTbarDileptonSolver<Number>::sample(const std::array<std::array<double, 4>, 4> &object, double metx, double mety, std::uint64_t state)
+{
+  // splitmix64, and the uniform and normal deviates made from it
+  auto uniform = [&state] () {
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return static_cast<double>((z ^ (z >> 31)) >> 11) * 0x1.0p-53;
+  };
+  auto normal = [&uniform] () {
+    return std::sqrt(-2. * std::log(1. - uniform())) * std::cos(2. * Framework::constants::pi<double> * uniform());
+  };
+
+  // breit-wigner, truncated at 5 widths from the pole
+  const double bw_range = std::atan(10.);
+  auto breit_wigner = [&uniform, bw_range] (double pole, double width) {
+    return pole + (0.5 * width * std::tan(bw_range * ((2. * uniform()) - 1.)));
+  };
+
+  const double inv_scale = 1. / top_mass;
+  const int n = std::max(n_sample, 1);
+  for (int iS = 0; iS < n; ++iS) {
+    std::array<double, 2> factor = {1., 1.};
+    std::array<double, 4> masses = {top_mass, top_mass, w_mass, w_mass};
+    if (n_sample) {
+      factor = {std::max(1. + (resolution * normal()), 0.1), std::max(1. + (resolution * normal()), 0.1)};
+      masses = {breit_wigner(top_mass, top_width), breit_wigner(top_mass, top_width), breit_wigner(w_mass, w_width), breit_wigner(w_mass, w_width)};
+    }
+
+    for (int iC = 0; iC < 4; ++iC) {
+      v_input[in_antilepton + iC].emplace_back(object[0][iC] * inv_scale);
+      v_input[in_bottom + iC].emplace_back(object[1][iC] * factor[0] * inv_scale);
+      v_input[in_lepton + iC].emplace_back(object[2][iC] * inv_scale);
+      v_input[in_antibottom + iC].emplace_back(object[3][iC] * factor[1] * inv_scale);
+      v_input[in_mass + iC].emplace_back(masses[iC] * masses[iC] * inv_scale * inv_scale);
+    }
+
+    // the jet energy change is absorbed into the missing transverse momentum
+    v_input[in_met].emplace_back((metx - ((factor[0] - 1.) * object[1][0]) - ((factor[1] - 1.) * object[3][0])) * inv_scale);
+    v_input[in_met + 1].emplace_back((mety - ((factor[0] - 1.) * object[1][1]) - ((factor[1] - 1.) * object[3][1])) * inv_scale);
+  }
+}
+
+
+
+template <typename Number>
+void TTbarDileptonSolver<Number>::resolve(int n_pairing)
+{
+  const int n_per = std::max(n_sample, 1);
+
+  for (int iR = 0; iR < n_pairing; ++iR) {
+    double sum_weight = 0.;
+    std::array<double, 6> sum_p = {0., 0., 0., 0., 0., 0.};
+
+    for (int iP = iR * n_per; iP < (iR + 1) * n_per; ++iP) {
+      auto input = [this, iP] (int column) { return v_input[column][iP]; };
+      auto p4 = [&input] (int object) { return std::array<double, 4>{input(object), input(object + 1), input(object + 2), input(object + 3)}; };
+
+      const auto f1 = linear_form(input, in_antilepton, in_bottom, in_mass + 2, in_mass);
+      const auto f2 = linear_form(input, in_lepton, in_antibottom, in_mass + 3, in_mass + 1);
+      const auto c1 = neutrino_conic(f1);
+      const auto c2 = reflect_conic(neutrino_conic(f2), input(in_met), input(in_met + 1));
+      const auto [p2, p1, p0, q1, q0] = conic_elimination(c1, c2);
+
+      const std::array<double, 4> k = {v_coefficient[0][iP], v_coefficient[1][iP], v_coefficient[2][iP], v_coefficient[3][iP]};
+      const auto alep = p4(in_antilepton), bot = p4(in_bottom), lep = p4(in_lepton), abot = p4(in_antibottom);
+      double best_mass = -1.;
+      std::array<double, 6> best_p = {};
+      for (int iQ = 0; iQ < 4; ++iQ) {
+        double x = v_re[(4 * iP) + iQ];
+        const double imag = v_im[(4 * iP) + iQ];
+        if (!std::isfinite(x) or std::abs(imag) > 1e-3 * (1. + std::abs(x)))
+          continue;
+
+        // polish the nearly real roots on the real axis
+        for (int iN = 0; iN < 2; ++iN) {
+          const double f = (((((x + k[3]) * x) + k[2]) * x) + k[1]) * x + k[0];
+          const double df = ((((4. * x) + (3. * k[3])) * x) + (2. * k[2])) * x + k[1];
+          if (df != 0.)
+            x -= f / df;
+        }
+
+        const double y = -((((p2 * x) + p1) * x) + p0) / ((q1 * x) + q0);
+        const double e1 = f1[0] + (f1[1] * x) + (f1[2] * y), z1 = f1[3] + (f1[4] * x) + (f1[5] * y);
+        const double x2 = input(in_met) - x, y2 = input(in_met + 1) - y;
+        const double e2 = f2[0] + (f2[1] * x2) + (f2[2] * y2), z2 = f2[3] + (f2[4] * x2) + (f2[5] * y2);
+        if (!std::isfinite(y) or !(e1 > 0.) or !(e2 > 0.))
+          continue;
+
+        // the neutrinos must be massless to a good approximation, which rejects the spurious roots
+        const double m1 = (e1 * e1) - (x * x) - (y * y) - (z1 * z1), m2 = (e2 * e2) - (x2 * x2) - (y2 * y2) - (z2 * z2);
+        if (std::abs(m1) > 1e-4 * e1 * e1 or std::abs(m2) > 1e-4 * e2 * e2)
+          continue;
+
+        const double se = alep[3] + bot[3] + lep[3] + abot[3] + e1 + e2;
+        const double sx = alep[0] + bot[0] + lep[0] + abot[0] + input(in_met);
+        const double sy = alep[1] + bot[1] + lep[1] + abot[1] + input(in_met + 1);
+        const double sz = alep[2] + bot[2] + lep[2] + abot[2] + z1 + z2;
+        const double mtt = (se * se) - (sx * sx) - (sy * sy) - (sz * sz);
+        if (best_mass < 0. or mtt < best_mass) {
+          best_mass = mtt;
+          best_p = {x, y, z1, x2, y2, z2};
+        }
+      }
+
+      if (best_mass < 0.)
+        continue;
+
+      double weight = 1.;
+      if (weighter) {
+        auto mlb = [this] (const std::array<double, 4> &l, const std::array<double, 4> &b) {
+          const double e = l[3] + b[3], x = l[0] + b[0], y = l[1] + b[1], z = l[2] + b[2];
+          return top_mass * std::sqrt(std::max((e * e) - (x * x) - (y * y) - (z * z), 0.));
+        };
+        weight = weighter(mlb(alep, bot), mlb(lep, abot));
+      }
+
+      sum_weight += weight;
+      for (int iC = 0; iC < 6; ++iC)
+        sum_p[iC] += weight * best_p[iC];
+    }
+
+    if (!(sum_weight > 0.))
+      continue;
+
+    // the averaged neutrinos are combined with the nominal leptons and jets
+    const double scale = top_mass / sum_weight;
+    const auto &object = v_object[iR];
+    auto vector = [] (const std::array<double, 4> &p) { return FourVector<Number>(p[0], p[1], p[2], p[3]); };
+    auto neutrino = [scale, &sum_p] (int offset) {
+      const double px = sum_p[offset] * scale, py = sum_p[offset + 1] * scale, pz = sum_p[offset + 2] * scale;
+      return FourVector<Number>(px, py, pz, std::sqrt((px * px) + (py * py) + (pz * pz)));
+    };
+
+    Solution solution;
+    solution.index = v_pairing[iR];
+    solution.weight = sum_weight / n_per;
+    solution.neutrino = neutrino(0);
+    solution.antineutrino = neutrino(3);
+    solution.antilepton = vector(object[0]);
+    solution.lepton = vector(object[2]);
+    solution.top = solution.antilepton + vector(object[1]) + solution.neutrino;
+    solution.antitop = solution.lepton + vector(object[3]) + solution.antineutrino;
+    v_solution.emplace_back(solution);
+  }
+}
+
+#endif
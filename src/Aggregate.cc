@@ -6,7 +6,8 @@ template <int N, typename... Ts>
 template <typename ...Groups>
 Framework::Aggregate<N, Ts...>::Aggregate(const std::string &name_, int reserve_, int init, Groups &...groups) : 
 Framework::Group<Ts...>::Group(name_, 1),
-v_group{ std::ref<Group<Ts...>>(groups)... }
+v_group{ std::ref<Group<Ts...>>(groups)... },
+lazy(false)
 {
   static_assert(N > 1, "ERROR: Aggregate must be made out of two or more (not necessarily unique) Groups!!");
   static_assert(sizeof...(groups) == N, "ERROR: non-matching template argument count and number of Groups in Aggregate ctor!!");
@@ -20,6 +21,25 @@ v_group{ std::ref<Group<Ts...>>(groups)... }
     this->initialize(init);
   else
     this->initialize(1);
+
+  v_indices.reserve(this->v_index.capacity());
+  for (auto &gather : v_gather)
+    gather.reserve(this->v_index.capacity());
+
+  v_generation.fill(0ULL);
+  for (auto &group : v_group)
+    group.get().v_dependent.emplace_back(this);
+}
+
+
+
+template <int N, typename... Ts>
+Framework::Aggregate<N, Ts...>::~Aggregate()
+{
+  for (auto &group : v_group) {
+    auto &v_dependent = group.get().v_dependent;
+    v_dependent.erase(std::remove(std::begin(v_dependent), std::end(v_dependent), this), std::end(v_dependent));
+  }
 }
 
 
@@ -29,11 +49,18 @@ template <typename Indexer>
 void Framework::Aggregate<N, Ts...>::set_indexer(Indexer indexer_)
 {
   if (!indexer) {
-    auto get_indexer = [indexer_] (const auto &...grps) { return indexer_(grps.get()...); };
+    auto f_index = [this, indexer_] () mutable -> void {
+      auto get_indexer = [this, &indexer_] (const auto &...grps) -> void {
+        // the indexer either fills the buffer it is given, which is then reused across events, or returns a fresh one
+        if constexpr (std::is_invocable_v<Indexer &, std::vector<std::array<int, N>> &, decltype(grps.get())...>) {
+          v_indices.clear();
+          indexer_(v_indices, grps.get()...);
+        }
+        else
+          v_indices = indexer_(grps.get()...);
+      };
 
-    auto f_index = [this, get_indexer] () -> void {
-      v_indices.clear();
-      v_indices = std::apply(get_indexer, v_group);
+      std::apply(get_indexer, v_group);
     };
 
     indexer = std::function<void()>(f_index);
@@ -51,6 +78,16 @@ void Framework::Aggregate<N, Ts...>::reserve(int attr)
 
 
 
+template <int N, typename ...Ts>
+void Framework::Aggregate<N, Ts...>::set_lazy(bool lazy_)
+{
+  lazy = lazy_;
+  if (!lazy)
+    this->v_pending.clear();
+}
+
+
+
 template <int N, typename ...Ts>
 template <typename Function, typename ...Attributes>
 bool Framework::Aggregate<N, Ts...>::add_attribute(const std::string &attr, Function function, Attributes &&...attrs)
@@ -71,10 +108,6 @@ bool Framework::Aggregate<N, Ts...>::add_attribute(const std::string &attr, Func
   if (!has_all_attribute)
     return false;
 
-  auto f_calculate = [function] (auto &val, const auto &...vals) -> void {
-    val = function(vals...);
-  };
-
   auto f_bump_duplicate = [this] (Attributes &&...attrs) -> std::array<std::array<int, 2>, sizeof...(attrs)> {
     std::array<std::array<int, 2>, sizeof...(attrs)> grp_inq = { inquire_group(attrs)... };
 
@@ -106,25 +139,45 @@ bool Framework::Aggregate<N, Ts...>::add_attribute(const std::string &attr, Func
   const std::array<std::array<int, 2>, sizeof...(attrs)> grp_inq = f_bump_duplicate(attrs...);
 
   // grps and grp_inq must be captured by value, since they die outside add_attribute scope
-  auto f_apply = [f_calculate, this, iattr = this->v_data.size(), grps, grp_inq] (Attributes &&...attrs) -> void {
-    static std::array<int, sizeof...(attrs)> attr_idx;
-    for (int iE = 0; iE < this->counter; ++iE) {
-      attr_idx.fill(-1);
-      auto single_idx = v_indices[iE];
+  // argument k is read off grps[k] at the element indices in the slot grp_inq[k][0], as transposed into v_gather by populate
+  auto f_apply = [function, this, iattr = this->v_data.size(), grps, grp_inq] () -> void {
+    std::array<const int *, sizeof...(attrs)> gather;
+    for (int iI = 0; iI < grp_inq.size(); ++iI) {
+      v_group[ grp_inq[iI][0] ].get().fetch(grp_inq[iI][1]);
+      gather[iI] = v_gather[ grp_inq[iI][0] ].data();
+    }
 
-      for (int iI = 0; iI < grp_inq.size(); ++iI)
-        attr_idx[iI] = single_idx[ grp_inq[iI][0] ];
+    gather_apply(function, std::get<std::vector<typename Traits::result_type>>(this->v_data[iattr]), this->counter, grps, gather,
+                 std::make_index_sequence<sizeof...(attrs)>{});
+  };
 
-      auto args = zip_nn(grps, attr_idx);
-      auto refs = std::tuple_cat(std::make_tuple(std::ref( std::get<std::vector<typename Traits::result_type>>(this->v_data[iattr])[iE] )), 
-                                 args );
+  this->v_attr.emplace_back(std::make_pair(attr, std::function<void()>(f_apply)));
+  this->v_data.emplace_back(std::vector<typename Traits::result_type>());
+  v_flag.emplace_back(1);
 
-      std::apply(f_calculate, refs);
-    }
-  };
+  std::visit([init = this->v_index.capacity()] (auto &vec) {vec.reserve(init); vec.clear();}, this->v_data.back());
+  return true;
+}
+
+
+
+template <int N, typename ...Ts>
+template <typename Function>
+bool Framework::Aggregate<N, Ts...>::add_indexed_attribute(const std::string &attr, Function function)
+{
+  using Traits = function_traits<decltype(function)>;
+  static_assert(contained_in<typename Traits::result_type, Ts...>, 
+                "ERROR: Aggregate::add_indexed_attribute: the function return type is not among the types expected by the Aggregate!!");
+  static_assert(Traits::arity == 1 and std::is_same_v<std::decay_t<std::tuple_element_t<0, typename Traits::tuple_arg_types>>, std::array<int, N>>, 
+                "ERROR: Aggregate::add_indexed_attribute: the function must take a single std::array<int, N> of indices!!");
+
+  if (this->has_attribute(attr))
+    return false;
 
-  auto f_add = [f_apply, attrs...] () -> void {
-    f_apply(attrs...);
+  auto f_add = [function, this, iattr = this->v_data.size()] () -> void {
+    auto &vec = std::get<std::vector<typename Traits::result_type>>(this->v_data[iattr]);
+    for (int iE = 0; iE < this->counter; ++iE)
+      vec[iE] = function(v_indices[iE]);
   };
 
   this->v_attr.emplace_back(std::make_pair(attr, std::function<void()>(f_add)));
@@ -155,18 +208,38 @@ bool Framework::Aggregate<N, Ts...>::transform_attribute(const std::string &attr
 template <int N, typename ...Ts>
 void Framework::Aggregate<N, Ts...>::populate(long long)
 {
+  FWK_PROFILE_SCOPE(aggregate_populate, this->name.c_str());
+  ++this->n_populate;
+
   indexer();
   this->counter = v_indices.size();
   this->selected = this->counter;
+  this->peak = std::max(this->peak, this->counter);
 
   if (this->counter > this->v_index.capacity())
     this->initialize(this->counter);
 
+  // the indices are transposed once per event, rather than once per attribute and element
+  for (int iG = 0; iG < N; ++iG) {
+    v_gather[iG].resize(this->counter);
+    for (int iD = 0; iD < this->counter; ++iD)
+      v_gather[iG][iD] = v_indices[iD][iG];
+
+    v_generation[iG] = v_group[iG].get().generation();
+  }
+
   this->v_index.clear();
   for (int iD = 0; iD < this->counter; ++iD)
     this->v_index.emplace_back(iD);
 
+  // the internals fetch the externals they depend on when their turn comes, see Group::fetch()
+  if (lazy) {
+    this->v_pending.assign(this->v_data.size(), 1);
+    return;
+  }
+
   // first run the external attributes
+  FWK_PROFILE_SCOPE(transform, this->name.c_str());
   for (int iD = 0; iD < this->v_data.size(); ++iD) {
     if (v_flag[iD] == 1)
       this->v_attr[iD].second();
@@ -181,6 +254,56 @@ void Framework::Aggregate<N, Ts...>::populate(long long)
 
 
 
+template <int N, typename ...Ts>
+void Framework::Aggregate<N, Ts...>::settle() const
+{
+  // a group populated anew since holds the elements of another event, which the pending attributes can no longer be evaluated from
+  // they are left pending, so that reading them throws rather than returning the values of an earlier event
+  if (stale())
+    return;
+
+  Group<Ts...>::settle();
+}
+
+
+
+template <int N, typename ...Ts>
+bool Framework::Aggregate<N, Ts...>::stale() const
+{
+  for (int iG = 0; iG < N; ++iG) {
+    if (v_group[iG].get().generation() != v_generation[iG])
+      return true;
+  }
+
+  return false;
+}
+
+
+
+template <int N, typename ...Ts>
+template <typename Function, typename Result, typename Columns, std::size_t ...Is>
+void Framework::Aggregate<N, Ts...>::gather_apply(const Function &function, std::vector<Result> &out, int n, const Columns &columns,
+                                                  const std::array<const int *, sizeof...(Is)> &gather, std::index_sequence<Is...>)
+{
+  for (int iE = 0; iE < n; ++iE)
+    out[iE] = function( std::get<Is>(columns)[ gather[Is][iE] ]... );
+}
+
+
+
+template <int N, typename ...Ts>
+Framework::MemoryUsage Framework::Aggregate<N, Ts...>::memory_usage() const
+{
+  auto usage = Group<Ts...>::memory_usage();
+  usage.overhead += v_indices.capacity() * sizeof(std::array<int, N>);
+  for (const auto &gather : v_gather)
+    usage.overhead += gather.capacity() * sizeof(int);
+
+  return usage;
+}
+
+
+
 template <int N, typename ...Ts>
 std::array<int, 2> Framework::Aggregate<N, Ts...>::inquire_group(const std::string &name)
 {
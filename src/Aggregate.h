@@ -28,16 +28,28 @@ namespace Framework {
     template <typename ...Groups>
     Aggregate(const std::string &name_, int reserve_, int init, Groups &...groups);
 
+    /// destructor - deregisters the aggregate from its underlying groups
+    ~Aggregate();
+
     /// provide the indexing function
     /// ie how to go from indices in each group to an index in the aggregate
     /// which common to the entire aggregate
     /// signature: args are the refs to the N groups, and returns one std::vector<std::array<int, N>> output
+    /// alternatively, args are a std::vector<std::array<int, N>> & to be filled followed by the refs to the N groups, and returns void
+    /// the latter fills the aggregate's own (cleared) buffer, saving an allocation per event; see plugins/misc/combinatorics.h
     template <typename Indexer>
     void set_indexer(Indexer indexer_);
 
     /// reserve the space for expected number of attributes
     void reserve(int attr);
 
+    /// whether the attributes are evaluated lazily, false by default
+    /// lazy attributes are left pending by populate, and evaluated the first time they are accessed after it
+    /// so that e.g. events rejected based on n_elements() alone do not pay for attributes they never use
+    /// reordering an underlying group evaluates whatever is still pending beforehand, as it would read the wrong elements after
+    /// populating an underlying group anew leaves nothing to evaluate them from, so accessing them then throws until the aggregate is populated again
+    void set_lazy(bool lazy_ = true);
+
     /// add an attribute into the collection
     /// returns false upon failure to add the attribute
     /// this can happen if some data types are inconsistent
@@ -47,6 +59,13 @@ namespace Framework {
     template <typename Function, typename ...Attributes>
     bool add_attribute(const std::string &attr, Function function, Attributes &&...attrs);
 
+    /// add an attribute computed directly from the indices of the underlying groups
+    /// signature: the function takes the std::array<int, N> of element indices, in the same order as the groups given to the constructor
+    /// useful when the calculation is better done by something that knows the elements rather than their attribute values
+    /// e.g. a KinematicsCache shared between attributes, see plugins/misc/kinematics_cache.h
+    template <typename Function>
+    bool add_indexed_attribute(const std::string &attr, Function function);
+
     /// transform a group of internal attributes into another attribute
     /// the transformation is done element-wise on every element of held data
     /// as this adds a new attribute, its name has to be unique
@@ -56,7 +75,16 @@ namespace Framework {
     /// populate the data by calling the functions provided
     void populate(long long) override;
 
+    /// as in Group, with the indices of the underlying elements counted as overhead
+    MemoryUsage memory_usage() const override;
+
   protected:
+    /// evaluate the pending attributes if the underlying groups are still as they were populated from, see set_lazy()
+    void settle() const override;
+
+    /// whether any underlying group has been populated or reordered since the aggregate was populated
+    bool stale() const override;
+
     /// inquire attribute of the underlying groups
     /// similar to the above, but now an array: 
     /// first collection index in v_group, second the attribute index within it
@@ -67,12 +95,25 @@ namespace Framework {
     /// necessarily implemented without safety...
     const std::variant<std::vector<Ts>...>& underlying_attribute(const std::string &name);
 
+    /// evaluate an external attribute over all elements
+    /// argument Is of the function is taken from the column Is, at the element index gather[Is][element]
+    template <typename Function, typename Result, typename Columns, std::size_t ...Is>
+    static void gather_apply(const Function &function, std::vector<Result> &out, int n, const Columns &columns,
+                             const std::array<const int *, sizeof...(Is)> &gather, std::index_sequence<Is...>);
+
     /// indexing function - how to go from indices in each group to an index in the aggregate
     std::function<void()> indexer;
 
     /// and the indices that are made by the above
     std::vector<std::array<int, N>> v_indices;
 
+    /// the same indices transposed i.e. v_gather[group][element], from which the external attributes read their arguments
+    /// both are kept across events, so that populating allocates nothing once they have grown large enough
+    std::array<std::vector<int>, N> v_gather;
+
+    /// generations of the underlying groups as of the last populate
+    std::array<unsigned long long, N> v_generation;
+
     /// just a flag for each attribute whether it is external or internal
     /// external 1 are attributes that are transformed from groups' underlying attributes
     /// internal 0 are attributes transformed from this aggregate's external attributes
@@ -80,6 +121,9 @@ namespace Framework {
 
     /// references to the groups
     std::array<std::reference_wrapper<Group<Ts...>>, N> v_group;
+
+    /// see set_lazy()
+    bool lazy;
   };
 
   /// deduction guides for convenience
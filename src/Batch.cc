@@ -0,0 +1,410 @@
+// -*- C++ -*-
+// author: afiq anuar
+// short: please refer to header for information
+
+template <typename ...Ts>
+Framework::Batch<Ts...>::Batch(Group<Ts...> &group_, const std::vector<std::string> &v_attr_, int events, int elements) :
+name(group_.name),
+group(group_)
+{
+  const auto v_name = (v_attr_.empty()) ? group.attributes() : v_attr_;
+  const auto &data = group.data();
+
+  v_attr.reserve(v_name.size());
+  v_source.reserve(v_name.size());
+  v_data.reserve(v_name.size());
+  v_pending.reserve(v_name.size());
+  for (const auto &attr : v_name) {
+    const int iA = group.inquire(attr);
+    if (iA == -1)
+      throw std::invalid_argument( "ERROR: Batch: requested attribute " + attr + " is not within the group " + name + "!!" );
+
+    v_attr.emplace_back(attr, nullptr);
+    v_source.emplace_back(iA);
+    v_pending.emplace_back(0);
+
+    // an empty vector of the same type as the attribute in the group
+    v_data.emplace_back(std::visit([] (const auto &vec) -> std::variant<std::vector<Ts>...> {
+          return std::decay_t<decltype(vec)>();
+        }, data[iA]));
+    std::visit([n = events * elements] (auto &vec) {vec.reserve(n);}, v_data.back());
+  }
+
+  v_offset.reserve(events + 1);
+  v_offset.emplace_back(0);
+}
+
+
+
+template <typename ...Ts>
+void Framework::Batch<Ts...>::append(long long entry)
+{
+  group.populate(entry);
+
+  const auto &v_index = group.ref_to_indices();
+  const auto &data = group.data();
+  for (int iA = 0; iA < v_data.size(); ++iA) {
+    if (v_source[iA] == -1) {
+      v_pending[iA] = 1;
+      continue;
+    }
+
+    std::visit([&v_index, &data, iS = v_source[iA]] (auto &vec) {
+        const auto &source = std::get<std::decay_t<decltype(vec)>>(data[iS]);
+        for (auto index : v_index)
+          vec.emplace_back(source[index]);
+      }, v_data[iA]);
+  }
+
+  v_offset.emplace_back(v_offset.back() + v_index.size());
+}
+
+
+
+template <typename ...Ts>
+void Framework::Batch<Ts...>::seal()
+{
+  for (int iA = 0; iA < v_pending.size(); ++iA)
+    fetch(iA);
+}
+
+
+
+template <typename ...Ts>
+void Framework::Batch<Ts...>::clear()
+{
+  for (auto &dat : v_data)
+    std::visit([] (auto &vec) {vec.clear();}, dat);
+
+  for (int iA = 0; iA < v_pending.size(); ++iA)
+    v_pending[iA] = (v_source[iA] == -1);
+
+  v_offset.resize(1);
+}
+
+
+
+template <typename ...Ts>
+int Framework::Batch<Ts...>::n_events() const
+{
+  return v_offset.size() - 1;
+}
+
+
+
+template <typename ...Ts>
+int Framework::Batch<Ts...>::n_elements() const
+{
+  return v_offset.back();
+}
+
+
+
+template <typename ...Ts>
+const std::vector<int>& Framework::Batch<Ts...>::offsets() const
+{
+  return v_offset;
+}
+
+
+
+template <typename ...Ts>
+std::vector<int> Framework::Batch<Ts...>::counts() const
+{
+  std::vector<int> v_count(n_events());
+  for (int iV = 0; iV < v_count.size(); ++iV)
+    v_count[iV] = v_offset[iV + 1] - v_offset[iV];
+
+  return v_count;
+}
+
+
+
+template <typename ...Ts>
+int Framework::Batch<Ts...>::n_attributes() const
+{
+  return v_attr.size();
+}
+
+
+
+template <typename ...Ts>
+bool Framework::Batch<Ts...>::has_attribute(const std::string &name) const
+{
+  return inquire(name) != -1;
+}
+
+
+
+template <typename ...Ts>
+std::vector<std::string> Framework::Batch<Ts...>::attributes() const
+{
+  std::vector<std::string> v_attr_name;
+  for (const auto &attr : v_attr)
+    v_attr_name.emplace_back(attr.first);
+  return v_attr_name;
+}
+
+
+
+template <typename ...Ts>
+const std::variant<std::vector<Ts>...>& Framework::Batch<Ts...>::operator()(const std::string &name) const
+{
+  auto iA = inquire(name);
+  if (iA == -1)
+    throw std::invalid_argument( "ERROR: Batch::get: requested attribute " + name + " is not within the batch!!" );
+
+  fetch(iA);
+  return v_data[iA];
+}
+
+
+
+template <typename ...Ts>
+template <typename T>
+const std::vector<T>& Framework::Batch<Ts...>::get(const std::string &name) const
+{
+  static_assert(contained_in<T, Ts...>, "ERROR: Batch::get: called with a type not among the types of by the Batch!!");
+  return std::get<std::vector<T>>((*this)(name));
+}
+
+
+
+template <typename ...Ts>
+template <typename Function, typename ...Attributes>
+bool Framework::Batch<Ts...>::transform_attribute(const std::string &attr, Function function, Attributes &&...attrs)
+{
+  static_assert(sizeof...(attrs) > 0, "ERROR: Batch::transform_attribute requires some attributes to be provided!!");
+
+  using Traits = function_traits<decltype(function)>;
+  static_assert(contained_in<typename Traits::result_type, Ts...>,
+                "ERROR: Batch::transform_attribute: the function return type is not among the types expected by the Batch!!");
+  static_assert(Traits::arity == sizeof...(attrs),
+                "ERROR: Batch::transform_attribute: the function must take as many arguments as there are attributes!!");
+
+  if (has_attribute(attr))
+    return false;
+
+  auto iA = (has_attribute(attrs) and ...);
+  if (!iA)
+    throw std::invalid_argument( "ERROR: Batch::transform_attribute: some of the requested attributes are not within the batch!!" );
+
+  const std::array<int, sizeof...(attrs)> iattrs = {inquire(attrs)...};
+
+  // the transforms read are evaluated first, as they may be pending too
+  auto f_apply = [function, this, iattr = v_data.size(), iattrs] () -> void {
+    for (auto iA : iattrs)
+      fetch(iA);
+
+    auto &out = std::get<std::vector<typename Traits::result_type>>(v_data[iattr]);
+    out.resize(n_elements());
+    transform_helper(function, out, iattrs, std::make_index_sequence<Traits::arity>{});
+  };
+
+  v_attr.emplace_back(std::make_pair(attr, std::function<void()>(f_apply)));
+  v_source.emplace_back(-1);
+  v_data.emplace_back(std::vector<typename Traits::result_type>());
+  v_pending.emplace_back(1);
+
+  return true;
+}
+
+
+
+template <typename ...Ts>
+template <typename Kernel, typename ...Attributes>
+bool Framework::Batch<Ts...>::kernel_attribute(const std::string &attr, Kernel kernel, Attributes &&...attrs)
+{
+  static_assert(sizeof...(attrs) > 0, "ERROR: Batch::kernel_attribute requires some attributes to be provided!!");
+
+  using Traits = function_traits<decltype(kernel)>;
+  static_assert(Traits::arity == sizeof...(attrs) + 2,
+                "ERROR: Batch::kernel_attribute: the kernel must take the count and the output, then as many columns as there are attributes!!");
+
+  using Result = std::remove_pointer_t<typename Traits::template bare_arg<1>>;
+  static_assert(contained_in<Result, Ts...>,
+                "ERROR: Batch::kernel_attribute: the kernel output type is not among the types expected by the Batch!!");
+
+  if (has_attribute(attr))
+    return false;
+
+  auto iA = (has_attribute(attrs) and ...);
+  if (!iA)
+    throw std::invalid_argument( "ERROR: Batch::kernel_attribute: some of the requested attributes are not within the batch!!" );
+
+  const std::array<int, sizeof...(attrs)> iattrs = {inquire(attrs)...};
+
+  auto f_apply = [kernel, this, iattr = v_data.size(), iattrs] () -> void {
+    for (auto iA : iattrs)
+      fetch(iA);
+
+    auto &out = std::get<std::vector<Result>>(v_data[iattr]);
+    out.resize(n_elements());
+    kernel_helper(kernel, out, iattrs, std::make_index_sequence<sizeof...(Attributes)>{});
+  };
+
+  v_attr.emplace_back(std::make_pair(attr, std::function<void()>(f_apply)));
+  v_source.emplace_back(-1);
+  v_data.emplace_back(std::vector<Result>());
+  v_pending.emplace_back(1);
+
+  return true;
+}
+
+
+
+template <typename ...Ts>
+template <typename Compare, typename ...Attributes>
+std::vector<int> Framework::Batch<Ts...>::filter(Compare compare, Attributes &&...attrs) const
+{
+  static_assert(sizeof...(attrs) > 0, "ERROR: Batch::filter makes no sense without specifying attributes!!");
+
+  auto iA = (has_attribute(attrs) and ...);
+  if (!iA)
+    throw std::invalid_argument( "ERROR: Batch::filter some of the requested attributes are not within the batch!!" );
+
+  (fetch(inquire(attrs)), ...);
+
+  std::vector<int> v_idx;
+  std::visit([&v_idx, &compare, n = n_elements()] (const auto &...vec) {
+      for (int iE = 0; iE < n; ++iE) {
+        if (compare(vec[iE]...))
+          v_idx.emplace_back(iE);
+      }
+    }, v_data[inquire(attrs)]...);
+
+  return v_idx;
+}
+
+
+
+template <typename ...Ts>
+template <typename Compare, typename ...Attributes>
+std::vector<int> Framework::Batch<Ts...>::count(Compare compare, Attributes &&...attrs) const
+{
+  return tally(filter(compare, std::forward<Attributes>(attrs)...));
+}
+
+
+
+template <typename ...Ts>
+std::vector<int> Framework::Batch<Ts...>::tally(const std::vector<int> &v_idx) const
+{
+  // both the indices and the offsets are ascending, so one pass over each is enough
+  std::vector<int> v_count(n_events(), 0);
+  int iV = 0;
+  for (auto idx : v_idx) {
+    while (idx >= v_offset[iV + 1])
+      ++iV;
+    ++v_count[iV];
+  }
+
+  return v_count;
+}
+
+
+
+template <typename ...Ts>
+void Framework::Batch<Ts...>::update_indices(const std::vector<int> &v_idx)
+{
+  // compacted in place, as the kept elements never move forward
+  seal();
+  for (auto &dat : v_data) {
+    std::visit([&v_idx] (auto &vec) {
+        for (int iI = 0; iI < v_idx.size(); ++iI)
+          vec[iI] = vec[v_idx[iI]];
+        vec.resize(v_idx.size());
+      }, dat);
+  }
+
+  const auto v_count = tally(v_idx);
+  for (int iV = 0; iV < v_count.size(); ++iV)
+    v_offset[iV + 1] = v_offset[iV] + v_count[iV];
+}
+
+
+
+template <typename ...Ts>
+void Framework::Batch<Ts...>::fill(TH1 *hist, const std::string &attr, const std::vector<double> &v_weight) const
+{
+  FWK_PROFILE_SCOPE(histogram_fill, name.c_str());
+  std::visit([this, hist, &v_weight] (const auto &vec) {
+      if (v_weight.empty()) {
+        for (int iE = 0; iE < n_elements(); ++iE)
+          hist->Fill(vec[iE]);
+        return;
+      }
+
+      for (int iV = 0; iV < n_events(); ++iV) {
+        for (int iE = v_offset[iV]; iE < v_offset[iV + 1]; ++iE)
+          hist->Fill(vec[iE], v_weight[iV]);
+      }
+    }, (*this)(attr));
+}
+
+
+
+template <typename ...Ts>
+void Framework::Batch<Ts...>::fill(TH2 *hist, const std::string &xattr, const std::string &yattr, const std::vector<double> &v_weight) const
+{
+  FWK_PROFILE_SCOPE(histogram_fill, name.c_str());
+  std::visit([this, hist, &v_weight] (const auto &xvec, const auto &yvec) {
+      for (int iV = 0; iV < n_events(); ++iV) {
+        const double weight = (v_weight.empty()) ? 1. : v_weight[iV];
+        for (int iE = v_offset[iV]; iE < v_offset[iV + 1]; ++iE)
+          hist->Fill(xvec[iE], yvec[iE], weight);
+      }
+    }, (*this)(xattr), (*this)(yattr));
+}
+
+
+
+template <typename ...Ts>
+int Framework::Batch<Ts...>::inquire(const std::string &name) const
+{
+  for (int iA = 0; iA < v_attr.size(); ++iA) {
+    if (v_attr[iA].first == name)
+      return iA;
+  }
+
+  return -1;
+}
+
+
+
+template <typename ...Ts>
+void Framework::Batch<Ts...>::fetch(int attr) const
+{
+  // cleared before the call, as in Group::fetch
+  if (attr > -1 and attr < v_pending.size() and v_pending[attr]) {
+    FWK_PROFILE_SCOPE(transform, name.c_str());
+    v_pending[attr] = 0;
+    v_attr[attr].second();
+  }
+}
+
+
+
+template <typename ...Ts>
+template <typename Function, typename Result, std::size_t ...Is>
+void Framework::Batch<Ts...>::transform_helper(const Function &function, std::vector<Result> &out, const std::array<int, sizeof...(Is)> &iattrs,
+                                               std::index_sequence<Is...>) const
+{
+  using Traits = function_traits<Function>;
+  const auto columns = std::forward_as_tuple(std::get<std::vector<typename Traits::template bare_arg<Is>>>(v_data[iattrs[Is]])...);
+
+  for (int iE = 0; iE < out.size(); ++iE)
+    out[iE] = function(std::get<Is>(columns)[iE]...);
+}
+
+
+
+template <typename ...Ts>
+template <typename Kernel, typename Result, std::size_t ...Is>
+void Framework::Batch<Ts...>::kernel_helper(const Kernel &kernel, std::vector<Result> &out, const std::array<int, sizeof...(Is)> &iattrs,
+                                            std::index_sequence<Is...>) const
+{
+  using Traits = function_traits<Kernel>;
+  kernel(out.size(), out.data(),
+         std::get<std::vector<std::remove_cv_t<std::remove_pointer_t<typename Traits::template bare_arg<Is + 2>>>>>(v_data[iattrs[Is]]).data()...);
+}
@@ -0,0 +1,153 @@
+#ifndef FWK_BATCH_H
+#define FWK_BATCH_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: the elements of a group over many events at once, as jagged arrays i.e. flat attribute values plus event offsets
+// note: in batch mode (see Dataset::set_batch_analyzer) the group is populated entry by entry, and its selected elements appended here
+// note: the transforms, filters and histogram fills then run once over the whole batch, in plain loops over the flat values
+// note: a transform is evaluated by seal(), or by whichever access to it comes first after the batch changes
+// note: so that the per-event costs of the function dispatch and variant visits are paid once per batch instead
+// note: a kernel attribute goes further, handing whole columns to one call of a function that is written to be vectorized
+// note: the elements of event i are those in [offsets()[i], offsets()[i + 1]) of every attribute
+// note: the event axis is shared by all the batches of a dataset, and is never reordered; selections act on the elements only
+// note: the reading off the files is still entry by entry, as it is for the groups
+
+#include "Group.h"
+
+#include "TH1.h"
+#include "TH2.h"
+
+namespace Framework {
+  template <typename ...Ts>
+  class Batch {
+  public:
+    /// no default constructor
+    Batch() = delete;
+
+    /// constructor
+    /// the group whose elements are batched, and the attributes to batch, all those the group has at this point if empty
+    /// events and elements are estimates of the events per batch and the elements per event, to reserve the storage with
+    Batch(Group<Ts...> &group_, const std::vector<std::string> &v_attr_ = {}, int events = 1024, int elements = 4);
+
+    /// populate the group with an entry, and append its selected elements to the batch as one more event
+    void append(long long entry);
+
+    /// evaluate the transforms over the whole batch, to be called once it is complete
+    /// any access to a transform not yet evaluated evaluates it too, so this only chooses when the cost is paid
+    void seal();
+
+    /// empty the batch, keeping the storage
+    void clear();
+
+    /// number of events in the batch
+    int n_events() const;
+
+    /// number of elements in the batch, over all events
+    int n_elements() const;
+
+    /// the offsets of each event into the flat attributes, n_events() + 1 of them
+    const std::vector<int>& offsets() const;
+
+    /// number of elements in each event
+    std::vector<int> counts() const;
+
+    /// number of attributes, batched and transformed
+    int n_attributes() const;
+
+    /// as it says on the tin
+    bool has_attribute(const std::string &name) const;
+
+    /// list of attributes
+    std::vector<std::string> attributes() const;
+
+    /// reference to the flat values of an attribute - variant version
+    const std::variant<std::vector<Ts>...>& operator()(const std::string &name) const;
+
+    /// and typed version
+    template <typename T>
+    const std::vector<T>& get(const std::string &name) const;
+
+    /// add an attribute that is transformed element-wise from others, as Group::transform_attribute
+    /// it is evaluated over every element of the batch by seal() or on first access, see fetch()
+    template <typename Function, typename ...Attributes>
+    bool transform_attribute(const std::string &attr, Function function, Attributes &&...attrs);
+
+    /// add an attribute that is computed by a kernel over whole columns, rather than element by element as above
+    /// signature: the kernel takes the number of elements, the output column then the input columns i.e. void(std::size_t, R *, const A *...)
+    /// for kernels written to be vectorized, e.g. batch_invariant_mass and friends in plugins/misc/numeric_vector.h
+    /// it is evaluated as the transforms are, by seal() or on first access
+    template <typename Kernel, typename ...Attributes>
+    bool kernel_attribute(const std::string &attr, Kernel kernel, Attributes &&...attrs);
+
+    /// the elements passing a criteria, as in Group::filter, over the whole batch
+    /// returns the indices into the flat attributes, in ascending order
+    template <typename Compare, typename ...Attributes>
+    std::vector<int> filter(Compare compare, Attributes &&...attrs) const;
+
+    /// the number of elements passing a criteria in each event
+    template <typename Compare, typename ...Attributes>
+    std::vector<int> count(Compare compare, Attributes &&...attrs) const;
+
+    /// the number of the given elements in each event
+    /// the indices are into the flat attributes, in ascending order e.g. the output of filter
+    std::vector<int> tally(const std::vector<int> &v_idx) const;
+
+    /// keep only the given elements, with the offsets updated accordingly
+    /// the indices are into the flat attributes, in ascending order e.g. the output of filter
+    /// the transforms not yet evaluated are evaluated beforehand, so that every attribute holds the same elements
+    void update_indices(const std::vector<int> &v_idx);
+
+    /// fill a histogram with every element of the batch
+    /// the weights are one per event, and every element is filled with the weight of its event; unit weights if empty
+    void fill(TH1 *hist, const std::string &attr, const std::vector<double> &v_weight = {}) const;
+
+    /// the same for two dimensional histograms
+    void fill(TH2 *hist, const std::string &xattr, const std::string &yattr, const std::vector<double> &v_weight = {}) const;
+
+    /// name of the batch, that of the group
+    std::string name;
+
+  protected:
+    /// returns the index where an attribute occurs
+    int inquire(const std::string &name) const;
+
+    /// evaluate the transform at the given index if it is pending, no-op otherwise
+    /// transforms are pending since the last append or clear, or since they are added
+    void fetch(int attr) const;
+
+    /// evaluate a transform over every element of the batch
+    template <typename Function, typename Result, std::size_t ...Is>
+    void transform_helper(const Function &function, std::vector<Result> &out, const std::array<int, sizeof...(Is)> &iattrs,
+                          std::index_sequence<Is...>) const;
+
+    /// evaluate a kernel over the columns of the batch
+    template <typename Kernel, typename Result, std::size_t ...Is>
+    void kernel_helper(const Kernel &kernel, std::vector<Result> &out, const std::array<int, sizeof...(Is)> &iattrs,
+                       std::index_sequence<Is...>) const;
+
+    /// the group being batched
+    Group<Ts...> &group;
+
+    /// register of the attributes
+    /// first string is attribute alias
+    /// second function is the transform over the batch, empty for attributes batched off the group
+    std::vector<std::pair<std::string, std::function<void()>>> v_attr;
+
+    /// index of the batched attributes in the group, -1 for transformed ones
+    std::vector<int> v_source;
+
+    /// attribute storage, flat over the events
+    std::vector<std::variant<std::vector<Ts>...>> v_data;
+
+    /// event offsets into the above
+    std::vector<int> v_offset;
+
+    /// whether the attribute is a transform awaiting evaluation, see fetch()
+    mutable std::vector<int> v_pending;
+  };
+}
+
+#include "Batch.cc"
+
+#endif
@@ -7,7 +7,12 @@ Framework::Collection<Ts...>::Collection(const std::string &name_, int reserve_)
 Framework::Group<Ts...>::Group(name_, 1),
 tree(nullptr),
 counter_name(""),
-counter_branch(nullptr)
+counter_branch(nullptr),
+io_stats(nullptr),
+counter_key(-1),
+n_rebind(0LL),
+cache(nullptr),
+counter_column(-1)
 {
   reserve(reserve_);
   this->initialize(1);
@@ -20,7 +25,12 @@ Framework::Collection<Ts...>::Collection(const std::string &name_, const std::st
 Framework::Group<Ts...>::Group(name_, 1),
 tree(nullptr),
 counter_name(counter_name_),
-counter_branch(nullptr)
+counter_branch(nullptr),
+io_stats(nullptr),
+counter_key(-1),
+n_rebind(0LL),
+cache(nullptr),
+counter_column(-1)
 {
   reserve(reserve_);
   if (counter_name != "")
@@ -48,6 +58,14 @@ void Framework::Collection<Ts...>::reserve(int attr)
 
 
 
+template <typename ...Ts>
+const std::string& Framework::Collection<Ts...>::get_counter_name() const
+{
+  return counter_name;
+}
+
+
+
 template <typename ...Ts>
 template <typename Number>
 bool Framework::Collection<Ts...>::add_attribute(const std::string &name, const std::string &branch, Number _)
@@ -86,16 +104,73 @@ bool Framework::Collection<Ts...>::transform_attribute(const std::string &attr,
 
 
 
+template <typename ...Ts>
+void Framework::Collection<Ts...>::columns(std::vector<ColumnCache::Column> &v_column_) const
+{
+  auto add = [&v_column_] (const ColumnCache::Column &col) {
+    if (std::none_of(std::begin(v_column_), std::end(v_column_), [&col] (const auto &have) {return have.branch == col.branch;}))
+      v_column_.emplace_back(col);
+  };
+
+  if (counter_name != "")
+    add({counter_name, sizeof(int), ""});
+
+  for (int iB = 0; iB < v_branch.size(); ++iB) {
+    if (v_branch[iB].first == "")
+      continue;
+
+    std::visit([&add, &branch_name = v_branch[iB].first, this] (const auto &vec) {
+        add({branch_name, sizeof(typename std::decay_t<decltype(vec)>::value_type), counter_name});
+      }, this->v_data[iB]);
+  }
+}
+
+
+
 template <typename ...Ts>
 template <typename Tree>
 void Framework::Collection<Ts...>::associate(Dataset<Tree> &dataset)
 {
   tree = dataset.tree().get();
+  io_stats = dataset.io_stats();
+  cache = dataset.column_cache();
+
+  // the cache knows the largest count of the whole dataset, so the storage is sized once and the tree never touched
+  if (cache != nullptr) {
+    counter_column = (counter_name != "") ? cache->column(counter_name) : -1;
+    if (counter_name != "" and counter_column == -1)
+      throw std::runtime_error( "ERROR: Collection::associate: counter " + counter_name + " is not in the column cache. Aborting!!" );
+
+    if (counter_column > -1 and cache->maximum(counter_column) > this->v_index.capacity())
+      this->initialize(cache->maximum(counter_column));
+
+    v_column.assign(v_branch.size(), -1);
+    for (int iB = 0; iB < v_branch.size(); ++iB) {
+      if (v_branch[iB].first == "")
+        continue;
+
+      v_column[iB] = cache->column(v_branch[iB].first);
+      if (v_column[iB] == -1)
+        throw std::runtime_error( "ERROR: Collection::associate: branch " + v_branch[iB].first + " is not in the column cache. Aborting!!" );
+    }
+
+    return;
+  }
+
+  // with the counter prescanned, the storage is sized once for the whole dataset and reassociate never grows it
+  if (counter_name != "") {
+    if (auto maximum = dataset.counter_maximum(counter_name); maximum > this->v_index.capacity())
+      this->initialize(maximum);
+  }
+  v_key.assign(v_branch.size(), -1);
 
   if (counter_name != "") {
     tree->SetBranchStatus(counter_name.c_str(), 1);
     tree->SetBranchAddress(counter_name.c_str(), &(this->counter), &counter_branch);
     counter_branch->SetAutoDelete(false);
+
+    if (io_stats != nullptr)
+      counter_key = io_stats->add_branch(this->name, "(counter)", counter_name);
   }
 
   for (int iB = 0; iB < v_branch.size(); ++iB) {
@@ -103,6 +178,9 @@ void Framework::Collection<Ts...>::associate(Dataset<Tree> &dataset)
     if (branch_name == "")
       continue;
 
+    if (io_stats != nullptr)
+      v_key[iB] = io_stats->add_branch(this->name, this->v_attr[iB].first, branch_name);
+
     tree->SetBranchStatus(branch_name.c_str(), 1);
     std::visit([this, &branch = branch, &branch_name = branch_name] (auto &vec) { 
         tree->SetBranchAddress(branch_name.c_str(), vec.data(), &branch);
@@ -120,7 +198,7 @@ void Framework::Collection<Ts...>::reassociate()
     throw std::runtime_error( "ERROR: Collection::reassociate: the associated tree is null." 
                               "Perhaps Collection::associate has not been called? Aborting!!" );
 
-  if (counter_name == "")
+  if (counter_name == "" or cache != nullptr)
     return;
 
   TLeaf *leaf = tree->GetLeaf(counter_name.c_str());
@@ -136,6 +214,7 @@ void Framework::Collection<Ts...>::reassociate()
       std::visit([this, &branch = branch, &branch_name = branch_name] (auto &vec) {
           tree->SetBranchAddress(branch_name.c_str(), vec.data(), &branch);
         }, this->v_data[iD]);
+      ++n_rebind;
     }
   }
 }
@@ -145,10 +224,19 @@ void Framework::Collection<Ts...>::reassociate()
 template <typename ...Ts>
 void Framework::Collection<Ts...>::populate(long long entry)
 {
+  FWK_PROFILE_SCOPE(collection_populate, this->name.c_str());
+  ++this->n_populate;
+
   // get the number of elements and fill up indices
-  if (counter_branch != nullptr) {
-    counter_branch->GetEntry(entry);
+  if (counter_branch != nullptr or counter_column > -1) {
+    if (counter_column > -1)
+      cache->read(counter_column, entry, &(this->counter));
+    else if (io_stats == nullptr)
+      counter_branch->GetEntry(entry);
+    else
+      io_stats->read(counter_key, counter_branch, entry);
     this->selected = this->counter;
+    this->peak = std::max(this->peak, this->counter);
 
     this->v_index.clear();
     for (int iD = 0; iD < this->counter; ++iD)
@@ -157,13 +245,22 @@ void Framework::Collection<Ts...>::populate(long long entry)
 
   // and then get the data of all the branches
   for (int iD = 0; iD < this->v_data.size(); ++iD) {
+    if (cache != nullptr and iD < v_column.size() and v_column[iD] > -1) {
+      std::visit([this, &entry, iC = v_column[iD]] (auto &vec) {cache->read(iC, entry, vec.data());}, this->v_data[iD]);
+      continue;
+    }
+
     if (v_branch[iD].second == nullptr)
       continue;
 
-    v_branch[iD].second->GetEntry(entry);
+    if (io_stats == nullptr)
+      v_branch[iD].second->GetEntry(entry);
+    else
+      io_stats->read(v_key[iD], v_branch[iD].second, entry);
   }
 
   // functional transformations can only run after everything else is populated
+  FWK_PROFILE_SCOPE(transform, this->name.c_str());
   for (int iD = 0; iD < this->v_data.size(); ++iD) {
     if (v_branch[iD].second == nullptr and this->v_attr[iD].second)
       this->v_attr[iD].second();
@@ -172,6 +269,16 @@ void Framework::Collection<Ts...>::populate(long long entry)
 
 
 
+template <typename ...Ts>
+Framework::MemoryUsage Framework::Collection<Ts...>::memory_usage() const
+{
+  auto usage = Group<Ts...>::memory_usage();
+  usage.rebinds = n_rebind;
+  return usage;
+}
+
+
+
 template <typename ...Ts>
 void Framework::Collection<Ts...>::detach()
 {
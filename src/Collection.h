@@ -37,6 +37,9 @@ namespace Framework {
     /// reserve the space for expected number of attributes
     void reserve(int attr);
 
+    /// name of the counter branch, empty for single element collections
+    const std::string& get_counter_name() const;
+
     /// add an attribute into the collection
     /// returns false upon failure to add the attribute
     /// this can happen if the data type is inconsistent with the collection
@@ -53,7 +56,11 @@ namespace Framework {
     template <typename Function, typename ...Attributes>
     bool transform_attribute(const std::string &attr, Function function, Attributes &&...attrs);
 
+    /// append the branches the collection reads, as columns of a ColumnCache
+    void columns(std::vector<ColumnCache::Column> &v_column) const;
+
     /// associate the attributes to relevant branches in a Dataset
+    /// if the dataset has a column cache, the attributes are read off it instead, and the tree is left alone
     template <typename Tree>
     void associate(Dataset<Tree> &dataset);
 
@@ -64,6 +71,9 @@ namespace Framework {
     /// populate the data with information read from the branches
     void populate(long long entry) override;
 
+    /// as in Group, plus the number of times the branches were rebound by reassociate
+    MemoryUsage memory_usage() const override;
+
   protected:
     /// detach the branches
     void detach();
@@ -79,6 +89,23 @@ namespace Framework {
 
     /// attribute branches
     std::vector<std::pair<std::string, TBranch *>> v_branch;
+
+    /// I/O statistics of the dataset, if enabled, and the keys of the counter and attribute branches in it
+    IOStats *io_stats;
+
+    int counter_key;
+
+    std::vector<int> v_key;
+
+    /// SetBranchAddress calls made by reassociate
+    long long n_rebind;
+
+    /// column cache of the dataset, if enabled, and the columns of the counter and attribute branches in it
+    ColumnCache *cache;
+
+    int counter_column;
+
+    std::vector<int> v_column;
   };
 }
 
@@ -0,0 +1,434 @@
+// -*- C++ -*-
+// author: afiq anuar
+// short: please refer to header for information
+
+namespace Framework {
+  namespace column_cache {
+    /// tells a cache file apart, and its layout version
+    constexpr char magic[8] = {'F', 'W', 'K', 'C', 'O', 'L', 'C', '1'};
+    constexpr std::uint32_t version = 1;
+
+    /// blocks begin on cache line boundaries
+    constexpr std::uint64_t alignment = 64;
+
+    /// the most that ROOT compresses in one go
+    constexpr int chunk = 0xffffff;
+
+    /// ROOT compression header size, and the LZ4 level used
+    constexpr int header = 9;
+    constexpr int level = 4;
+
+    /// builds started in the process so far, telling apart the files they write aside
+    inline std::atomic<unsigned long long> n_build = 0ULL;
+  }
+}
+
+
+
+Framework::ColumnCache::ColumnCache(const std::string &path_) :
+path(path_),
+codec(Codec::none),
+descriptor(-1),
+mapping(nullptr),
+mapped(0),
+current(-1)
+{
+  if (path == "")
+    throw std::invalid_argument( "ERROR: ColumnCache: the path to the cache file is empty!!" );
+}
+
+
+
+Framework::ColumnCache::~ColumnCache()
+{
+  close();
+}
+
+
+
+bool Framework::ColumnCache::open(std::uint64_t catalogue_hash, std::uint64_t column_hash)
+{
+  close();
+
+  descriptor = ::open(path.c_str(), O_RDONLY);
+  if (descriptor < 0)
+    return false;
+
+  struct stat status;
+  if (fstat(descriptor, &status) != 0 or status.st_size < sizeof(Header)) {
+    close();
+    return false;
+  }
+
+  mapped = status.st_size;
+  void *map = mmap(nullptr, mapped, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  if (map == MAP_FAILED) {
+    mapping = nullptr;
+    close();
+    return false;
+  }
+  mapping = static_cast<char *>(map);
+  madvise(mapping, mapped, MADV_SEQUENTIAL);
+
+  Header header;
+  std::memcpy(&header, mapping, sizeof(Header));
+  if (std::memcmp(header.magic, column_cache::magic, sizeof(header.magic)) != 0 or header.version != column_cache::version
+      or header.catalogue_hash != catalogue_hash or header.column_hash != column_hash or header.table >= mapped) {
+    close();
+    return false;
+  }
+
+  // the table is read through a cursor that refuses to run past the end, so a truncated file is merely unusable
+  std::uint64_t cursor = header.table;
+  auto take = [this, &cursor] (void *target, std::uint64_t bytes) {
+    if (cursor + bytes > mapped)
+      return false;
+
+    std::memcpy(target, mapping + cursor, bytes);
+    cursor += bytes;
+    return true;
+  };
+
+  bool good = true;
+  v_column.assign(header.n_column, Column{});
+  v_counter.assign(header.n_column, -1);
+  v_maximum.assign(header.n_column, 0);
+  for (int iC = 0; iC < header.n_column and good; ++iC) {
+    std::uint32_t length = 0;
+    std::int32_t size = 0, counter = -1, maximum = 0;
+    good = take(&length, sizeof(length)) and length <= mapped;
+    if (good) {
+      v_column[iC].branch.resize(length);
+      good = take(v_column[iC].branch.data(), length) and take(&size, sizeof(size)) and take(&counter, sizeof(counter)) and take(&maximum, sizeof(maximum));
+    }
+
+    v_column[iC].size = size;
+    v_counter[iC] = counter;
+    v_maximum[iC] = maximum;
+    good = good and size > 0 and counter >= -1 and counter < int(header.n_column);
+  }
+
+  for (int iC = 0; iC < header.n_column and good; ++iC) {
+    if (v_counter[iC] > -1)
+      v_column[iC].counter = v_column[v_counter[iC]].branch;
+  }
+
+  v_first.assign(header.n_cluster + 1, 0LL);
+  v_block.assign(std::size_t(header.n_cluster) * header.n_column, Block{});
+  good = good and take(v_first.data(), v_first.size() * sizeof(long long)) and take(v_block.data(), v_block.size() * sizeof(Block));
+  for (const auto &block : v_block)
+    good = good and block.offset + block.stored <= mapped;
+
+  if (!good or v_first.back() != header.entries) {
+    close();
+    return false;
+  }
+
+  codec = static_cast<Codec>(header.codec);
+  v_value.assign(v_column.size(), nullptr);
+  v_buffer.assign(v_column.size(), {});
+  v_offset.assign(v_column.size(), {});
+  return true;
+}
+
+
+
+template <typename FileInfo>
+void Framework::ColumnCache::build(const std::string &tree_name, const std::vector<FileInfo> &v_info, const std::vector<Column> &v_column_, Codec codec_,
+                                   std::uint64_t catalogue_hash, std::uint64_t column_hash)
+{
+  close();
+  codec = codec_;
+  v_first.clear();
+  v_block.clear();
+
+  // the single values go first, so that the counts of an entry are known by the time its arrays are read
+  v_column.clear();
+  for (const auto &col : v_column_) {
+    if (col.counter == "")
+      v_column.emplace_back(col);
+  }
+  for (const auto &col : v_column_) {
+    if (col.counter != "")
+      v_column.emplace_back(col);
+  }
+
+  const int ncol = v_column.size();
+  v_counter.assign(ncol, -1);
+  v_maximum.assign(ncol, 1);
+  for (int iC = 0; iC < ncol; ++iC) {
+    if (v_column[iC].counter == "")
+      continue;
+
+    v_counter[iC] = column(v_column[iC].counter);
+    if (v_counter[iC] == -1 or v_column[v_counter[iC]].size != sizeof(int))
+      throw std::invalid_argument( "ERROR: ColumnCache::build: the counter " + v_column[iC].counter + " of branch " + v_column[iC].branch +
+                                   " is not among the columns, or is not a 4-byte integer!!" );
+
+    v_maximum[iC] = 0;
+    v_maximum[v_counter[iC]] = 0;
+  }
+
+  // unique to the build, as several datasets in a process may be building the same cache at once
+  const std::string temporary = path + ".tmp" + std::to_string(getpid()) + "." + std::to_string(column_cache::n_build++);
+  std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+  if (!out)
+    throw std::runtime_error( "ERROR: ColumnCache::build: unable to open " + temporary + " for writing!!" );
+
+  Header header{};
+  std::memcpy(header.magic, column_cache::magic, sizeof(header.magic));
+  header.version = column_cache::version;
+  header.codec = static_cast<std::uint32_t>(codec);
+  header.catalogue_hash = catalogue_hash;
+  header.column_hash = column_hash;
+  header.n_column = ncol;
+  out.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+
+  std::vector<char> v_zip;
+  auto write_block = [this, &out, &v_zip] (const std::vector<char> &raw) {
+    const std::uint64_t offset = out.tellp();
+    const std::uint64_t pad = (column_cache::alignment - (offset % column_cache::alignment)) % column_cache::alignment;
+    const char zero[column_cache::alignment] = {};
+    out.write(zero, pad);
+
+    Block block{offset + pad, raw.size(), raw.size()};
+
+    // compressed chunk by chunk, and kept as is unless every chunk shrinks
+    bool zipped = codec == Codec::lz4 and !raw.empty();
+    v_zip.resize(raw.size() + (raw.size() / column_cache::chunk + 1) * column_cache::header);
+    std::uint64_t stored = 0;
+    for (std::uint64_t begin = 0; zipped and begin < raw.size(); begin += column_cache::chunk) {
+      int srcsize = std::min<std::uint64_t>(column_cache::chunk, raw.size() - begin);
+      int tgtsize = v_zip.size() - stored;
+      int irep = 0;
+      R__zipMultipleAlgorithm(column_cache::level, &srcsize, const_cast<char *>(raw.data() + begin), &tgtsize, v_zip.data() + stored, &irep,
+                              ROOT::RCompressionSetting::EAlgorithm::kLZ4);
+
+      zipped = irep > 0 and irep < srcsize;
+      stored += irep;
+    }
+
+    if (zipped) {
+      block.stored = stored;
+      out.write(v_zip.data(), stored);
+    }
+    else
+      out.write(raw.data(), raw.size());
+
+    return block;
+  };
+
+  // per column, the values of the current cluster, and the buffer the branch reads an entry into
+  std::vector<std::vector<char>> v_values(ncol), v_entry(ncol);
+  long long offset = 0LL;
+  for (const auto &info : v_info) {
+    if (info.entries <= 0LL)
+      continue;
+
+    std::unique_ptr<TFile> tfile(TFile::Open(info.name.c_str(), "read"));
+    if (tfile == nullptr or tfile->IsZombie())
+      throw std::runtime_error( "ERROR: ColumnCache::build: unable to read the file " + info.name + ". Aborting!!" );
+
+    TTree *tree = nullptr;
+    tfile->GetObject(tree_name.c_str(), tree);
+    if (tree == nullptr)
+      throw std::runtime_error( "ERROR: ColumnCache::build: tree " + tree_name + " is not in the file " + info.name + ". Aborting!!" );
+
+    std::vector<TBranch *> v_branch(ncol, nullptr);
+    for (int iC = 0; iC < ncol; ++iC) {
+      v_branch[iC] = tree->GetBranch(v_column[iC].branch.c_str());
+      TLeaf *leaf = (v_counter[iC] > -1) ? tree->GetLeaf(v_column[iC].counter.c_str()) : nullptr;
+      if (v_branch[iC] == nullptr or (v_counter[iC] > -1 and leaf == nullptr))
+        throw std::runtime_error( "ERROR: ColumnCache::build: branch " + v_column[iC].branch + " or its counter is not in the file " + info.name + ". Aborting!!" );
+
+      v_entry[iC].assign(std::size_t(v_column[iC].size) * ((leaf != nullptr) ? std::max(1, leaf->GetMaximum()) : 1), 0);
+      v_branch[iC]->SetAddress(v_entry[iC].data());
+    }
+
+    for (int iK = 0; iK < info.v_cluster.size(); ++iK) {
+      const long long begin = info.v_cluster[iK];
+      const long long end = (iK + 1 < info.v_cluster.size()) ? info.v_cluster[iK + 1] : info.entries;
+
+      for (auto entry = begin; entry < end; ++entry) {
+        for (int iC = 0; iC < ncol; ++iC) {
+          v_branch[iC]->GetEntry(entry);
+
+          int count = 1;
+          if (v_counter[iC] > -1) {
+            std::memcpy(&count, v_entry[v_counter[iC]].data(), sizeof(int));
+            v_maximum[iC] = std::max(v_maximum[iC], count);
+            v_maximum[v_counter[iC]] = std::max(v_maximum[v_counter[iC]], count);
+          }
+
+          v_values[iC].insert(std::end(v_values[iC]), std::begin(v_entry[iC]), std::begin(v_entry[iC]) + std::size_t(count) * v_column[iC].size);
+        }
+      }
+
+      v_first.emplace_back(offset + begin);
+      for (int iC = 0; iC < ncol; ++iC) {
+        v_block.emplace_back(write_block(v_values[iC]));
+        v_values[iC].clear();
+      }
+    }
+
+    offset += info.entries;
+  }
+  v_first.emplace_back(offset);
+
+  header.entries = offset;
+  header.n_cluster = v_first.size() - 1;
+  header.table = out.tellp();
+  for (int iC = 0; iC < ncol; ++iC) {
+    const std::uint32_t length = v_column[iC].branch.size();
+    const std::int32_t size = v_column[iC].size, counter = v_counter[iC], maximum = v_maximum[iC];
+    out.write(reinterpret_cast<const char *>(&length), sizeof(length));
+    out.write(v_column[iC].branch.data(), length);
+    out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    out.write(reinterpret_cast<const char *>(&counter), sizeof(counter));
+    out.write(reinterpret_cast<const char *>(&maximum), sizeof(maximum));
+  }
+  out.write(reinterpret_cast<const char *>(v_first.data()), v_first.size() * sizeof(long long));
+  out.write(reinterpret_cast<const char *>(v_block.data()), v_block.size() * sizeof(Block));
+
+  out.seekp(0);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+  out.close();
+  if (!out)
+    throw std::runtime_error( "ERROR: ColumnCache::build: failed writing " + temporary + "!!" );
+
+  if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    throw std::runtime_error( "ERROR: ColumnCache::build: unable to move " + temporary + " to " + path + "!!" );
+
+  v_first.clear();
+  v_block.clear();
+}
+
+
+
+int Framework::ColumnCache::column(const std::string &branch) const
+{
+  for (int iC = 0; iC < v_column.size(); ++iC) {
+    if (v_column[iC].branch == branch)
+      return iC;
+  }
+
+  return -1;
+}
+
+
+
+int Framework::ColumnCache::maximum(int column) const
+{
+  return v_maximum[column];
+}
+
+
+
+long long Framework::ColumnCache::entries() const
+{
+  return (v_first.empty()) ? 0LL : v_first.back();
+}
+
+
+
+int Framework::ColumnCache::read(int column, long long entry, void *target)
+{
+  if (current < 0 or entry < v_first[current] or entry >= v_first[current + 1])
+    enter(entry);
+
+  const int local = entry - v_first[current];
+  const int size = v_column[column].size;
+  if (v_counter[column] == -1) {
+    std::memcpy(target, v_value[column] + std::size_t(local) * size, size);
+    return 1;
+  }
+
+  const auto &offset = v_offset[v_counter[column]];
+  const int count = offset[local + 1] - offset[local];
+  std::memcpy(target, v_value[column] + std::size_t(offset[local]) * size, std::size_t(count) * size);
+  return count;
+}
+
+
+
+std::uint64_t Framework::ColumnCache::hash(const std::string &str, std::uint64_t seed)
+{
+  for (unsigned char c : str) {
+    seed ^= c;
+    seed *= 1099511628211ULL;
+  }
+
+  return seed;
+}
+
+
+
+void Framework::ColumnCache::enter(long long entry)
+{
+  if (mapping == nullptr or entry < 0LL or entry >= entries())
+    throw std::out_of_range( "ERROR: ColumnCache::enter: entry " + std::to_string(entry) + " is not in the cache " + path + "!!" );
+
+  current = std::distance(std::begin(v_first), std::upper_bound(std::begin(v_first), std::end(v_first), entry)) - 1;
+
+  const int ncol = v_column.size();
+  for (int iC = 0; iC < ncol; ++iC) {
+    const auto &block = v_block[std::size_t(current) * ncol + iC];
+    if (block.stored == block.raw) {
+      v_value[iC] = mapping + block.offset;
+      continue;
+    }
+
+    auto &buffer = v_buffer[iC];
+    buffer.resize(block.raw);
+    std::uint64_t done = 0, read = 0;
+    while (read < block.stored) {
+      auto src = reinterpret_cast<unsigned char *>(mapping + block.offset + read);
+      int srcsize = 0, tgtsize = 0, irep = 0;
+      if (R__unzip_header(&srcsize, src, &tgtsize) != 0 or done + tgtsize > block.raw)
+        throw std::runtime_error( "ERROR: ColumnCache::enter: corrupted block in the cache " + path + "!!" );
+
+      R__unzip(&srcsize, src, &tgtsize, reinterpret_cast<unsigned char *>(buffer.data() + done), &irep);
+      if (irep != tgtsize)
+        throw std::runtime_error( "ERROR: ColumnCache::enter: corrupted block in the cache " + path + "!!" );
+
+      read += srcsize;
+      done += tgtsize;
+    }
+    v_value[iC] = buffer.data();
+  }
+
+  // the element offsets within the cluster follow from the counts
+  for (auto &offset : v_offset)
+    offset.clear();
+
+  const int nentry = v_first[current + 1] - v_first[current];
+  for (int iC = 0; iC < ncol; ++iC) {
+    if (v_counter[iC] == -1 or !v_offset[v_counter[iC]].empty())
+      continue;
+
+    auto &offset = v_offset[v_counter[iC]];
+    offset.resize(nentry + 1);
+    offset[0] = 0;
+    for (int iE = 0; iE < nentry; ++iE) {
+      int count = 0;
+      std::memcpy(&count, v_value[v_counter[iC]] + std::size_t(iE) * sizeof(int), sizeof(int));
+      offset[iE + 1] = offset[iE] + count;
+    }
+  }
+}
+
+
+
+void Framework::ColumnCache::close()
+{
+  if (mapping != nullptr)
+    munmap(mapping, mapped);
+
+  if (descriptor > -1)
+    ::close(descriptor);
+
+  descriptor = -1;
+  mapping = nullptr;
+  mapped = 0;
+  current = -1;
+}
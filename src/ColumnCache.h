@@ -0,0 +1,151 @@
+#ifndef FWK_COLUMNCACHE_H
+#define FWK_COLUMNCACHE_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: a local columnar copy of the branches a dataset reads, for analyzing the same branches of the same files over and over
+// note: enabled per dataset by Dataset::enable_cache, before associating the collections
+// note: associate then writes the branches of the collections into the cache file if there is no usable one, and reads them off it from then on
+// note: the file holds one block per TTree cluster and branch, uncompressed or LZ4-compressed through ROOT, with a table of where each block is
+// note: it is memory-mapped, so uncompressed blocks are read directly off the page cache, and compressed ones are decompressed once per cluster
+// note: the cache is remade when the files change, as told by their names, entries and modification times in the catalogue, or the branches do
+// note: the values are copied from the mapping into the collections, as the groups own their storage; that is one memcpy per branch and entry
+// note: the layout is that of the machine writing it, so a cache is not to be shared across architectures
+// note: while reading off the cache the tree is never loaded, so nothing that relies on the file changes e.g. IOStats sees anything
+
+#include "Heap.h"
+
+#include <cstdint>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TLeaf.h"
+#include "RZip.h"
+#include "Compression.h"
+
+namespace Framework {
+  class ColumnCache {
+  public:
+    /// how the blocks are stored
+    enum class Codec : std::uint32_t {none = 0, lz4 = 1};
+
+    /// one cached branch
+    /// size is the bytes per element, and counter the branch giving the element count for arrays, empty for single values
+    struct Column {
+      std::string branch;
+      int size;
+      std::string counter;
+    };
+
+    /// constructor
+    /// path is the cache file, which need not exist yet
+    ColumnCache(const std::string &path_);
+
+    /// destructor - unmaps the file
+    ~ColumnCache();
+
+    /// the mapping is not to be shared
+    ColumnCache(const ColumnCache &) = delete;
+
+    ColumnCache& operator=(const ColumnCache &) = delete;
+
+    /// map the cache file, if it exists and has been made with the given signatures
+    /// returns whether it is usable
+    bool open(std::uint64_t catalogue_hash, std::uint64_t column_hash);
+
+    /// write the cache file off the files in the catalogue (see Dataset::FileInfo), aligned to their clusters
+    /// the file is written aside and moved in place once complete, so an interrupted build leaves no cache behind
+    /// and concurrent builds of the same cache each write their own, the last one to complete being the one left in place
+    template <typename FileInfo>
+    void build(const std::string &tree_name, const std::vector<FileInfo> &v_info, const std::vector<Column> &v_column_, Codec codec_,
+               std::uint64_t catalogue_hash, std::uint64_t column_hash);
+
+    /// index of the column of a branch, -1 if not cached
+    int column(const std::string &branch) const;
+
+    /// the most elements of a column in any entry; for counters, the largest count
+    int maximum(int column) const;
+
+    /// number of entries cached
+    long long entries() const;
+
+    /// copy the values of a column at an entry into the target, returning the number of elements copied
+    /// the target must have room for maximum(column) elements
+    int read(int column, long long entry, void *target);
+
+    /// signature of a string, FNV-1a, continuing from seed
+    static std::uint64_t hash(const std::string &str, std::uint64_t seed = 14695981039346656037ULL);
+
+    /// path to the cache file
+    std::string path;
+
+  protected:
+    /// what is at the head of the file
+    struct Header {
+      char magic[8];
+      std::uint32_t version, codec;
+      std::uint64_t catalogue_hash, column_hash;
+      std::int64_t entries;
+      std::uint32_t n_column, n_cluster;
+      std::uint64_t table;
+    };
+
+    /// where a block is in the file, and its size as stored and as decompressed
+    struct Block {
+      std::uint64_t offset, stored, raw;
+    };
+
+    /// make the cluster holding an entry the current one
+    void enter(long long entry);
+
+    /// drop the mapping
+    void close();
+
+    Codec codec;
+
+    std::vector<Column> v_column;
+
+    /// per column, the index of its counter column, -1 for single values, and its maximum
+    std::vector<int> v_counter;
+
+    std::vector<int> v_maximum;
+
+    /// first entry of every cluster, followed by the number of entries
+    std::vector<long long> v_first;
+
+    /// the blocks, cluster by cluster
+    std::vector<Block> v_block;
+
+    /// the mapping
+    int descriptor;
+
+    char *mapping;
+
+    std::size_t mapped;
+
+    /// the current cluster, -1 if none
+    int current;
+
+    /// per column, its values in the current cluster, and the decompressed copy they are in if the block is compressed
+    std::vector<const char *> v_value;
+
+    std::vector<std::vector<char>> v_buffer;
+
+    /// per counter column, the offset of the elements of every entry in the current cluster, followed by the number of elements
+    std::vector<std::vector<int>> v_offset;
+  };
+}
+
+#include "ColumnCache.cc"
+
+#endif
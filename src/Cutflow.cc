@@ -0,0 +1,282 @@
+// -*- C++ -*-
+// author: afiq anuar
+// short: please refer to header for information
+
+Framework::Cutflow::Slot::Slot(std::thread::id thread_, int n_) :
+thread(thread_),
+n(n_),
+v_tally(std::make_unique<Tally[]>(n_))
+{}
+
+
+
+Framework::Cutflow::Cutflow(const std::string &name_, int reserve_) :
+name(name_),
+id([] () { static std::atomic<unsigned long long> n_instance = 0ULL; return n_instance++; }()),
+counting(false)
+{
+  v_step.reserve(reserve_);
+}
+
+
+
+int Framework::Cutflow::add_step(const std::string &step)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (counting)
+    throw std::logic_error( "ERROR: Cutflow::add_step: step " + step + " can not be added to cutflow " + name + " once counting has started!!" );
+
+  if (std::find(std::begin(v_step), std::end(v_step), step) != std::end(v_step))
+    throw std::invalid_argument( "ERROR: Cutflow::add_step: step " + step + " is already in cutflow " + name + "!!" );
+
+  v_step.emplace_back(step);
+
+  // only the slots of add() can exist before counting starts, and nothing reads them concurrently with this
+  for (auto &slot : v_slot) {
+    auto grown = std::make_unique<Slot>(slot->thread, v_step.size());
+    const auto v_count = read(*slot);
+    for (int iS = 0; iS < v_count.size(); ++iS) {
+      grown->v_tally[iS].raw = v_count[iS].raw;
+      grown->v_tally[iS].sumw = v_count[iS].sumw;
+      grown->v_tally[iS].sumw2 = v_count[iS].sumw2;
+    }
+    slot = std::move(grown);
+  }
+
+  return v_step.size() - 1;
+}
+
+
+
+int Framework::Cutflow::step_index(const std::string &step) const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  auto iS = std::find(std::begin(v_step), std::end(v_step), step);
+  return (iS == std::end(v_step)) ? -1 : std::distance(std::begin(v_step), iS);
+}
+
+
+
+int Framework::Cutflow::n_steps() const
+{
+  return v_step.size();
+}
+
+
+
+void Framework::Cutflow::count(int step, double weight)
+{
+  auto &own = slot();
+  if (step < 0 or step >= own.n)
+    throw std::out_of_range( "ERROR: Cutflow::count: step " + std::to_string(step) + " is not within cutflow " + name + "!!" );
+
+  accumulate(own, step, weight);
+}
+
+
+
+std::vector<Framework::Cutflow::Counter> Framework::Cutflow::counts() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<Counter> v_count(v_step.size());
+
+  for (const auto &slot : v_slot) {
+    const auto v_thread = read(*slot);
+    for (int iS = 0; iS < v_count.size(); ++iS) {
+      auto &total = v_count[iS];
+      const auto &thread = v_thread[iS];
+
+      total.raw += thread.raw;
+
+      // compensation terms are folded in before adding, so that nothing is lost in the merging either
+      const double sumw = thread.sumw - thread.cw, sumw2 = thread.sumw2 - thread.cw2;
+      double y = sumw - total.cw, t = total.sumw + y;
+      total.cw = (t - total.sumw) - y;
+      total.sumw = t;
+
+      y = sumw2 - total.cw2; t = total.sumw2 + y;
+      total.cw2 = (t - total.sumw2) - y;
+      total.sumw2 = t;
+    }
+  }
+
+  return v_count;
+}
+
+
+
+void Framework::Cutflow::merge(const Cutflow &other)
+{
+  if (other.v_step != v_step)
+    throw std::invalid_argument( "ERROR: Cutflow::merge: the steps of cutflow " + other.name + " do not match those of " + name + "!!" );
+
+  add(other.counts());
+}
+
+
+
+void Framework::Cutflow::add(const std::vector<Counter> &v_count)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (v_count.size() != v_step.size())
+    throw std::invalid_argument( "ERROR: Cutflow::add: the number of counts does not match the number of steps of cutflow " + name + "!!" );
+
+  auto added = std::make_unique<Slot>(std::thread::id(), v_count.size());
+  for (int iS = 0; iS < v_count.size(); ++iS) {
+    added->v_tally[iS].raw = v_count[iS].raw;
+    added->v_tally[iS].sumw = v_count[iS].sumw - v_count[iS].cw;
+    added->v_tally[iS].sumw2 = v_count[iS].sumw2 - v_count[iS].cw2;
+  }
+  v_slot.emplace_back(std::move(added));
+}
+
+
+
+void Framework::Cutflow::print(std::ostream &out) const
+{
+  const auto v_count = counts();
+
+  int width = 4;
+  for (const auto &step : v_step)
+    width = std::max(width, int(step.size()));
+
+  const auto flags = out.flags();
+  const auto precision = out.precision();
+
+  out << "Cutflow " << name << ":\n";
+  out << std::left << std::setw(width) << "step" << std::right
+      << std::setw(14) << "raw" << std::setw(18) << "weighted" << std::setw(14) << "error"
+      << std::setw(12) << "rel. eff" << std::setw(12) << "cum. eff" << "\n";
+
+  for (int iS = 0; iS < v_count.size(); ++iS) {
+    const auto &counter = v_count[iS];
+    const double first = v_count.front().sumw, previous = (iS > 0) ? v_count[iS - 1].sumw : counter.sumw;
+
+    out << std::left << std::setw(width) << v_step[iS] << std::right
+        << std::setw(14) << counter.raw
+        << std::setw(18) << std::setprecision(6) << std::scientific << counter.sumw
+        << std::setw(14) << std::setprecision(3) << std::sqrt(counter.sumw2)
+        << std::setw(12) << std::setprecision(4) << std::fixed << ((previous != 0.) ? counter.sumw / previous : 0.)
+        << std::setw(12) << ((first != 0.) ? counter.sumw / first : 0.) << "\n";
+  }
+
+  out.flags(flags);
+  out.precision(precision);
+  out << std::flush;
+}
+
+
+
+std::unique_ptr<TH1D> Framework::Cutflow::histogram(bool raw) const
+{
+  const auto v_count = counts();
+  const int nbin = std::max(1, int(v_count.size()));
+
+  auto hist = std::make_unique<TH1D>((name + ((raw) ? "_raw" : "_weighted")).c_str(), (raw) ? "cutflow raw counts" : "cutflow weighted counts",
+                                     nbin, 0., double(nbin));
+  hist->SetDirectory(nullptr);
+
+  for (int iS = 0; iS < v_count.size(); ++iS) {
+    hist->GetXaxis()->SetBinLabel(iS + 1, v_step[iS].c_str());
+    hist->SetBinContent(iS + 1, (raw) ? double(v_count[iS].raw) : v_count[iS].sumw);
+    hist->SetBinError(iS + 1, (raw) ? std::sqrt(double(v_count[iS].raw)) : std::sqrt(v_count[iS].sumw2));
+  }
+
+  return hist;
+}
+
+
+
+bool Framework::Cutflow::is_raw(const TH1 &hist)
+{
+  return std::string(hist.GetTitle()) == "cutflow raw counts";
+}
+
+
+
+void Framework::Cutflow::save_as(const std::string &filename, const std::string &mode) const
+{
+  auto file = std::make_unique<TFile>(filename.c_str(), mode.c_str());
+  file->cd();
+
+  histogram(true)->Write();
+  histogram(false)->Write();
+}
+
+
+
+Framework::Cutflow::Slot& Framework::Cutflow::slot()
+{
+  // every thread caches its slot of every cutflow by the instance id, so that the lookup is a single index
+  // whichever number of cutflows a thread counts into; the ids are never reused, so entries of cutflows since destroyed are never read
+  thread_local std::vector<Slot *> v_cache;
+  if (id < v_cache.size() and v_cache[id] != nullptr)
+    return *v_cache[id];
+
+  std::lock_guard<std::mutex> lock(mutex);
+  counting = true;
+  const auto thread = std::this_thread::get_id();
+  auto iS = std::find_if(std::begin(v_slot), std::end(v_slot), [&thread] (const auto &slot) {return slot->thread == thread;});
+  if (iS == std::end(v_slot)) {
+    v_slot.emplace_back(std::make_unique<Slot>(thread, v_step.size()));
+    iS = std::prev(std::end(v_slot));
+  }
+
+  if (id >= v_cache.size())
+    v_cache.resize(id + 1, nullptr);
+
+  v_cache[id] = iS->get();
+  return *v_cache[id];
+}
+
+
+
+void Framework::Cutflow::accumulate(Slot &slot, int step, double weight)
+{
+  // only the owning thread writes, so the fields need no read-modify-write, only to be atomic for the readers' sake
+  // the release stores make a reader that sees any of the new values see the odd sequence number too; on x86 they are plain stores
+  auto &tally = slot.v_tally[step];
+  const auto sequence = slot.sequence.load(std::memory_order_relaxed);
+  slot.sequence.store(sequence + 1ULL, std::memory_order_relaxed);
+
+  tally.raw.store(tally.raw.load(std::memory_order_relaxed) + 1LL, std::memory_order_release);
+
+  double sumw = tally.sumw.load(std::memory_order_relaxed), cw = tally.cw.load(std::memory_order_relaxed);
+  double y = weight - cw, t = sumw + y;
+  tally.cw.store((t - sumw) - y, std::memory_order_release);
+  tally.sumw.store(t, std::memory_order_release);
+
+  double sumw2 = tally.sumw2.load(std::memory_order_relaxed), cw2 = tally.cw2.load(std::memory_order_relaxed);
+  y = (weight * weight) - cw2; t = sumw2 + y;
+  tally.cw2.store((t - sumw2) - y, std::memory_order_release);
+  tally.sumw2.store(t, std::memory_order_release);
+
+  slot.sequence.store(sequence + 2ULL, std::memory_order_release);
+}
+
+
+
+std::vector<Framework::Cutflow::Counter> Framework::Cutflow::read(const Slot &slot)
+{
+  std::vector<Counter> v_count(slot.n);
+  while (true) {
+    const auto before = slot.sequence.load(std::memory_order_acquire);
+    if (before & 1ULL) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    for (int iS = 0; iS < slot.n; ++iS) {
+      const auto &tally = slot.v_tally[iS];
+      v_count[iS].raw = tally.raw.load(std::memory_order_acquire);
+      v_count[iS].sumw = tally.sumw.load(std::memory_order_acquire);
+      v_count[iS].cw = tally.cw.load(std::memory_order_acquire);
+      v_count[iS].sumw2 = tally.sumw2.load(std::memory_order_acquire);
+      v_count[iS].cw2 = tally.cw2.load(std::memory_order_acquire);
+    }
+
+    // the acquire loads above keep the sequence number from being read again before them
+    if (slot.sequence.load(std::memory_order_relaxed) == before)
+      return v_count;
+  }
+}
@@ -0,0 +1,135 @@
+#ifndef FWK_CUTFLOW_H
+#define FWK_CUTFLOW_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: raw and weighted event counts surviving each step of an analyzer i.e. a cutflow
+// note: counting is done into per-thread slots which are merged only when the result is requested
+// note: a slot is written only by its thread, under a sequence number that lets counts() read it consistently meanwhile (a seqlock)
+// note: weighted sums use Kahan compensation, so that 1e8 small weights still add up correctly in a double
+
+#include "Heap.h"
+
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "TFile.h"
+#include "TH1D.h"
+
+namespace Framework {
+  class Cutflow {
+  public:
+    /// the per-step counter
+    /// sumw and sumw2 are Kahan-compensated sums, with compensation terms cw and cw2
+    struct Counter {
+      long long raw = 0LL;
+      double sumw = 0., cw = 0.;
+      double sumw2 = 0., cw2 = 0.;
+    };
+
+    /// no default constructor
+    Cutflow() = delete;
+
+    /// constructor
+    /// name is used as prefix for the histograms when saving
+    /// reserve_ is an estimate of the number of steps
+    Cutflow(const std::string &name_, int reserve_ = 8);
+
+    /// add a step to the cutflow
+    /// returns the index of the step, to be used in count()
+    /// throws if a step with the same name already exists
+    /// the steps are fixed once counting has started, so this throws if called after the first count()
+    int add_step(const std::string &step);
+
+    /// index of a step, -1 if not found
+    int step_index(const std::string &step) const;
+
+    /// number of steps
+    int n_steps() const;
+
+    /// count one event passing a step with a given weight
+    /// this is the hot path, to be called from within the analyzer
+    /// throws if the step is not one returned by add_step()
+    void count(int step, double weight = 1.);
+
+    /// the counts summed over all thread slots
+    /// safe to call while other threads are counting, e.g. by a Snapshot, each slot being read as of between two counts
+    std::vector<Counter> counts() const;
+
+    /// merge the counts from another cutflow having the same steps
+    /// e.g. one made by a separate job
+    void merge(const Cutflow &other);
+
+    /// add counts, one per step, made elsewhere e.g. those read back from a snapshot
+    void add(const std::vector<Counter> &v_count);
+
+    /// print the cutflow as a table
+    void print(std::ostream &out = std::cout) const;
+
+    /// make histograms of the cutflow, with one bin per step
+    /// the raw version has the raw counts, the other the weighted sums and sqrt(sumw2) as error
+    /// the two are told apart from other histograms by their titles, see is_raw()
+    std::unique_ptr<TH1D> histogram(bool raw = false) const;
+
+    /// whether a histogram is the raw version of a cutflow histogram, e.g. as read back from a file
+    /// these hold numbers of events, so they are not to be scaled along with the others when merging
+    static bool is_raw(const TH1 &hist);
+
+    /// save the cutflow histograms into a ROOT file
+    /// by default the file is updated, so that the cutflow sits in the same file as Histogram::save_as
+    void save_as(const std::string &filename, const std::string &mode = "update") const;
+
+    /// name of the cutflow
+    std::string name;
+
+  protected:
+    /// a counter as held in the slots, which other threads read while it is counted into
+    struct Tally {
+      std::atomic<long long> raw = 0LL;
+      std::atomic<double> sumw = 0., cw = 0.;
+      std::atomic<double> sumw2 = 0., cw2 = 0.;
+    };
+
+    /// the counters of one thread, one per step
+    /// sequence is odd while a count is being written, and advances by 2 with every count
+    struct Slot {
+      Slot(std::thread::id thread_, int n_);
+
+      std::thread::id thread;
+      int n;
+      std::unique_ptr<Tally[]> v_tally;
+      std::atomic<unsigned long long> sequence = 0ULL;
+    };
+
+    /// get the slot belonging to the calling thread, registering it if needed
+    Slot& slot();
+
+    /// add one weight into a counter of a slot, by the thread owning it
+    static void accumulate(Slot &slot, int step, double weight);
+
+    /// read the counters of a slot, retrying until they are read between two counts
+    static std::vector<Counter> read(const Slot &slot);
+
+    /// unique id of the instance, indexing the thread-local slot cache
+    const unsigned long long id;
+
+    /// step names
+    std::vector<std::string> v_step;
+
+    /// per-thread counters, plus those added by add() and merge() in slots of no thread
+    std::vector<std::unique_ptr<Slot>> v_slot;
+
+    /// whether any thread has started counting, after which the steps are fixed
+    bool counting;
+
+    /// guard for slot registration and the steps
+    mutable std::mutex mutex;
+  };
+}
+
+#include "Cutflow.cc"
+
+#endif
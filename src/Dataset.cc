@@ -14,6 +14,13 @@ Framework::Dataset<Tree>::Dataset(const std::string &name_, const std::string &t
 {
   tree_ptr = nullptr;
   v_weight = {};
+  snapshot = nullptr;
+  progress = nullptr;
+  progress_source = nullptr;
+  memory = nullptr;
+  prescan_thread = 0;
+  cache_codec = ColumnCache::Codec::none;
+  range = {-1LL, -1LL};
 
   if (!v_file.empty())
     evaluate();
@@ -140,17 +147,238 @@ Framework::Dataset<Tree> Framework::Dataset<Tree>::split()
 
 
 
+template <typename Tree>
+void Framework::Dataset<Tree>::shard(int n, int i)
+{
+  if (n < 1 or i < 0 or i >= n)
+    throw std::invalid_argument( "ERROR: Dataset::shard: shard " + std::to_string(i) + " out of " + std::to_string(n) + 
+                                 " is not a valid shard. Expecting n > 0 and 0 <= i < n!!" );
+
+  // global cluster boundaries, including the total number of entries at the end
+  std::vector<long long> v_boundary;
+  long long offset = 0LL;
+  for (const auto &info : catalogue()) {
+    for (auto cluster : info.v_cluster)
+      v_boundary.emplace_back(offset + cluster);
+    offset += info.entries;
+  }
+  v_boundary.emplace_back(offset);
+
+  // the shard edges are the boundaries nearest to the ideal equal splitting
+  // as the same edge is used as end of shard i - 1 and start of shard i, the shards cover the dataset exactly once
+  auto f_edge = [&v_boundary, total = offset, n] (int k) -> long long {
+    const long long ideal = (total * k) / n;
+    auto iB = std::lower_bound(std::begin(v_boundary), std::end(v_boundary), ideal);
+    if (iB == std::end(v_boundary))
+      return total;
+
+    if (iB != std::begin(v_boundary) and ideal - *std::prev(iB) < *iB - ideal)
+      --iB;
+
+    return *iB;
+  };
+
+  range = {f_edge(i), f_edge(i + 1)};
+  std::cout << "Dataset " << name << " shard " << i << "/" << n << ": entries [" << range.first << ", " << range.second << ")" << std::endl;
+}
+
+
+
+template <typename Tree>
+void Framework::Dataset<Tree>::shard(const std::string &spec)
+{
+  const auto iSl = spec.find('/');
+  if (iSl == std::string::npos)
+    throw std::invalid_argument( "ERROR: Dataset::shard: shard specification " + spec + " is not of the form i/n!!" );
+
+  shard(std::stoi(spec.substr(iSl + 1)), std::stoi(spec.substr(0, iSl)));
+}
+
+
+
+template <>
+void Framework::Dataset<TChain>::prescan(const std::vector<std::string> &v_counter, int nthread)
+{
+  if (v_file.empty())
+    return;
+
+  // the catalogue is made by the first scan, and the maximum of a counter by the first scan asking for it
+  const bool make = v_catalogue.empty();
+  std::vector<std::string> v_new;
+  for (const auto &counter : v_counter) {
+    if (counter != "" and std::find(std::begin(v_new), std::end(v_new), counter) == std::end(v_new) and (make or counter_maximum(counter) < 0))
+      v_new.emplace_back(counter);
+  }
+
+  if (!make and v_new.empty())
+    return;
+
+  std::vector<FileInfo> v_info = (make) ? std::vector<FileInfo>(v_file.size()) : v_catalogue;
+  std::vector<std::string> v_error(v_file.size());
+
+  // the maximum is part of the leaf metadata, so no entry has to be read for it
+  auto scan = [this, make, &v_new, &v_info, &v_error] (int iF) {
+    const auto &file = v_file[iF];
+    std::unique_ptr<TFile> tfile(TFile::Open(file.c_str(), "read"));
+    if (tfile == nullptr or tfile->IsZombie()) {
+      v_error[iF] = "unable to read the file " + file;
+      return;
+    }
+
+    TTree *tree = nullptr;
+    tfile->GetObject(tree_name.c_str(), tree);
+    if (tree == nullptr) {
+      v_error[iF] = "tree " + tree_name + " is not in the file " + file;
+      return;
+    }
+
+    auto &info = v_info[iF];
+    if (make) {
+      info = FileInfo{file, tree->GetEntries(), static_cast<long long>(tfile->GetModificationDate().Convert()), {}, {}};
+      auto iterator = tree->GetClusterIterator(0);
+      for (auto start = iterator.Next(); start < info.entries; start = iterator.Next())
+        info.v_cluster.emplace_back(start);
+    }
+
+    for (const auto &counter : v_new) {
+      TLeaf *leaf = tree->GetLeaf(counter.c_str());
+      if (leaf == nullptr) {
+        v_error[iF] = "counter " + counter + " is not in the file " + file;
+        return;
+      }
+
+      info.v_maximum.emplace_back(counter, leaf->GetMaximum());
+    }
+  };
+
+  // each thread takes every nthread-th file, as in exec/merge_output.cc
+  nthread = std::max(1, std::min(nthread, int(v_file.size())));
+  if (nthread == 1) {
+    for (int iF = 0; iF < v_file.size(); ++iF)
+      scan(iF);
+  }
+  else {
+    ROOT::EnableThreadSafety();
+
+    std::vector<std::thread> v_thread;
+    for (int iT = 0; iT < nthread; ++iT) {
+      v_thread.emplace_back([iT, nthread, nfile = int(v_file.size()), &scan] () {
+          for (int iF = iT; iF < nfile; iF += nthread)
+            scan(iF);
+        });
+    }
+
+    for (auto &thread : v_thread)
+      thread.join();
+  }
+
+  // the catalogue is kept as it was if any file fails
+  for (const auto &error : v_error) {
+    if (error != "")
+      throw std::runtime_error( "ERROR: Dataset::prescan: " + error + ". Aborting!!" );
+  }
+
+  v_catalogue = std::move(v_info);
+}
+
+
+
+template <>
+const std::vector<Framework::Dataset<TChain>::FileInfo>& Framework::Dataset<TChain>::catalogue()
+{
+  if (v_catalogue.empty())
+    prescan({});
+
+  return v_catalogue;
+}
+
+
+
+template <>
+const std::vector<Framework::Dataset<TTree>::FileInfo>& Framework::Dataset<TTree>::catalogue()
+{
+  // text files are read into a single in-memory tree, so the catalogue is made from that tree
+  if (!v_catalogue.empty() or tree_ptr == nullptr)
+    return v_catalogue;
+
+  FileInfo info{"", tree_ptr->GetEntries(), 0LL, {}, {}};
+  auto iterator = tree_ptr->GetClusterIterator(0);
+  for (auto start = iterator.Next(); start < info.entries; start = iterator.Next())
+    info.v_cluster.emplace_back(start);
+
+  v_catalogue.emplace_back(std::move(info));
+  return v_catalogue;
+}
+
+
+
+template <>
+void Framework::Dataset<TTree>::prescan(const std::vector<std::string> &v_counter, int)
+{
+  // text files are read into a single in-memory tree, so there is only that tree to scan
+  if (catalogue().empty())
+    return;
+
+  for (const auto &counter : v_counter) {
+    if (counter == "" or counter_maximum(counter) > -1)
+      continue;
+
+    TLeaf *leaf = tree_ptr->GetLeaf(counter.c_str());
+    if (leaf == nullptr)
+      throw std::runtime_error( "ERROR: Dataset::prescan: counter " + counter + " is not in the tree. Aborting!!" );
+
+    v_catalogue.front().v_maximum.emplace_back(counter, leaf->GetMaximum());
+  }
+}
+
+
+
+template <typename Tree>
+int Framework::Dataset<Tree>::counter_maximum(const std::string &counter) const
+{
+  if (v_catalogue.empty())
+    return -1;
+
+  int maximum = -1;
+  for (const auto &info : v_catalogue) {
+    auto iM = std::find_if(std::begin(info.v_maximum), std::end(info.v_maximum), [&counter] (const auto &max) {return max.first == counter;});
+    if (iM == std::end(info.v_maximum))
+      return -1;
+
+    maximum = std::max(maximum, iM->second);
+  }
+
+  return maximum;
+}
+
+
+
 template <typename Tree>
 long long Framework::Dataset<Tree>::current_entry(long long entry) const
 {
   if (tree_ptr == nullptr)
     return -1;
 
+  // the collections read off the cache by the global entry, so the tree is left alone
+  if (cache != nullptr)
+    return entry;
+
   return tree_ptr->LoadTree(entry);
 }
 
 
 
+template <typename Tree>
+std::pair<long long, long long> Framework::Dataset<Tree>::entry_range() const
+{
+  if (range.first > -1LL)
+    return range;
+
+  return {0LL, (tree_ptr == nullptr) ? 0LL : tree_ptr->GetEntries()};
+}
+
+
+
 template <typename Tree>
 const std::unique_ptr<Tree>& Framework::Dataset<Tree>::tree() const
 {
@@ -173,9 +401,20 @@ double Framework::Dataset<Tree>::get_weight(const std::string &wgt_name) const
 
 
 
+template <typename Tree>
+bool Framework::Dataset<Tree>::has_weight(const std::string &wgt_name) const
+{
+  return std::any_of(std::begin(v_weight), std::end(v_weight), [&wgt_name] (const auto &weight) {return weight.first == wgt_name;});
+}
+
+
+
 template <>
 void Framework::Dataset<TChain>::evaluate(int index)
 {
+  v_catalogue.clear();
+  range = {-1LL, -1LL};
+
   if (tree_ptr == nullptr) {
     tree_ptr = std::make_unique<TChain>(tree_name.c_str());
     //tree_ptr->SetImplicitMT(false);
@@ -195,6 +434,9 @@ void Framework::Dataset<TChain>::evaluate(int index)
 template <>
 void Framework::Dataset<TTree>::evaluate(int index)
 {
+  v_catalogue.clear();
+  range = {-1LL, -1LL};
+
   static bool flag_struct = false;
   if (!flag_struct and tree_struct == "") {
     // TODO something about logging the error
@@ -242,8 +484,50 @@ void Framework::Dataset<Tree>::associate(Collections &...colls)
   // so associate will fail without it
   tree_ptr->GetEntries();
 
+  if (prescan_thread > 0)
+    prescan({colls.get_counter_name()...}, prescan_thread);
+
+  if (cache != nullptr) {
+    std::vector<ColumnCache::Column> v_column;
+    (colls.columns(v_column), ...);
+
+    // the signatures tell whether the cache on disk was made of these files and these branches
+    auto catalogue_hash = ColumnCache::hash(tree_name);
+    for (const auto &info : catalogue())
+      catalogue_hash = ColumnCache::hash(info.name + ":" + std::to_string(info.entries) + ":" + std::to_string(info.modified), catalogue_hash);
+
+    auto v_sorted = v_column;
+    std::sort(std::begin(v_sorted), std::end(v_sorted), [] (const auto &c1, const auto &c2) {return c1.branch < c2.branch;});
+    auto column_hash = ColumnCache::hash(std::to_string(static_cast<std::uint32_t>(cache_codec)));
+    for (const auto &col : v_sorted)
+      column_hash = ColumnCache::hash(col.branch + ":" + std::to_string(col.size) + ":" + col.counter, column_hash);
+
+    if (!cache->open(catalogue_hash, column_hash)) {
+      std::cout << "Making the column cache " << cache->path << " of " << v_column.size() << " branches..." << std::endl;
+      cache->build(tree_name, catalogue(), v_column, cache_codec, catalogue_hash, column_hash);
+
+      if (!cache->open(catalogue_hash, column_hash))
+        throw std::runtime_error( "ERROR: Dataset::associate: unable to read the column cache " + cache->path + " just made. Aborting!!" );
+    }
+  }
+
   (colls.associate(*this), ...);
-  allocator.set_allocator([&colls...] () { (colls.reassociate(), ...); });
+  if (memory != nullptr)
+    memory->add_group(colls...);
+
+  allocator.set_allocator([this, io = io.get(), &colls...] () {
+      if (io != nullptr)
+        io->change_file();
+
+      if (progress_source != nullptr and tree_ptr->GetCurrentFile() != nullptr)
+        progress->set_file(*progress_source, tree_ptr->GetCurrentFile()->GetName());
+
+      // opened before the reassociation, so that the stage includes any growth it makes
+      if (memory != nullptr and tree_ptr->GetCurrentFile() != nullptr)
+        memory->begin_stage(name + ": " + tree_ptr->GetCurrentFile()->GetName());
+
+      (colls.reassociate(), ...);
+    });
   tree_ptr->SetNotify(&allocator);
 }
 
@@ -259,14 +543,160 @@ void Framework::Dataset<Tree>::set_analyzer(Analyzer analyzer_)
   static_assert(std::is_same_v<typename Traits::result_type, void>, 
                 "ERROR: Dataset::set_analyzer: currently non-void return type is not supported!!");
 
-  if (!analyzer)
-    analyzer = std::function<void(long long)>(analyzer_);
+  if (analyzer)
+    return;
+
+#ifdef FWK_PROFILE
+  // every call is an event as far as the profiler is concerned
+  analyzer = [analyzer_, label = name] (long long entry) mutable {
+    {
+      FWK_PROFILE_SCOPE(analyzer, label.c_str());
+      analyzer_(entry);
+    }
+    FWK_PROFILE_EVENT();
+  };
+#else
+  analyzer = std::function<void(long long)>(analyzer_);
+#endif
+}
+
+
+
+template <typename Tree>
+template <typename Analyzer, typename ...Batches>
+void Framework::Dataset<Tree>::set_batch_analyzer(int size, Analyzer analyzer_, Batches &...batches)
+{
+  static_assert(sizeof...(batches) > 0, "ERROR: Dataset::set_batch_analyzer makes no sense when called without batches!!");
+  static_assert(std::is_invocable_r_v<void, Analyzer, Batches &...>,
+                "ERROR: Dataset::set_batch_analyzer: the analyzer must take the refs to the batches, in the order given!!");
+
+  if (size < 1)
+    throw std::invalid_argument( "ERROR: Dataset::set_batch_analyzer: the batch size must be positive!!" );
+
+  if (analyzer)
+    return;
+
+  // shared by the analyzer, which runs it whenever the batches are full, and flush
+  auto run = std::make_shared<std::function<void()>>([analyzer_, &batches...] () mutable {
+      if (std::get<0>(std::forward_as_tuple(batches...)).n_events() == 0)
+        return;
+
+      (batches.seal(), ...);
+      analyzer_(batches...);
+      (batches.clear(), ...);
+    });
+
+  set_analyzer([run, size, &batches...] (long long entry) {
+      (batches.append(entry), ...);
+      if (std::get<0>(std::forward_as_tuple(batches...)).n_events() >= size)
+        (*run)();
+    });
+  flush = [run] () { (*run)(); };
+}
+
+
+
+template <typename Tree>
+void Framework::Dataset<Tree>::add_cutflow(Cutflow &cutflow)
+{
+  auto iC = std::find_if(std::begin(v_cutflow), std::end(v_cutflow), [&cutflow] (const auto &cut) {return &cut.get() == &cutflow;});
+  if (iC == std::end(v_cutflow))
+    v_cutflow.emplace_back(std::ref(cutflow));
+}
+
+
+
+template <typename Tree>
+void Framework::Dataset<Tree>::set_snapshot(Snapshot &snapshot_)
+{
+  snapshot = &snapshot_;
+}
+
+
+
+template <typename Tree>
+void Framework::Dataset<Tree>::enable_io_stats(const std::string &json)
+{
+  if (tree_ptr == nullptr)
+    throw std::runtime_error( "ERROR: Dataset::enable_io_stats should not be called before assigning the files to be analyzed!!" );
+
+  if (allocator)
+    throw std::runtime_error( "ERROR: Dataset::enable_io_stats should be called before Dataset::associate!!" );
+
+  if (io == nullptr)
+    io = std::make_unique<IOStats>(tree_ptr.get());
+  io_json = json;
+}
+
+
+
+template <typename Tree>
+Framework::IOStats* Framework::Dataset<Tree>::io_stats() const
+{
+  return io.get();
+}
+
+
+
+template <typename Tree>
+void Framework::Dataset<Tree>::enable_prescan(int nthread)
+{
+  if (allocator)
+    throw std::runtime_error( "ERROR: Dataset::enable_prescan should be called before Dataset::associate!!" );
+
+  prescan_thread = std::max(1, nthread);
+}
+
+
+
+template <typename Tree>
+void Framework::Dataset<Tree>::set_progress(Progress &progress_)
+{
+  if (progress == &progress_)
+    return;
+
+  progress = &progress_;
+  progress_source = &progress->add_source(name);
 }
 
 
 
 template <typename Tree>
-void Framework::Dataset<Tree>::analyze(long long total, long long skip) const
+void Framework::Dataset<Tree>::set_memory(Memory &memory_)
+{
+  if (allocator)
+    throw std::runtime_error( "ERROR: Dataset::set_memory should be called before Dataset::associate!!" );
+
+  memory = &memory_;
+}
+
+
+
+template <typename Tree>
+void Framework::Dataset<Tree>::enable_cache(const std::string &path, bool compress)
+{
+  if constexpr (!std::is_same_v<Tree, TChain>)
+    throw std::runtime_error( "ERROR: Dataset::enable_cache: the column cache is only available for TChain datasets!!" );
+
+  if (allocator)
+    throw std::runtime_error( "ERROR: Dataset::enable_cache should be called before Dataset::associate!!" );
+
+  cache = std::make_unique<ColumnCache>(path);
+  cache_codec = (compress) ? ColumnCache::Codec::lz4 : ColumnCache::Codec::none;
+}
+
+
+
+template <typename Tree>
+Framework::ColumnCache* Framework::Dataset<Tree>::column_cache() const
+{
+  return cache.get();
+}
+
+
+
+template <typename Tree>
+void Framework::Dataset<Tree>::analyze(long long total, long long skip, bool resume) const
 {
   if (tree_ptr == nullptr)
     throw std::runtime_error( "ERROR: Dataset::analyze should not be called before assigning the files to be analyzed!!" );
@@ -277,14 +707,114 @@ void Framework::Dataset<Tree>::analyze(long long total, long long skip) const
   if (!analyzer)
     throw std::runtime_error( "ERROR: Dataset::analyze should not be called before calling Dataset::set_analyzer!!" );
 
-  const auto dEvt = (total > 0LL and total <= tree_ptr->GetEntries()) ? total : tree_ptr->GetEntries();
-  std::cout << "Processing " << dEvt << " events..." << std::endl;
-  if (skip > 0LL)
-    std::cout << "Skipping " << skip << " events..." << std::endl;
+  // total and skip are counted from the start of the range, which is the whole dataset unless it is sharded
+  const auto [first, last] = entry_range();
+  const auto dEvt = (total > 0LL and first + total <= last) ? first + total : last;
+  auto bEvt = (skip > 0LL) ? first + skip : first;
+  std::cout << "Processing " << dEvt - first << " events..." << std::endl;
+
+  // the cutflows of the dataset are part of its output, so they are snapshot along with whatever else was registered
+  if (snapshot != nullptr) {
+    for (const auto &cutflow : v_cutflow)
+      snapshot->add_cutflow(cutflow.get());
+  }
+
+  if (resume and snapshot != nullptr) {
+    const auto last_snapshot = snapshot->restore();
+    if (last_snapshot > -1LL) {
+      std::cout << "Resuming from snapshot " << snapshot->filename << " after entry " << last_snapshot << "..." << std::endl;
+      bEvt = std::max(bEvt, last_snapshot + 1LL);
+    }
+  }
+
+  if (bEvt > first)
+    std::cout << "Skipping " << bEvt - first << " events..." << std::endl;
+
+  // keep the read-ahead within the range, so that no baskets outside of it are read
+  tree_ptr->SetCacheEntryRange(bEvt, dEvt);
 
-  for (auto cEvt = (skip > 0LL) ? skip : 0LL; cEvt < dEvt; ++cEvt)
+  // a reporter already running belongs to whoever started it
+  const bool own_progress = progress != nullptr and !progress->running();
+  if (own_progress)
+    progress->start(dEvt - bEvt);
+
+  if (snapshot != nullptr)
+    snapshot->start(bEvt);
+
+  if (snapshot == nullptr) {
+    for (auto cEvt = bEvt; cEvt < dEvt; ++cEvt) {
+      analyzer(current_entry(cEvt));
+      if (progress_source != nullptr)
+        progress_source->events.fetch_add(1LL, std::memory_order_relaxed);
+    }
+  }
+  else {
+    for (auto cEvt = bEvt; cEvt < dEvt; ++cEvt) {
+      analyzer(current_entry(cEvt));
+      if (progress_source != nullptr)
+        progress_source->events.fetch_add(1LL, std::memory_order_relaxed);
+
+      // the events held in a batch are analyzed before the snapshot, which takes them as done
+      if (snapshot->due(cEvt)) {
+        if (flush)
+          flush();
+        snapshot->take(cEvt);
+      }
+    }
+  }
+
+  if (flush)
+    flush();
+
+  if (snapshot != nullptr)
+    snapshot->finish();
+
+  if (own_progress)
+    progress->stop();
+  std::cout << "Processed " << dEvt - first << " events!" << std::endl;
+
+  for (const auto &cutflow : v_cutflow)
+    cutflow.get().print();
+
+  if (io != nullptr) {
+    io->finish();
+    io->print();
+    if (io_json != "")
+      io->write_json(io_json);
+  }
+
+  if (memory != nullptr) {
+    memory->end_stage();
+    memory->print();
+  }
+
+#ifdef FWK_PROFILE
+  Profiler::instance().print();
+#endif
+}
+
+
+
+template <typename Tree>
+void Framework::Dataset<Tree>::analyze_range(long long first, long long last) const
+{
+  if (tree_ptr == nullptr or !allocator or !analyzer)
+    throw std::runtime_error( "ERROR: Dataset::analyze_range: dataset " + name + " is not ready to be analyzed. Aborting!!" );
+
+  tree_ptr->SetCacheEntryRange(first, last);
+
+  for (auto cEvt = first; cEvt < last; ++cEvt) {
     analyzer(current_entry(cEvt));
-  std::cout << "Processed " << dEvt << " events!" << std::endl;
+    if (progress_source != nullptr)
+      progress_source->events.fetch_add(1LL, std::memory_order_relaxed);
+  }
+
+  if (flush)
+    flush();
+
+  // so that the time between the calls is not counted
+  if (io != nullptr)
+    io->finish();
 }
 
 
@@ -292,8 +822,10 @@ void Framework::Dataset<Tree>::analyze(long long total, long long skip) const
 template <typename Tree>
 void Framework::Dataset<Tree>::reset()
 {
-  tree_ptr->ResetBranchAddresses();
-  tree_ptr->Reset();
+  if (tree_ptr != nullptr) {
+    tree_ptr->ResetBranchAddresses();
+    tree_ptr->Reset();
+  }
 
   v_file.clear();
   v_file.shrink_to_fit();
@@ -6,8 +6,18 @@
 // short: handling of datasets i.e. sets of files to be treated as single units
 
 #include "Allocator.h"
+#include "Cutflow.h"
+#include "Snapshot.h"
+#include "Profiler.h"
+#include "IOStats.h"
+#include "Progress.h"
+#include "Memory.h"
+#include "ColumnCache.h"
 #include "TTree.h"
 #include "TChain.h"
+#include "TFile.h"
+#include "TLeaf.h"
+#include "TROOT.h"
 
 #include <iostream>
 
@@ -20,6 +30,18 @@ namespace Framework {
   template <typename Tree>
   class Dataset {
   public:
+    /// per-file information used in planning how the dataset is processed
+    /// v_cluster holds the first entries of the TTree clusters, local to the file
+    /// modified is the modification time of the file, as a UNIX time, 0 if not known
+    /// v_maximum holds the maximum of the counter branches in the file, for those that have been prescanned
+    struct FileInfo {
+      std::string name;
+      long long entries;
+      long long modified;
+      std::vector<long long> v_cluster;
+      std::vector<std::pair<std::string, int>> v_maximum;
+    };
+
     /// constructor
     Dataset(const std::string &name_, const std::string &tree_name_, 
             const std::string &tree_struct_ = "", char tree_delim_ = ' ', 
@@ -62,13 +84,37 @@ namespace Framework {
     /// both datasets will keep the same set of weights
     Dataset split();
 
+    /// restrict the analysis to the i-th out of n shards (0 <= i < n) of the dataset
+    /// the shards are contiguous ranges of entries, balanced in the number of entries and aligned to the cluster boundaries
+    /// so that no job has to read a basket belonging to another shard
+    void shard(int n, int i);
+
+    /// the same, with the shard given as a string "i/n" e.g. from the command line
+    void shard(const std::string &spec);
+
+    /// the catalogue of the files, made on first call
+    const std::vector<FileInfo>& catalogue();
+
+    /// read the maximum of the given counter branches in every file into the catalogue, with the files spread over nthread threads
+    /// counters already prescanned are skipped, and so are empty names
+    void prescan(const std::vector<std::string> &v_counter, int nthread = 1);
+
+    /// the maximum of a counter branch over all the files, -1 if it has not been prescanned
+    int counter_maximum(const std::string &counter) const;
+
     /// getter methods
     long long current_entry(long long entry) const;
 
+    /// the range of entries [first, last) to be analyzed
+    std::pair<long long, long long> entry_range() const;
+
     const std::unique_ptr<Tree>& tree() const;
 
     double get_weight(const std::string &wgt_name) const;
 
+    /// whether a weight of that name has been added, as get_weight returns 0 for those that have not
+    bool has_weight(const std::string &wgt_name) const;
+
     /// add the files to the Tree and evaluate entries
     /// argument index can be 0 for evaluate everything, or -1 for evaluate only the last v_file element
     void evaluate(int index = 0);
@@ -83,9 +129,63 @@ namespace Framework {
     template <typename Analyzer>
     void set_analyzer(Analyzer analyzer_);
 
+    /// provide the analysis function for the batch mode, in place of the above, see Batch.h
+    /// every entry populates the groups of the batches and appends them, in the order given, so a group must come after those it is made of
+    /// the analyzer is called with the refs to the batches once they hold size events, and once more for the events left at the end
+    /// the batches are cleared after every call, so they may be freely selected on within it
+    template <typename Analyzer, typename ...Batches>
+    void set_batch_analyzer(int size, Analyzer analyzer_, Batches &...batches);
+
+    /// register a cutflow that is filled by the analyzer
+    /// its table is printed at the end of analyze, after merging the per-thread counts
+    void add_cutflow(Cutflow &cutflow);
+
+    /// take periodic snapshots of the output during analyze, according to the snapshot policy
+    void set_snapshot(Snapshot &snapshot_);
+
+    /// record what is read off the files, see IOStats.h
+    /// to be called before associate, as the collections register their branches then
+    /// the statistics are printed at the end of analyze, and also written as json if a file name is given
+    void enable_io_stats(const std::string &json = "");
+
+    /// the I/O statistics, null unless enabled
+    IOStats* io_stats() const;
+
+    /// prescan the counters of the collections when associating them, with nthread threads
+    /// so that each collection is sized once for the largest element count in the whole dataset
+    /// rather than grown by reassociate, together with the rebinding of its branches, as larger files are met
+    /// to be called before associate
+    void enable_prescan(int nthread = std::thread::hardware_concurrency());
+
+    /// report the progress of the analysis to a progress reporter, see Progress.h
+    /// analyze starts and stops the reporting by itself, unless it is already running e.g. under the Scheduler
+    void set_progress(Progress &progress_);
+
+    /// account for the memory of the analysis, see Memory.h
+    /// to be called before associate, which registers the collections; other groups are to be added to the memory directly
+    /// a stage is opened each time the dataset moves to another file, and the report is printed at the end of analyze
+    void set_memory(Memory &memory_);
+
+    /// read the branches of the collections off a local columnar cache at path, see ColumnCache.h
+    /// associate makes the cache if there is none, or if the files or the branches have changed since it was made
+    /// compress stores the blocks LZ4-compressed, for a smaller cache at the cost of decompressing each cluster as it is entered
+    /// to be called before associate, and only for TChain datasets
+    void enable_cache(const std::string &path, bool compress = false);
+
+    /// the column cache, null unless enabled
+    ColumnCache* column_cache() const;
+
     /// perform the analysis
     /// can also cap the total events ran, or skip some
-    void analyze(long long total = -1LL, long long skip = -1LL) const;
+    /// resume restarts from the entry after the last one in the snapshot, whose content is added back to the histograms and cutflows
+    /// it is ignored if no snapshot is set, or there is no snapshot to resume from
+    /// when compiled with FWK_PROFILE, the time per event spent in each stage is printed at the end, see Profiler.h
+    void analyze(long long total = -1LL, long long skip = -1LL, bool resume = false) const;
+
+    /// run the analyzer over the entries [first, last) only, without any of the bookkeeping of analyze
+    /// i.e. no printouts, snapshots or cutflow summary; meant for the Scheduler, which calls it once per task
+    /// the I/O statistics, if enabled, are still recorded, and can be printed through io_stats() afterwards
+    void analyze_range(long long first, long long last) const;
 
     /// reset Tree state, but keep the info strings
     void reset();
@@ -106,6 +206,15 @@ namespace Framework {
     /// filenames
     std::vector<std::string> v_file;
 
+    /// file catalogue, see catalogue()
+    std::vector<FileInfo> v_catalogue;
+
+    /// threads to prescan the counters with on associate, none if 0
+    int prescan_thread;
+
+    /// the range of entries set by shard, {-1, -1} if the whole dataset is to be analyzed
+    std::pair<long long, long long> range;
+
     /// ptr to the tree
     std::unique_ptr<Tree> tree_ptr;
 
@@ -116,6 +225,33 @@ namespace Framework {
     /// see Dataset::set_analyzer above for more info
     std::function<void(long long)> analyzer;
 
+    /// in batch mode, runs the analyzer over the events not yet analyzed, if any
+    std::function<void()> flush;
+
+    /// cutflows to be reported at the end of the analysis
+    std::vector<std::reference_wrapper<Cutflow>> v_cutflow;
+
+    /// snapshot policy, if any
+    Snapshot *snapshot;
+
+    /// I/O statistics if enabled, and where to write them
+    std::unique_ptr<IOStats> io;
+
+    std::string io_json;
+
+    /// progress reporter if any, and the counter of this dataset in it
+    Progress *progress;
+
+    Progress::Source *progress_source;
+
+    /// memory accounting if any
+    Memory *memory;
+
+    /// column cache if enabled, and how its blocks are to be stored when it is made
+    std::unique_ptr<ColumnCache> cache;
+
+    ColumnCache::Codec cache_codec;
+
     /// weights associated to the dataset
     /// mainly in view of MC samples: xsec and such
     std::vector<std::pair<std::string, double>> v_weight;
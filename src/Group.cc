@@ -6,7 +6,10 @@ template <typename... Ts>
 Framework::Group<Ts...>::Group(const std::string &name_, int counter_) :
 name(name_),
 counter(counter_),
-selected(counter_)
+selected(counter_),
+n_populate(0ULL),
+peak(counter_),
+n_reallocate(0LL)
 {
   if (counter > 0) {
     for (int iC = 0; iC < counter; ++iC)
@@ -32,6 +35,14 @@ const int& Framework::Group<Ts...>::ref_to_n_elements() const
 
 
 
+template <typename ...Ts>
+int Framework::Group<Ts...>::n_populated_elements() const
+{
+  return counter;
+}
+
+
+
 template <typename ...Ts>
 int& Framework::Group<Ts...>::mref_to_n_elements()
 {
@@ -99,6 +110,9 @@ bool Framework::Group<Ts...>::transform_attribute(const std::string &attr, Funct
   const std::array<int, sizeof...(attrs)> iattrs = {inquire(attrs)...};
 
   auto f_apply = [f_loop, this, iattr = v_data.size(), iattrs] () -> void {
+    for (auto iA : iattrs)
+      fetch(iA);
+
     auto refs = std::tuple_cat(std::make_tuple(std::ref( std::get<std::vector<typename Traits::result_type>>(v_data[iattr]) )), 
                                tuple_of_ref( zip_1n(v_data, iattrs), Traits{}, std::make_index_sequence<Traits::arity>{}) );
 
@@ -127,6 +141,9 @@ std::vector<std::string> Framework::Group<Ts...>::attributes() const
 template <typename ...Ts>
 const std::vector<std::variant<std::vector<Ts>...>>& Framework::Group<Ts...>::data() const
 {
+  for (int iA = 0; iA < v_pending.size(); ++iA)
+    fetch(iA);
+
   return v_data;
 }
 
@@ -139,6 +156,7 @@ const std::variant<std::vector<Ts>...>& Framework::Group<Ts...>::operator()(cons
   if (iA == -1)
     throw std::invalid_argument( "ERROR: Group::get: requested attribute " + name + " is not within the group!!" );
 
+  fetch(iA);
   return v_data[iA];
 }
 
@@ -211,6 +229,8 @@ void Framework::Group<Ts...>::iterate(Function function, int begin, int end, Att
   if (!iA)
     throw std::invalid_argument( "ERROR: Group::iterate: some of the requested attributes are not within the group!!" );
 
+  (fetch(inquire(attrs)), ...);
+
   std::visit([&function, &begin, &end, this] (const auto &...vec) {
       for (int iE = begin; iE < end; ++iE)
         function(vec[this->v_index[iE]]...);
@@ -484,9 +504,61 @@ int Framework::Group<Ts...>::inquire(const std::string &name) const
 
 
 
+template <typename ...Ts>
+void Framework::Group<Ts...>::fetch(int attr) const
+{
+  // cleared before the call, as the evaluation may itself go through the accessors
+  if (attr > -1 and attr < v_pending.size() and v_pending[attr]) {
+    if (stale())
+      throw std::runtime_error( "ERROR: Group::fetch: attribute " + v_attr[attr].first + " of group " + name + 
+                                " is pending, but what it is computed from has changed since the group was populated!!" );
+
+    FWK_PROFILE_SCOPE(transform, name.c_str());
+    v_pending[attr] = 0;
+    v_attr[attr].second();
+  }
+}
+
+
+
+template <typename ...Ts>
+unsigned long long Framework::Group<Ts...>::generation() const
+{
+  return n_populate;
+}
+
+
+
+template <typename ...Ts>
+void Framework::Group<Ts...>::settle() const
+{
+  for (int iA = 0; iA < v_pending.size(); ++iA)
+    fetch(iA);
+}
+
+
+
+template <typename ...Ts>
+bool Framework::Group<Ts...>::stale() const
+{
+  return false;
+}
+
+
+
 template <typename ...Ts>
 void Framework::Group<Ts...>::reorder()
 {
+  // done while the element indices the dependents hold still point to the elements they were made from
+  for (auto dependent : v_dependent)
+    dependent->settle();
+
+  ++n_populate;
+
+  // pending attributes are evaluated in the element order they were populated in
+  for (int iA = 0; iA < v_pending.size(); ++iA)
+    fetch(iA);
+
   for (int iS = 0; iS < selected; ++iS) {
     if (iS != v_index[iS]) {
       for (auto &dat : v_data)
@@ -499,9 +571,32 @@ void Framework::Group<Ts...>::reorder()
 
 
 
+template <typename ...Ts>
+Framework::MemoryUsage Framework::Group<Ts...>::memory_usage() const
+{
+  MemoryUsage usage;
+  for (int iA = 0; iA < v_data.size(); ++iA) {
+    std::visit([&usage, &attr = v_attr[iA].first] (const auto &vec) {
+        usage.v_attribute.emplace_back(attr, sizeof(typename std::decay_t<decltype(vec)>::value_type), vec.capacity());
+      }, v_data[iA]);
+  }
+
+  usage.overhead = v_index.capacity() * sizeof(int);
+  usage.capacity = v_index.capacity();
+  usage.peak = peak;
+  usage.reallocations = n_reallocate;
+  return usage;
+}
+
+
+
 template <typename ...Ts>
 void Framework::Group<Ts...>::initialize(int init)
 {
+  // setting up the storage before any attribute is added is not a reallocation
+  if (init > v_index.capacity() and !v_data.empty())
+    ++n_reallocate;
+
   v_index.reserve(init);
 
   for (auto &dat : v_data)
@@ -514,6 +609,8 @@ template <typename ...Ts>
 template <typename Compare, typename ...Attributes>
 std::vector<int> Framework::Group<Ts...>::filter_helper(Compare &compare, Attributes &&...attrs) const
 {
+  (fetch(attrs), ...);
+
   std::vector<int> v_idx;
   std::visit([this, &v_idx, &compare] (const auto &...vec) {
       for (auto &index : this->v_index) {
@@ -531,6 +628,8 @@ template <typename ...Ts>
 template <typename Compare>
 std::vector<int> Framework::Group<Ts...>::sort_helper(Compare &compare, int attr) const
 {
+  fetch(attr);
+
   std::vector<int> v_idx;
   std::visit([this, &v_idx, &compare] (const auto &vec) {
       using VT = typename std::decay_t<decltype(vec)>::value_type;
@@ -7,6 +7,8 @@
 // note: attributes that are self-referencing e.g. GenPart_motherIdx can't be handled by iterate(); for this one needs to use operator()
 
 #include "Heap.h"
+#include "Profiler.h"
+#include "Memory.h"
 
 // https://stackoverflow.com/questions/670308/alternative-to-vectorbool
 class boolean {
@@ -25,6 +27,9 @@ class boolean {
 };
 
 namespace Framework {
+  template <int N, typename ...Ts>
+  class Aggregate;
+
   template <typename ...Ts>
   class Group {
     static_assert(unique_types<Ts...>, "ERROR: a Group must be initialized with unique types!");
@@ -32,6 +37,10 @@ namespace Framework {
                   "when bool is among the included types. For boolean attributes please use the 'boolean' type instead, which is a drop-in "
                   "replacement provided precisely to avoid this quirk of the standard.");
 
+    /// aggregates register themselves as dependents of their underlying groups, see v_dependent
+    template <int N, typename ...Us>
+    friend class Aggregate;
+
   public:
     using data_type = Types<Ts...>;
 
@@ -47,6 +56,9 @@ namespace Framework {
     /// ref instead of copy of the above
     const int& ref_to_n_elements() const;
 
+    /// number of elements as populated, regardless of any selection made with update_indices
+    int n_populated_elements() const;
+
     /// a mutable ref version
     /// can't be const if it's to be used to write TTree...
     /// might be worth considering to write TTree using copies rather than in-place references?
@@ -196,13 +208,28 @@ namespace Framework {
     /// returns the index where an attribute occurs
     int inquire(const std::string &name) const;
 
+    /// evaluate the attribute at the given index if it is pending, no-op otherwise
+    /// attributes are left pending by groups that evaluate them lazily e.g. Aggregate::set_lazy()
+    /// all the accessors above call this, so it is needed only when reading v_data by other means
+    /// throws if the attribute is pending but can no longer be evaluated, see stale()
+    void fetch(int attr) const;
+
     /// populate the Group data
+    /// implementations are expected to increment n_populate, see generation()
     virtual void populate(long long entry) = 0;
 
+    /// number of times the group has been populated or reordered so far
+    /// anything derived from the group data and cached across calls is stale when this changes
+    unsigned long long generation() const;
+
     /// reorder the group data such that selected elements occur in front
     /// selected elements are those whose index is in v_index
+    /// the pending attributes of the dependent groups are evaluated beforehand, as they read the elements by index
     void reorder();
 
+    /// memory held by the group, and how it has grown, see Memory.h
+    virtual MemoryUsage memory_usage() const;
+
     /// name of the group
     std::string name;
 
@@ -218,12 +245,28 @@ namespace Framework {
     template <typename Compare>
     std::vector<int> sort_helper(Compare &compare, int attr) const;
 
+    /// evaluate all pending attributes, called by the groups this one depends on before they are reordered
+    virtual void settle() const;
+
+    /// whether the pending attributes can no longer be evaluated, as what they are computed from has changed since
+    /// false unless overridden, consulted only when an attribute is pending
+    virtual bool stale() const;
+
     /// element counter before prefiltering
     int counter;
 
     /// element counter after prefiltering i.e. v_index.size()
     int selected;
 
+    /// see generation()
+    unsigned long long n_populate;
+
+    /// the most elements ever populated, to be updated by populate implementations alongside counter
+    int peak;
+
+    /// times initialize grew the storage of existing attributes
+    long long n_reallocate;
+
     /// element indices in the group
     std::vector<int> v_index;
 
@@ -234,6 +277,13 @@ namespace Framework {
 
     /// attribute storage
     std::vector<std::variant<std::vector<Ts>...>> v_data;
+
+    /// whether the attribute awaits evaluation, see fetch()
+    /// may be shorter than v_data, in which case the missing attributes are never pending
+    mutable std::vector<int> v_pending;
+
+    /// groups whose attributes are computed from the elements of this one, e.g. the aggregates made of it
+    std::vector<const Group *> v_dependent;
   };
 }
 
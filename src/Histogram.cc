@@ -47,10 +47,13 @@ bool Framework::Histogram::make_histogram(Filler filler, const std::string &name
 
 void Framework::Histogram::fill()
 {
+  FWK_PROFILE_SCOPE(histogram_fill, "");
   weight = (weighter) ? weighter() : 1.;
 
-  for (auto &hist : v_hist)
-    hist.second();
+  for (auto &hist : v_hist) {
+    if (hist.second)
+      hist.second();
+  }
 }
 
 
@@ -73,6 +76,51 @@ const std::vector<Framework::Histogram::histfunc>& Framework::Histogram::histogr
 
 
 
+void Framework::Histogram::add_from(const std::string &name, double scale)
+{
+  std::unique_ptr<TFile> file(TFile::Open(name.c_str(), "read"));
+  if (file == nullptr or file->IsZombie())
+    throw std::runtime_error( "ERROR: Histogram::add_from: unable to read the file " + name + ". Aborting!!" );
+
+  TIter next(file->GetListOfKeys());
+  while (auto key = static_cast<TKey *>(next())) {
+    if (key->GetCycle() != file->GetKey(key->GetName())->GetCycle())
+      continue;
+
+    std::unique_ptr<TH1> hist(dynamic_cast<TH1 *>(key->ReadObj()));
+    if (hist == nullptr)
+      continue;
+
+    hist->SetDirectory(nullptr);
+    add_one(std::move(hist), scale);
+  }
+}
+
+
+
+void Framework::Histogram::add(const Histogram &other, double scale)
+{
+  for (const auto &hist : other.histograms())
+    add_one(std::unique_ptr<TH1>(static_cast<TH1 *>(hist.first->Clone())), scale);
+}
+
+
+
+void Framework::Histogram::add_one(std::unique_ptr<TH1> hist, double scale)
+{
+  if (scale != 1.)
+    hist->Scale(scale);
+
+  auto iH = std::find_if(std::begin(v_hist), std::end(v_hist), 
+                         [name = std::string(hist->GetName())] (const auto &held) {return name == held.first->GetName();});
+  if (iH != std::end(v_hist))
+    iH->first->Add(hist.get());
+  else
+    v_hist.emplace_back(std::move(hist), std::function<void()>());
+}
+
+
+
 template <typename ...Hists>
 void Framework::save_all_as(const std::string &name, const Hists &...hists)
 {
@@ -6,8 +6,11 @@
 // short: an interface for creating, filling and saving of histograms from groups
 
 #include "Heap.h"
+#include "Profiler.h"
 
 #include "TFile.h"
+#include "TKey.h"
+#include "TList.h"
 
 #include "TH1.h"
 #include "TH1I.h"
@@ -53,7 +56,20 @@ namespace Framework {
     /// provide reference to held histograms
     const std::vector<histfunc>& histograms() const;
 
+    /// add the histograms in a ROOT file (top directory only) into the held ones, matched by name
+    /// only the last cycle of each is taken, as hadd does, the older ones being earlier states of the same histogram
+    /// histograms not yet held are appended, without a filling function
+    /// scale is applied to the read histograms before adding
+    void add_from(const std::string &name, double scale = 1.);
+
+    /// add the histograms of another instance into the held ones, matched by name
+    /// with the same behavior for histograms not yet held as add_from
+    void add(const Histogram &other, double scale = 1.);
+
   protected:
+    /// add one histogram into the held ones, taking ownership of it
+    void add_one(std::unique_ptr<TH1> hist, double scale);
+
     /// the weight to be used when filling the histograms
     double weight;
 
@@ -0,0 +1,226 @@
+// -*- C++ -*-
+// author: afiq anuar
+// short: please refer to header for information
+
+Framework::IOStats::IOStats(TTree *tree_) :
+tree(tree_),
+current(-1),
+since(std::chrono::steady_clock::now()),
+read_offset(0LL)
+{
+  if (tree == nullptr)
+    throw std::invalid_argument( "ERROR: IOStats: the tree to be monitored is null!!" );
+}
+
+
+
+int Framework::IOStats::add_branch(const std::string &group, const std::string &attribute, const std::string &branch)
+{
+  Branch br;
+  br.group = group;
+  br.attribute = attribute;
+  br.branch = branch;
+
+  v_branch.emplace_back(std::move(br));
+  v_basket.emplace_back(-1, -1);
+  return v_branch.size() - 1;
+}
+
+
+
+int Framework::IOStats::read(int key, TBranch *branch, long long entry)
+{
+  if (current < 0)
+    change_file();
+
+  const auto start = std::chrono::steady_clock::now();
+  const int bytes = branch->GetEntry(entry);
+  const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+
+  auto &br = v_branch[key];
+  auto &file = v_file[current];
+  ++br.entries;
+  br.bytes += bytes;
+  br.time += time.count();
+  file.bytes += bytes;
+  file.time += time.count();
+
+  // a basket is counted when the branch moves to it, which is when it is read and decompressed
+  const int basket = branch->GetReadBasket();
+  if (basket > -1 and (basket != v_basket[key].first or current != v_basket[key].second)) {
+    v_basket[key] = {basket, current};
+
+    const int zip_bytes = (branch->GetBasketBytes() != nullptr) ? branch->GetBasketBytes()[basket] : 0;
+    ++br.baskets;
+    br.zip_bytes += zip_bytes;
+    ++file.baskets;
+    file.zip_bytes += zip_bytes;
+
+    refresh();
+  }
+
+  return bytes;
+}
+
+
+
+void Framework::IOStats::change_file()
+{
+  const auto now = std::chrono::steady_clock::now();
+  if (current > -1)
+    v_file[current].wall += std::chrono::duration<double>(now - since).count();
+  since = now;
+
+  TFile *tfile = tree->GetCurrentFile();
+  const std::string name = (tfile != nullptr) ? tfile->GetName() : "";
+
+  // the same file may be entered more than once e.g. over several analyze_range calls
+  auto iF = std::find_if(std::begin(v_file), std::end(v_file), [&name] (const File &file) {return file.name == name;});
+  if (iF == std::end(v_file)) {
+    File file;
+    file.name = name;
+    v_file.emplace_back(std::move(file));
+    iF = std::prev(std::end(v_file));
+  }
+  current = std::distance(std::begin(v_file), iF);
+  read_offset = iF->bytes_read - ((tfile != nullptr) ? tfile->GetBytesRead() : 0LL);
+}
+
+
+
+void Framework::IOStats::finish()
+{
+  if (current < 0)
+    return;
+
+  refresh();
+  v_file[current].wall += std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+  current = -1;
+}
+
+
+
+const std::vector<Framework::IOStats::Branch>& Framework::IOStats::branches() const
+{
+  return v_branch;
+}
+
+
+
+const std::vector<Framework::IOStats::File>& Framework::IOStats::files() const
+{
+  return v_file;
+}
+
+
+
+void Framework::IOStats::print(std::ostream &out) const
+{
+  std::vector<int> v_order(v_branch.size());
+  std::iota(std::begin(v_order), std::end(v_order), 0);
+  std::stable_sort(std::begin(v_order), std::end(v_order), [this] (int ib1, int ib2) {return v_branch[ib1].time > v_branch[ib2].time;});
+
+  double total = 0.;
+  std::size_t width = 6;
+  for (const auto &br : v_branch) {
+    total += br.time;
+    width = std::max(width, br.branch.size());
+  }
+
+  out << "I/O per branch:\n";
+  out << std::left << std::setw(width + 2) << "branch" << std::setw(24) << "attribute" << std::right << std::setw(12) << "MB" << std::setw(12) << "zip MB"
+      << std::setw(10) << "baskets" << std::setw(12) << "read (s)" << std::setw(12) << "ns/entry" << std::setw(10) << "share" << "\n";
+
+  out << std::fixed << std::setprecision(2);
+  for (int iB : v_order) {
+    const auto &br = v_branch[iB];
+    out << std::left << std::setw(width + 2) << br.branch << std::setw(24) << br.group + "::" + br.attribute << std::right
+        << std::setw(12) << br.bytes * 1e-6 << std::setw(12) << br.zip_bytes * 1e-6 << std::setw(10) << br.baskets << std::setw(12) << br.time
+        << std::setw(12) << ((br.entries) ? 1e9 * br.time / br.entries : 0.) << std::setw(9) << ((total > 0.) ? 100. * br.time / total : 0.) << "%\n";
+  }
+
+  out << "I/O per file:\n";
+  out << std::left << std::setw(48) << "file" << std::right << std::setw(12) << "MB" << std::setw(12) << "zip MB" << std::setw(12) << "read MB"
+      << std::setw(12) << "read (s)" << std::setw(12) << "wall (s)" << std::setw(12) << "MB/s" << std::setw(10) << "cache eff" << "\n";
+
+  for (const auto &file : v_file) {
+    // long paths are shown by their tails, which is where they differ
+    const std::string name = (file.name.size() > 46) ? "..." + file.name.substr(file.name.size() - 43) : file.name;
+    out << std::left << std::setw(48) << name << std::right
+        << std::setw(12) << file.bytes * 1e-6 << std::setw(12) << file.zip_bytes * 1e-6 << std::setw(12) << file.bytes_read * 1e-6
+        << std::setw(12) << file.time << std::setw(12) << file.wall << std::setw(12) << ((file.wall > 0.) ? file.bytes_read * 1e-6 / file.wall : 0.)
+        << std::setw(10) << file.efficiency << "\n";
+  }
+  out << std::defaultfloat << std::setprecision(6) << std::flush;
+}
+
+
+
+void Framework::IOStats::write_json(const std::string &file) const
+{
+  std::ofstream out(file);
+  if (!out)
+    throw std::runtime_error( "ERROR: IOStats::write_json: unable to open " + file + " for writing!!" );
+
+  // names are branch and file names, so only quotes and backslashes are escaped
+  auto quote = [] (const std::string &str) {
+    std::string quoted = "\"";
+    for (auto c : str)
+      quoted += (c == '"' or c == '\\') ? std::string("\\") + c : std::string(1, c);
+    return quoted + "\"";
+  };
+
+  out << "{\n  \"branches\": [";
+  for (int iB = 0; iB < v_branch.size(); ++iB) {
+    const auto &br = v_branch[iB];
+    out << ((iB == 0) ? "\n" : ",\n")
+        << "    {\"branch\": " << quote(br.branch) << ", \"group\": " << quote(br.group) << ", \"attribute\": " << quote(br.attribute)
+        << ", \"entries\": " << br.entries << ", \"bytes\": " << br.bytes << ", \"zip_bytes\": " << br.zip_bytes << ", \"baskets\": " << br.baskets
+        << ", \"time_s\": " << br.time << "}";
+  }
+
+  out << "\n  ],\n  \"files\": [";
+  for (int iF = 0; iF < v_file.size(); ++iF) {
+    const auto &f = v_file[iF];
+    out << ((iF == 0) ? "\n" : ",\n")
+        << "    {\"file\": " << quote(f.name) << ", \"bytes\": " << f.bytes << ", \"zip_bytes\": " << f.zip_bytes << ", \"baskets\": " << f.baskets
+        << ", \"bytes_read\": " << f.bytes_read << ", \"time_s\": " << f.time << ", \"wall_s\": " << f.wall
+        << ", \"cache_efficiency\": " << f.efficiency << ", \"cache_efficiency_rel\": " << f.efficiency_rel << "}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+
+
+void Framework::IOStats::reset()
+{
+  for (auto &br : v_branch) {
+    br.entries = 0LL;
+    br.bytes = 0LL;
+    br.zip_bytes = 0LL;
+    br.baskets = 0LL;
+    br.time = 0.;
+  }
+
+  std::fill(std::begin(v_basket), std::end(v_basket), std::make_pair(-1, -1));
+  v_file.clear();
+  current = -1;
+  read_offset = 0LL;
+}
+
+
+
+void Framework::IOStats::refresh()
+{
+  TFile *tfile = tree->GetCurrentFile();
+  if (current < 0 or tfile == nullptr)
+    return;
+
+  auto &file = v_file[current];
+  file.bytes_read = read_offset + tfile->GetBytesRead();
+
+  if (auto cache = tree->GetReadCache(tfile); cache != nullptr) {
+    file.efficiency = cache->GetEfficiency();
+    file.efficiency_rel = cache->GetEfficiencyRel();
+  }
+}
@@ -0,0 +1,103 @@
+#ifndef FWK_IOSTATS_H
+#define FWK_IOSTATS_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: statistics of what a dataset reads off its files, per branch and per file
+// note: enabled per dataset by Dataset::enable_io_stats, before associating the collections; otherwise nothing is recorded
+// note: collections hand every branch read to read(), which times it and notes each basket the branch moves to
+// note: per branch are the uncompressed bytes returned by GetEntry, the compressed bytes and number of the baskets loaded, and the time in GetEntry
+// note: the time includes the decompression and any read off the file not served by the TTreeCache, which is the point
+// note: per file are the same summed over the branches, plus the bytes actually read off the file, the wall time spent in it and the TTreeCache efficiency
+// note: the file quantities are refreshed whenever a basket is loaded, as the chain closes the file before telling anyone it moved on
+// note: a branch that is read but whose attribute is never used still shows up here, with its full cost
+
+#include "Heap.h"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+
+#include "TTree.h"
+#include "TBranch.h"
+#include "TFile.h"
+#include "TTreeCache.h"
+
+namespace Framework {
+  class IOStats {
+  public:
+    /// what is read through one branch
+    struct Branch {
+      std::string group, attribute, branch;
+      long long entries = 0LL, bytes = 0LL, zip_bytes = 0LL, baskets = 0LL;
+      double time = 0.;
+    };
+
+    /// what is read off one file
+    /// bytes_read is as counted by the file, i.e. including the read-ahead of the cache; efficiency is -1 when there is no cache
+    struct File {
+      std::string name;
+      long long bytes = 0LL, zip_bytes = 0LL, baskets = 0LL, bytes_read = 0LL;
+      double time = 0., wall = 0., efficiency = -1., efficiency_rel = -1.;
+    };
+
+    /// constructor
+    /// the tree is the one the collections read through, i.e. the chain of the dataset
+    IOStats(TTree *tree_);
+
+    /// register a branch, returning the key to be given to read()
+    int add_branch(const std::string &group, const std::string &attribute, const std::string &branch);
+
+    /// read an entry of a branch, recording what it costs
+    /// returns what GetEntry returns
+    int read(int key, TBranch *branch, long long entry);
+
+    /// to be called whenever the tree moves to another file
+    void change_file();
+
+    /// to be called once the reading is done, so that the time spent in the last file is counted
+    /// reading again afterwards picks up where it left off, without counting the time in between
+    void finish();
+
+    /// the statistics so far
+    const std::vector<Branch>& branches() const;
+
+    const std::vector<File>& files() const;
+
+    /// print the statistics as two tables, the branches from the most costly
+    void print(std::ostream &out = std::cout) const;
+
+    /// write the statistics as json
+    void write_json(const std::string &file) const;
+
+    /// drop everything recorded so far, keeping the branches registered
+    void reset();
+
+  protected:
+    /// refresh the quantities that can only be read off the current file
+    void refresh();
+
+    TTree *tree;
+
+    std::vector<Branch> v_branch;
+
+    /// the basket each branch last read from, and the file it was in
+    std::vector<std::pair<int, int>> v_basket;
+
+    std::vector<File> v_file;
+
+    /// index of the current file in v_file, -1 if none, and since when it is being read
+    int current;
+
+    std::chrono::steady_clock::time_point since;
+
+    /// bytes_read of the current file, minus what its TFile has read so far
+    /// a file may be opened more than once, each time with a fresh count
+    long long read_offset;
+  };
+}
+
+#include "IOStats.cc"
+
+#endif
@@ -0,0 +1,203 @@
+// -*- C++ -*-
+// author: afiq anuar
+// short: please refer to header for information
+
+#include <sys/resource.h>
+
+Framework::Memory::Memory() :
+open(false),
+resettable(false)
+{
+  begin_stage("setup");
+}
+
+
+
+template <typename ...Groups>
+void Framework::Memory::add_group(Groups &...groups)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  (v_group.emplace_back(groups.name, [&groups] () {return groups.memory_usage();}), ...);
+}
+
+
+
+void Framework::Memory::begin_stage(const std::string &stage)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  close();
+
+  // 5 resets the peak RSS to the current RSS, see proc(5)
+  std::ofstream clear("/proc/self/clear_refs");
+  clear << "5" << std::flush;
+  resettable = clear.good();
+
+  Stage st;
+  st.name = stage;
+  st.rss_begin = rss().first;
+  st.exact = resettable;
+  v_stage.emplace_back(std::move(st));
+
+  open = true;
+  since = std::chrono::steady_clock::now();
+}
+
+
+
+void Framework::Memory::end_stage()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  close();
+}
+
+
+
+void Framework::Memory::close()
+{
+  if (!open)
+    return;
+
+  auto &stage = v_stage.back();
+  stage.wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+  std::tie(stage.rss_end, stage.peak) = rss();
+  open = false;
+}
+
+
+
+std::vector<Framework::Memory::Stage> Framework::Memory::stages() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return std::vector<Stage>(std::begin(v_stage), std::end(v_stage) - ((open) ? 1 : 0));
+}
+
+
+
+void Framework::Memory::print(std::ostream &out) const
+{
+  std::vector<std::pair<std::string, MemoryUsage>> v_usage;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &[name, usage] : v_group)
+      v_usage.emplace_back(name, usage());
+  }
+
+  std::size_t width = 6;
+  for (const auto &[name, usage] : v_usage) {
+    width = std::max(width, name.size());
+    for (const auto &[attr, size, capacity] : usage.v_attribute)
+      width = std::max(width, attr.size() + 2);
+  }
+
+  out << "Memory per group:\n";
+  out << std::left << std::setw(width + 2) << "group" << std::right << std::setw(10) << "B/element" << std::setw(12) << "capacity" << std::setw(12) << "peak"
+      << std::setw(12) << "reallocs" << std::setw(12) << "rebinds" << std::setw(12) << "MB" << "\n";
+
+  out << std::fixed << std::setprecision(3);
+  for (const auto &[name, usage] : v_usage) {
+    std::size_t element = 0, bytes = usage.overhead;
+    for (const auto &[attr, size, capacity] : usage.v_attribute) {
+      element += size;
+      bytes += size * capacity;
+    }
+
+    out << std::left << std::setw(width + 2) << name << std::right << std::setw(10) << element << std::setw(12) << usage.capacity << std::setw(12) << usage.peak
+        << std::setw(12) << usage.reallocations << std::setw(12) << usage.rebinds << std::setw(12) << bytes * 1e-6 << "\n";
+
+    for (const auto &[attr, size, capacity] : usage.v_attribute)
+      out << std::left << std::setw(width + 2) << "  " + attr << std::right << std::setw(10) << size << std::setw(12) << capacity << std::setw(36) << ""
+          << std::setw(12) << size * capacity * 1e-6 << "\n";
+  }
+
+  auto v_done = stages();
+  out << "RSS per stage:\n";
+  out << std::left << std::setw(48) << "stage" << std::right << std::setw(12) << "wall (s)" << std::setw(12) << "begin MB" << std::setw(12) << "end MB"
+      << std::setw(12) << "growth MB" << std::setw(12) << "peak MB" << "\n";
+
+  bool cumulative = false;
+  for (const auto &stage : v_done) {
+    const std::string name = (stage.name.size() > 46) ? "..." + stage.name.substr(stage.name.size() - 43) : stage.name;
+    out << std::left << std::setw(48) << name << std::right << std::setw(12) << stage.wall << std::setw(12) << stage.rss_begin * 1e-6
+        << std::setw(12) << stage.rss_end * 1e-6 << std::setw(12) << (stage.rss_end - stage.rss_begin) * 1e-6 << std::setw(12) << stage.peak * 1e-6
+        << ((stage.exact) ? "" : " *") << "\n";
+    cumulative = cumulative or !stage.exact;
+  }
+
+  if (cumulative)
+    out << "* the peak RSS could not be reset here, so the peak is that of the job up to the end of the stage\n";
+  out << std::defaultfloat << std::setprecision(6) << std::flush;
+}
+
+
+
+void Framework::Memory::write_json(const std::string &file) const
+{
+  std::ofstream out(file);
+  if (!out)
+    throw std::runtime_error( "ERROR: Memory::write_json: unable to open " + file + " for writing!!" );
+
+  // names are group, attribute and file names, so only quotes and backslashes are escaped
+  auto quote = [] (const std::string &str) {
+    std::string quoted = "\"";
+    for (auto c : str)
+      quoted += (c == '"' or c == '\\') ? std::string("\\") + c : std::string(1, c);
+    return quoted + "\"";
+  };
+
+  std::vector<std::pair<std::string, MemoryUsage>> v_usage;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &[name, usage] : v_group)
+      v_usage.emplace_back(name, usage());
+  }
+
+  out << "{\n  \"groups\": [";
+  for (int iG = 0; iG < v_usage.size(); ++iG) {
+    const auto &[name, usage] = v_usage[iG];
+    out << ((iG == 0) ? "\n" : ",\n")
+        << "    {\"group\": " << quote(name) << ", \"capacity\": " << usage.capacity << ", \"peak\": " << usage.peak
+        << ", \"reallocations\": " << usage.reallocations << ", \"rebinds\": " << usage.rebinds << ", \"overhead_bytes\": " << usage.overhead << ", \"attributes\": [";
+
+    for (int iA = 0; iA < usage.v_attribute.size(); ++iA) {
+      const auto &[attr, size, capacity] = usage.v_attribute[iA];
+      out << ((iA == 0) ? "" : ", ") << "{\"attribute\": " << quote(attr) << ", \"element_bytes\": " << size << ", \"capacity\": " << capacity
+          << ", \"bytes\": " << size * capacity << "}";
+    }
+    out << "]}";
+  }
+
+  auto v_done = stages();
+  out << "\n  ],\n  \"stages\": [";
+  for (int iS = 0; iS < v_done.size(); ++iS) {
+    const auto &stage = v_done[iS];
+    out << ((iS == 0) ? "\n" : ",\n")
+        << "    {\"stage\": " << quote(stage.name) << ", \"wall_s\": " << stage.wall << ", \"rss_begin_bytes\": " << stage.rss_begin
+        << ", \"rss_end_bytes\": " << stage.rss_end << ", \"peak_bytes\": " << stage.peak << ", \"exact_peak\": " << ((stage.exact) ? "true" : "false") << "}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+
+
+std::pair<long long, long long> Framework::Memory::rss()
+{
+  long long current = -1LL, peak = -1LL;
+
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.rfind("VmRSS:", 0) == 0)
+      current = std::stoll(line.substr(6)) * 1024LL;
+    else if (line.rfind("VmHWM:", 0) == 0)
+      peak = std::stoll(line.substr(6)) * 1024LL;
+  }
+
+  // elsewhere only the peak is known, in kB on linux
+  if (peak < 0LL) {
+    rusage use;
+    getrusage(RUSAGE_SELF, &use);
+    peak = use.ru_maxrss * 1024LL;
+  }
+
+  return {current, peak};
+}
@@ -0,0 +1,101 @@
+#ifndef FWK_MEMORY_H
+#define FWK_MEMORY_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: accounting of the memory held by the groups, and of the RSS of the job over its stages
+// note: every group reports the bytes allocated per attribute, its capacity against the most elements it was ever populated with
+// note: and how many times its storage was grown, and for collections how many times the branches were rebound to it as a result
+// note: a capacity far above the peak means the init hint is too generous; many reallocations that it is too small, see Collection
+// note: the job is split into stages, each with the RSS as it begins and ends, and its peak RSS
+// note: the peak is the VmHWM of the process, which is reset as each stage begins where the kernel allows; otherwise it is the peak so far
+// note: the reset is by /proc/self/clear_refs, and is process-wide; anything else resetting it, or reading it, interferes with the stages
+// note: Dataset::set_memory registers the collections of the dataset and opens a stage per file, which is where runaway growth shows up
+
+#include "Heap.h"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <mutex>
+
+namespace Framework {
+  /// memory held by a group, as reported by Group::memory_usage()
+  struct MemoryUsage {
+    /// per attribute: its name, the bytes per element and the number of elements there is room for
+    std::vector<std::tuple<std::string, std::size_t, std::size_t>> v_attribute;
+
+    /// bytes held besides the attributes e.g. the indices
+    std::size_t overhead = 0;
+
+    /// elements there is room for, and the most elements ever populated
+    int capacity = 0, peak = 0;
+
+    /// times the storage was grown once attributes were added, and times the branches were rebound to it
+    long long reallocations = 0LL, rebinds = 0LL;
+  };
+
+  class Memory {
+  public:
+    /// one stage of the job, with the RSS in bytes
+    /// exact is whether the peak is that of the stage, or that of the job so far because it could not be reset
+    struct Stage {
+      std::string name;
+      double wall = 0.;
+      long long rss_begin = -1LL, rss_end = -1LL, peak = -1LL;
+      bool exact = false;
+    };
+
+    /// constructor
+    /// opens the first stage, named setup
+    Memory();
+
+    /// register groups whose memory is to be reported
+    /// the groups are held by reference, and must outlive the report
+    template <typename ...Groups>
+    void add_group(Groups &...groups);
+
+    /// close the current stage, if any, and open another
+    void begin_stage(const std::string &stage);
+
+    /// close the current stage, if any
+    void end_stage();
+
+    /// the stages so far, the current one excluded
+    std::vector<Stage> stages() const;
+
+    /// print the memory held by the groups, and the stages so far
+    void print(std::ostream &out = std::cout) const;
+
+    /// write the same as json
+    void write_json(const std::string &file) const;
+
+    /// the current and peak RSS of the process in bytes, -1 when not known
+    static std::pair<long long, long long> rss();
+
+  protected:
+    /// close the current stage, if any, with the mutex held
+    void close();
+
+    /// the groups, by name
+    std::vector<std::pair<std::string, std::function<MemoryUsage()>>> v_group;
+
+    /// the stages, the last being the current one when open is true
+    std::vector<Stage> v_stage;
+
+    bool open;
+
+    /// whether resetting the peak RSS works here
+    bool resettable;
+
+    std::chrono::steady_clock::time_point since;
+
+    /// stages may be changed by the threads of a Scheduler
+    mutable std::mutex mutex;
+  };
+}
+
+#include "Memory.cc"
+
+#endif
@@ -0,0 +1,483 @@
+// -*- C++ -*-
+// author: afiq anuar
+// short: please refer to header for information
+
+Framework::Profiler::Scope::Scope(Stage stage_, const char *label_) :
+stage(stage_),
+label(label_),
+buffer(Profiler::instance().buffer())
+{
+  buffer.v_child.emplace_back(0LL, Counts{});
+#ifdef FWK_PROFILE_COUNTERS
+  read_counters(buffer, counts);
+#endif
+  start = Profiler::instance().now();
+}
+
+
+
+Framework::Profiler::Scope::~Scope()
+{
+  const long long duration = Profiler::instance().now() - start;
+  const int istage = static_cast<int>(stage);
+
+  // the time of the nested scopes is taken off this one, and this one is added to its parent's
+  const auto child = buffer.v_child.back();
+  buffer.v_child.pop_back();
+  if (!buffer.v_child.empty())
+    buffer.v_child.back().first += duration;
+
+  buffer.event_time[istage] += duration - child.first;
+  buffer.event_seen[istage] = true;
+
+#ifdef FWK_PROFILE_COUNTERS
+  // and the same for the counts
+  Counts end;
+  read_counters(buffer, end);
+  for (int iC = 0; iC < n_counter; ++iC) {
+    const long long count = end[iC] - counts[iC];
+    buffer.event_counts[istage][iC] += count - child.second[iC];
+    if (!buffer.v_child.empty())
+      buffer.v_child.back().second[iC] += count;
+  }
+#endif
+
+  if (buffer.v_span.empty())
+    return;
+
+  auto &span = buffer.v_span[buffer.written % buffer.v_span.size()];
+  span.stage = stage;
+  std::strncpy(span.label, label, sizeof(span.label) - 1);
+  span.label[sizeof(span.label) - 1] = '\0';
+  span.start = start;
+  span.duration = duration;
+  ++buffer.written;
+}
+
+
+
+Framework::Profiler::Buffer::~Buffer()
+{
+  close_counters(*this);
+}
+
+
+
+Framework::Profiler::Profiler() :
+origin(std::chrono::steady_clock::now()),
+capacity(1ULL << 16ULL)
+{}
+
+
+
+Framework::Profiler& Framework::Profiler::instance()
+{
+  static Profiler profiler;
+  return profiler;
+}
+
+
+
+void Framework::Profiler::set_capacity(std::size_t capacity_)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  capacity = capacity_;
+}
+
+
+
+void Framework::Profiler::end_event()
+{
+  auto &buf = buffer();
+
+  for (int iS = 0; iS < n_stage; ++iS) {
+    if (!buf.event_seen[iS])
+      continue;
+
+    ++buf.n_event[iS];
+    buf.total[iS] += buf.event_time[iS];
+    ++buf.v_bin[iS][bin(buf.event_time[iS])];
+    for (int iC = 0; iC < n_counter; ++iC)
+      buf.total_counts[iS][iC] += buf.event_counts[iS][iC];
+
+    buf.event_time[iS] = 0LL;
+    buf.event_counts[iS] = {};
+    buf.event_seen[iS] = false;
+  }
+}
+
+
+
+std::vector<Framework::Profiler::Summary> Framework::Profiler::summary() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<Summary> v_summary;
+
+  for (int iS = 0; iS < n_stage; ++iS) {
+    long long n_event = 0LL, total = 0LL;
+    std::array<long long, n_bin> v_bin = {};
+
+    // a counter is quoted only if every thread that ran the stage had it
+    Counts counts = {};
+    std::array<bool, n_counter> available;
+#ifdef FWK_PROFILE_COUNTERS
+    available.fill(true);
+#else
+    available.fill(false);
+#endif
+
+    for (const auto &buf : v_buffer) {
+      n_event += buf->n_event[iS];
+      total += buf->total[iS];
+      for (int iB = 0; iB < n_bin; ++iB)
+        v_bin[iB] += buf->v_bin[iS][iB];
+
+      for (int iC = 0; iC < n_counter; ++iC) {
+        counts[iC] += buf->total_counts[iS][iC];
+        if (buf->n_event[iS] and buf->v_slot[iC] < 0)
+          available[iC] = false;
+      }
+    }
+
+    if (n_event == 0LL)
+      continue;
+
+    // the percentiles are the centers of the bins the n-th event falls into
+    auto f_percentile = [&v_bin, n_event] (double fraction) {
+      const long long target = static_cast<long long>(fraction * (n_event - 1));
+      long long sum = 0LL;
+      for (int iB = 0; iB < n_bin; ++iB) {
+        sum += v_bin[iB];
+        if (sum > target)
+          return bin_center(iB);
+      }
+      return bin_center(n_bin - 1);
+    };
+
+    std::array<double, n_counter> v_counter;
+    for (int iC = 0; iC < n_counter; ++iC)
+      v_counter[iC] = (available[iC]) ? static_cast<double>(counts[iC]) / n_event : -1.;
+
+    v_summary.push_back({static_cast<Stage>(iS), n_event, static_cast<double>(total) / n_event, f_percentile(0.5), f_percentile(0.99),
+                         static_cast<double>(total), v_counter});
+  }
+
+  return v_summary;
+}
+
+
+
+void Framework::Profiler::print(std::ostream &out) const
+{
+  const auto v_summary = summary();
+  if (v_summary.empty())
+    return;
+
+  double total = 0.;
+  for (const auto &sum : v_summary)
+    total += sum.total;
+
+  out << "Time per event by stage, in us:\n";
+  out << std::left << std::setw(22) << "stage" << std::right << std::setw(14) << "events" << std::setw(12) << "mean" << std::setw(12) << "p50"
+      << std::setw(12) << "p99" << std::setw(12) << "total (s)" << std::setw(10) << "share" << "\n";
+
+  out << std::fixed << std::setprecision(2);
+  for (const auto &sum : v_summary) {
+    out << std::left << std::setw(22) << stage_name(sum.stage) << std::right << std::setw(14) << sum.events
+        << std::setw(12) << sum.mean * 1e-3 << std::setw(12) << sum.p50 * 1e-3 << std::setw(12) << sum.p99 * 1e-3
+        << std::setw(12) << sum.total * 1e-9 << std::setw(9) << 100. * sum.total / total << "%\n";
+  }
+
+#ifdef FWK_PROFILE_COUNTERS
+  if (counter_error != "")
+    out << "Hardware counters unavailable: " << counter_error << "\n";
+  else {
+    auto f_print = [&out] (double value) {
+      if (value < 0.)
+        out << std::setw(16) << "n/a";
+      else
+        out << std::setw(16) << value;
+    };
+
+    out << "Hardware counters per event:\n";
+    out << std::left << std::setw(22) << "stage" << std::right;
+    for (int iC = 0; iC < n_counter; ++iC)
+      out << std::setw(16) << counter_name(static_cast<Counter>(iC));
+    out << std::setw(10) << "IPC" << std::setw(16) << "cache miss/kI" << "\n";
+
+    for (const auto &sum : v_summary) {
+      out << std::left << std::setw(22) << stage_name(sum.stage) << std::right;
+      for (int iC = 0; iC < n_counter; ++iC)
+        f_print(sum.counters[iC]);
+
+      const double cycles = sum.counters[0], instructions = sum.counters[1], misses = sum.counters[2];
+      out << std::setw(10);
+      if (cycles > 0. and instructions >= 0.)
+        out << instructions / cycles;
+      else
+        out << "n/a";
+      f_print((instructions > 0. and misses >= 0.) ? 1e3 * misses / instructions : -1.);
+      out << "\n";
+    }
+  }
+#endif
+  out << std::defaultfloat << std::setprecision(6) << std::flush;
+}
+
+
+
+void Framework::Profiler::write_trace(const std::string &file) const
+{
+  std::ofstream out(file);
+  if (!out)
+    throw std::runtime_error( "ERROR: Profiler::write_trace: unable to open " + file + " for writing!!" );
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // the labels are names of groups, so only quotes and backslashes are escaped
+  auto quote = [] (const char *str) {
+    std::string quoted = "\"";
+    for (; *str != '\0'; ++str)
+      quoted += (*str == '"' or *str == '\\') ? std::string("\\") + *str : std::string(1, *str);
+    return quoted + "\"";
+  };
+
+  // complete events i.e. ph X, with times in us
+  out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+  bool first = true;
+  out << std::fixed << std::setprecision(3);
+  for (const auto &buf : v_buffer) {
+    const std::size_t size = buf->v_span.size(), n_span = std::min(buf->written, size);
+
+    for (std::size_t iP = buf->written - n_span; iP < buf->written; ++iP) {
+      const auto &span = buf->v_span[iP % size];
+      out << (first ? "\n" : ",\n")
+          << "{\"name\": " << quote((span.label[0] == '\0') ? stage_name(span.stage) : span.label) << ", \"cat\": " << quote(stage_name(span.stage))
+          << ", \"ph\": \"X\", \"pid\": 0, \"tid\": " << buf->thread << ", \"ts\": " << span.start * 1e-3 << ", \"dur\": " << span.duration * 1e-3 << "}";
+      first = false;
+    }
+  }
+  out << "\n]}\n";
+}
+
+
+
+void Framework::Profiler::reset()
+{
+  // the buffers are cleared rather than dropped, as the threads hold on to them
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto &buf : v_buffer) {
+    buf->written = 0;
+    buf->event_time = {};
+    buf->event_counts = {};
+    buf->event_seen = {};
+    buf->n_event = {};
+    buf->total = {};
+    buf->total_counts = {};
+    buf->v_bin = {};
+  }
+}
+
+
+
+const char* Framework::Profiler::stage_name(Stage stage)
+{
+  switch (stage) {
+  case Stage::analyzer:
+    return "analyzer (other)";
+  case Stage::collection_populate:
+    return "collection_populate";
+  case Stage::transform:
+    return "transform";
+  case Stage::aggregate_populate:
+    return "aggregate_populate";
+  case Stage::histogram_fill:
+    return "histogram_fill";
+  case Stage::tree_fill:
+    return "tree_fill";
+  default:
+    return "unknown";
+  }
+}
+
+
+
+const char* Framework::Profiler::counter_name(Counter counter)
+{
+  switch (counter) {
+  case Counter::cycles:
+    return "cycles";
+  case Counter::instructions:
+    return "instructions";
+  case Counter::cache_misses:
+    return "cache_misses";
+  case Counter::branch_misses:
+    return "branch_misses";
+  default:
+    return "unknown";
+  }
+}
+
+
+
+Framework::Profiler::Buffer& Framework::Profiler::buffer()
+{
+  // hands the buffer back when the thread exits, which happens before the profiler itself is destroyed
+  struct Handle {
+    Buffer *buf = nullptr;
+    ~Handle() { if (buf != nullptr) Profiler::instance().release(*buf); }
+  };
+
+  thread_local Handle cache;
+  if (cache.buf != nullptr)
+    return *cache.buf;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto idle = std::find_if(std::begin(v_buffer), std::end(v_buffer), [] (const auto &buf) { return buf->idle; });
+  if (idle != std::end(v_buffer)) {
+    cache.buf = idle->get();
+    cache.buf->idle = false;
+  }
+  else {
+    v_buffer.emplace_back(std::make_unique<Buffer>());
+    cache.buf = v_buffer.back().get();
+    cache.buf->thread = v_buffer.size() - 1;
+    cache.buf->v_span.resize(capacity);
+    cache.buf->v_child.reserve(16);
+  }
+
+#ifdef FWK_PROFILE_COUNTERS
+  open_counters(*cache.buf);
+#endif
+
+  return *cache.buf;
+}
+
+
+
+void Framework::Profiler::release(Buffer &buf)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  close_counters(buf);
+  buf.idle = true;
+}
+
+
+
+void Framework::Profiler::open_counters(Buffer &buf)
+{
+#ifdef FWK_PROFILE_COUNTERS
+  // called with the mutex held, from buffer(), on a buffer that is new or whose counters have been closed
+  buf.v_slot = {-1, -1, -1, -1};
+  constexpr std::array<unsigned long long, n_counter> v_config = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                                  PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+  int n_open = 0;
+  for (int iC = 0; iC < n_counter; ++iC) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = v_config[iC];
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.disabled = (n_open == 0) ? 1 : 0;
+
+    // this thread, on whichever cpu it runs
+    const int leader = (n_open == 0) ? -1 : buf.v_fd[0];
+    const int fd = syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0UL);
+    if (fd < 0) {
+      // without the leader there is no group; the others being absent only loses them
+      if (iC == 0) {
+        counter_error = std::string("perf_event_open failed for cycles: ") + std::strerror(errno) +
+          ((errno == EACCES or errno == EPERM) ? " (see /proc/sys/kernel/perf_event_paranoid)" : "");
+        return;
+      }
+      continue;
+    }
+
+    buf.v_fd[n_open] = fd;
+    buf.v_slot[iC] = n_open;
+    ++n_open;
+  }
+
+  ioctl(buf.v_fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(buf.v_fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#else
+  (void) buf;
+#endif
+}
+
+
+
+void Framework::Profiler::read_counters(const Buffer &buf, Counts &counts)
+{
+  counts = {};
+
+#ifdef FWK_PROFILE_COUNTERS
+  if (buf.v_fd[0] < 0)
+    return;
+
+  // the layout of a group read: the number of counters, the times enabled and running, then the values
+  std::array<unsigned long long, 3 + n_counter> data;
+  if (read(buf.v_fd[0], data.data(), sizeof(data)) < static_cast<ssize_t>(3 * sizeof(unsigned long long)))
+    return;
+
+  // the counters are multiplexed when there are more of them than the PMU has, in which case the counts are extrapolated
+  const double scale = (data[2] > 0ULL) ? static_cast<double>(data[1]) / data[2] : 0.;
+  for (int iC = 0; iC < n_counter; ++iC) {
+    if (buf.v_slot[iC] > -1 and buf.v_slot[iC] < data[0])
+      counts[iC] = static_cast<long long>(data[3 + buf.v_slot[iC]] * scale);
+  }
+#else
+  (void) buf;
+#endif
+}
+
+
+
+void Framework::Profiler::close_counters(Buffer &buf)
+{
+#ifdef FWK_PROFILE_COUNTERS
+  for (auto &fd : buf.v_fd) {
+    if (fd > -1)
+      close(fd);
+    fd = -1;
+  }
+#else
+  (void) buf;
+#endif
+}
+
+
+
+long long Framework::Profiler::now() const
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+
+
+int Framework::Profiler::bin(long long time)
+{
+  if (time < 16LL)
+    return (time < 0LL) ? 0 : time;
+
+  // 8 bins per octave, i.e. the three bits below the leading one
+  const int octave = 63 - __builtin_clzll(time);
+  const int ibin = 16 + ((octave - 4) * 8) + ((time >> (octave - 3)) & 7LL);
+  return std::min(ibin, n_bin - 1);
+}
+
+
+
+double Framework::Profiler::bin_center(int ibin)
+{
+  if (ibin < 16)
+    return ibin;
+
+  const int octave = 4 + ((ibin - 16) / 8), sub = (ibin - 16) % 8;
+  const double width = std::ldexp(1., octave - 3);
+  return ((8 + sub) * width) + (0.5 * width);
+}
@@ -0,0 +1,243 @@
+#ifndef FWK_PROFILER_H
+#define FWK_PROFILER_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: per-stage timing of the framework methods, summarized per event and exportable as a Chrome trace
+// note: the timers are compiled in only if FWK_PROFILE is defined, e.g. with -DFWK_PROFILE; otherwise FWK_PROFILE_SCOPE expands to nothing
+// note: timed are Collection::populate, the transforms (including the lazy ones), Aggregate::populate, Histogram::fill, Tree::fill and the analyzer as a whole
+// note: the stages are accounted exclusively i.e. the transforms ran within a populate count only as transforms, and the analyzer only counts what no other stage does
+// note: every thread records into its own buffers, so that the timers take no lock; reading them out is not safe while any thread is still recording
+// note: a thread that exits hands its buffers over to the next thread to start recording, so that they number as many as the threads ever running at once
+// note: the spans for the trace are kept in a ring buffer per thread, holding only the most recent ones once it is full
+// note: the per-event times are binned into log-spaced bins of 1/8 octave, so the quoted percentiles are good to about 10%
+// note: defining FWK_PROFILE_COUNTERS as well (it implies FWK_PROFILE) also counts cycles, instructions, cache and branch misses per stage
+// note: these are read through perf_event_open, per thread and for user space only, one read syscall per scope edge, so the stages get slower
+// note: where the counters can not be opened e.g. no PMU in a VM, or perf_event_paranoid too strict, they are reported as unavailable and the timing goes on
+
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(FWK_PROFILE_COUNTERS) and !defined(FWK_PROFILE)
+#define FWK_PROFILE
+#endif
+
+#ifdef FWK_PROFILE_COUNTERS
+#include <cerrno>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#ifdef FWK_PROFILE
+#define FWK_PROFILE_CONCAT_(a, b) a##b
+#define FWK_PROFILE_CONCAT(a, b) FWK_PROFILE_CONCAT_(a, b)
+#define FWK_PROFILE_SCOPE(stage, label) Framework::Profiler::Scope FWK_PROFILE_CONCAT(fwk_profile_scope_, __LINE__)(Framework::Profiler::Stage::stage, label)
+#define FWK_PROFILE_EVENT() Framework::Profiler::instance().end_event()
+#else
+#define FWK_PROFILE_SCOPE(stage, label)
+#define FWK_PROFILE_EVENT()
+#endif
+
+namespace Framework {
+  class Profiler {
+  public:
+    /// the timed stages
+    enum class Stage : int {
+      analyzer,
+      collection_populate,
+      transform,
+      aggregate_populate,
+      histogram_fill,
+      tree_fill,
+      n_stage
+    };
+
+    static constexpr int n_stage = static_cast<int>(Stage::n_stage);
+
+    /// the hardware counters, see the notes above
+    enum class Counter : int {
+      cycles,
+      instructions,
+      cache_misses,
+      branch_misses,
+      n_counter
+    };
+
+    static constexpr int n_counter = static_cast<int>(Counter::n_counter);
+
+    using Counts = std::array<long long, n_counter>;
+
+    /// one timed span, as it appears in the trace
+    /// the label is the name of the group etc the span belongs to, truncated to fit
+    struct Span {
+      Stage stage;
+      char label[19];
+      long long start, duration;
+    };
+
+    /// the per-event summary of a stage, with times in ns
+    /// events is the number of events in which the stage ran, which the mean and percentiles are over
+    /// counters are the means per event of the hardware counters, -1 for those unavailable
+    struct Summary {
+      Stage stage;
+      long long events;
+      double mean, p50, p99, total;
+      std::array<double, n_counter> counters;
+    };
+
+  protected:
+    struct Buffer;
+
+  public:
+    /// times the enclosing scope as a stage
+    /// the label must outlive the scope
+    class Scope {
+    public:
+      Scope(Stage stage_, const char *label_);
+      ~Scope();
+
+      Scope(const Scope &) = delete;
+      Scope& operator=(const Scope &) = delete;
+
+    protected:
+      Stage stage;
+      const char *label;
+      Buffer &buffer;
+      long long start;
+
+#ifdef FWK_PROFILE_COUNTERS
+      Counts counts;
+#endif
+    };
+
+    /// the single profiler of the process
+    static Profiler& instance();
+
+    /// the number of spans kept per thread for the trace
+    /// only affects the threads that have not yet recorded anything
+    void set_capacity(std::size_t capacity_);
+
+    /// close the current event of the calling thread, moving its stage times into the per-event bins
+    /// called by Dataset after every call to the analyzer
+    void end_event();
+
+    /// the per-event summary of every stage that has been timed, summed over all threads
+    std::vector<Summary> summary() const;
+
+    /// print the summary as a table
+    void print(std::ostream &out = std::cout) const;
+
+    /// write the spans of all threads as a Chrome trace, to be viewed in chrome://tracing or ui.perfetto.dev
+    void write_trace(const std::string &file) const;
+
+    /// drop everything recorded so far
+    void reset();
+
+    /// name of a stage and of a counter
+    static const char* stage_name(Stage stage);
+
+    static const char* counter_name(Counter counter);
+
+  protected:
+    /// number of bins of the per-event times, see bin()
+    static constexpr int n_bin = 16 + (44 * 8);
+
+    /// what a thread records
+    /// the counters are closed when the buffer is destroyed, see close_counters()
+    struct Buffer {
+      Buffer() = default;
+      ~Buffer();
+
+      Buffer(const Buffer &) = delete;
+      Buffer& operator=(const Buffer &) = delete;
+
+      /// the trace id of the thread, shared by the threads the buffer has been handed over to
+      int thread;
+
+      /// whether the thread recording into the buffer has exited, see release()
+      bool idle = false;
+
+      /// ring buffer of spans, and the number of spans ever written into it
+      std::vector<Span> v_span;
+      std::size_t written = 0;
+
+      /// open scopes, each with the time and counts taken by the scopes nested within it
+      std::vector<std::pair<long long, Counts>> v_child;
+
+      /// exclusive time and counts of the current event per stage, and whether the stage ran in it
+      std::array<long long, n_stage> event_time = {};
+      std::array<Counts, n_stage> event_counts = {};
+      std::array<bool, n_stage> event_seen = {};
+
+      /// per stage: events seen, total time and counts, and the per-event time distribution
+      std::array<long long, n_stage> n_event = {};
+      std::array<long long, n_stage> total = {};
+      std::array<Counts, n_stage> total_counts = {};
+      std::array<std::array<long long, n_bin>, n_stage> v_bin = {};
+
+      /// the perf_event_open descriptors of the counters, -1 where unavailable; the first one is the group leader
+      /// and the position of each counter in what the group read returns
+      std::array<int, n_counter> v_fd = {-1, -1, -1, -1};
+      std::array<int, n_counter> v_slot = {-1, -1, -1, -1};
+    };
+
+    Profiler();
+
+    /// the buffer of the calling thread, registering it if needed
+    /// an idle buffer is taken over before a new one is made
+    Buffer& buffer();
+
+    /// mark the buffer of an exiting thread as idle, closing its counters as they count only for that thread
+    void release(Buffer &buf);
+
+    /// ns since the profiler was made
+    long long now() const;
+
+    /// open the counters of the calling thread into its buffer, and read them
+    /// the counts are 0 for the counters that are unavailable
+    void open_counters(Buffer &buf);
+
+    static void read_counters(const Buffer &buf, Counts &counts);
+
+    /// close the descriptors of the counters, keeping v_slot as it records which counters the buffer has been read with
+    static void close_counters(Buffer &buf);
+
+    /// the bin of a time in ns, and the time at the center of a bin
+    static int bin(long long time);
+
+    static double bin_center(int ibin);
+
+    /// reference time point of the trace
+    const std::chrono::steady_clock::time_point origin;
+
+    std::size_t capacity;
+
+    /// per-thread buffers, kept beyond the lifetime of their threads so that they can be read out afterwards
+    /// and released only with the profiler itself
+    std::vector<std::unique_ptr<Buffer>> v_buffer;
+
+    /// guard for buffer registration
+    mutable std::mutex mutex;
+
+    /// why the counters could not be opened, empty if they could or were never tried
+    std::string counter_error;
+  };
+}
+
+#include "Profiler.cc"
+
+#endif
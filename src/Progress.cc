@@ -0,0 +1,194 @@
+// -*- C++ -*-
+// author: afiq anuar
+// short: please refer to header for information
+
+#include <cstdio>
+
+Framework::Progress::Progress(double every_second_, const std::string &status_) :
+every_second(every_second_),
+status(status_),
+total(0LL),
+begin_events(0LL),
+previous_events(0LL),
+begin_bytes(0LL),
+previous_bytes(0LL),
+active(false),
+halt(false)
+{
+  if (every_second_ <= 0.)
+    throw std::invalid_argument( "ERROR: Progress: the reporting period must be positive!!" );
+}
+
+
+
+Framework::Progress::~Progress()
+{
+  stop();
+}
+
+
+
+Framework::Progress::Source& Framework::Progress::add_source(const std::string &name)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  v_source.emplace_back(std::make_unique<Source>());
+  v_source.back()->name = name;
+  return *v_source.back();
+}
+
+
+
+void Framework::Progress::set_file(Source &source, const std::string &file)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  source.file = file;
+  last_file = file;
+}
+
+
+
+void Framework::Progress::start(long long total_)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (active)
+    return;
+
+  total = total_;
+  begin = std::chrono::steady_clock::now();
+  previous_time = begin;
+
+  begin_events = 0LL;
+  for (const auto &source : v_source)
+    begin_events += source->events.load(std::memory_order_relaxed);
+  previous_events = begin_events;
+
+  begin_bytes = TFile::GetFileBytesRead();
+  previous_bytes = begin_bytes;
+
+  active = true;
+  halt = false;
+  reporter = std::thread(&Progress::report_loop, this);
+}
+
+
+
+void Framework::Progress::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!active)
+      return;
+    halt = true;
+  }
+  condition.notify_all();
+
+  if (reporter.joinable())
+    reporter.join();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  report(true);
+  active = false;
+}
+
+
+
+bool Framework::Progress::running() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return active;
+}
+
+
+
+void Framework::Progress::report_loop()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!halt) {
+    if (condition.wait_for(lock, every_second, [this] () {return halt;}))
+      break;
+
+    report(false);
+  }
+}
+
+
+
+void Framework::Progress::report(bool final)
+{
+  // called with the mutex held
+  const auto now = std::chrono::steady_clock::now();
+  const double elapsed = std::chrono::duration<double>(now - begin).count();
+  const double period = std::chrono::duration<double>(now - previous_time).count();
+
+  long long events = 0LL;
+  for (const auto &source : v_source)
+    events += source->events.load(std::memory_order_relaxed);
+  const long long bytes = TFile::GetFileBytesRead();
+
+  // the rates are over the last period, or over the whole run for the final report
+  const long long done = events - begin_events;
+  const double rate = (final) ? ((elapsed > 0.) ? done / elapsed : 0.) : ((period > 0.) ? (events - previous_events) / period : 0.);
+  const double mbps = (final) ? ((elapsed > 0.) ? (bytes - begin_bytes) * 1e-6 / elapsed : 0.) :
+    ((period > 0.) ? (bytes - previous_bytes) * 1e-6 / period : 0.);
+
+  // while the ETA is from the average rate so far, which fluctuates less
+  const double average = (elapsed > 0.) ? done / elapsed : 0.;
+  const double eta = (total > 0LL and average > 0. and !final) ? std::max(0LL, total - done) / average : -1.;
+
+  previous_time = now;
+  previous_events = events;
+  previous_bytes = bytes;
+
+  auto f_clock = [] (double seconds) {
+    const long long sec = static_cast<long long>(seconds);
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%lld:%02lld:%02lld", sec / 3600LL, (sec / 60LL) % 60LL, sec % 60LL);
+    return std::string(buffer);
+  };
+
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(1) << ((final) ? "Done: " : "Progress: ") << done;
+  if (total > 0LL)
+    line << " / " << total << " events (" << 100. * done / total << "%)";
+  else
+    line << " events";
+  line << ", " << rate << " events/s, " << mbps << " MB/s, elapsed " << f_clock(elapsed);
+  if (eta >= 0.)
+    line << ", ETA " << f_clock(eta);
+  if (last_file != "" and !final)
+    line << ", file " << last_file;
+  std::cerr << line.str() << std::endl;
+
+  if (status == "")
+    return;
+
+  // names are dataset and file names, so only quotes and backslashes are escaped
+  auto quote = [] (const std::string &str) {
+    std::string quoted = "\"";
+    for (auto c : str)
+      quoted += (c == '"' or c == '\\') ? std::string("\\") + c : std::string(1, c);
+    return quoted + "\"";
+  };
+
+  const std::string tmp = status + ".tmp";
+  {
+    std::ofstream out(tmp);
+    if (!out)
+      return;
+
+    out << "{\n  \"state\": " << ((final) ? "\"done\"" : "\"running\"") << ",\n  \"time\": "
+        << std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count()
+        << ",\n  \"events\": " << done << ",\n  \"total\": " << total << ",\n  \"elapsed_s\": " << elapsed
+        << ",\n  \"events_per_s\": " << rate << ",\n  \"megabyte_per_s\": " << mbps << ",\n  \"eta_s\": " << eta
+        << ",\n  \"file\": " << quote(last_file) << ",\n  \"sources\": [";
+    for (int iS = 0; iS < v_source.size(); ++iS) {
+      const auto &source = *v_source[iS];
+      out << ((iS == 0) ? "\n" : ",\n") << "    {\"name\": " << quote(source.name) << ", \"events\": " << source.events.load(std::memory_order_relaxed)
+          << ", \"file\": " << quote(source.file) << "}";
+    }
+    out << "\n  ]\n}\n";
+  }
+
+  // a status file that can not be written is not worth stopping the analysis for
+  std::rename(tmp.c_str(), status.c_str());
+}
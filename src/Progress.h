@@ -0,0 +1,104 @@
+#ifndef FWK_PROGRESS_H
+#define FWK_PROGRESS_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: live reporting of the progress of a running analysis, for monitoring batch jobs
+// note: every dataset reporting to the progress has its own event counter, bumped by one relaxed atomic increment per event
+// note: a background thread samples the counters periodically, and reports the events done, events/s, MB/s read off the files, ETA and current file
+// note: the report goes to stderr, and optionally also to a status file in json, which is rewritten atomically so a scraper never sees half of it
+// note: Dataset::analyze starts and stops the reporting by itself; with the Scheduler, give the progress to Scheduler::set_progress instead
+// note: MB/s is from TFile::GetFileBytesRead, which counts every file of the process i.e. also those not belonging to the reporting datasets
+
+#include "Heap.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "TFile.h"
+
+namespace Framework {
+  class Progress {
+  public:
+    /// one reporting dataset
+    /// the counter is on a cache line of its own, as the sources are counted by different threads
+    struct Source {
+      alignas(64) std::atomic<long long> events{0LL};
+      std::string name;
+      std::string file;
+    };
+
+    /// constructor
+    /// every_second_ is the reporting period, status_ the json status file, none if empty
+    Progress(double every_second_ = 30., const std::string &status_ = "");
+
+    /// destructor - stops the reporting if still running
+    ~Progress();
+
+    /// register a source, whose counter is then to be incremented once per event
+    /// the reference stays valid for the lifetime of the progress
+    Source& add_source(const std::string &name);
+
+    /// note the file a source has moved to
+    void set_file(Source &source, const std::string &file);
+
+    /// start reporting, with the total number of events expected over all sources
+    /// a total <= 0 means unknown, and no ETA is given
+    void start(long long total_);
+
+    /// stop reporting, after a final report
+    void stop();
+
+    /// whether the reporting is running
+    bool running() const;
+
+  protected:
+    /// the loop ran by the background thread
+    void report_loop();
+
+    /// make one report
+    void report(bool final);
+
+    /// reporting period and status file
+    std::chrono::duration<double> every_second;
+
+    std::string status;
+
+    /// registered sources
+    std::vector<std::unique_ptr<Source>> v_source;
+
+    /// events expected, and the file most recently moved to by any source
+    long long total;
+
+    std::string last_file;
+
+    /// the previous sample, to compute the rates over the last period
+    std::chrono::steady_clock::time_point begin, previous_time;
+
+    long long begin_events, previous_events;
+
+    long long begin_bytes, previous_bytes;
+
+    /// background reporting machinery
+    bool active;
+
+    bool halt;
+
+    mutable std::mutex mutex;
+
+    std::condition_variable condition;
+
+    std::thread reporter;
+  };
+}
+
+#include "Progress.cc"
+
+#endif
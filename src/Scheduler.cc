@@ -0,0 +1,318 @@
+// -*- C++ -*-
+// author: afiq anuar
+// short: please refer to header for information
+
+Framework::Scheduler::Scheduler(int nthread_, long long grain_) :
+nthread(std::max(1, nthread_)),
+grain(std::max(1LL, grain_)),
+abort(false),
+n_release(0ULL),
+progress(nullptr),
+elapsed(0.)
+{}
+
+
+
+void Framework::Scheduler::add(Dataset<TChain> &dat, const std::string &sample)
+{
+  const std::string sname = (sample == "") ? dat.name : sample;
+  auto iS = std::find_if(std::begin(v_sample), std::end(v_sample), [&sname] (const auto &smp) {return smp->name == sname;});
+
+  if (iS == std::end(v_sample)) {
+    v_sample.emplace_back(std::make_unique<Sample>());
+    iS = std::prev(std::end(v_sample));
+    (*iS)->name = sname;
+    (*iS)->processed = 0LL;
+    (*iS)->pending = 0LL;
+  }
+  else {
+    auto &first = (*iS)->v_replica.front().get();
+    if (&first == &dat)
+      return;
+
+    if (first.entry_range() != dat.entry_range())
+      throw std::invalid_argument( "ERROR: Scheduler::add: dataset " + dat.name + " does not cover the same entries as the other replicas of sample " +
+                                   sname + "!!" );
+  }
+
+  (*iS)->v_replica.emplace_back(std::ref(dat));
+  (*iS)->v_busy.emplace_back(std::make_unique<std::mutex>());
+}
+
+
+
+void Framework::Scheduler::set_progress(Progress &progress_)
+{
+  progress = &progress_;
+}
+
+
+
+void Framework::Scheduler::run()
+{
+  if (v_sample.empty())
+    return;
+
+  // every worker reads its own files concurrently
+  ROOT::EnableThreadSafety();
+
+  plan();
+  abort = false;
+  error = nullptr;
+
+  // every replica counts its own events, and the total is that of the samples, not of the replicas
+  if (progress != nullptr) {
+    long long total = 0LL;
+    for (auto &sample : v_sample) {
+      const auto [first, last] = sample->v_replica.front().get().entry_range();
+      total += last - first;
+
+      for (auto &replica : sample->v_replica)
+        replica.get().set_progress(*progress);
+    }
+    progress->start(total);
+  }
+
+  start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> v_thread;
+  for (int iT = 0; iT < nthread; ++iT)
+    v_thread.emplace_back(&Scheduler::work, this, iT);
+
+  for (auto &thread : v_thread)
+    thread.join();
+
+  elapsed = std::chrono::steady_clock::now() - start;
+
+  if (progress != nullptr)
+    progress->stop();
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+
+
+long long Framework::Scheduler::processed(const std::string &sample) const
+{
+  auto iS = std::find_if(std::begin(v_sample), std::end(v_sample), [&sample] (const auto &smp) {return smp->name == sample;});
+  if (iS == std::end(v_sample))
+    throw std::invalid_argument( "ERROR: Scheduler::processed: sample " + sample + " is not registered!!" );
+
+  return (*iS)->processed.load();
+}
+
+
+
+void Framework::Scheduler::print(std::ostream &out) const
+{
+  int width = 6;
+  for (const auto &sample : v_sample)
+    width = std::max(width, int(sample->name.size()));
+
+  out << "Scheduler ran " << v_sample.size() << " samples on " << nthread << " threads in " << elapsed.count() << " s:\n";
+  out << std::left << std::setw(width) << "sample" << std::right << std::setw(10) << "replicas" << std::setw(16) << "events" << std::setw(12) << "done (s)" << "\n";
+
+  for (const auto &sample : v_sample) {
+    const std::chrono::duration<double> done = sample->done - start;
+    out << std::left << std::setw(width) << sample->name << std::right << std::setw(10) << sample->v_replica.size()
+        << std::setw(16) << sample->processed.load() << std::setw(12) << ((sample->pending == 0LL) ? done.count() : -1.) << "\n";
+  }
+  out << std::flush;
+
+#ifdef FWK_PROFILE
+  Profiler::instance().print(out);
+#endif
+}
+
+
+
+void Framework::Scheduler::plan()
+{
+  // the tasks of each sample in entry order, the largest sample first so that its tasks start early
+  std::vector<Task> v_task;
+  std::vector<int> v_order(v_sample.size());
+  std::iota(std::begin(v_order), std::end(v_order), 0);
+
+  std::vector<long long> v_size(v_sample.size());
+  for (int iS = 0; iS < v_sample.size(); ++iS) {
+    const auto [first, last] = v_sample[iS]->v_replica.front().get().entry_range();
+    v_size[iS] = last - first;
+  }
+  std::stable_sort(std::begin(v_order), std::end(v_order), [&v_size] (int is1, int is2) {return v_size[is1] > v_size[is2];});
+
+  for (int iS : v_order) {
+    auto &dat = v_sample[iS]->v_replica.front().get();
+    const auto [first, last] = dat.entry_range();
+
+    // global cluster boundaries, within the range of the dataset
+    std::vector<long long> v_boundary = {first};
+    long long offset = 0LL;
+    for (const auto &info : dat.catalogue()) {
+      for (auto cluster : info.v_cluster) {
+        if (offset + cluster > first and offset + cluster < last)
+          v_boundary.emplace_back(offset + cluster);
+      }
+      offset += info.entries;
+    }
+    v_boundary.emplace_back(last);
+
+    long long pending = 0LL;
+    for (int iB = 0; iB < v_boundary.size() - 1; ) {
+      int iE = iB + 1;
+      while (iE < v_boundary.size() - 1 and v_boundary[iE] - v_boundary[iB] < grain)
+        ++iE;
+
+      if (v_boundary[iE] > v_boundary[iB]) {
+        v_task.push_back({iS, v_boundary[iB], v_boundary[iE]});
+        ++pending;
+      }
+      iB = iE;
+    }
+
+    v_sample[iS]->processed = 0LL;
+    v_sample[iS]->pending = pending;
+    v_sample[iS]->done = std::chrono::steady_clock::now();
+  }
+
+  // contiguous blocks, so that a worker mostly runs consecutive clusters of the same files
+  v_queue.clear();
+  for (int iT = 0; iT < nthread; ++iT)
+    v_queue.emplace_back(std::make_unique<Queue>());
+
+  for (int iK = 0; iK < v_task.size(); ++iK) {
+    auto &queue = *v_queue[(iK * nthread) / v_task.size()];
+    queue.tasks.emplace_back(v_task[iK]);
+    ++queue.size;
+  }
+}
+
+
+
+void Framework::Scheduler::work(int worker)
+{
+  // the replica held by this worker, kept across tasks of the same sample to continue using its tree cache
+  int held_sample = -1, held_replica = -1;
+  auto f_release = [this, &held_sample, &held_replica] () {
+    if (held_sample > -1) {
+      v_sample[held_sample]->v_busy[held_replica]->unlock();
+      {
+        std::lock_guard<std::mutex> lock(release_mutex);
+        ++n_release;
+      }
+      release_condition.notify_all();
+    }
+    held_sample = -1;
+    held_replica = -1;
+  };
+
+  // consecutive tasks found with all their replicas busy, and the release count when the first of them was found
+  std::size_t n_blocked = 0;
+  unsigned long long seen = 0ULL;
+
+  Task task;
+  while (!abort and next(worker, task)) {
+    auto &sample = *v_sample[task.sample];
+
+    if (held_sample != task.sample) {
+      f_release();
+
+      if (n_blocked == 0) {
+        std::lock_guard<std::mutex> lock(release_mutex);
+        seen = n_release;
+      }
+
+      for (int iR = 0; iR < sample.v_busy.size(); ++iR) {
+        if (sample.v_busy[iR]->try_lock()) {
+          held_sample = task.sample;
+          held_replica = iR;
+          break;
+        }
+      }
+
+      // all replicas are busy; put the task back behind the others and look for something else
+      // once every task in the queue has been found so, wait for a replica to be released instead of going round them again
+      if (held_sample == -1) {
+        std::size_t queued = 0;
+        {
+          std::lock_guard<std::mutex> lock(v_queue[worker]->mutex);
+          v_queue[worker]->tasks.emplace_back(task);
+          ++v_queue[worker]->size;
+          queued = v_queue[worker]->tasks.size();
+        }
+
+        if (++n_blocked > queued) {
+          std::unique_lock<std::mutex> lock(release_mutex);
+          release_condition.wait(lock, [this, seen] () { return abort or n_release != seen; });
+          n_blocked = 0;
+        }
+        continue;
+      }
+    }
+    n_blocked = 0;
+
+    try {
+      sample.v_replica[held_replica].get().analyze_range(task.first, task.last);
+
+      // only a task that ran through is counted, so that a failed sample is never reported as done
+      sample.processed += task.last - task.first;
+      if (--sample.pending == 0LL)
+        sample.done = std::chrono::steady_clock::now();
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error)
+        error = std::current_exception();
+      abort = true;
+    }
+
+    // so that the waiting workers see the abort
+    if (abort) {
+      std::lock_guard<std::mutex> lock(release_mutex);
+      release_condition.notify_all();
+    }
+  }
+
+  f_release();
+}
+
+
+
+bool Framework::Scheduler::next(int worker, Task &task)
+{
+  {
+    auto &own = *v_queue[worker];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = own.tasks.front();
+      own.tasks.pop_front();
+      --own.size;
+      return true;
+    }
+  }
+
+  // steal from the back of the fullest queue, i.e. the tasks its owner would reach last
+  while (true) {
+    int victim = -1;
+    std::size_t most = 0;
+    for (int iT = 0; iT < v_queue.size(); ++iT) {
+      const auto size = v_queue[iT]->size.load();
+      if (iT != worker and size > most) {
+        victim = iT;
+        most = size;
+      }
+    }
+
+    if (victim == -1)
+      return false;
+
+    auto &other = *v_queue[victim];
+    std::lock_guard<std::mutex> lock(other.mutex);
+    if (!other.tasks.empty()) {
+      task = other.tasks.back();
+      other.tasks.pop_back();
+      --other.size;
+      return true;
+    }
+  }
+}
@@ -0,0 +1,131 @@
+#ifndef FWK_SCHEDULER_H
+#define FWK_SCHEDULER_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: running many datasets in one process on a work-stealing thread pool
+// note: each dataset is broken into tasks of one or more TTree clusters, which are dealt out to the workers in contiguous blocks
+// note: a worker that runs out of tasks steals from the far end of the fullest queue, so no core idles until the whole lot is done
+// note: a dataset reads through a single tree and its collections, so it can only ever run one task at a time
+// note: to spread a large sample over several cores, register several replicas of it under the same sample name
+// note: i.e. separately constructed datasets over the same files, each with its own collections, analyzer and histograms
+// note: the outputs of the replicas are then combined with Histogram::add, Cutflow::merge etc
+// note: a worker whose tasks all wait on busy replicas sleeps until a replica is released, rather than spinning over them
+// note: the queues are mutex-guarded rather than lock-free, as a task is a whole cluster and the locking is negligible next to it
+
+#include "Dataset.h"
+
+#include <iomanip>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <exception>
+
+#include "TROOT.h"
+
+namespace Framework {
+  class Scheduler {
+  public:
+    /// constructor
+    /// nthread_ is the number of worker threads, defaulting to the number of cores
+    /// grain_ is the minimum number of entries in a task; consecutive clusters are merged until this is reached
+    Scheduler(int nthread_ = std::thread::hardware_concurrency(), long long grain_ = 1LL);
+
+    /// register a dataset to be run
+    /// the dataset must already be associated, and have its analyzer set
+    /// datasets registered with the same non-empty sample name are taken as replicas of one another, and must cover the same entries
+    /// if sample is empty, the dataset name is used
+    void add(Dataset<TChain> &dat, const std::string &sample = "");
+
+    /// report the progress of the run to a progress reporter, see Progress.h
+    /// every registered dataset is made to report to it, and the reporting runs for as long as run() does
+    void set_progress(Progress &progress_);
+
+    /// run all the registered datasets to completion
+    /// any exception thrown by an analyzer stops the workers, and is rethrown here
+    void run();
+
+    /// number of events of a sample processed by the last run, counting only the tasks that ran through without throwing
+    long long processed(const std::string &sample) const;
+
+    /// print the number of events processed and the time taken, per sample
+    /// a sample whose tasks did not all run through is printed with a done time of -1
+    /// and when compiled with FWK_PROFILE, the time per event spent in each stage over all workers
+    void print(std::ostream &out = std::cout) const;
+
+  protected:
+    /// a unit of work: the range of entries [first, last) of a sample
+    struct Task {
+      int sample;
+      long long first, last;
+    };
+
+    /// the datasets making up one sample, and which of them are currently in use
+    struct Sample {
+      std::string name;
+      std::vector<std::reference_wrapper<Dataset<TChain>>> v_replica;
+      std::vector<std::unique_ptr<std::mutex>> v_busy;
+      std::atomic<long long> processed;
+      std::atomic<long long> pending;
+      std::chrono::steady_clock::time_point done;
+    };
+
+    /// per-worker task queue
+    /// size mirrors tasks.size(), so that thieves can pick a victim without taking every lock
+    struct Queue {
+      std::deque<Task> tasks;
+      std::atomic<std::size_t> size = 0;
+      std::mutex mutex;
+    };
+
+    /// break the registered samples into tasks and deal them out to the queues
+    void plan();
+
+    /// the loop ran by each worker
+    void work(int worker);
+
+    /// take the next task of a worker, stealing one if its own queue is empty
+    /// returns false if there is no task left anywhere
+    bool next(int worker, Task &task);
+
+    /// number of worker threads and task grain
+    int nthread;
+
+    long long grain;
+
+    /// registered samples
+    std::vector<std::unique_ptr<Sample>> v_sample;
+
+    /// task queues, one per worker
+    std::vector<std::unique_ptr<Queue>> v_queue;
+
+    /// the first exception thrown by a worker, and the flag telling the others to stop
+    std::exception_ptr error;
+
+    std::mutex error_mutex;
+
+    std::atomic<bool> abort;
+
+    /// count of replica releases, signalled to the workers waiting for one
+    unsigned long long n_release;
+
+    std::mutex release_mutex;
+
+    std::condition_variable release_condition;
+
+    /// progress reporter, if any
+    Progress *progress;
+
+    /// when the run started, and how long it took
+    std::chrono::steady_clock::time_point start;
+
+    std::chrono::duration<double> elapsed;
+  };
+}
+
+#include "Scheduler.cc"
+
+#endif
@@ -0,0 +1,241 @@
+// -*- C++ -*-
+// author: afiq anuar
+// short: please refer to header for information
+
+#include <cstdio>
+
+Framework::Snapshot::Snapshot(const std::string &filename_, long long every_event_, double every_second_) :
+filename(filename_),
+every_event(every_event_),
+every_second(every_second_),
+next_entry(every_event_),
+next_time(std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(every_second)),
+pending_entry(-1LL),
+writing(false),
+stop(false)
+{
+  if (filename == "")
+    throw std::invalid_argument( "ERROR: Snapshot: the snapshot filename must not be empty!!" );
+
+  // the writer thread does its own file I/O concurrently with the event loop
+  ROOT::EnableThreadSafety();
+  writer = std::thread(&Snapshot::write_loop, this);
+}
+
+
+
+Framework::Snapshot::~Snapshot()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  condition.notify_all();
+
+  if (writer.joinable())
+    writer.join();
+}
+
+
+
+void Framework::Snapshot::add_histogram(Histogram &hist)
+{
+  auto iH = std::find_if(std::begin(v_hist), std::end(v_hist), [&hist] (const auto &h) {return &h.get() == &hist;});
+  if (iH == std::end(v_hist))
+    v_hist.emplace_back(std::ref(hist));
+}
+
+
+
+void Framework::Snapshot::add_tree(Tree &tree)
+{
+  auto iT = std::find_if(std::begin(v_tree), std::end(v_tree), [&tree] (const auto &t) {return &t.get() == &tree;});
+  if (iT == std::end(v_tree))
+    v_tree.emplace_back(std::ref(tree));
+}
+
+
+
+void Framework::Snapshot::add_cutflow(Cutflow &cutflow)
+{
+  auto iC = std::find_if(std::begin(v_cutflow), std::end(v_cutflow), [&cutflow] (const auto &c) {return &c.get() == &cutflow;});
+  if (iC == std::end(v_cutflow))
+    v_cutflow.emplace_back(std::ref(cutflow));
+}
+
+
+
+void Framework::Snapshot::start(long long entry)
+{
+  next_entry = entry + every_event;
+  next_time = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(every_second);
+}
+
+
+
+bool Framework::Snapshot::due(long long entry)
+{
+  if (every_event > 0LL and entry >= next_entry)
+    return true;
+
+  if (every_second.count() > 0. and (entry & 1023LL) == 0LL)
+    return std::chrono::steady_clock::now() >= next_time;
+
+  return false;
+}
+
+
+
+void Framework::Snapshot::take(long long entry)
+{
+  std::vector<std::unique_ptr<TH1>> v_clone;
+  for (const auto &hist : v_hist) {
+    for (const auto &hf : hist.get().histograms())
+      v_clone.emplace_back(static_cast<TH1 *>(hf.first->Clone()));
+  }
+
+  for (const auto &cutflow : v_cutflow) {
+    v_clone.emplace_back(cutflow.get().histogram(true));
+    v_clone.emplace_back(cutflow.get().histogram(false));
+  }
+
+  for (auto &tree : v_tree)
+    tree.get().flush();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    v_pending = std::move(v_clone);
+    pending_entry = entry;
+  }
+  condition.notify_all();
+
+  next_entry = entry + every_event;
+  next_time = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(every_second);
+}
+
+
+
+void Framework::Snapshot::finish()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  condition.wait(lock, [this] () { return pending_entry < 0LL and !writing; });
+}
+
+
+
+long long Framework::Snapshot::last_entry(const std::string &filename)
+{
+  std::unique_ptr<TFile> file(TFile::Open(filename.c_str(), "read"));
+  if (file == nullptr or file->IsZombie())
+    return -1LL;
+
+  TParameter<Long64_t> *entry = nullptr;
+  file->GetObject("snapshot_entry", entry);
+  return (entry != nullptr) ? entry->GetVal() : -1LL;
+}
+
+
+
+long long Framework::Snapshot::restore()
+{
+  const auto entry = last_entry(filename);
+  if (entry < 0LL)
+    return -1LL;
+
+  std::unique_ptr<TFile> file(TFile::Open(filename.c_str(), "read"));
+  for (auto &hist : v_hist) {
+    for (const auto &hf : hist.get().histograms()) {
+      TH1 *saved = nullptr;
+      file->GetObject(hf.first->GetName(), saved);
+      if (saved == nullptr)
+        throw std::runtime_error( "ERROR: Snapshot::restore: histogram " + std::string(hf.first->GetName()) + " is not in the snapshot " +
+                                  filename + ". Was the snapshot made by the same analysis? Aborting!!" );
+
+      hf.first->Add(saved);
+    }
+  }
+
+  // the counts are read back off the histograms of Cutflow::histogram: the raw counts, and the weighted sums with sqrt(sumw2) as error
+  for (auto &cutflow : v_cutflow) {
+    auto &cut = cutflow.get();
+    TH1 *raw = nullptr, *weighted = nullptr;
+    file->GetObject((cut.name + "_raw").c_str(), raw);
+    file->GetObject((cut.name + "_weighted").c_str(), weighted);
+    if (raw == nullptr or weighted == nullptr or raw->GetNbinsX() != cut.n_steps())
+      throw std::runtime_error( "ERROR: Snapshot::restore: cutflow " + cut.name + " is not in the snapshot " + filename +
+                                ", or has different steps. Was the snapshot made by the same analysis? Aborting!!" );
+
+    std::vector<Cutflow::Counter> v_count(cut.n_steps());
+    for (int iS = 0; iS < v_count.size(); ++iS) {
+      if (cut.step_index(raw->GetXaxis()->GetBinLabel(iS + 1)) != iS)
+        throw std::runtime_error( "ERROR: Snapshot::restore: the steps of cutflow " + cut.name + " differ from those in the snapshot " + filename + ". Aborting!!" );
+
+      v_count[iS].raw = std::llround(raw->GetBinContent(iS + 1));
+      v_count[iS].sumw = weighted->GetBinContent(iS + 1);
+      v_count[iS].sumw2 = weighted->GetBinError(iS + 1) * weighted->GetBinError(iS + 1);
+    }
+    cut.add(v_count);
+  }
+
+  return entry;
+}
+
+
+
+std::string Framework::Snapshot::resumed_filename(const std::string &filename)
+{
+  const auto dot = filename.rfind('.');
+  const auto stem = (dot == std::string::npos) ? filename : filename.substr(0, dot);
+  const auto extension = (dot == std::string::npos) ? "" : filename.substr(dot);
+
+  std::string resumed = stem + "_resumed" + extension;
+  for (int iR = 2; std::ifstream(resumed).good(); ++iR)
+    resumed = stem + "_resumed_" + std::to_string(iR) + extension;
+
+  return resumed;
+}
+
+
+
+void Framework::Snapshot::write_loop()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    condition.wait(lock, [this] () { return stop or pending_entry >= 0LL; });
+    if (pending_entry < 0LL and stop)
+      return;
+
+    auto v_clone = std::move(v_pending);
+    const auto entry = pending_entry;
+    pending_entry = -1LL;
+    writing = true;
+
+    lock.unlock();
+    write(v_clone, entry);
+    lock.lock();
+
+    writing = false;
+    condition.notify_all();
+  }
+}
+
+
+
+void Framework::Snapshot::write(std::vector<std::unique_ptr<TH1>> &v_clone, long long entry) const
+{
+  const std::string tmpname = filename + ".tmp";
+  {
+    auto file = std::make_unique<TFile>(tmpname.c_str(), "recreate");
+    file->cd();
+
+    for (auto &hist : v_clone)
+      hist->Write();
+
+    TParameter<Long64_t>("snapshot_entry", entry).Write();
+    file->Close();
+  }
+
+  if (std::rename(tmpname.c_str(), filename.c_str()) != 0)
+    std::cerr << "WARNING: Snapshot::write: unable to move " << tmpname << " to " << filename <<
+      ", the previous snapshot is kept." << std::endl;
+}
@@ -0,0 +1,130 @@
+#ifndef FWK_SNAPSHOT_H
+#define FWK_SNAPSHOT_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: periodic snapshots of the analysis output during long jobs, and resuming from them
+// note: histograms are cloned on the event loop thread, and written out by a background thread into filename.tmp
+// note: which is then renamed to filename, so the snapshot file on disk is always complete
+// note: trees are not copied; instead their baskets are flushed and the header saved into their own file (TTree::AutoSave)
+// note: this has to happen on the event loop thread as TTree is not thread-safe, but is cheap compared to writing them all out
+// note: as the Tree constructor recreates its file, a resumed job should write its tree into a different file, see resumed_filename()
+// note: cutflows are saved as their histograms (see Cutflow::histogram) and added back on restore, so a resumed job continues their counts
+// note: the cutflow counts may be read while other threads count into them, see Cutflow::counts(); the histograms may not, so they are to be filled by the event loop thread only
+
+#include "Histogram.h"
+#include "Tree.h"
+#include "Cutflow.h"
+
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "TROOT.h"
+#include "TParameter.h"
+
+namespace Framework {
+  class Snapshot {
+  public:
+    /// no default constructor
+    Snapshot() = delete;
+
+    /// constructor
+    /// filename is where the snapshots are written
+    /// a snapshot is taken every every_event processed events, or every_second seconds, whichever comes first
+    /// values <= 0 disable the respective condition
+    Snapshot(const std::string &filename_, long long every_event_, double every_second_ = 0.);
+
+    /// destructor - waits for any pending write
+    ~Snapshot();
+
+    /// histograms whose content is to be included in the snapshots
+    void add_histogram(Histogram &hist);
+
+    /// trees whose baskets are to be flushed at each snapshot
+    void add_tree(Tree &tree);
+
+    /// cutflows whose counts are to be included in the snapshots
+    /// those registered with the dataset through Dataset::add_cutflow are added by Dataset::analyze
+    void add_cutflow(Cutflow &cutflow);
+
+    /// count the snapshot conditions from the first entry to be analyzed, and from now
+    /// called by Dataset::analyze, so that a resumed job or a shard not starting at 0 is not snapshot right away
+    void start(long long entry);
+
+    /// whether a snapshot should be taken after processing the given entry
+    /// to be called once per event, so it is kept cheap: the clock is consulted only once every 1024 entries
+    bool due(long long entry);
+
+    /// take a snapshot including all events up to and including the given entry
+    /// if the previous snapshot is still being written, it is superseded by this one
+    void take(long long entry);
+
+    /// wait for the pending write to be done
+    void finish();
+
+    /// read the last entry that is included in an existing snapshot file
+    /// returns -1 if there is no usable snapshot
+    static long long last_entry(const std::string &filename);
+
+    /// add the histogram contents and cutflow counts in the snapshot file to the registered histograms and cutflows
+    /// returns the last entry included in the snapshot, or -1 if there is no snapshot to restore from
+    long long restore();
+
+    /// the file a resumed job is to write its tree into, given the one the job was first run with e.g. tree.root
+    /// that is tree_resumed.root, or tree_resumed_2.root, tree_resumed_3.root... if it exists already
+    /// so that resuming again does not overwrite the entries written by the previous resumes
+    static std::string resumed_filename(const std::string &filename);
+
+    /// name of the snapshot file
+    std::string filename;
+
+  protected:
+    /// the writing loop ran by the background thread
+    void write_loop();
+
+    /// write one snapshot
+    void write(std::vector<std::unique_ptr<TH1>> &v_clone, long long entry) const;
+
+    /// snapshot conditions
+    long long every_event;
+
+    std::chrono::duration<double> every_second;
+
+    /// entry and time at which the next snapshot is due
+    long long next_entry;
+
+    std::chrono::steady_clock::time_point next_time;
+
+    /// registered outputs
+    std::vector<std::reference_wrapper<Histogram>> v_hist;
+
+    std::vector<std::reference_wrapper<Tree>> v_tree;
+
+    std::vector<std::reference_wrapper<Cutflow>> v_cutflow;
+
+    /// the snapshot waiting to be written, and its entry
+    std::vector<std::unique_ptr<TH1>> v_pending;
+
+    long long pending_entry;
+
+    /// background writing machinery
+    bool writing;
+
+    bool stop;
+
+    std::mutex mutex;
+
+    std::condition_variable condition;
+
+    std::thread writer;
+  };
+}
+
+#include "Snapshot.cc"
+
+#endif
@@ -140,6 +140,7 @@ bool Framework::Tree::make_array_branches(Group &group, Attributes &&...attrs)
 
 void Framework::Tree::fill()
 {
+  FWK_PROFILE_SCOPE(tree_fill, ptr->GetName());
   for (auto &branch : v_branch)
     std::get<1>(branch)();
 
@@ -154,3 +155,43 @@ void Framework::Tree::save() const
   ptr->Write();
 }
 
+
+
+
+void Framework::Tree::flush()
+{
+  file->cd();
+  ptr->AutoSave("FlushBaskets SaveSelf");
+}
+
+
+
+long long Framework::merge_trees(const std::vector<std::string> &v_file, const std::string &output, const std::string &treename, int compression)
+{
+  if (v_file.empty())
+    return 0LL;
+
+  std::vector<int> v_compression;
+  for (const auto &name : v_file) {
+    std::unique_ptr<TFile> file(TFile::Open(name.c_str(), "read"));
+    if (file == nullptr or file->IsZombie())
+      throw std::runtime_error( "ERROR: merge_trees: unable to read the file " + name + ". Aborting!!" );
+
+    v_compression.emplace_back(file->GetCompressionSettings());
+  }
+
+  if (compression < 0)
+    compression = v_compression.front();
+
+  const bool fast = std::all_of(std::begin(v_compression), std::end(v_compression), [compression] (int comp) {return comp == compression;});
+
+  TChain chain(treename.c_str());
+  for (const auto &name : v_file)
+    chain.Add(name.c_str());
+
+  auto file = std::make_unique<TFile>(output.c_str(), "recreate", "", compression);
+  auto nentry = chain.Merge(file.get(), 0, (fast) ? "fast keep" : "keep");
+  file->Close();
+
+  return nentry;
+}
@@ -11,6 +11,7 @@
 
 #include "TFile.h"
 #include "TTree.h"
+#include "TChain.h"
 
 namespace Framework {
   class Tree {
@@ -45,6 +46,10 @@ namespace Framework {
     /// save the tree into a ROOT file
     void save(/*const std::string &name*/) const;
 
+    /// flush the baskets and the tree header into the file
+    /// so that the entries filled so far are readable even if the job is killed later on
+    void flush();
+
   protected:
     // FIXME https://root-forum.cern.ch/t/follow-up-on-ram-vs-disk-resident-ttree-compression-bug/40775
     // for the moment use disk-resident tree as workaround
@@ -64,6 +69,12 @@ namespace Framework {
     /// which, even though the counter branch clash is checkable, is more headache than it's worth
     std::vector<std::tuple<std::string, std::function<void()>, std::vector<TBranch *>>> v_branch;
   };
+
+  /// merge the trees of the same name in a list of files into one output file
+  /// when all inputs share the same compression setting, and it matches the requested one (-1 to take it from the inputs)
+  /// the baskets are copied as they are without being decompressed ie fast cloning
+  /// returns the number of merged entries
+  long long merge_trees(const std::vector<std::string> &v_file, const std::string &output, const std::string &treename, int compression = -1);
 }
 
 #include "Tree.cc"
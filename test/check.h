@@ -0,0 +1,68 @@
+#ifndef FWK_TEST_CHECK_H
+#define FWK_TEST_CHECK_H
+
+// -*- C++ -*-
+// author: afiq anuar
+// short: the little that the tests here share: named checks that are tallied, and a summary that becomes the exit code
+// note: a failed check prints what was checked and, for the numerical ones, both values; the test carries on so that all failures show
+
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <functional>
+
+class Checks {
+public:
+  /// name is that of the test, printed in the summary
+  explicit Checks(const std::string &name_) : name(name_), n_check(0), n_fail(0) {}
+
+  /// a condition that must hold
+  bool operator()(bool pass, const std::string &what)
+  {
+    ++n_check;
+    if (!pass) {
+      ++n_fail;
+      std::cout << name << ": FAILED " << what << std::endl;
+    }
+    return pass;
+  }
+
+  /// a value that must be within tolerance of the expected one, relative for large values and absolute for small ones
+  bool near(double value, double expected, double tolerance, const std::string &what)
+  {
+    const bool pass = std::abs(value - expected) <= tolerance * std::max(1., std::abs(expected));
+    if (!(*this)(pass, what))
+      std::cout << std::setprecision(10) << "    got " << value << ", expected " << expected << " within " << tolerance << std::endl;
+    return pass;
+  }
+
+  /// a call that must throw the given exception type
+  template <typename Exception>
+  bool throws(const std::function<void()> &call, const std::string &what)
+  {
+    try {
+      call();
+    }
+    catch (const Exception &) {
+      return (*this)(true, what);
+    }
+    catch (...) {
+      return (*this)(false, what + " (threw something else)");
+    }
+    return (*this)(false, what + " (did not throw)");
+  }
+
+  /// print the summary, and return the exit code of the test
+  int summary() const
+  {
+    std::cout << name << ": " << n_check - n_fail << " of " << n_check << " checks passed" << std::endl;
+    return (n_fail == 0) ? 0 : 1;
+  }
+
+protected:
+  std::string name;
+  int n_check, n_fail;
+};
+
+#endif
@@ -0,0 +1,29 @@
+# compiles and runs every test_*.cc here, then a smoke run of the benchmark pipeline, stopping at the first that fails
+# run from this directory as ./run.sh, or ./run.sh test_x to run only test_x
+set -e
+#
+#
+#
+flags="$(root-config --cflags --evelibs) -std=c++17 -O3 -Wall -Wextra -Wpedantic -Werror -Wno-float-equal -Wno-sign-compare -I ../plugins/ -I ../src/"
+tests=${@:-$(ls test_*.cc | sed 's/\.cc$//')}
+for filename in ${tests}; do
+  rm -rf ${filename}
+  g++ ${flags} -o ${filename} ${filename}.cc
+  ./${filename}
+  rm -f ${filename}
+done
+#
+#
+#
+if [ $# -eq 0 ]; then
+  # the whole pipeline over a few generated events, with the solver and the trees on so that every part of it is made and run
+  for filename in make_nanoaod_like benchmark_pipeline; do
+    rm -rf ${filename}
+    g++ ${flags} -o ${filename} ../exec/${filename}.cc
+  done
+
+  ./make_nanoaod_like --output smoke_input --files 2 --events 500
+  ./benchmark_pipeline --threads 1 --threads 2 --solve --output smoke_output smoke_input_0.root smoke_input_1.root
+  rm -f make_nanoaod_like benchmark_pipeline smoke_input_*.root smoke_output*.root
+  echo "benchmark_pipeline smoke run: passed"
+fi
@@ -0,0 +1,69 @@
+// checks that filters, counts and selections on a Batch see the transforms, whether or not the batch has been sealed
+// compile and run with the other tests by ./run.sh
+
+#include "Batch.h"
+
+#include "misc/synthetic_group.h"
+
+#include "check.h"
+
+int main() {
+  using namespace Framework;
+
+  SyntheticGroup<int, float> jet("jet", 2, 0, {6., 16});
+  jet.add_attribute<float>("pt", [] (SyntheticRandom &rng) { return static_cast<float>(rng.exponential(50.)); });
+  jet.add_attribute<float>("eta", [] (SyntheticRandom &rng) { return static_cast<float>(rng.normal(0., 2.)); });
+
+  Batch b_jet(jet, {}, 100, 8);
+  b_jet.transform_attribute("abs_eta", [] (float eta) -> float { return std::abs(eta); }, "eta");
+  b_jet.transform_attribute("central", [] (float abs_eta) -> int { return abs_eta < 2.4f; }, "abs_eta");
+
+  Checks check("test_batch");
+  for (int iB = 0; iB < 3; ++iB) {
+    const std::string batch = "batch " + std::to_string(iB) + ((iB % 2) ? " (sealed midway): " : ": ");
+    b_jet.clear();
+    for (long long entry = 100 * iB; entry < 100 * (iB + 1); ++entry)
+      b_jet.append(entry);
+
+    // the expected outcome, worked out by hand from the batched attributes
+    const auto v_pt = b_jet.get<float>("pt");
+    const auto v_eta = b_jet.get<float>("eta");
+    const auto &v_offset = b_jet.offsets();
+    std::vector<int> v_expect, v_expect_count(b_jet.n_events(), 0);
+    for (int iV = 0; iV < b_jet.n_events(); ++iV) {
+      for (int iE = v_offset[iV]; iE < v_offset[iV + 1]; ++iE) {
+        if (v_pt[iE] > 30.f and std::abs(v_eta[iE]) < 2.4f) {
+          v_expect.emplace_back(iE);
+          ++v_expect_count[iV];
+        }
+      }
+    }
+
+    // none of the transforms have been evaluated at this point, as the batch is not sealed
+    const auto filter_central = [] (float pt, int central) { return pt > 30.f and central; };
+    check(b_jet.filter(filter_central, "pt", "central") == v_expect, batch + "filter on an unsealed transform");
+    check(b_jet.count(filter_central, "pt", "central") == v_expect_count, batch + "count on an unsealed transform");
+
+    // half of the batches are sealed only after the first selection, so that the selection is applied to the transforms too
+    b_jet.update_indices(b_jet.filter([] (float pt) { return pt > 30.f; }, "pt"));
+    if (iB % 2)
+      b_jet.seal();
+    b_jet.update_indices(b_jet.filter([] (float abs_eta) { return abs_eta < 2.4f; }, "abs_eta"));
+
+    check(b_jet.n_elements() == v_expect.size() and b_jet.counts() == v_expect_count, batch + "offsets after update_indices");
+    for (const auto &attr : b_jet.attributes())
+      check(std::visit([] (const auto &vec) { return vec.size(); }, b_jet(attr)) == v_expect.size(), batch + "size of " + attr + " after update_indices");
+
+    bool pt = true, abs_eta = true, central = true;
+    for (int iE = 0; iE < v_expect.size(); ++iE) {
+      pt = pt and b_jet.get<float>("pt")[iE] == v_pt[v_expect[iE]];
+      abs_eta = abs_eta and b_jet.get<float>("abs_eta")[iE] == std::abs(v_eta[v_expect[iE]]);
+      central = central and b_jet.get<int>("central")[iE] == 1;
+    }
+    check(pt, batch + "pt after update_indices");
+    check(abs_eta, batch + "abs_eta after update_indices");
+    check(central, batch + "central after update_indices");
+  }
+
+  return check.summary();
+}
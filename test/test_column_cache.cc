@@ -0,0 +1,145 @@
+// a cache built off two files reads back every value they hold, single and array, in any entry order and with either codec
+// and is refused when made for other files or branches, or truncated; several builds of the same cache at once all succeed
+// compile and run with the other tests by ./run.sh; writes and removes test_column_cache_* in the working directory
+
+#include "ColumnCache.h"
+
+#include "TROOT.h"
+
+#include "check.h"
+
+#include <thread>
+#include <memory>
+#include <iterator>
+#include <cstdio>
+
+// what ColumnCache::build reads of the catalogue, see Dataset::FileInfo
+struct FileInfo {
+  std::string name;
+  long long entries;
+  std::vector<long long> v_cluster;
+};
+
+// the values of the global entry e: run is e, n is e % 4, and x holds n values e + 0.25 i
+bool read_entry(Framework::ColumnCache &cache, long long entry)
+{
+  const int crun = cache.column("run"), cn = cache.column("n"), cx = cache.column("x");
+  int run = -1, n = -1;
+  float x[3] = {-1.f, -1.f, -1.f};
+
+  bool pass = cache.read(crun, entry, &run) == 1 and run == entry;
+  pass = pass and cache.read(cn, entry, &n) == 1 and n == entry % 4;
+  pass = pass and cache.read(cx, entry, x) == n;
+  for (int iX = 0; iX < n and pass; ++iX)
+    pass = x[iX] == entry + (0.25f * iX);
+  return pass;
+}
+
+
+
+int main() {
+  using namespace Framework;
+  Checks check("test_column_cache");
+
+  // the baskets are flushed every 50 entries, so that the files have clusters at 0, 50, 100 and 0, 50
+  const std::vector<FileInfo> v_info = {{"test_column_cache_0.root", 120, {0, 50, 100}}, {"test_column_cache_1.root", 80, {0, 50}}};
+  long long offset = 0LL;
+  for (const auto &info : v_info) {
+    TFile file(info.name.c_str(), "recreate");
+    TTree tree("Events", "");
+    tree.SetAutoFlush(50);
+    int run = 0, n = 0;
+    float x[3] = {};
+    tree.Branch("run", &run, "run/I");
+    tree.Branch("n", &n, "n/I");
+    tree.Branch("x", x, "x[n]/F");
+    for (int iE = 0; iE < info.entries; ++iE) {
+      run = offset + iE;
+      n = run % 4;
+      for (int iX = 0; iX < n; ++iX)
+        x[iX] = run + (0.25f * iX);
+      tree.Fill();
+    }
+    tree.Write();
+    file.Close();
+    offset += info.entries;
+  }
+
+  // listed out of order, as build puts the single values first
+  const std::vector<ColumnCache::Column> v_column = {{"x", sizeof(float), "n"}, {"run", sizeof(int), ""}, {"n", sizeof(int), ""}};
+  const std::uint64_t catalogue_hash = ColumnCache::hash("catalogue"), column_hash = ColumnCache::hash("columns");
+  const std::string path = "test_column_cache.cache";
+
+  check.throws<std::invalid_argument>([] () { ColumnCache cache(""); }, "empty path refused");
+
+  for (auto codec : {ColumnCache::Codec::none, ColumnCache::Codec::lz4}) {
+    const std::string what = (codec == ColumnCache::Codec::none) ? "uncompressed: " : "lz4: ";
+    std::remove(path.c_str());
+
+    ColumnCache cache(path);
+    check(!cache.open(catalogue_hash, column_hash), what + "no cache before the build");
+    cache.build("Events", v_info, v_column, codec, catalogue_hash, column_hash);
+    check(cache.open(catalogue_hash, column_hash), what + "cache usable after the build");
+    check(cache.entries() == 200LL, what + "200 entries");
+    check(cache.column("run") > -1 and cache.column("n") > -1 and cache.column("x") > -1 and cache.column("y") == -1, what + "columns of the branches");
+    check(cache.maximum(cache.column("x")) == 3 and cache.maximum(cache.column("n")) == 3 and cache.maximum(cache.column("run")) == 1,
+          what + "maxima of the columns");
+
+    bool forward = true, backward = true;
+    for (long long iE = 0; iE < 200; ++iE)
+      forward = read_entry(cache, iE) and forward;
+    for (long long iE = 199; iE > -1; iE -= 7)
+      backward = read_entry(cache, iE) and backward;
+    check(forward, what + "every entry read in order");
+    check(backward, what + "entries read backwards across the clusters");
+    check.throws<std::out_of_range>([&cache] () { int run = 0; cache.read(cache.column("run"), 200, &run); }, what + "entry past the end refused");
+
+    check(!cache.open(ColumnCache::hash("other files"), column_hash), what + "cache for other files refused");
+    check(!cache.open(catalogue_hash, ColumnCache::hash("other columns")), what + "cache for other columns refused");
+  }
+
+  // a copy cut short of its table
+  {
+    std::ifstream in(path, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(content.data(), content.size() - 16);
+  }
+  ColumnCache truncated(path);
+  check(!truncated.open(catalogue_hash, column_hash), "truncated cache refused");
+
+  // as datasets over the same files would, each building the cache on its own thread
+  ROOT::EnableThreadSafety();
+  std::remove(path.c_str());
+  std::vector<std::unique_ptr<ColumnCache>> v_cache;
+  std::vector<std::thread> v_thread;
+  std::atomic<int> n_built = 0;
+  for (int iT = 0; iT < 4; ++iT) {
+    v_cache.emplace_back(std::make_unique<ColumnCache>(path));
+    v_thread.emplace_back([&, cache = v_cache.back().get()] () {
+        try {
+          cache->build("Events", v_info, v_column, ColumnCache::Codec::lz4, catalogue_hash, column_hash);
+          ++n_built;
+        }
+        catch (const std::exception &ex) {
+          std::cout << ex.what() << std::endl;
+        }
+      });
+  }
+  for (auto &thread : v_thread)
+    thread.join();
+
+  check(n_built == 4, "4 concurrent builds of the same cache");
+  bool concurrent = true;
+  for (auto &cache : v_cache) {
+    concurrent = cache->open(catalogue_hash, column_hash) and concurrent;
+    for (long long iE = 0; iE < 200 and concurrent; ++iE)
+      concurrent = read_entry(*cache, iE);
+  }
+  check(concurrent, "the cache left by the concurrent builds read back by all");
+
+  std::remove(path.c_str());
+  for (const auto &info : v_info)
+    std::remove(info.name.c_str());
+  return check.summary();
+}
@@ -0,0 +1,132 @@
+// the combination and permutation indexers on groups with known selections: exact outputs of small cases
+// counts against the closed forms and a brute force enumeration, slots sharing a group not next to each other, and pruning
+// compile and run with the other tests by ./run.sh
+
+#include "misc/combinatorics.h"
+
+#include "check.h"
+
+#include <algorithm>
+#include <numeric>
+
+// just the part of the group interface the indexers use
+struct Selection {
+  std::vector<int> index;
+
+  const std::vector<int>& ref_to_indices() const { return index; }
+};
+
+
+
+// every assignment of selection positions to the 3 slots, kept if the slots of one group take distinct elements
+// and, for combinations, increasing positions; in the depth first order of the indexers
+template <typename Keep>
+std::vector<std::array<int, 3>> brute_force(const std::array<const Selection *, 3> &group, bool ordered, Keep keep)
+{
+  std::vector<std::array<int, 3>> out;
+  const auto &l0 = group[0]->index, &l1 = group[1]->index, &l2 = group[2]->index;
+  for (int i0 = 0; i0 < l0.size(); ++i0) {
+    for (int i1 = 0; i1 < l1.size(); ++i1) {
+      for (int i2 = 0; i2 < l2.size(); ++i2) {
+        const std::array<int, 3> position = {i0, i1, i2};
+        bool pass = true;
+        for (int iS = 0; iS < 3; ++iS) {
+          for (int iP = 0; iP < iS; ++iP) {
+            if (group[iP] == group[iS])
+              pass = pass and (ordered ? position[iP] != position[iS] : position[iP] < position[iS]);
+          }
+        }
+
+        const std::array<int, 3> candidate = {l0[i0], l1[i1], l2[i2]};
+        if (pass and keep(candidate))
+          out.emplace_back(candidate);
+      }
+    }
+  }
+  return out;
+}
+
+
+
+int main() {
+  using Pairs = std::vector<std::array<int, 2>>;
+  Checks check("test_combinatorics");
+
+  // the selection order is kept, and the indices are those of the group, not the positions in the selection
+  const Selection lepton{{4, 1, 7}}, jet{{0, 2}}, none{{}};
+  Pairs out;
+  combination_indexer<2>()(out, lepton, lepton);
+  check(out == Pairs{{4, 1}, {4, 7}, {1, 7}}, "combinations of a group with itself");
+
+  out.clear();
+  permutation_indexer<2>()(out, lepton, lepton);
+  check(out == Pairs{{4, 1}, {4, 7}, {1, 4}, {1, 7}, {7, 4}, {7, 1}}, "permutations of a group with itself");
+
+  out.clear();
+  combination_indexer<2>()(out, lepton, jet);
+  check(out == Pairs{{4, 0}, {4, 2}, {1, 0}, {1, 2}, {7, 0}, {7, 2}}, "combinations of two groups");
+
+  out.clear();
+  combination_indexer<2>()(out, lepton, none);
+  check(out.empty(), "nothing with an empty group");
+
+  // the indexer appends to a buffer as the aggregate gives it, already cleared
+  out = {{9, 9}};
+  permutation_indexer<2>()(out, jet, jet);
+  check(out == Pairs{{9, 9}, {0, 2}, {2, 0}}, "the output is appended to");
+
+  // counts against the closed forms for a selection of 8 and one of 5
+  Selection large{std::vector<int>(8)}, small{std::vector<int>(5)};
+  std::iota(std::begin(large.index), std::end(large.index), 0);
+  std::iota(std::begin(small.index), std::end(small.index), 10);
+  std::vector<std::array<int, 3>> triplets;
+  combination_indexer<3>()(triplets, large, large, large);
+  check(triplets.size() == 56, "8 choose 3");
+  triplets.clear();
+  permutation_indexer<3>()(triplets, large, large, large);
+  check(triplets.size() == 336, "8 x 7 x 6");
+  triplets.clear();
+  permutation_indexer<3>()(triplets, small, large, large);
+  check(triplets.size() == 280, "5 x 8 x 7");
+
+  // all the arrangements of two groups over three slots, including those where a group's slots are not adjacent, against brute force
+  const std::array<std::array<const Selection *, 3>, 4> arrangement = {{{&large, &small, &large}, {&small, &large, &small},
+                                                                         {&large, &large, &small}, {&small, &small, &small}}};
+  for (int iA = 0; iA < arrangement.size(); ++iA) {
+    const auto &group = arrangement[iA];
+    for (const bool ordered : {false, true}) {
+      triplets.clear();
+      if (ordered)
+        permutation_indexer<3>()(triplets, *group[0], *group[1], *group[2]);
+      else
+        combination_indexer<3>()(triplets, *group[0], *group[1], *group[2]);
+
+      check(triplets == brute_force(group, ordered, [] (const auto &) { return true; }),
+            std::string(ordered ? "permutations" : "combinations") + " of arrangement " + std::to_string(iA));
+    }
+  }
+
+  // pruning on the first two slots: the leptons must be of opposite charge, and the branches failing it are never extended
+  const std::vector<int> charge = {1, -1, 1, -1, -1, 1, 1, -1};
+  int n_ask = 0;
+  auto opposite = [&charge, &n_ask] (int depth, const std::array<int, 3> &idx) {
+    ++n_ask;
+    return depth != 1 or charge[idx[0]] != charge[idx[1]];
+  };
+
+  triplets.clear();
+  combination_indexer<3>(opposite)(triplets, large, large, small);
+  check(triplets == brute_force({&large, &large, &small}, false, [&charge] (const auto &idx) { return charge[idx[0]] != charge[idx[1]]; }),
+        "combinations pruned on the charge");
+  check(triplets.size() == 4 * 4 * 5, "4 positive times 4 negative times 5");
+
+  // 8 first slots, 28 pairs asked about at depth 1, of which the 16 opposite ones are extended by 5 each
+  check(n_ask == 8 + 28 + (16 * 5), "the prune is asked once per partial candidate, " + std::to_string(n_ask));
+
+  n_ask = 0;
+  triplets.clear();
+  permutation_indexer<3>(opposite)(triplets, large, large, small);
+  check(triplets.size() == 2 * 4 * 4 * 5 and n_ask == 8 + 56 + (32 * 5), "permutations pruned on the charge");
+
+  return check.summary();
+}
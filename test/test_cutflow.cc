@@ -0,0 +1,87 @@
+// the cutflow counts against ones worked out by hand: single-threaded, with several threads counting at once, and while being read
+// compile and run with the other tests by ./run.sh
+
+#include "Cutflow.h"
+
+#include "check.h"
+
+#include <thread>
+
+int main() {
+  using namespace Framework;
+  Checks check("test_cutflow");
+
+  Cutflow cutflow("cutflow");
+  const int step_all = cutflow.add_step("all"), step_two = cutflow.add_step("two_leptons");
+  check(step_all == 0 and step_two == 1 and cutflow.n_steps() == 2, "step indices are handed out in order");
+  check.throws<std::invalid_argument>([&] () { cutflow.add_step("all"); }, "a step can not be added twice");
+  check(cutflow.step_index("two_leptons") == 1 and cutflow.step_index("three_leptons") == -1, "step_index");
+
+  // weights 1, 2, 3 and 4 pass the first step, the even ones the second
+  for (int weight = 1; weight <= 4; ++weight) {
+    cutflow.count(step_all, weight);
+    if (weight % 2 == 0)
+      cutflow.count(step_two, weight);
+  }
+
+  auto v_count = cutflow.counts();
+  check(v_count[0].raw == 4 and v_count[1].raw == 2, "raw counts");
+  check.near(v_count[0].sumw, 10., 0., "sum of weights of all");
+  check.near(v_count[0].sumw2, 30., 0., "sum of squared weights of all");
+  check.near(v_count[1].sumw, 6., 0., "sum of weights of two_leptons");
+  check.near(v_count[1].sumw2, 20., 0., "sum of squared weights of two_leptons");
+
+  check.throws<std::out_of_range>([&] () { cutflow.count(-1); }, "counting into step -1");
+  check.throws<std::out_of_range>([&] () { cutflow.count(2); }, "counting into a step past the last");
+  check.throws<std::logic_error>([&] () { cutflow.add_step("late"); }, "adding a step once counting has started");
+
+  // 1e7 weights of 0.1 into one step, which a plain double sum gets wrong in the 9th digit or so
+  Cutflow precise("precise");
+  const int step_small = precise.add_step("small");
+  for (int iE = 0; iE < 10000000; ++iE)
+    precise.count(step_small, 0.1);
+  check.near(precise.counts()[0].sumw, 1e6, 1e-13, "compensated sum of 1e7 weights of 0.1");
+
+  // 4 threads count 250k events of weight 0.25 each into two cutflows, while the main thread reads them
+  // as 0.25 and its square are exact, any read of a slot in the middle of a count shows as sumw != raw / 4
+  Cutflow threaded("threaded"), other("other");
+  const int step_thread = threaded.add_step("all");
+  other.add_step("all");
+
+  std::vector<std::thread> v_thread;
+  for (int iT = 0; iT < 4; ++iT)
+    v_thread.emplace_back([&threaded, &other, step_thread] () {
+        for (int iE = 0; iE < 250000; ++iE) {
+          threaded.count(step_thread, 0.25);
+          other.count(step_thread, 1.);
+        }
+      });
+
+  bool consistent = true;
+  for (int iR = 0; iR < 2000; ++iR) {
+    const auto counts = threaded.counts();
+    consistent = consistent and counts[0].sumw == 0.25 * counts[0].raw and counts[0].sumw2 == 0.0625 * counts[0].raw;
+  }
+  for (auto &thread : v_thread)
+    thread.join();
+
+  check(consistent, "counts read while the threads are counting are each as of between two counts");
+  v_count = threaded.counts();
+  check(v_count[0].raw == 1000000 and other.counts()[0].raw == 1000000, "raw counts over 4 threads");
+  check.near(v_count[0].sumw, 250000., 0., "sum of weights over 4 threads");
+  check.near(v_count[0].sumw2, 62500., 0., "sum of squared weights over 4 threads");
+
+  // merging and adding, as done for separate jobs and for snapshots
+  Cutflow merged("merged");
+  merged.add_step("all");
+  merged.add_step("two_leptons");
+  merged.merge(cutflow);
+  merged.add({Cutflow::Counter{1, 0.5, 0., 0.25, 0.}, Cutflow::Counter{0, 0., 0., 0., 0.}});
+  v_count = merged.counts();
+  check(v_count[0].raw == 5 and v_count[1].raw == 2, "raw counts after merge and add");
+  check.near(v_count[0].sumw, 10.5, 0., "sum of weights after merge and add");
+  check.near(v_count[0].sumw2, 30.25, 0., "sum of squared weights after merge and add");
+  check.throws<std::invalid_argument>([&] () { merged.merge(threaded); }, "merging cutflows of different steps");
+
+  return check.summary();
+}
@@ -0,0 +1,133 @@
+// DeltaRMatching on hand-made configurations with known matches: greedy against optimal, phi wrapping and selected indices
+// then on random events, the grid binning against the all-pairs comparison, and the optimal strategy against a brute force search
+// compile and run with the other tests by ./run.sh
+
+#include "misc/delta_r_matching.h"
+#include "misc/synthetic_group.h"
+
+#include "check.h"
+
+// just the part of the group interface the matching reads
+struct Points {
+  std::vector<float> eta, phi;
+  std::vector<int> index;
+
+  Points(const std::vector<float> &eta_, const std::vector<float> &phi_) : eta(eta_), phi(phi_), index(eta_.size())
+  {
+    std::iota(std::begin(index), std::end(index), 0);
+  }
+
+  template <typename T>
+  const std::vector<T>& get(const std::string &name) const { return (name == "eta") ? eta : phi; }
+
+  const std::vector<int>& ref_to_indices() const { return index; }
+};
+
+
+
+double delta_r(float eta1, float phi1, float eta2, float phi2)
+{
+  return std::hypot(double(eta1) - eta2, std::remainder(double(phi1) - phi2, 2. * Framework::constants::pi<double>));
+}
+
+
+
+// the most matches, then the smallest sum of dR, by trying every assignment of the first group
+void brute_force(const Points &p1, const Points &p2, double dr_max, int i1, std::vector<int> &used, int count, double sum,
+                 int &best_count, double &best_sum)
+{
+  if (i1 == p1.eta.size()) {
+    if (count > best_count or (count == best_count and sum < best_sum)) {
+      best_count = count;
+      best_sum = sum;
+    }
+    return;
+  }
+
+  brute_force(p1, p2, dr_max, i1 + 1, used, count, sum, best_count, best_sum);
+  for (int i2 = 0; i2 < p2.eta.size(); ++i2) {
+    const double dr = delta_r(p1.eta[i1], p1.phi[i1], p2.eta[i2], p2.phi[i2]);
+    if (used[i2] or !(dr < dr_max))
+      continue;
+
+    used[i2] = 1;
+    brute_force(p1, p2, dr_max, i1 + 1, used, count + 1, sum + dr, best_count, best_sum);
+    used[i2] = 0;
+  }
+}
+
+
+
+int main() {
+  using Matches = std::vector<std::array<int, 2>>;
+  Checks check("test_delta_r_matching");
+
+  DeltaRMatching<float> greedy(0.4f), optimal(0.4f, DeltaRMatching<float>::Strategy::optimal);
+
+  // a-x is the closest pair, but taking it leaves b with nothing, while a-y and b-x are both within 0.4
+  const Points p1({0.f, 0.35f}, {0.f, 0.f}), p2({0.1f, -0.3f}, {0.f, 0.f});
+  check(greedy(p1, p2) == Matches{{0, 0}}, "greedy takes the closest pair first");
+  check(optimal(p1, p2) == Matches{{0, 1}, {1, 0}}, "optimal maximizes the number of matches");
+
+  // across the phi = pi boundary the distance is 0.083, not 6.2; dr_max is exclusive, with the other pairs at exactly 0.5 apart
+  const Points p3({1.f, 1.f, 0.f}, {3.1f, 0.f, -2.f}), p4({1.f, 1.5f, 0.f}, {-3.1f, 0.f, -1.5f});
+  check(DeltaRMatching<float>(0.5f)(p3, p4) == Matches{{0, 0}}, "matching across the phi boundary, with nothing at exactly dr_max");
+  check(DeltaRMatching<float>(0.501f)(p3, p4) == Matches{{0, 0}, {1, 1}, {2, 2}}, "everything matched just above dr_max");
+
+  // only the selected elements take part, and the indices returned are those of the groups
+  check(greedy.match(p1, {1}, p2, {0, 1}) == Matches{{1, 0}}, "matching a selection of the first group");
+  check(greedy.match(p1, {0, 1}, p2, {1}) == Matches{{0, 1}}, "matching a selection of the second group");
+  check(greedy.match(p1, {}, p2, {0, 1}).empty(), "nothing to match");
+
+  check.throws<std::invalid_argument>([] () { DeltaRMatching<float> matching(0.f); }, "a non-positive dr_max");
+
+  // random events of up to 40 by 80 elements: the grid, used here from 1 element on, must find exactly the same matches as the all-pairs loop
+  SyntheticRandom rng(11ULL);
+  auto random_points = [&rng] (int n) {
+    std::vector<float> eta(n), phi(n);
+    for (int iE = 0; iE < n; ++iE) {
+      eta[iE] = rng.uniform(-2.5, 2.5);
+      phi[iE] = rng.uniform(-3.14159, 3.14159);
+    }
+    return Points(eta, phi);
+  };
+
+  DeltaRMatching<float> greedy_grid(0.4f, DeltaRMatching<float>::Strategy::greedy, "eta", "phi", 1);
+  DeltaRMatching<float> optimal_grid(0.4f, DeltaRMatching<float>::Strategy::optimal, "eta", "phi", 1);
+  int n_same_greedy = 0, n_same_optimal = 0;
+  for (int iV = 0; iV < 200; ++iV) {
+    const auto r1 = random_points(rng.integer(1, 40)), r2 = random_points(rng.integer(1, 80));
+    n_same_greedy += greedy_grid(r1, r2) == greedy(r1, r2);
+    n_same_optimal += optimal_grid(r1, r2) == optimal(r1, r2);
+  }
+  check(n_same_greedy == 200, "greedy with the grid as without, " + std::to_string(n_same_greedy) + " of 200");
+  check(n_same_optimal == 200, "optimal with the grid as without, " + std::to_string(n_same_optimal) + " of 200");
+
+  // random events dense enough to have conflicts: the optimal matching must be as good as the best of all assignments
+  // and greedy never does better than it
+  DeltaRMatching<float> wide(1.f, DeltaRMatching<float>::Strategy::optimal), wide_greedy(1.f);
+  int n_best = 0, n_greedy_worse = 0;
+  for (int iV = 0; iV < 200; ++iV) {
+    const auto r1 = random_points(rng.integer(1, 6)), r2 = random_points(rng.integer(1, 6));
+
+    int best_count = 0;
+    double best_sum = 0.;
+    std::vector<int> used(r2.eta.size(), 0);
+    brute_force(r1, r2, 1., 0, used, 0, 0., best_count, best_sum);
+
+    auto sum = [&r1, &r2] (const Matches &matches) {
+      double total = 0.;
+      for (const auto &[i1, i2] : matches)
+        total += delta_r(r1.eta[i1], r1.phi[i1], r2.eta[i2], r2.phi[i2]);
+      return total;
+    };
+
+    const auto matches = wide(r1, r2), matches_greedy = wide_greedy(r1, r2);
+    n_best += matches.size() == best_count and std::abs(sum(matches) - best_sum) < 1e-5;
+    n_greedy_worse += matches_greedy.size() < best_count or (matches_greedy.size() == best_count and sum(matches_greedy) > best_sum - 1e-5);
+  }
+  check(n_best == 200, "optimal as good as the brute force search, " + std::to_string(n_best) + " of 200");
+  check(n_greedy_worse == 200, "greedy never better than the brute force search, " + std::to_string(n_greedy_worse) + " of 200");
+
+  return check.summary();
+}
@@ -0,0 +1,97 @@
+// checks that the lazy attributes of an Aggregate are evaluated from the elements they were made of
+// even when an underlying group is reordered before they are read, as happens when filling a tree with the group
+// and that they are refused rather than evaluated from another event once an underlying group is populated anew
+// compile and run with the other tests by ./run.sh
+
+#include "Aggregate.h"
+
+#include "misc/synthetic_group.h"
+
+#include "check.h"
+
+int main() {
+  using namespace Framework;
+
+  SyntheticGroup<int, float> lepton("lepton", 2, 0, {4., 12});
+  lepton.add_attribute<float>("pt", [] (SyntheticRandom &rng) { return static_cast<float>(rng.exponential(30.)); });
+  lepton.add_attribute<int>("charge", [] (SyntheticRandom &rng) { return (rng.uniform() < 0.5) ? -1 : 1; });
+
+  SyntheticGroup<int, float> jet("jet", 1, 0, {6., 16}, 1ULL);
+  jet.add_attribute<float>("pt", [] (SyntheticRandom &rng) { return static_cast<float>(rng.exponential(50.)); });
+
+  // every lepton paired with every jet, in the order they are populated in
+  Aggregate lepton_jet("lepton_jet", 2, 0, lepton, jet);
+  lepton_jet.set_indexer([] (std::vector<std::array<int, 2>> &v_idx, const auto &g1, const auto &g2) {
+      for (int i1 = 0; i1 < g1.n_elements(); ++i1) {
+        for (int i2 = 0; i2 < g2.n_elements(); ++i2)
+          v_idx.push_back({i1, i2});
+      }
+    });
+  lepton_jet.add_attribute("pt_sum", [] (float pt1, float pt2) { return pt1 + pt2; }, "lepton::pt", "jet::pt");
+  lepton_jet.add_attribute("charge", [] (int charge) { return charge; }, "lepton::charge");
+  lepton_jet.transform_attribute("pt_sum_signed", [] (float pt, int charge) { return pt * charge; }, "pt_sum", "charge");
+  lepton_jet.set_lazy();
+
+  Checks check("test_lazy_aggregate");
+  int n_mismatch = 0;
+  for (long long entry = 0; entry < 1000; ++entry) {
+    lepton.populate(entry);
+    jet.populate(entry);
+    lepton_jet.populate(entry);
+
+    const auto v_lepton_pt = lepton.get<float>("pt");
+    const auto v_lepton_charge = lepton.get<int>("charge");
+    const auto v_jet_pt = jet.get<float>("pt");
+
+    // both underlying groups are sorted and reordered before any of the attributes is read
+    lepton.update_indices(lepton.sort_ascending("pt"));
+    lepton.reorder();
+    jet.update_indices(jet.filter_greater("pt", 20.f));
+    jet.reorder();
+
+    const auto &pt_sum = lepton_jet.get<float>("pt_sum");
+    const auto &pt_sum_signed = lepton_jet.get<float>("pt_sum_signed");
+    int iD = 0;
+    for (int i1 = 0; i1 < v_lepton_pt.size(); ++i1) {
+      for (int i2 = 0; i2 < v_jet_pt.size(); ++i2, ++iD) {
+        if (pt_sum[iD] != v_lepton_pt[i1] + v_jet_pt[i2] or pt_sum_signed[iD] != (v_lepton_pt[i1] + v_jet_pt[i2]) * v_lepton_charge[i1])
+          ++n_mismatch;
+      }
+    }
+
+    // the last entries with some pairs also check what happens when the aggregate is read after an underlying group has moved on
+    if (entry < 990 or lepton_jet.n_elements() == 0)
+      continue;
+
+    // populated anew and reordered: the reorder can not evaluate what is left pending, so neither can the read after it
+    lepton_jet.populate(entry);
+    lepton.populate(entry + 1000);
+    lepton.update_indices(lepton.sort_descending("pt"));
+    lepton.reorder();
+    check.throws<std::runtime_error>([&lepton_jet] () { lepton_jet.get<float>("pt_sum"); },
+                                     "entry " + std::to_string(entry) + ": pending pt_sum refused after a repopulate and reorder");
+
+    // populated anew without a reorder, through the other accessors
+    lepton_jet.populate(entry);
+    jet.populate(entry + 1000);
+    check.throws<std::runtime_error>([&lepton_jet] () { lepton_jet("pt_sum_signed"); },
+                                     "entry " + std::to_string(entry) + ": pending pt_sum_signed refused after a repopulate");
+
+    // attributes evaluated before the underlying group moved on stay readable, and populating the aggregate again restores the rest
+    lepton.populate(entry);
+    jet.populate(entry);
+    lepton_jet.populate(entry);
+    const int charge0 = lepton_jet.get<int>("charge")[0];
+    lepton.populate(entry + 2000);
+    check(lepton_jet.get<int>("charge")[0] == charge0, "entry " + std::to_string(entry) + ": evaluated charge still readable");
+    if (lepton.n_elements() == 0)
+      continue;
+
+    lepton_jet.populate(entry);
+    check(lepton_jet.get<float>("pt_sum")[0] == lepton.get<float>("pt")[0] + jet.get<float>("pt")[0], 
+          "entry " + std::to_string(entry) + ": pt_sum evaluated anew after the aggregate is populated again");
+  }
+
+  check(n_mismatch == 0, std::to_string(n_mismatch) + " mismatches in the pairs of 1000 entries");
+  return check.summary();
+}
@@ -0,0 +1,93 @@
+// merging histograms off job outputs as merge_output does: only the last cycle of a histogram written more than once counts
+// and the raw cutflow counts are told apart from the histograms to be scaled
+// compile and run with the other tests by ./run.sh; writes and removes test_merge_*.root in the working directory
+
+#include "Histogram.h"
+#include "Cutflow.h"
+
+#include "check.h"
+
+#include <cstdio>
+
+int main() {
+  using namespace Framework;
+  Checks check("test_merge");
+
+  TH1::AddDirectory(false);
+  const std::array<std::string, 2> v_shard = {"test_merge_0.root", "test_merge_1.root"};
+
+  // the first job writes x twice, as a snapshot-taking job would, with 1 and then 3 entries in bin 2
+  // and its cutflow of 3 events of weight 2, 2 of which pass the second step
+  {
+    TH1D x("x", "", 4, 0., 4.);
+    TFile file(v_shard[0].c_str(), "recreate");
+    x.SetDirectory(nullptr);
+    x.Fill(1.5);
+    file.cd();
+    x.Write();
+    x.Fill(1.5);
+    x.Fill(1.5);
+    x.Write();
+    file.Close();
+
+    Cutflow cutflow("cutflow");
+    const int step_all = cutflow.add_step("all"), step_two = cutflow.add_step("two");
+    for (int iE = 0; iE < 3; ++iE) {
+      cutflow.count(step_all, 2.);
+      if (iE > 0)
+        cutflow.count(step_two, 2.);
+    }
+    cutflow.save_as(v_shard[0]);
+  }
+
+  // the second job writes x once, with 2 entries in bin 2 and 1 in bin 4, and a cutflow of 1 event passing both steps
+  {
+    TH1D x("x", "", 4, 0., 4.);
+    x.SetDirectory(nullptr);
+    x.Fill(1.5);
+    x.Fill(1.5);
+    x.Fill(3.5);
+    TFile file(v_shard[1].c_str(), "recreate");
+    file.cd();
+    x.Write();
+    file.Close();
+
+    Cutflow cutflow("cutflow");
+    cutflow.add_step("all");
+    cutflow.add_step("two");
+    cutflow.count(0, 2.);
+    cutflow.count(1, 2.);
+    cutflow.save_as(v_shard[1]);
+  }
+
+  Histogram merged;
+  for (const auto &shard : v_shard)
+    merged.add_from(shard);
+
+  check(merged.histograms().size() == 3, "x and the two cutflow histograms are merged, each once");
+  for (const auto &[hist, _] : merged.histograms()) {
+    const std::string name = hist->GetName();
+    if (name == "x") {
+      check.near(hist->GetBinContent(2), 5., 0., "x bin 2 has the 3 + 2 entries of the last cycles only");
+      check.near(hist->GetBinContent(4), 1., 0., "x bin 4");
+      check(!Cutflow::is_raw(*hist), "x is not a raw cutflow histogram");
+    }
+    else if (name == "cutflow_raw") {
+      check.near(hist->GetBinContent(1), 4., 0., "raw count of all");
+      check.near(hist->GetBinContent(2), 3., 0., "raw count of two");
+      check(Cutflow::is_raw(*hist), "cutflow_raw is a raw cutflow histogram");
+    }
+    else if (name == "cutflow_weighted") {
+      check.near(hist->GetBinContent(1), 8., 0., "weighted count of all");
+      check.near(hist->GetBinContent(2), 6., 0., "weighted count of two");
+      check(!Cutflow::is_raw(*hist), "cutflow_weighted is not a raw cutflow histogram");
+    }
+    else
+      check(false, "unexpected histogram " + name);
+  }
+
+  for (const auto &shard : v_shard)
+    std::remove(shard.c_str());
+
+  return check.summary();
+}
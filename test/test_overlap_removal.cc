@@ -0,0 +1,99 @@
+// OverlapRemoval on hand-made events with known outcomes: both policies, the exclusive dr, the selections and the order of the steps
+// and the steps that are refused, among them a group that is both the target and a reference
+// compile and run with the other tests by ./run.sh
+
+#include "misc/overlap_removal.h"
+
+#include "check.h"
+
+// just the part of the group interface the cleaning uses
+struct Points {
+  std::string name;
+  std::vector<float> eta, phi;
+  std::vector<int> index;
+
+  Points(const std::string &name_, const std::vector<float> &eta_, const std::vector<float> &phi_) :
+  name(name_), eta(eta_), phi(phi_), index(eta_.size())
+  {
+    std::iota(std::begin(index), std::end(index), 0);
+  }
+
+  int inquire(const std::string &attr) const { return (attr == "eta") ? 0 : (attr == "phi") ? 1 : -1; }
+
+  template <typename T>
+  const std::vector<T>& get(const std::string &attr) const { return (attr == "eta") ? eta : phi; }
+
+  const std::vector<int>& ref_to_indices() const { return index; }
+
+  void update_indices(const std::vector<int> &index_) { index = index_; }
+};
+
+
+
+int main() {
+  using Policy = OverlapRemoval<float>::Policy;
+  Checks check("test_overlap_removal");
+
+  {
+    // jet 0 is 0.1 off the muon, jet 1 exactly 0.5 off it, jet 2 across the phi boundary from the electron, jet 3 far from all
+    Points muon("muon", {0.f}, {0.f}), electron("electron", {1.f}, {3.1f}), jet("jet", {0.1f, 0.f, 1.f, -2.f}, {0.f, 0.5f, -3.1f, 1.f});
+    OverlapRemoval<float> cleaning;
+    cleaning.add_step(Policy::remove_target, 0.5f, jet, muon, electron);
+    cleaning.run();
+    check(jet.ref_to_indices() == std::vector<int>{1, 3}, "jets within dr of either lepton are removed, not those at exactly dr");
+    check(muon.ref_to_indices() == std::vector<int>{0} and electron.ref_to_indices() == std::vector<int>{0}, "the references are untouched");
+  }
+
+  {
+    // the same with the jets as the reference, which then clean the leptons instead
+    Points muon("muon", {0.f, 2.f}, {0.f, 0.f}), jet("jet", {0.1f, -2.f}, {0.f, 1.f});
+    OverlapRemoval<float> cleaning;
+    cleaning.add_step(Policy::remove_reference, 0.4f, jet, muon);
+    cleaning.run();
+    check(muon.ref_to_indices() == std::vector<int>{1}, "remove_reference cleans the references");
+    check(jet.ref_to_indices() == std::vector<int>{0, 1}, "remove_reference leaves the target untouched");
+  }
+
+  {
+    // only the selected elements take part: the unselected muon removes nothing, and the unselected jet is not kept back
+    Points muon("muon", {0.f, 1.f}, {0.f, 0.f}), jet("jet", {0.f, 1.f, 2.f}, {0.1f, 0.1f, 0.f});
+    muon.update_indices({1});
+    jet.update_indices({0, 1});
+    OverlapRemoval<float> cleaning;
+    cleaning.add_step(Policy::remove_target, 0.4f, jet, muon);
+    cleaning.run();
+    check(jet.ref_to_indices() == std::vector<int>{0}, "only selected elements are cleaned, and only against selected elements");
+  }
+
+  {
+    // the electron sits on the muon, and the jet on both: the muon removes the electron first, which then no longer removes anything
+    // the other way around the electron removes the jet before it is itself removed
+    auto run = [] (bool electron_first) {
+      Points muon("muon", {0.f}, {0.f}), electron("electron", {0.05f}, {0.f}), jet("jet", {0.35f}, {0.f});
+      OverlapRemoval<float> cleaning;
+      if (electron_first)
+        cleaning.add_step(Policy::remove_target, 0.4f, jet, electron);
+      cleaning.add_step(Policy::remove_target, 0.1f, electron, muon);
+      if (!electron_first)
+        cleaning.add_step(Policy::remove_target, 0.4f, jet, electron);
+      cleaning.run();
+      return std::make_pair(electron.ref_to_indices().size(), jet.ref_to_indices().size());
+    };
+    check(run(false) == std::make_pair(std::size_t(0), std::size_t(1)), "a step sees the groups as cleaned by the steps before it");
+    check(run(true) == std::make_pair(std::size_t(0), std::size_t(0)), "and not as cleaned by those after it");
+  }
+
+  {
+    Points muon("muon", {0.f}, {0.f}), jet("jet", {0.f}, {0.f});
+    OverlapRemoval<float> cleaning, wrong("eta", "azimuth");
+    check.throws<std::invalid_argument>([&] () { cleaning.add_step(Policy::remove_target, 0.f, jet, muon); }, "a non-positive dr");
+    check.throws<std::invalid_argument>([&] () { wrong.add_step(Policy::remove_target, 0.4f, jet, muon); }, "a group without the attributes");
+    check.throws<std::invalid_argument>([&] () { cleaning.add_step(Policy::remove_target, 0.4f, jet, muon, jet); }, "a group as both target and reference");
+    check.throws<std::invalid_argument>([&] () { cleaning.add_step(Policy::remove_reference, 0.4f, muon, muon); }, "the same with remove_reference");
+
+    cleaning.run();
+    check(jet.ref_to_indices().size() == 1 and muon.ref_to_indices().size() == 1, "the refused steps are not run");
+  }
+
+  return check.summary();
+}
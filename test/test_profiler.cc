@@ -0,0 +1,107 @@
+// threads recording one after another share a single buffer, threads recording at once get one each, and no event is lost in the handover
+// and the counter descriptors of a thread are closed when it exits, whether or not the counters could be opened here
+// compile and run with the other tests by ./run.sh; writes and removes test_profiler.json in the working directory
+
+#define FWK_PROFILE_COUNTERS
+#include "Profiler.h"
+
+#include "check.h"
+
+#include <atomic>
+#include <set>
+#include <sstream>
+#include <cstdio>
+#include <fcntl.h>
+
+// the descriptors open in the process
+int n_open_fd()
+{
+  int n_fd = 0;
+  for (int fd = 0; fd < 1024; ++fd)
+    n_fd += (fcntl(fd, F_GETFD) != -1);
+  return n_fd;
+}
+
+// the thread ids in the trace, and the number of spans with them
+std::pair<std::set<int>, int> trace_threads(const std::string &file)
+{
+  std::ifstream in(file);
+  std::stringstream content;
+  content << in.rdbuf();
+  const std::string trace = content.str();
+
+  std::set<int> threads;
+  int n_span = 0;
+  const std::string tid = "\"tid\": ";
+  for (auto pos = trace.find(tid); pos != std::string::npos; pos = trace.find(tid, pos + 1), ++n_span)
+    threads.insert(std::stoi(trace.substr(pos + tid.size())));
+  return {threads, n_span};
+}
+
+long long events(Framework::Profiler::Stage stage)
+{
+  for (const auto &sum : Framework::Profiler::instance().summary()) {
+    if (sum.stage == stage)
+      return sum.events;
+  }
+  return 0LL;
+}
+
+int main() {
+  using namespace Framework;
+  Checks check("test_profiler");
+  const std::string file = "test_profiler.json";
+  auto &profiler = Profiler::instance();
+  profiler.set_capacity(64);
+
+  auto record = [] () {
+    {
+      FWK_PROFILE_SCOPE(transform, "record");
+    }
+    FWK_PROFILE_EVENT();
+  };
+
+  // one after another
+  const int n_fd = n_open_fd();
+  for (int iT = 0; iT < 20; ++iT)
+    std::thread(record).join();
+
+  check(n_open_fd() == n_fd, "descriptors of the exited threads closed");
+  check(events(Profiler::Stage::transform) == 20, "20 events from threads one after another");
+  profiler.write_trace(file);
+  const auto sequential = trace_threads(file);
+  check(sequential.first.size() == 1 and sequential.second == 20, "threads one after another recorded into the same buffer");
+
+  // four at once, each waiting until all have recorded before exiting
+  std::atomic<int> n_ready = 0;
+  auto record_together = [&record, &n_ready] () {
+    record();
+    ++n_ready;
+    while (n_ready.load() < 4)
+      std::this_thread::yield();
+  };
+
+  std::vector<std::thread> v_thread;
+  for (int iT = 0; iT < 4; ++iT)
+    v_thread.emplace_back(record_together);
+  for (auto &thread : v_thread)
+    thread.join();
+
+  check(n_open_fd() == n_fd, "descriptors of the concurrent threads closed");
+  check(events(Profiler::Stage::transform) == 24, "24 events after the concurrent threads");
+  profiler.write_trace(file);
+  const auto concurrent = trace_threads(file);
+  check(concurrent.first.size() == 4 and concurrent.second == 24, "concurrent threads recorded into a buffer each, one of them taken over");
+
+  // and after a reset, the buffers recorded into anew
+  profiler.reset();
+  for (int iT = 0; iT < 3; ++iT)
+    std::thread(record).join();
+
+  check(events(Profiler::Stage::transform) == 3, "3 events after a reset");
+  profiler.write_trace(file);
+  check(trace_threads(file).second == 3, "3 spans after a reset");
+
+  std::remove(file.c_str());
+  return check.summary();
+}
@@ -0,0 +1,105 @@
+// running two samples on a pool of threads, one of them over two replicas: every entry is analyzed once, whatever worker gets it
+// and an analyzer that throws stops the run, with the exception rethrown by run() and its task left uncounted
+// compile and run with the other tests by ./run.sh; writes and removes test_scheduler_*.root in the working directory
+
+#include "Scheduler.h"
+#include "Collection.h"
+
+#include "check.h"
+
+#include <cstdio>
+
+// a dataset over the files and the collection it reads, summing the values it sees
+struct Replica {
+  Replica(const std::string &name, const std::vector<std::string> &v_file, long long poison = -1LL) :
+  dat(name, "Events"),
+  coll("value", 1),
+  count(0LL),
+  sum(0LL)
+  {
+    for (const auto &file : v_file)
+      dat.add_file(file);
+
+    coll.add_attribute("value", "value", 1);
+    dat.associate(coll);
+
+    dat.set_analyzer([this, poison, &value = coll.get<int>("value")] (long long entry) {
+        coll.populate(entry);
+        if (value[0] == poison)
+          throw std::runtime_error("poisoned entry");
+
+        ++count;
+        sum += value[0];
+      });
+  }
+
+  Framework::Dataset<TChain> dat;
+  Framework::Collection<int> coll;
+  long long count, sum;
+};
+
+
+
+int main() {
+  using namespace Framework;
+  Checks check("test_scheduler");
+
+  // value runs over the global entry number of each sample, and the baskets are flushed every 50 entries
+  const std::vector<std::pair<std::string, int>> v_file = {{"test_scheduler_a0.root", 600}, {"test_scheduler_a1.root", 400}, {"test_scheduler_b0.root", 300}};
+  int offset = 0;
+  for (const auto &[name, entries] : v_file) {
+    if (name == "test_scheduler_b0.root")
+      offset = 0;
+
+    TFile file(name.c_str(), "recreate");
+    TTree tree("Events", "");
+    tree.SetAutoFlush(50);
+    int value = 0;
+    tree.Branch("value", &value, "value/I");
+    for (int iE = 0; iE < entries; ++iE) {
+      value = offset + iE;
+      tree.Fill();
+    }
+    tree.Write();
+    file.Close();
+    offset += entries;
+  }
+
+  const std::vector<std::string> v_a = {"test_scheduler_a0.root", "test_scheduler_a1.root"}, v_b = {"test_scheduler_b0.root"};
+
+  {
+    Replica a0("a0", v_a), a1("a1", v_a), b("b", v_b);
+    Scheduler scheduler(3);
+    scheduler.add(a0.dat, "a");
+    scheduler.add(a1.dat, "a");
+    scheduler.add(b.dat);
+    scheduler.run();
+
+    check(a0.count + a1.count == 1000LL, "sample a entries over both replicas");
+    check(a0.sum + a1.sum == 499500LL, "sample a sum of values, 0 + ... + 999");
+    check(b.count == 300LL and b.sum == 44850LL, "sample b entries and sum of values, 0 + ... + 299");
+    check(scheduler.processed("a") == 1000LL and scheduler.processed("b") == 300LL, "processed per sample");
+    check.throws<std::invalid_argument>([&] () { scheduler.processed("c"); }, "processed of an unknown sample");
+
+    // a second run goes over everything again
+    scheduler.run();
+    check(a0.count + a1.count == 2000LL and b.count == 600LL, "a second run");
+  }
+
+  {
+    // the task holding entry 123 of b throws; a runs either to completion or until it sees the abort
+    Replica a("a", v_a), b("b", v_b, 123LL);
+    Scheduler scheduler(2);
+    scheduler.add(a.dat);
+    scheduler.add(b.dat);
+    check.throws<std::runtime_error>([&] () { scheduler.run(); }, "the analyzer exception out of run()");
+    check(b.count < 300LL, "sample b stopped at the poisoned entry");
+    check(scheduler.processed("b") < 300LL and scheduler.processed("b") <= b.count, "the failed task of sample b is not counted as processed");
+    check(scheduler.processed("a") <= a.count, "sample a counts only the tasks that ran through");
+  }
+
+  for (const auto &file : v_file)
+    std::remove(file.first.c_str());
+
+  return check.summary();
+}
@@ -0,0 +1,70 @@
+// sharding a dataset of two files with clusters of 100 entries: the shard edges fall on the cluster boundaries nearest to the even split
+// and the shards cover the dataset exactly once
+// compile and run with the other tests by ./run.sh; writes and removes test_shard_*.root in the working directory
+
+#include "Dataset.h"
+
+#include "check.h"
+
+#include <cstdio>
+
+int main() {
+  using namespace Framework;
+  Checks check("test_shard");
+
+  // 1000 and 550 entries, the baskets flushed every 100 entries, so the clusters start at 0, 100, ... within each file
+  const std::array<std::pair<std::string, int>, 2> v_file = {std::make_pair("test_shard_0.root", 1000), std::make_pair("test_shard_1.root", 550)};
+  for (const auto &[name, entries] : v_file) {
+    TFile file(name.c_str(), "recreate");
+    TTree tree("Events", "");
+    tree.SetAutoFlush(100);
+    int value = 0;
+    tree.Branch("value", &value, "value/I");
+    for (value = 0; value < entries; ++value)
+      tree.Fill();
+    tree.Write();
+    file.Close();
+  }
+
+  Dataset<TChain> dat("shard", "Events");
+  for (const auto &file : v_file)
+    dat.add_file(file.first);
+
+  const auto &v_catalogue = dat.catalogue();
+  check(v_catalogue.size() == 2 and v_catalogue[0].entries == 1000 and v_catalogue[1].entries == 550, "catalogue entries");
+  check(v_catalogue.size() == 2 and v_catalogue[0].v_cluster.size() == 10 and v_catalogue[1].v_cluster.size() == 6, "catalogue clusters");
+  check(dat.entry_range() == std::make_pair(0LL, 1550LL), "the whole dataset before sharding");
+
+  // the even split of 1550 in 3 is at 516 and 1033, whose nearest global boundaries are 500 and 1000
+  const std::array<std::pair<long long, long long>, 3> v_expect = {std::make_pair(0LL, 500LL), std::make_pair(500LL, 1000LL), std::make_pair(1000LL, 1550LL)};
+  for (int iS = 0; iS < 3; ++iS) {
+    dat.shard(3, iS);
+    check(dat.entry_range() == v_expect[iS], "range of shard " + std::to_string(iS) + "/3");
+  }
+
+  // the even split of 1550 in 2 is at 775, nearest to 800; the string form is i/n
+  dat.shard("0/2");
+  check(dat.entry_range() == std::make_pair(0LL, 800LL), "range of shard 0/2");
+  dat.shard("1/2");
+  check(dat.entry_range() == std::make_pair(800LL, 1550LL), "range of shard 1/2");
+
+  // more shards than clusters leave some of them empty, but the union is still the whole dataset, each entry once
+  long long covered = 0LL, previous = 0LL;
+  bool contiguous = true;
+  for (int iS = 0; iS < 40; ++iS) {
+    dat.shard(40, iS);
+    const auto [first, last] = dat.entry_range();
+    contiguous = contiguous and first == previous and last >= first and (first % 50 == 0);
+    covered += last - first;
+    previous = last;
+  }
+  check(contiguous and covered == 1550LL and previous == 1550LL, "40 shards are contiguous, aligned and cover every entry once");
+
+  check.throws<std::invalid_argument>([&] () { dat.shard(3, 3); }, "shard index past the last");
+  check.throws<std::invalid_argument>([&] () { dat.shard("1-3"); }, "malformed shard specification");
+
+  for (const auto &file : v_file)
+    std::remove(file.first.c_str());
+
+  return check.summary();
+}
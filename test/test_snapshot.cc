@@ -0,0 +1,97 @@
+// a snapshot written and restored by another set of outputs gives back the same histogram contents and cutflow counts
+// plus when snapshots fall due, and the naming of the files of resumed jobs
+// compile and run with the other tests by ./run.sh; writes and removes test_snapshot*.root in the working directory
+
+#include "Snapshot.h"
+
+#include "check.h"
+
+#include <cstdio>
+
+int main() {
+  using namespace Framework;
+  Checks check("test_snapshot");
+
+  const std::string filename = "test_snapshot.root";
+  std::remove(filename.c_str());
+  check(Snapshot::last_entry(filename) == -1LL, "no snapshot before one is taken");
+
+  // the outputs of the job that is killed: x = 0.5, 1.5, ... 9.5 filled with weight x, and counted with the same weight
+  double x = 0.;
+  Histogram hist;
+  hist.make_histogram<TH1D>([&x] (TH1D *h, double) { h->Fill(x, x); }, "x", "", 10, 0., 10.);
+
+  Cutflow cutflow("cutflow");
+  const int step_all = cutflow.add_step("all"), step_high = cutflow.add_step("high");
+
+  {
+    Snapshot snapshot(filename, 0LL);
+    snapshot.add_histogram(hist);
+    snapshot.add_cutflow(cutflow);
+
+    for (int iE = 0; iE < 10; ++iE) {
+      x = iE + 0.5;
+      hist.fill();
+      cutflow.count(step_all, x);
+      if (x > 5.)
+        cutflow.count(step_high, x);
+    }
+
+    snapshot.take(41LL);
+    snapshot.finish();
+  }
+  check(Snapshot::last_entry(filename) == 41LL, "last_entry is the entry the snapshot was taken at");
+
+  // the outputs of the resumed job, made the same way and still empty
+  Histogram resumed_hist;
+  resumed_hist.make_histogram<TH1D>([] (TH1D *, double) {}, "x", "", 10, 0., 10.);
+
+  Cutflow resumed_cutflow("cutflow");
+  resumed_cutflow.add_step("all");
+  resumed_cutflow.add_step("high");
+
+  Snapshot resumed(filename, 0LL);
+  resumed.add_histogram(resumed_hist);
+  resumed.add_cutflow(resumed_cutflow);
+  check(resumed.restore() == 41LL, "restore returns the entry the snapshot was taken at");
+
+  const auto &restored = resumed_hist.histograms().front().first;
+  for (int iB = 1; iB <= 10; ++iB) {
+    check.near(restored->GetBinContent(iB), iB - 0.5, 1e-12, "content of bin " + std::to_string(iB));
+    check.near(restored->GetBinError(iB), iB - 0.5, 1e-12, "error of bin " + std::to_string(iB));
+  }
+
+  // all: 0.5 + ... + 9.5 = 50, and 0.25 + 2.25 + ... + 90.25 = 332.5; high: 5.5 + ... + 9.5 = 37.5, and 30.25 + ... + 90.25 = 292.5
+  const auto v_count = resumed_cutflow.counts();
+  check(v_count[0].raw == 10 and v_count[1].raw == 5, "restored raw counts");
+  check.near(v_count[0].sumw, 50., 1e-12, "restored sum of weights of all");
+  check.near(v_count[0].sumw2, 332.5, 1e-12, "restored sum of squared weights of all");
+  check.near(v_count[1].sumw, 37.5, 1e-12, "restored sum of weights of high");
+  check.near(v_count[1].sumw2, 292.5, 1e-12, "restored sum of squared weights of high");
+
+  // a cutflow with other steps is not restored into
+  Cutflow other("cutflow");
+  other.add_step("all");
+  other.add_step("low");
+  Snapshot mismatched(filename, 0LL);
+  mismatched.add_cutflow(other);
+  check.throws<std::runtime_error>([&] () { mismatched.restore(); }, "restoring into a cutflow of other steps");
+
+  // due every 100 entries, counted from the entry given to start
+  Snapshot every(filename, 100LL);
+  every.start(250LL);
+  check(!every.due(349LL) and every.due(350LL), "due 100 entries after the start");
+
+  // every resume writes its tree into a file of its own
+  const std::string tree = "test_snapshot_tree.root";
+  check(Snapshot::resumed_filename(tree) == "test_snapshot_tree_resumed.root", "name of the first resumed file");
+  std::ofstream("test_snapshot_tree_resumed.root").put('\n');
+  check(Snapshot::resumed_filename(tree) == "test_snapshot_tree_resumed_2.root", "name of the second resumed file");
+  std::ofstream("test_snapshot_tree_resumed_2.root").put('\n');
+  check(Snapshot::resumed_filename(tree) == "test_snapshot_tree_resumed_3.root", "name of the third resumed file");
+
+  for (const auto &name : {filename, std::string("test_snapshot_tree_resumed.root"), std::string("test_snapshot_tree_resumed_2.root")})
+    std::remove(name.c_str());
+
+  return check.summary();
+}
@@ -0,0 +1,136 @@
+// the spin correlation observables of batch_spin_correlation on float inputs, against a reference in double with the exact functions
+// i.e. FourVector<double> boosts as TLorentzVector does them and std::acos, on random ttbar events with the tops up to large rapidities
+// and the single event interfaces against the batch one
+// compile and run with the other tests by ./run.sh
+
+#include "Group.h"
+
+#include "misc/spin_correlation.h"
+#include "misc/synthetic_group.h"
+
+#include "check.h"
+
+using Vector = std::array<double, 3>;
+
+double dot(const Vector &v1, const Vector &v2) { return (v1[0] * v2[0]) + (v1[1] * v2[1]) + (v1[2] * v2[2]); }
+
+Vector unit(const Vector &v) { const double norm = std::sqrt(dot(v, v)); return {v[0] / norm, v[1] / norm, v[2] / norm}; }
+
+Vector cross(const Vector &v1, const Vector &v2)
+{
+  return {(v1[1] * v2[2]) - (v1[2] * v2[1]), (v1[2] * v2[0]) - (v1[0] * v2[2]), (v1[0] * v2[1]) - (v1[1] * v2[0])};
+}
+
+Vector direction(const FourVector<double> &p4) { return unit({p4.px, p4.py, p4.pz}); }
+
+void boost_into(FourVector<double> &p4, const FourVector<double> &frame) { p4.Boost(-frame.px / frame.e, -frame.py / frame.e, -frame.pz / frame.e); }
+
+
+
+// the observables checked, and their reference values from the definitions in 1508.05271 and 1702.06063
+constexpr std::array<SpinObservable, 13> v_observable = {SpinObservable::cLab, SpinObservable::cHel, SpinObservable::b1k, SpinObservable::b2k,
+                                                         SpinObservable::b1j, SpinObservable::b1r, SpinObservable::b2r, SpinObservable::b1n,
+                                                         SpinObservable::b2n, SpinObservable::ckk, SpinObservable::kNorm,
+                                                         SpinObservable::phi0, SpinObservable::phi1};
+
+std::array<double, 13> reference(const std::array<float, 16> &arg)
+{
+  auto p4 = [&arg] (int body) { return FourVector<double>::pt_eta_phi_m(arg[4 * body], arg[(4 * body) + 1], arg[(4 * body) + 2], arg[(4 * body) + 3]); };
+  auto pTop = p4(0), aTop = p4(1), pLep = p4(2), aLep = p4(3);
+
+  const double cLab = dot(direction(aLep), direction(pLep));
+  const double sD = (std::abs(pTop.Rapidity()) > std::abs(aTop.Rapidity())) ? 1. : -1.;
+
+  const auto pTT = pTop + aTop;
+  boost_into(pTop, pTT);
+  boost_into(aTop, pTT);
+  boost_into(aLep, pTT);
+  boost_into(aLep, pTop);
+  boost_into(pLep, pTT);
+  boost_into(pLep, aTop);
+
+  const Vector k = direction(pTop), a = direction(aLep), l = direction(pLep), z = {0., 0., 1.};
+  const double sY = (k[2] >= 0.) ? 1. : -1., s = std::sqrt(1. - (k[2] * k[2]));
+  const Vector r = {sY / s * (z[0] - (k[2] * k[0])), sY / s * (z[1] - (k[2] * k[1])), sY / s * (z[2] - (k[2] * k[2]))};
+  const Vector n = unit(cross(z, k)), n_signed = {sY * n[0], sY * n[1], sY * n[2]};
+
+  const double kNorm = dot(cross(a, l), k);
+  const Vector t_a = unit({a[0] - (dot(a, k) * k[0]), a[1] - (dot(a, k) * k[1]), a[2] - (dot(a, k) * k[2])});
+  const Vector t_l = unit({l[0] - (dot(l, k) * k[0]), l[1] - (dot(l, k) * k[1]), l[2] - (dot(l, k) * k[2])});
+  const double phi0 = std::acos(std::clamp(dot(t_a, t_l), -1., 1.));
+  const double phi1 = (kNorm >= 0.) ? phi0 : (2. * Framework::constants::pi<double>) - phi0;
+
+  return {cLab, dot(a, l), dot(a, k), -dot(l, k), sD * dot(a, k), dot(a, r), -dot(l, r), dot(a, n_signed), -dot(l, n_signed),
+          -dot(a, k) * dot(l, k), kNorm, phi0, phi1};
+}
+
+
+
+int main() {
+  Checks check("test_spin_correlation");
+
+  // ttbar-like events; the steep exponential tail and |eta| up to 3 give the large boosts where float loses the most
+  constexpr int n = 20000;
+  SyntheticRandom rng(5ULL);
+  std::array<std::vector<float>, 16> v_column;
+  for (auto &column : v_column)
+    column.resize(n);
+
+  for (int iN = 0; iN < n; ++iN) {
+    for (int iB = 0; iB < 4; ++iB) {
+      v_column[4 * iB][iN] = (iB < 2) ? 1. + rng.exponential(120.) : 5. + rng.exponential(40.);
+      v_column[(4 * iB) + 1][iN] = rng.uniform(-3., 3.);
+      v_column[(4 * iB) + 2][iN] = rng.uniform(-3.14159, 3.14159);
+      v_column[(4 * iB) + 3][iN] = (iB < 2) ? 172.5f : 0.f;
+    }
+  }
+
+  auto columns_of = [&v_column] (int body) {
+    return std::array<const float *, 4>{v_column[4 * body].data(), v_column[(4 * body) + 1].data(), v_column[(4 * body) + 2].data(), v_column[(4 * body) + 3].data()};
+  };
+
+  SpinCorrelationColumns<float> all;
+  batch_spin_correlation(n, columns_of(0), columns_of(1), columns_of(2), columns_of(3), all);
+
+  // the largest deviation from the reference over the events, phi1 taken modulo 2 pi as it jumps there when kNorm changes sign
+  std::array<double, v_observable.size()> v_deviation = {};
+  for (int iN = 0; iN < n; ++iN) {
+    std::array<float, 16> arg;
+    for (int iA = 0; iA < 16; ++iA)
+      arg[iA] = v_column[iA][iN];
+
+    const auto expect = reference(arg);
+    for (int iO = 0; iO < v_observable.size(); ++iO) {
+      double deviation = std::abs(all[v_observable[iO]][iN] - expect[iO]);
+      if (v_observable[iO] == SpinObservable::phi1)
+        deviation = std::min(deviation, (2. * Framework::constants::pi<double>) - deviation);
+      v_deviation[iO] = std::max(v_deviation[iO], deviation);
+    }
+  }
+
+  for (int iO = 0; iO < v_observable.size(); ++iO)
+    check.near(v_deviation[iO], 0., 1e-5, std::string("largest deviation of ") + spin_observable_name[static_cast<int>(v_observable[iO])] + " from the reference");
+
+  // a subset computes the same values, and leaves the columns not asked for alone
+  SpinCorrelationColumns<float> some;
+  batch_spin_correlation<SpinObservable::ckk, SpinObservable::phi0>(n, columns_of(0), columns_of(1), columns_of(2), columns_of(3), some);
+  check(some[SpinObservable::ckk] == all[SpinObservable::ckk] and some[SpinObservable::phi0] == all[SpinObservable::phi0], "a subset of the observables");
+  check(some[SpinObservable::cHel].empty(), "the observables not asked for are not computed");
+
+  // the single event interfaces are batches of one
+  const int iN = 17;
+  const auto &event = compute_spin_correlation(v_column[0][iN], v_column[1][iN], v_column[2][iN], v_column[3][iN],
+                                               v_column[4][iN], v_column[5][iN], v_column[6][iN], v_column[7][iN],
+                                               v_column[8][iN], v_column[9][iN], v_column[10][iN], v_column[11][iN],
+                                               v_column[12][iN], v_column[13][iN], v_column[14][iN], v_column[15][iN]);
+  bool same = event.size() == n_spin_observable;
+  for (int iO = 0; same and iO < n_spin_observable; ++iO)
+    same = event[iO].first == spin_observable_name[iO] and event[iO].second == all.v_column[iO][iN];
+  check(same, "compute_spin_correlation against the batch");
+
+  check(phi0(v_column[0][iN], v_column[1][iN], v_column[2][iN], v_column[3][iN], v_column[4][iN], v_column[5][iN], v_column[6][iN], v_column[7][iN],
+             v_column[8][iN], v_column[9][iN], v_column[10][iN], v_column[11][iN], v_column[12][iN], v_column[13][iN], v_column[14][iN], v_column[15][iN])
+        == all[SpinObservable::phi0][iN], "phi0 against the batch");
+
+  return check.summary();
+}
@@ -0,0 +1,83 @@
+// the mass, pt and rapidity of two- and three-body systems from the column kernels of four_vector.h and numeric_vector.h
+// against closed forms, against FourVector<double>, and within a Batch against the element-wise invariant_mass and friends
+// compile and run with the other tests by ./run.sh
+
+#include "Batch.h"
+
+#include "misc/numeric_vector.h"
+#include "misc/synthetic_group.h"
+
+#include "check.h"
+
+int main() {
+  using namespace Framework;
+  Checks check("test_system_kinematics");
+
+  // back-to-back massless pair, a W-like pair of 40 GeV legs at 90 degrees, and a collimated pair at large eta
+  // for massless legs m2 = 2 pt1 pt2 (cosh(deta) - cos(dphi)), whose float evaluation via E2 - p2 would have cancelled to nothing in the last case
+  const std::vector<float> pt1 = {100.f, 40.f, 500.f}, eta1 = {0.f, 0.5f, 3.f}, phi1 = {0.f, 0.f, 0.f}, mass1 = {0.f, 0.f, 0.f};
+  const std::vector<float> pt2 = {100.f, 40.f, 500.f}, eta2 = {0.f, 0.5f, 3.01f}, phi2 = {3.14159265f, 1.57079633f, 0.02f}, mass2 = {0.f, 0.f, 0.f};
+  std::vector<float> mass(3), pt(3), rapidity(3);
+  batch_system_kinematics<2>(3, {pt1.data(), pt2.data()}, {eta1.data(), eta2.data()}, {phi1.data(), phi2.data()}, {mass1.data(), mass2.data()},
+                             mass.data(), pt.data(), rapidity.data());
+
+  for (int iS = 0; iS < 3; ++iS) {
+    const double m2 = 2. * pt1[iS] * pt2[iS] * (std::cosh(double(eta1[iS]) - eta2[iS]) - std::cos(double(phi1[iS]) - phi2[iS]));
+    check.near(mass[iS], std::sqrt(m2), 1e-5, "closed form mass of system " + std::to_string(iS));
+
+    const auto p4 = FourVector<double>::pt_eta_phi_m(pt1[iS], eta1[iS], phi1[iS], mass1[iS]) + FourVector<double>::pt_eta_phi_m(pt2[iS], eta2[iS], phi2[iS], mass2[iS]);
+    check.near(pt[iS], p4.Pt(), 1e-5, "pt of system " + std::to_string(iS));
+    check.near(rapidity[iS], p4.Rapidity(), 1e-5, "rapidity of system " + std::to_string(iS));
+  }
+  check.near(mass[0], 200., 1e-5, "back-to-back pair mass");
+  check.near(pt[0], 0., 1e-4, "back-to-back pair pt");
+  check.near(mass[1], 40. * std::sqrt(2. * (1. - std::cos(1.57079633))), 1e-5, "pair at 90 degrees");
+
+  // an output that is not wanted goes to the scratch
+  std::vector<float> mass_only(3);
+  batch_system_kinematics<2, float>(3, {pt1.data(), pt2.data()}, {eta1.data(), eta2.data()}, {phi1.data(), phi2.data()}, {mass1.data(), mass2.data()},
+                                    mass_only.data(), nullptr, nullptr);
+  check(mass_only == mass, "mass alone is the same as with the other outputs");
+
+  // random three-body systems of massive legs, as a Batch of a group holding the legs as attributes of one element
+  SyntheticGroup<int, float> system("system", 1, 0, {1., 1}, 7ULL);
+  for (const auto &leg : {"1", "2", "3"}) {
+    system.add_attribute<float>(std::string("pt") + leg, [] (SyntheticRandom &rng) { return static_cast<float>(5. + rng.exponential(80.)); });
+    system.add_attribute<float>(std::string("eta") + leg, [] (SyntheticRandom &rng) { return static_cast<float>(rng.uniform(-4., 4.)); });
+    system.add_attribute<float>(std::string("phi") + leg, [] (SyntheticRandom &rng) { return static_cast<float>(rng.uniform(-3.14159, 3.14159)); });
+    system.add_attribute<float>(std::string("mass") + leg, [] (SyntheticRandom &rng) { return static_cast<float>(rng.uniform(0., 10.)); });
+  }
+
+  Batch b_system(system, {}, 1000, 1);
+  b_system.kernel_attribute("mass", batch_invariant_mass<3>(), "pt1", "eta1", "phi1", "mass1", "pt2", "eta2", "phi2", "mass2", "pt3", "eta3", "phi3", "mass3");
+  b_system.kernel_attribute("pt", batch_system_pt<3>(), "pt1", "eta1", "phi1", "mass1", "pt2", "eta2", "phi2", "mass2", "pt3", "eta3", "phi3", "mass3");
+  b_system.kernel_attribute("rapidity", batch_system_rapidity<3>(), "pt1", "eta1", "phi1", "mass1", "pt2", "eta2", "phi2", "mass2", "pt3", "eta3", "phi3", "mass3");
+  b_system.transform_attribute("mass_element", invariant_mass<3>(), "pt1", "eta1", "phi1", "mass1", "pt2", "eta2", "phi2", "mass2", "pt3", "eta3", "phi3", "mass3");
+  b_system.transform_attribute("pt_element", system_pt<3>(), "pt1", "eta1", "phi1", "mass1", "pt2", "eta2", "phi2", "mass2", "pt3", "eta3", "phi3", "mass3");
+  b_system.transform_attribute("rapidity_element", system_rapidity<3>(), "pt1", "eta1", "phi1", "mass1", "pt2", "eta2", "phi2", "mass2", "pt3", "eta3", "phi3", "mass3");
+  check(!b_system.kernel_attribute("mass", batch_invariant_mass<1>(), "pt1", "eta1", "phi1", "mass1"), "an attribute can only be added once");
+  check.throws<std::invalid_argument>([&] () { b_system.kernel_attribute("mass4", batch_invariant_mass<1>(), "pt4", "eta4", "phi4", "mass4"); },
+                                      "a kernel over attributes not in the batch");
+
+  for (long long entry = 0LL; entry < 1000LL; ++entry)
+    b_system.append(entry);
+  check(b_system.n_elements() == 1000, "one system per event");
+
+  // the kernels are evaluated on first access, and any selection after applies to them as it does to the transforms
+  int n_mass = 0, n_pt = 0, n_rapidity = 0;
+  for (int iE = 0; iE < b_system.n_elements(); ++iE) {
+    n_mass += std::abs(b_system.get<float>("mass")[iE] - b_system.get<float>("mass_element")[iE]) <= 1e-5 * b_system.get<float>("mass_element")[iE];
+    n_pt += std::abs(b_system.get<float>("pt")[iE] - b_system.get<float>("pt_element")[iE]) <= 1e-5 * std::max(1.f, b_system.get<float>("pt_element")[iE]);
+    n_rapidity += std::abs(b_system.get<float>("rapidity")[iE] - b_system.get<float>("rapidity_element")[iE]) <= 1e-5;
+  }
+  check(n_mass == 1000, "kernel mass matches the element-wise one, " + std::to_string(n_mass) + " of 1000");
+  check(n_pt == 1000, "kernel pt matches the element-wise one, " + std::to_string(n_pt) + " of 1000");
+  check(n_rapidity == 1000, "kernel rapidity matches the element-wise one, " + std::to_string(n_rapidity) + " of 1000");
+
+  const auto v_light = b_system.filter([] (float m) { return m < 100.f; }, "mass_element");
+  b_system.update_indices(v_light);
+  check(b_system.n_elements() == v_light.size() and b_system.get<float>("mass") == b_system.get<float>("mass_element"),
+        "kernel attribute after update_indices");
+
+  return check.summary();
+}
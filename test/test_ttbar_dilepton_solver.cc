@@ -0,0 +1,166 @@
+// TTbarDileptonSolver on dileptonic ttbar events made by hand from the top and W masses the solver assumes
+// unsmeared, every solution must have those masses and the missing transverse momentum, and one of them is the true one
+// and the attributes added to an aggregate are those of the solution of each pairing, in whatever order they are read
+// compile and run with the other tests by ./run.sh
+
+#include "misc/ttbar_dilepton_solver.h"
+#include "misc/synthetic_group.h"
+
+#include "check.h"
+
+#include <map>
+
+// just the part of the group interface the solver uses
+struct Objects {
+  std::string name;
+  std::map<std::string, std::vector<float>> m_column;
+  std::vector<int> charge, index;
+
+  explicit Objects(const std::string &name_) : name(name_) {}
+
+  void add(const FourVector<double> &p4, int charge_ = 0)
+  {
+    m_column["pt"].emplace_back(p4.Pt());
+    m_column["eta"].emplace_back(p4.Eta());
+    m_column["phi"].emplace_back(p4.Phi());
+    m_column["mass"].emplace_back(std::max(p4.M(), 0.));
+    charge.emplace_back(charge_);
+    index.emplace_back(index.size());
+  }
+
+  int inquire(const std::string &attr) const { return (m_column.count(attr) or (attr == "charge" and name == "lepton")) ? 1 : -1; }
+
+  template <typename T>
+  const std::vector<T>& get(const std::string &attr) const
+  {
+    if constexpr (std::is_same_v<T, int>)
+      return charge;
+    else
+      return m_column.at(attr);
+  }
+
+  const std::vector<int>& ref_to_indices() const { return index; }
+};
+
+
+
+// just the part of the aggregate interface add_attributes uses
+struct Attributes {
+  std::map<std::string, std::function<float(const std::array<int, 4> &)>> m_function;
+
+  template <typename Function>
+  bool add_indexed_attribute(const std::string &attr, Function function) { return m_function.emplace(attr, function).second; }
+};
+
+
+
+// a two-body decay of a particle at rest into a daughter of the given mass and another of mass2, the first along a random direction
+FourVector<double> decay(SyntheticRandom &rng, double mass, double mass1, double mass2)
+{
+  const double p = std::sqrt(((mass * mass) - ((mass1 + mass2) * (mass1 + mass2))) * ((mass * mass) - ((mass1 - mass2) * (mass1 - mass2)))) / (2. * mass);
+  const double cos = rng.uniform(-1., 1.), sin = std::sqrt(1. - (cos * cos)), phi = rng.uniform(-3.14159, 3.14159);
+  return FourVector<double>(p * sin * std::cos(phi), p * sin * std::sin(phi), p * cos, std::sqrt((p * p) + (mass1 * mass1)));
+}
+
+FourVector<double> rest_minus(const FourVector<double> &parent, const FourVector<double> &daughter)
+{
+  return FourVector<double>(-daughter.px, -daughter.py, -daughter.pz, parent.M() - daughter.e);
+}
+
+void boost_out_of(FourVector<double> &p4, const FourVector<double> &frame) { p4.Boost(frame.px / frame.e, frame.py / frame.e, frame.pz / frame.e); }
+
+FourVector<double> in_double(const FourVector<float> &p4) { return FourVector<double>(p4.px, p4.py, p4.pz, p4.e); }
+
+
+
+int main() {
+  using Solver = TTbarDileptonSolver<float>;
+  Checks check("test_ttbar_dilepton_solver");
+
+  constexpr double m_top = Framework::constants::m_top<double>, m_w = Framework::constants::m_w<double>, m_b = 4.7;
+  SyntheticRandom rng(13ULL);
+  Solver solver(0);
+
+  Attributes attributes;
+  solver.add_attributes(attributes);
+  check(attributes.m_function.size() == 17 and attributes.m_function.count("antitop_eta") and attributes.m_function.count("solver_weight"),
+        "the attributes added to the aggregate");
+
+  int n_solved = 0, n_masses = 0, n_met = 0, n_truth = 0, n_attribute = 0, n_reversed = 0;
+  for (int iV = 0; iV < 500; ++iV) {
+    // t -> W+ b -> l+ nu b and tbar -> W- bbar -> l- nubar bbar, built in the rest frames then boosted out to the lab
+    std::array<FourVector<double>, 2> top;
+    std::array<std::array<FourVector<double>, 3>, 2> daughter;
+    for (int iT = 0; iT < 2; ++iT) {
+      top[iT] = FourVector<double>::pt_eta_phi_m(rng.exponential(100.), rng.uniform(-2., 2.), rng.uniform(-3.14159, 3.14159), m_top);
+
+      auto w = decay(rng, m_top, m_w, m_b);
+      auto bottom = rest_minus(FourVector<double>(0., 0., 0., m_top), w);
+      auto lepton = decay(rng, m_w, 0., 0.);
+      auto neutrino = rest_minus(FourVector<double>(0., 0., 0., m_w), lepton);
+      boost_out_of(lepton, w);
+      boost_out_of(neutrino, w);
+
+      daughter[iT] = {lepton, neutrino, bottom};
+      for (auto &p4 : daughter[iT])
+        boost_out_of(p4, top[iT]);
+    }
+
+    Objects lepton("lepton"), jet("jet"), met("met");
+    lepton.add(daughter[1][0], -1);
+    lepton.add(daughter[0][0], 1);
+    jet.add(daughter[0][2]);
+    jet.add(daughter[1][2]);
+    const auto nunu = daughter[0][1] + daughter[1][1];
+    met.m_column["pt"] = {static_cast<float>(nunu.Pt())};
+    met.m_column["phi"] = {static_cast<float>(nunu.Phi())};
+
+    // the true pairing is {l-, l+, b, bbar}; the swapped jets may or may not have a solution too
+    const auto indices = solver(lepton, jet, met);
+    if (std::find(std::begin(indices), std::end(indices), std::array<int, 4>{0, 1, 0, 1}) == std::end(indices))
+      continue;
+    ++n_solved;
+
+    // of the up to four solutions the one of smallest ttbar mass is taken, which is not always the true one
+    // but whichever it is, it has the top and W masses it was solved with, and the neutrinos make up the missing transverse momentum
+    const auto &solution = solver.solution({0, 1, 0, 1});
+    const auto top_solved = in_double(solution.top), antitop_solved = in_double(solution.antitop);
+    const auto w_plus = in_double(solution.antilepton) + in_double(solution.neutrino), w_minus = in_double(solution.lepton) + in_double(solution.antineutrino);
+    n_masses += std::abs(top_solved.M() - m_top) < 0.05 and std::abs(antitop_solved.M() - m_top) < 0.05 and
+      std::abs(w_plus.M() - m_w) < 0.05 and std::abs(w_minus.M() - m_w) < 0.05;
+
+    const auto nunu_solved = in_double(solution.neutrino) + in_double(solution.antineutrino);
+    n_met += std::abs(nunu_solved.px - nunu.px) < 0.01 and std::abs(nunu_solved.py - nunu.py) < 0.01;
+    n_truth += std::abs(top_solved.px - top[0].px) < 0.05 and std::abs(top_solved.pz - top[0].pz) < 0.05 and std::abs(antitop_solved.pz - top[1].pz) < 0.05;
+
+    // the attributes of every pairing returned are those of its solution, read in the order returned or reversed
+    auto matches = [&attributes, &solver] (const std::array<int, 4> &index) {
+      const auto &expect = solver.solution(index);
+      return attributes.m_function["top_pt"](index) == expect.top.Pt() and attributes.m_function["antitop_mass"](index) == expect.antitop.M() and
+        attributes.m_function["antilepton_phi"](index) == expect.antilepton.Phi() and attributes.m_function["solver_weight"](index) == expect.weight;
+    };
+    n_attribute += std::all_of(std::begin(indices), std::end(indices), matches);
+    n_reversed += std::all_of(std::rbegin(indices), std::rend(indices), matches);
+  }
+
+  check(n_solved == 500, "the true pairing is solved in every event, " + std::to_string(n_solved) + " of 500");
+  check(n_masses == n_solved, "the solutions have the top and W masses, " + std::to_string(n_masses) + " of " + std::to_string(n_solved));
+  check(n_met == n_solved, "the neutrinos make up the missing transverse momentum, " + std::to_string(n_met) + " of " + std::to_string(n_solved));
+  check(n_truth > n_solved / 2, "the solution is the true one in most events, " + std::to_string(n_truth) + " of " + std::to_string(n_solved));
+  check(n_attribute == n_solved and n_reversed == n_solved, "the attributes of the aggregate in either order");
+
+  // the attributes of groups already seen are not checked again, but those of new ones are
+  Objects lepton("lepton"), jet("jet"), met("met");
+  lepton.add(FourVector<double>::pt_eta_phi_m(50., 0.3, 0.1, 0.), -1);
+  jet.add(FourVector<double>::pt_eta_phi_m(60., 0.1, 2.1, 4.7));
+  met.m_column["pt"] = {40.f};
+  met.m_column["phi"] = {-1.f};
+  check(solver(lepton, jet, met).empty(), "no pairing with a single lepton and jet");
+
+  Objects no_charge("muon");
+  no_charge.m_column = lepton.m_column;
+  check.throws<std::invalid_argument>([&] () { solver(no_charge, jet, met); }, "a lepton group without charge");
+  check.throws<std::invalid_argument>([&] () { solver.solution({0, 1, 0, 1}); }, "a pairing that has no solution");
+
+  return check.summary();
+}